@@ -44,10 +44,14 @@
 #include "VideoHandle.h"
 #include "VideoSubWindow.h"
 #include "lib/CalypOptions.h"
+#include "lib/CalypStream.h"
 #ifdef USE_FERVOR
 #include "fvupdater.h"
 #endif
 
+// Decoded frames kept for stepping back and forth (MiB)
+constexpr qulonglong kDefaultFrameCacheSize = 1024;
+
 MainWindow::MainWindow() : m_pcCurrentSubWindow( NULL ), m_pcCurrentVideoSubWindow( NULL ), m_pcAboutDialog( NULL )
 {
   setWindowModality( Qt::ApplicationModal );
@@ -961,6 +965,10 @@ void MainWindow::readSettings()
 
   m_cLastOpenPath = appSettings.value( "MainWindow/LastOpenPath", QDir::homePath() ).toString();
 
+  const qulonglong frameCacheSize =
+      appSettings.value( "MainWindow/FrameCacheSize", kDefaultFrameCacheSize ).toULongLong();
+  CalypStream::setFrameCacheBudget( static_cast<std::size_t>( frameCacheSize ) << 20 );
+
   QVariant value = appSettings.value( "MainWindow/RecentFileList" );
   m_aRecentFileStreamInfo = value.value<CalypFileInfoVector>();
   checkRecentFileActions();
@@ -979,6 +987,7 @@ void MainWindow::writeSettings()
   appSettings.setValue( "MainWindow/Position", pos() );
   appSettings.setValue( "MainWindow/Size", size() );
   appSettings.setValue( "MainWindow/LastOpenPath", m_cLastOpenPath );
+  appSettings.setValue( "MainWindow/FrameCacheSize", qulonglong( CalypStream::getFrameCacheBudget() >> 20 ) );
 
   QVariant var;
   var.setValue( m_aRecentFileStreamInfo );
@@ -25,58 +25,11 @@
 
 #include "ResourceHandle.h"
 
-#include <QCoreApplication>
-#include <QEvent>
-#include <QFileInfo>
-#include <QMutex>
-#include <QThread>
-#include <chrono>
-#include <iostream>
+#include <cassert>
 #include <memory>
-#include <optional>
 
-ResourceWorker::ResourceWorker( std::shared_ptr<CalypStream> stream )
-    : m_pcStream{ stream }
-{
-}
-
-void ResourceWorker::stop()
-{
-  m_bStop = true;
-  wake();
-  wait();
-}
-
-void ResourceWorker::wake()
-{
-  m_Mutex.lock();
-  m_ResourceIdle.wakeAll();
-  m_Mutex.unlock();
-}
-
-void ResourceWorker::run()
-{
-  m_bStop = false;
-
-  // Loop forever
-  while( !m_bStop )
-  {
-    // auto start = std::chrono::steady_clock::now();
-    m_pcStream->readNextFrameFillRGBBuffer();
-    // auto end = std::chrono::steady_clock::now();
-    // std::cout << "Elapsed time reading and processing a frame: "
-    //           << std::chrono::duration_cast<std::chrono::milliseconds>( end - start ).count()
-    //           << " ms" << std::endl;
-
-    while( !m_bStop && !m_pcStream->hasWritingSlot() )
-    {
-      // Wait here
-      m_Mutex.lock();
-      m_ResourceIdle.wait( &m_Mutex );
-      m_Mutex.unlock();
-    }
-  }
-}
+// Frames read (and converted to RGB) ahead of the displayed one
+constexpr std::size_t kReadAheadFrames = 4;
 
 ResourceHandle::ResourceHandle()
 {
@@ -86,10 +39,7 @@ auto ResourceHandle::addResource() -> std::size_t
 {
   auto resource_id = unique_id;
   unique_id++;
-  auto newStreamResource = std::make_shared<CalypStream>();
-  auto newStreamResourceWorker = std::make_unique<ResourceWorker>( newStreamResource );
-  m_apcStreamResourcesList[resource_id] = newStreamResource;
-  m_apcStreamResourcesWorkersList[resource_id] = std::move( newStreamResourceWorker );
+  m_apcStreamResourcesList[resource_id] = std::make_shared<CalypStream>();
   return resource_id;
 }
 
@@ -97,10 +47,10 @@ auto ResourceHandle::getResource( CalypStream* ptr ) -> std::size_t
 {
   if( ptr != nullptr )
   {
-    for( std::size_t i = 0; i < m_apcStreamResourcesList.size(); i++ )
+    for( const auto& [id, stream] : m_apcStreamResourcesList )
     {
-      if( m_apcStreamResourcesList[i].get() == ptr )
-        return i;
+      if( stream.get() == ptr )
+        return id;
     }
   }
   return addResource();
@@ -108,7 +58,7 @@ auto ResourceHandle::getResource( CalypStream* ptr ) -> std::size_t
 
 auto ResourceHandle::getResourceAsset( std::size_t id ) -> CalypStream*
 {
-  if( m_apcStreamResourcesWorkersList.count( id ) )
+  if( m_apcStreamResourcesList.count( id ) )
   {
     return m_apcStreamResourcesList[id].get();
   }
@@ -117,33 +67,18 @@ auto ResourceHandle::getResourceAsset( std::size_t id ) -> CalypStream*
 
 void ResourceHandle::removeResource( std::size_t id )
 {
-  if( !m_apcStreamResourcesWorkersList.count( id ) )
-  {
-    assert( false );
-    return;
-  }
-
-  // Remove worker first
-  m_apcStreamResourcesWorkersList[id]->stop();
-  m_apcStreamResourcesWorkersList[id] = nullptr;
-
-  // Then the underlying stream
-  m_apcStreamResourcesList[id] = nullptr;
-}
-
-void ResourceHandle::stopResourceWorker( std::size_t id )
-{
-  if( !m_apcStreamResourcesWorkersList.count( id ) )
+  if( !m_apcStreamResourcesList.count( id ) )
   {
     assert( false );
     return;
   }
-  m_apcStreamResourcesWorkersList[id]->stop();
+  // Joins the read-ahead thread
+  m_apcStreamResourcesList.erase( id );
 }
 
-void ResourceHandle::startResourceWorker( std::size_t id )
+void ResourceHandle::startReadAhead( std::size_t id )
 {
-  if( !m_apcStreamResourcesWorkersList.count( id ) )
+  if( !m_apcStreamResourcesList.count( id ) )
   {
     assert( false );
     return;
@@ -152,18 +87,5 @@ void ResourceHandle::startResourceWorker( std::size_t id )
   {
     return;  // No work to be done!
   }
-  m_apcStreamResourcesWorkersList[id]->setObjectName(
-      "RW-" +
-      QFileInfo( QString::fromStdString( m_apcStreamResourcesList[id]->getFileName() ) ).completeBaseName() );
-  m_apcStreamResourcesWorkersList[id]->start();
+  m_apcStreamResourcesList[id]->setReadAhead( kReadAheadFrames, true );
 }
-
-void ResourceHandle::wakeResourceWorker( std::size_t id )
-{
-  if( !m_apcStreamResourcesWorkersList.count( id ) )
-  {
-    assert( false );
-    return;
-  }
-  m_apcStreamResourcesWorkersList[id]->wake();
-}
\ No newline at end of file
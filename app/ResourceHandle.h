@@ -25,30 +25,16 @@
 #ifndef __RESOURCEHANDLE_H__
 #define __RESOURCEHANDLE_H__
 
-#include <QMutex>
-#include <QThread>
-#include <QVector>
-#include <QWaitCondition>
-#include <atomic>
+#include <map>
+#include <memory>
 
 #include "CommonDefs.h"
 #include "lib/CalypStream.h"
 
-class ResourceWorker : public QThread
-{
-private:
-  QMutex m_Mutex;
-  QWaitCondition m_ResourceIdle;
-  std::shared_ptr<CalypStream> m_pcStream;
-  std::atomic<bool> m_bStop{ false };
-
-public:
-  ResourceWorker( std::shared_ptr<CalypStream> stream );
-  void stop();
-  void wake();
-  void run();
-};
-
+/**
+ * Owns the streams of the sub-windows.
+ * Frames are read ahead by the streams themselves (see CalypStream::setReadAhead())
+ */
 class ResourceHandle
 {
 public:
@@ -58,9 +44,7 @@ public:
   auto getResource( CalypStream* ptr ) -> std::size_t;
   auto getResourceAsset( std::size_t id ) -> CalypStream*;
   void removeResource( std::size_t id );
-  void stopResourceWorker( std::size_t id );
-  void startResourceWorker( std::size_t id );
-  void wakeResourceWorker( std::size_t id );
+  void startReadAhead( std::size_t id );
 
 private:
   auto addResource() -> std::size_t;
@@ -68,7 +52,6 @@ private:
 private:
   std::size_t unique_id{ 0 };
   std::map<std::size_t, std::shared_ptr<CalypStream>> m_apcStreamResourcesList;
-  std::map<std::size_t, std::unique_ptr<ResourceWorker>> m_apcStreamResourcesWorkersList;
 };
 
 #endif  // __RESOURCEHANDLE_H__
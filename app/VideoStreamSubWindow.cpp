@@ -237,7 +237,7 @@ bool VideoStreamSubWindow::loadFile( QString cFilename, bool bForceDialog )
   appSettings.setValue( "VideoStreamSubWindow/LastBitsPerPixel", var );
 
 #ifdef CALYP_MANAGED_RESOURCES
-  m_pcResourceManager->startResourceWorker( m_uiResourceId );
+  m_pcResourceManager->startReadAhead( m_uiResourceId );
 #endif
 
   QApplication::restoreOverrideCursor();
@@ -271,7 +271,7 @@ bool VideoStreamSubWindow::loadFile( CalypFileInfo streamInfo )
   m_sStreamInfo = std::move( streamInfo );
 
 #ifdef CALYP_MANAGED_RESOURCES
-  m_pcResourceManager->startResourceWorker( m_uiResourceId );
+  m_pcResourceManager->startReadAhead( m_uiResourceId );
 #endif
 
   QApplication::restoreOverrideCursor();
@@ -439,17 +439,12 @@ bool VideoStreamSubWindow::guessFormat( const QString& filename, unsigned int& r
 
 void VideoStreamSubWindow::refreshSubWindow()
 {
-#ifdef CALYP_MANAGED_RESOURCES
-  m_pcResourceManager->stopResourceWorker( m_uiResourceId );
-#endif
+  // The stream restarts its read-ahead
   if( !m_pCurrStream->reload() )
   {
     close();
     return;
   }
-#ifdef CALYP_MANAGED_RESOURCES
-  m_pcResourceManager->startResourceWorker( m_uiResourceId );
-#endif
 
   updateVideoWindowInfo();
   refreshFrame();
@@ -491,13 +486,10 @@ bool VideoStreamSubWindow::goToNextFrame( bool bThreaded )
   m_cRefreshResult.waitForFinished();
   m_cReadResult.waitForFinished();
 #endif
-#ifdef CALYP_MANAGED_RESOURCES
-  while( !m_pCurrStream->hasNextFrame() && !m_pCurrStream->isEof() ) {}
-#endif
+  // Waits for the read-ahead thread when the next frame is not read yet
   bool bEndOfSeq = m_pCurrStream->setNextFrame();
 #ifdef CALYP_MANAGED_RESOURCES
   bThreaded = false;
-  m_pcResourceManager->wakeResourceWorker( m_uiResourceId );
 #endif
   if( !bEndOfSeq )
   {
@@ -568,10 +560,6 @@ void VideoStreamSubWindow::seekAbsoluteEvent( unsigned int new_frame_num )
   {
     if( m_pCurrStream->seekInput( new_frame_num ) )
       refreshFrame();
-
-#ifdef CALYP_MANAGED_RESOURCES
-    m_pcResourceManager->wakeResourceWorker( m_uiResourceId );
-#endif
   }
 }
 
@@ -586,9 +574,6 @@ void VideoStreamSubWindow::seekRelativeEvent( bool bIsForward )
     else
     {
       m_pCurrStream->seekInputRelative( bIsForward );
-#ifdef CALYP_MANAGED_RESOURCES
-      m_pcResourceManager->wakeResourceWorker( m_uiResourceId );
-#endif
       refreshFrame();
     }
   }
@@ -396,10 +396,10 @@ void FramePropertiesDock::setSelection( const QRect& selectionArea )
        */
       if( bSelectionChanged )
       {
-        m_pcSelectedFrame = std::make_shared<CalypFrame>( *m_pcFrame, selectionArea.x(),
-                                                          selectionArea.y(),
-                                                          selectionArea.width(),
-                                                          selectionArea.height() );
+        m_pcSelectedFrame = CalypFrame::createView( m_pcFrame, selectionArea.x(),
+                                                    selectionArea.y(),
+                                                    selectionArea.width(),
+                                                    selectionArea.height() );
       }
       updateDataHistogram();
       selectionImageButton->click();
@@ -426,11 +426,13 @@ void FramePropertiesDock::updateDataHistogram()
     {
       if( m_cSelectionArea.isValid() )
       {
-        m_pcSelectedFrame = std::make_shared<CalypFrame>( *m_pcFrame,
-                                                          m_cSelectionArea.x(),
-                                                          m_cSelectionArea.y(),
-                                                          m_cSelectionArea.width(),
-                                                          m_cSelectionArea.height() );
+        // Selections are counted from the tiles of the frame
+        m_pcFrame->calcHistogramIndex();
+        m_pcSelectedFrame = CalypFrame::createView( m_pcFrame,
+                                                    m_cSelectionArea.x(),
+                                                    m_cSelectionArea.y(),
+                                                    m_cSelectionArea.width(),
+                                                    m_cSelectionArea.height() );
         fullImageButton->show();
         selectionImageButton->show();
       }
@@ -189,13 +189,16 @@ void QualityMeasurementSidebar::updateSidebarData()
 
       CalypFrame* currFrame = m_pcCurrentVideoSubWindow->getCurrFrame();
       CalypFrame* refFrame = refSubWindow->getCurrFrame();
-      double quality;
+      const int metric = m_comboBoxMetric->currentIndex();
+      std::vector<unsigned int> components;
+      for( unsigned int component = 0; component < currFrame->getNumberChannels() && component < 3; component++ )
+        components.push_back( component );
+      const auto quality = currFrame->computeQuality( refFrame, { metric }, components );
       QString value;
       unsigned int component = 0;
-      for( ; component < currFrame->getNumberChannels(); component++ )
+      for( ; component < components.size(); component++ )
       {
-        quality = currFrame->getQuality( m_comboBoxMetric->currentIndex(), refFrame, component );
-        m_ppcLabelQualityValue[component]->setText( value.setNum( quality, 'f', 4 ) );
+        m_ppcLabelQualityValue[component]->setText( value.setNum( quality( metric, component ), 'f', 4 ) );
       }
       for( ; component < 3; component++ )
       {
@@ -0,0 +1,485 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2021  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     main.cpp
+ * \brief    calypBench - throughput of the library hot paths on synthetic frames
+ *
+ * Each benchmark runs for at least --min-time milliseconds and reports frames/s
+ * and GB/s, where the bytes are those of the raw frames read by the operation.
+ * The results are written as JSON (one result per line) so that two runs
+ * can be compared with a plain diff.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "lib/CalypCpuFeatures.h"
+#include "lib/CalypFrame.h"
+#include "lib/CalypModuleIf.h"
+#include "lib/CalypOptions.h"
+#include "lib/CalypStream.h"
+#include "lib/CalypThreadPool.h"
+#include "modules/CalypModulesFactory.h"
+
+namespace
+{
+constexpr std::size_t kNumSyntheticFrames = 4;
+
+struct BenchResult
+{
+  std::string name;
+  std::string format;
+  unsigned int bits{ 0 };
+  std::uint64_t frames{ 0 };
+  double seconds{ 0 };
+  std::uint64_t bytesPerFrame{ 0 };
+};
+
+auto splitList( const std::string& list ) -> std::vector<std::string>
+{
+  std::vector<std::string> items;
+  std::stringstream ss( list );
+  std::string item;
+  while( std::getline( ss, item, ',' ) )
+  {
+    if( !item.empty() )
+      items.push_back( item );
+  }
+  return items;
+}
+
+auto jsonString( const std::string& str ) -> std::string
+{
+  std::string out = "\"";
+  for( char c : str )
+  {
+    if( c == '"' || c == '\\' )
+      out += '\\';
+    out += c;
+  }
+  return out + "\"";
+}
+
+/**
+ * Raw frame of random samples in the little endian layout read by frameFromBuffer()
+ */
+auto syntheticBuffer( const CalypFrame& frame, std::mt19937& rng ) -> std::vector<ClpByte>
+{
+  std::vector<ClpByte> buffer( frame.getBytesPerFrame() );
+  const unsigned int maxval = ( 1u << frame.getBitsPel() ) - 1;
+  if( frame.getBitsPel() <= 8 )
+  {
+    for( auto& byte : buffer )
+      byte = ClpByte( rng() & maxval );
+    return buffer;
+  }
+  for( std::size_t i = 0; i + 1 < buffer.size(); i += 2 )
+  {
+    const unsigned int sample = rng() & maxval;
+    buffer[i] = ClpByte( sample & 0xFF );
+    buffer[i + 1] = ClpByte( sample >> 8 );
+  }
+  return buffer;
+}
+
+auto syntheticFrames( unsigned int width, unsigned int height, ClpPixelFormats format, unsigned int bits )
+    -> std::vector<std::unique_ptr<CalypFrame>>
+{
+  std::mt19937 rng( 1234 );
+  std::vector<std::unique_ptr<CalypFrame>> frames;
+  for( std::size_t i = 0; i < kNumSyntheticFrames; i++ )
+  {
+    auto frame = std::make_unique<CalypFrame>( width, height, format, bits );
+    frame->frameFromBuffer( syntheticBuffer( *frame, rng ), CLP_LITTLE_ENDIAN );
+    frames.push_back( std::move( frame ) );
+  }
+  return frames;
+}
+
+class CalypBench
+{
+public:
+  CalypBench() : m_cOptions( "calypBench" ) {}
+
+  auto parse( int argc, char* argv[] ) -> int;  // NOLINT
+  void run();
+  auto writeResults() -> bool;
+
+private:
+  auto selected( const std::string& name ) const -> bool
+  {
+    return m_strFilter.empty() || name.find( m_strFilter ) != std::string::npos;
+  }
+
+  /**
+   * Call fn( iteration ) until the minimum time is spent (after one warm-up call)
+   */
+  template <typename Fn>
+  void measure( const std::string& name, const CalypFrame& frame, std::uint64_t bytesPerFrame, Fn&& fn )
+  {
+    using Clock = std::chrono::steady_clock;
+    fn( std::size_t( 0 ) );
+
+    BenchResult result{ name, std::string( CalypFrame::pixelFormatName( frame.getPelFormat() ) ), frame.getBitsPel() };
+    result.bytesPerFrame = bytesPerFrame;
+    const auto start = Clock::now();
+    const auto minTime = std::chrono::milliseconds( m_uiMinTimeMs );
+    do
+    {
+      fn( std::size_t( result.frames++ ) );
+    } while( Clock::now() - start < minTime );
+    result.seconds = std::chrono::duration<double>( Clock::now() - start ).count();
+
+    std::cerr << name << " " << result.format << " " << result.bits << " bits: " << result.frames / result.seconds
+              << " frames/s\n";
+    m_aResults.push_back( std::move( result ) );
+  }
+
+  void benchFrameOperations( ClpPixelFormats format, unsigned int bits );
+  void benchQuality( ClpPixelFormats format, unsigned int bits );
+  void benchRawStream( ClpPixelFormats format, unsigned int bits );
+  void benchModules();
+
+  CalypOptions m_cOptions;
+  unsigned int m_uiWidth{ 1920 };
+  unsigned int m_uiHeight{ 1080 };
+  unsigned int m_uiMinTimeMs{ 500 };
+  unsigned int m_uiStreamFrames{ 16 };
+  std::string m_strFormats;
+  std::string m_strBits{ "8,10,16" };
+  std::string m_strFilter;
+  std::string m_strCpuLevel;
+  std::string m_strOutput;
+  std::string m_strTmpDir;
+
+  std::vector<BenchResult> m_aResults;
+};
+
+auto CalypBench::parse( int argc, char* argv[] ) -> int  // NOLINT
+{
+  std::string size;
+  m_cOptions.addOptions()                                                                      /**/
+      ( "help", "produce help message" )                                                       /**/
+      ( "size,s", size, "size of the synthetic frames (WxH) [1920x1080]" )                     /**/
+      ( "pel_fmt,p", m_strFormats, "pixel formats (comma separated) [all]" )                   /**/
+      ( "bits_pel", m_strBits, "bits per pixel (comma separated) [8,10,16]" )                  /**/
+      ( "min-time", m_uiMinTimeMs, "minimum time of each benchmark in ms [500]" )              /**/
+      ( "stream-frames", m_uiStreamFrames, "frames of the raw stream benchmarks [16]" )        /**/
+      ( "filter", m_strFilter, "only run the benchmarks whose name contains this string" )     /**/
+      ( "tmp-dir", m_strTmpDir, "directory of the raw stream files [system temp]" )            /**/
+      ( "cpu", m_strCpuLevel, "limit the SIMD kernels (generic, sse2, sse4.1, avx2, avx512)" ) /**/
+      ( "output,o", m_strOutput, "JSON results file [stdout]" );
+
+  int iRet = m_cOptions.parse( argc, argv );
+  if( iRet != 0 )
+    return iRet;
+
+  if( m_cOptions.hasOpt( "help" ) )
+  {
+    m_cOptions.doHelp( std::cout );
+    return 1;
+  }
+  if( m_cOptions.hasOpt( "size" ) && std::sscanf( size.c_str(), "%ux%u", &m_uiWidth, &m_uiHeight ) != 2 )
+  {
+    std::cerr << "Invalid size " << size << "!\n";
+    return -1;
+  }
+  if( m_uiWidth < 16 || m_uiHeight < 16 )
+  {
+    std::cerr << "The frames should be at least 16x16!\n";
+    return -1;
+  }
+  if( m_cOptions.hasOpt( "cpu" ) )
+  {
+    auto cpuLevel = calypFindCpuLevel( m_strCpuLevel );
+    if( !cpuLevel )
+    {
+      std::cerr << "Invalid cpu level " << m_strCpuLevel << "!\n";
+      return -1;
+    }
+    calypSetCpuLevel( *cpuLevel );
+  }
+  if( m_strTmpDir.empty() )
+    m_strTmpDir = std::filesystem::temp_directory_path().string();
+  return 0;
+}
+
+void CalypBench::benchFrameOperations( ClpPixelFormats format, unsigned int bits )
+{
+  auto frames = syntheticFrames( m_uiWidth, m_uiHeight, format, bits );
+  CalypFrame& frame = *frames[0];
+  const std::uint64_t bytes = frame.getBytesPerFrame();
+
+  std::mt19937 rng( 5678 );
+  std::vector<std::vector<ClpByte>> buffers;
+  for( std::size_t i = 0; i < kNumSyntheticFrames; i++ )
+    buffers.push_back( syntheticBuffer( frame, rng ) );
+
+  if( selected( "frameFromBuffer" ) )
+  {
+    measure( "frameFromBuffer", frame, bytes,
+             [&]( std::size_t i ) { frame.frameFromBuffer( buffers[i % kNumSyntheticFrames], CLP_LITTLE_ENDIAN ); } );
+  }
+  if( selected( "frameToBuffer" ) )
+  {
+    measure( "frameToBuffer", frame, bytes, [&]( std::size_t i ) {
+      frames[i % kNumSyntheticFrames]->frameToBuffer( buffers[i % kNumSyntheticFrames], CLP_LITTLE_ENDIAN );
+    } );
+  }
+  if( selected( "fillRGBBuffer" ) )
+  {
+    measure( "fillRGBBuffer", frame, bytes,
+             [&]( std::size_t i ) { frames[i % kNumSyntheticFrames]->fillRGBBuffer( std::nullopt ); } );
+  }
+  if( selected( "calcHistogram" ) )
+  {
+    measure( "calcHistogram", frame, bytes, [&]( std::size_t i ) {
+      // Writing a sample drops the histogram computed in the previous iteration
+      CalypFrame& histFrame = *frames[i % kNumSyntheticFrames];
+      histFrame.setPixel( 0, 0, histFrame.getPixel( 0, 0 ) );
+      histFrame.calcHistogram();
+    } );
+  }
+}
+
+void CalypBench::benchQuality( ClpPixelFormats format, unsigned int bits )
+{
+  auto frames = syntheticFrames( m_uiWidth, m_uiHeight, format, bits );
+  std::vector<unsigned int> components;
+  for( unsigned int ch = 0; ch < frames[0]->getNumberChannels(); ch++ )
+    components.push_back( ch );
+
+  auto metricsList = CalypFrame::supportedQualityMetricsList();
+  std::vector<int> allMetrics;
+  for( int metric = 0; metric < CalypFrame::NUMBER_METRICS; metric++ )
+  {
+    allMetrics.push_back( metric );
+    const std::string name = "quality:" + metricsList[metric];
+    if( !selected( name ) )
+      continue;
+    measure( name, *frames[0], 2 * frames[0]->getBytesPerFrame(), [&]( std::size_t i ) {
+      frames[i % kNumSyntheticFrames]->computeQuality( frames[( i + 1 ) % kNumSyntheticFrames].get(), { metric },
+                                                       components );
+    } );
+  }
+  if( selected( "quality:all" ) )
+  {
+    measure( "quality:all", *frames[0], 2 * frames[0]->getBytesPerFrame(), [&]( std::size_t i ) {
+      frames[i % kNumSyntheticFrames]->computeQuality( frames[( i + 1 ) % kNumSyntheticFrames].get(), allMetrics,
+                                                       components );
+    } );
+  }
+}
+
+void CalypBench::benchRawStream( ClpPixelFormats format, unsigned int bits )
+{
+  if( !selected( "stream:raw:write" ) && !selected( "stream:raw:read" ) )
+    return;
+
+  auto frames = syntheticFrames( m_uiWidth, m_uiHeight, format, bits );
+  const CalypFrame& frame = *frames[0];
+  const std::string fileName =
+      ( std::filesystem::path( m_strTmpDir ) /
+        ( "calypBench_" + std::string( CalypFrame::pixelFormatName( format ) ) + "_" + std::to_string( bits ) + ".yuv" ) )
+          .string();
+
+  if( selected( "stream:raw:write" ) )
+  {
+    // Each pass rewrites the file from its first frame
+    std::unique_ptr<CalypStream> output;
+    std::size_t written = 0;
+    measure( "stream:raw:write", frame, frame.getBytesPerFrame(), [&]( std::size_t i ) {
+      if( !output || written == m_uiStreamFrames )
+      {
+        output = std::make_unique<CalypStream>();
+        output->open( fileName, m_uiWidth, m_uiHeight, format, bits, CLP_LITTLE_ENDIAN, 1, CalypStream::Type::Output );
+        written = 0;
+      }
+      output->writeFrame( *frames[i % kNumSyntheticFrames] );
+      written++;
+    } );
+  }
+
+  // The read benchmark needs a complete file
+  {
+    CalypStream output;
+    output.open( fileName, m_uiWidth, m_uiHeight, format, bits, CLP_LITTLE_ENDIAN, 1, CalypStream::Type::Output );
+    for( std::size_t i = 0; i < m_uiStreamFrames; i++ )
+      output.writeFrame( *frames[i % kNumSyntheticFrames] );
+  }
+
+  if( selected( "stream:raw:read" ) )
+  {
+    CalypStream input;
+    input.open( fileName, m_uiWidth, m_uiHeight, format, bits, CLP_LITTLE_ENDIAN, 1, CalypStream::Type::Input );
+    measure( "stream:raw:read", frame, frame.getBytesPerFrame(), [&]( std::size_t ) {
+      input.getCurrFrame();
+      if( input.setNextFrame() )
+        input.seekInput( 0 );
+      else
+        input.readNextFrame();
+    } );
+  }
+
+  std::error_code ec;
+  std::filesystem::remove( fileName, ec );
+}
+
+void CalypBench::benchModules()
+{
+  auto frames = syntheticFrames( m_uiWidth, m_uiHeight, ClpPixelFormats::YUV420p, 8 );
+  for( auto& [moduleName, create] : CalypModulesFactory::Get()->getMap() )
+  {
+    const std::string name = "module:" + moduleName;
+    if( !selected( name ) )
+      continue;
+
+    CalypModulePtr module = create();
+    std::vector<CalypFrame*> moduleFrames;
+    for( unsigned int i = 0; i < module->m_uiNumberOfFrames; i++ )
+      moduleFrames.push_back( frames[i % kNumSyntheticFrames].get() );
+
+    try
+    {
+      bool created = true;
+      if( module->m_iModuleAPI >= CLP_MODULE_API_2 )
+        created = module->create( moduleFrames );
+      else
+        module->create( moduleFrames[0] );
+      if( !created )
+      {
+        std::cerr << name << ": cannot be created with the synthetic frames, skipped\n";
+        continue;
+      }
+
+      const bool api2 = module->m_iModuleAPI >= CLP_MODULE_API_2;
+      const bool measurement = module->m_iModuleType == ClpModuleType::FrameMeasurement;
+      measure( name, *frames[0], moduleFrames.size() * frames[0]->getBytesPerFrame(), [&]( std::size_t ) {
+        if( measurement )
+          api2 ? module->measure( moduleFrames ) : module->measure( moduleFrames[0] );
+        else
+          api2 ? module->process( moduleFrames ) : module->process( moduleFrames[0] );
+      } );
+      module->destroy();
+    }
+    catch( const std::exception& e )
+    {
+      std::cerr << name << ": " << e.what() << ", skipped\n";
+    }
+  }
+}
+
+void CalypBench::run()
+{
+  std::vector<unsigned int> bitsList;
+  for( const auto& bits : splitList( m_strBits ) )
+    bitsList.push_back( std::stoul( bits ) );
+
+  std::vector<std::string> formatNames = splitList( m_strFormats );
+  if( formatNames.empty() )
+  {
+    for( const auto& [format, name] : CalypFrame::supportedPixelFormatListNames() )
+      formatNames.emplace_back( name );
+  }
+
+  for( const auto& formatName : formatNames )
+  {
+    auto format = CalypFrame::findPixelFormat( formatName );
+    if( !format )
+    {
+      std::cerr << "Unknown pixel format " << formatName << ", skipped\n";
+      continue;
+    }
+    for( unsigned int bits : bitsList )
+    {
+      try
+      {
+        benchFrameOperations( *format, bits );
+        benchQuality( *format, bits );
+        benchRawStream( *format, bits );
+      }
+      catch( const std::exception& e )
+      {
+        std::cerr << formatName << " " << bits << " bits: " << e.what() << ", skipped\n";
+      }
+    }
+  }
+  benchModules();
+}
+
+auto CalypBench::writeResults() -> bool
+{
+  std::ofstream file;
+  if( !m_strOutput.empty() )
+  {
+    file.open( m_strOutput );
+    if( !file.is_open() )
+    {
+      std::cerr << "Cannot open " << m_strOutput << "!\n";
+      return false;
+    }
+  }
+  std::ostream& out = m_strOutput.empty() ? std::cout : file;
+
+  out << "{\n";
+  out << "  \"version\": " << jsonString( CALYP_VERSION_STRING ) << ",\n";
+  out << "  \"cpu_level\": " << jsonString( std::string( calypCpuLevelName( calypCpuLevel() ) ) ) << ",\n";
+  out << "  \"threads\": " << calypThreadPool().numThreads() << ",\n";
+  out << "  \"width\": " << m_uiWidth << ",\n";
+  out << "  \"height\": " << m_uiHeight << ",\n";
+  out << "  \"results\": [\n";
+  for( std::size_t i = 0; i < m_aResults.size(); i++ )
+  {
+    const BenchResult& result = m_aResults[i];
+    const double framesPerSecond = result.frames / result.seconds;
+    out << "    { \"name\": " << jsonString( result.name ) << ", \"format\": " << jsonString( result.format )
+        << ", \"bits\": " << result.bits << ", \"frames\": " << result.frames << ", \"seconds\": " << result.seconds
+        << ", \"frames_per_s\": " << framesPerSecond
+        << ", \"gb_per_s\": " << framesPerSecond * double( result.bytesPerFrame ) / 1e9 << " }"
+        << ( i + 1 < m_aResults.size() ? "," : "" ) << "\n";
+  }
+  out << "  ]\n";
+  out << "}\n";
+  return bool( out );
+}
+
+}  // namespace
+
+int main( int argc, char* argv[] )
+{
+  CalypBench bench;
+  int iRet = bench.parse( argc, argv );
+  if( iRet == 1 )
+    return 0;
+  if( iRet < 0 )
+    return 1;
+
+  bench.run();
+  return bench.writeResults() ? 0 : 1;
+}
@@ -62,20 +62,22 @@ bool AbsoluteFrameDifferenceExample::create( std::vector<CalypFrame*> apcFrameLi
 
 CalypFrame* AbsoluteFrameDifferenceExample::process( std::vector<CalypFrame*> apcFrameList )
 {
-  CalypFrame* Input1 = apcFrameList[0];
-  CalypFrame* Input2 = apcFrameList[1];
-  ClpPel* pInput1PelYUV = Input1->getPelBufferYUV()[0][0];
-  ClpPel* pInput2PelYUV = Input2->getPelBufferYUV()[0][0];
-  ClpPel* pOutputPelYUV = m_pcFrameDifference->getPelBufferYUV()[0][0];
+  const CalypFrame* Input1 = apcFrameList[0];
+  const CalypFrame* Input2 = apcFrameList[1];
   int aux_pel_1, aux_pel_2;
 
   for( unsigned int y = 0; y < m_pcFrameDifference->getHeight(); y++ )
+  {
+    const ClpPel* pInput1PelYUV = Input1->getPelBufferYUV()[0][y];
+    const ClpPel* pInput2PelYUV = Input2->getPelBufferYUV()[0][y];
+    ClpPel* pOutputPelYUV = m_pcFrameDifference->getPelBufferYUV()[0][y];
     for( unsigned int x = 0; x < m_pcFrameDifference->getWidth(); x++ )
     {
       aux_pel_1 = *pInput1PelYUV++;
       aux_pel_2 = *pInput2PelYUV++;
       *pOutputPelYUV++ = abs( aux_pel_1 - aux_pel_2 );
     }
+  }
   return m_pcFrameDifference;
 }
 
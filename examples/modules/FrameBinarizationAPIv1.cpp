@@ -52,13 +52,16 @@ void FrameBinarizationAPIv1::create( CalypFrame* frame )
 
 CalypFrame* FrameBinarizationAPIv1::process( CalypFrame* frame )
 {
-  const ClpPel* pPelInput = frame->getPelBufferYUV()[0][0];
-  ClpPel* pPelBin = m_pcBinFrame->getPelBufferYUV()[0][0];
-  for( unsigned int y = 0; y < frame->getHeight(); y++ )
-    for( unsigned int x = 0; x < frame->getWidth(); x++ )
+  const CalypFrame* pcInputFrame = frame;
+  for( unsigned int y = 0; y < pcInputFrame->getHeight(); y++ )
+  {
+    const ClpPel* pPelInput = pcInputFrame->getPelBufferYUV()[0][y];
+    ClpPel* pPelBin = m_pcBinFrame->getPelBufferYUV()[0][y];
+    for( unsigned int x = 0; x < pcInputFrame->getWidth(); x++ )
     {
       *pPelBin++ = *pPelInput++ >= m_uiThreshold ? 255 : 0;
     }
+  }
   return m_pcBinFrame;
 }
 
@@ -0,0 +1,158 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2021  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     CalypCpuFeatures.cpp
+ * \brief    CPU feature detection used to dispatch the SIMD kernels
+ */
+
+#include "CalypCpuFeatures.h"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <string>
+
+#include "CalypDefs.h"
+#include "config.h"
+
+#if defined( USE_SSE ) && ( defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 ) )
+#define CLP_X86_SIMD 1
+#if defined( _MSC_VER )
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+constexpr std::array<std::string_view, 5> kCpuLevelNames{ "generic", "sse2", "sse4.1", "avx2", "avx512" };
+constexpr auto kBestCpuLevel = ClpCpuLevel::AVX512;
+
+/**
+ * Highest level supported by the running cpu
+ */
+auto detectCpuLevel() -> ClpCpuLevel
+{
+#ifdef CLP_X86_SIMD
+#if defined( _MSC_VER )
+  int info[4];
+  __cpuid( info, 0 );
+  const int maxLeaf = info[0];
+  __cpuid( info, 1 );
+  const bool sse2 = info[3] & ( 1 << 26 );
+  const bool sse41 = ( info[2] & ( 1 << 19 ) ) && ( info[2] & ( 1 << 9 ) );
+  const bool osxsave = info[2] & ( 1 << 27 );
+  const unsigned long long xcr0 = osxsave ? _xgetbv( 0 ) : 0;
+  bool avx2 = false;
+  bool avx512 = false;
+  if( maxLeaf >= 7 )
+  {
+    __cpuidex( info, 7, 0 );
+    avx2 = ( info[1] & ( 1 << 5 ) ) && ( xcr0 & 0x6 ) == 0x6;
+    avx512 = ( info[1] & ( 1 << 16 ) ) && ( info[1] & ( 1 << 30 ) ) && ( xcr0 & 0xE6 ) == 0xE6;
+  }
+#else
+  // libgcc also checks that the OS saves the extended registers
+  __builtin_cpu_init();
+  const bool sse2 = __builtin_cpu_supports( "sse2" );
+  const bool sse41 = __builtin_cpu_supports( "sse4.1" ) && __builtin_cpu_supports( "ssse3" );
+  const bool avx2 = __builtin_cpu_supports( "avx2" );
+  const bool avx512 = __builtin_cpu_supports( "avx512f" ) && __builtin_cpu_supports( "avx512bw" );
+#endif
+  if( avx512 && avx2 )
+    return ClpCpuLevel::AVX512;
+  if( avx2 && sse41 )
+    return ClpCpuLevel::AVX2;
+  if( sse41 && sse2 )
+    return ClpCpuLevel::SSE41;
+  if( sse2 )
+    return ClpCpuLevel::SSE2;
+#endif
+  return ClpCpuLevel::Generic;
+}
+
+auto supportedCpuLevel() -> ClpCpuLevel
+{
+  static const ClpCpuLevel level = detectCpuLevel();
+  return level;
+}
+
+auto initialCpuLevel() -> ClpCpuLevel
+{
+  ClpCpuLevel level = supportedCpuLevel();
+  if( const char* env = std::getenv( "CALYP_CPU" ) )
+  {
+    if( auto envLevel = calypFindCpuLevel( env ); envLevel && *envLevel < level )
+      level = *envLevel;
+  }
+  return level;
+}
+
+std::atomic<int> g_iCpuLevel{ -1 };
+
+}  // namespace
+
+auto calypCpuSupports( ClpCpuLevel level ) -> bool
+{
+  return level <= supportedCpuLevel();
+}
+
+auto calypCpuLevel() -> ClpCpuLevel
+{
+  int level = g_iCpuLevel.load( std::memory_order_relaxed );
+  if( level < 0 )
+  {
+    int expected = -1;
+    g_iCpuLevel.compare_exchange_strong( expected, static_cast<int>( initialCpuLevel() ) );
+    level = g_iCpuLevel.load( std::memory_order_relaxed );
+  }
+  return static_cast<ClpCpuLevel>( level );
+}
+
+auto calypSetCpuLevel( ClpCpuLevel maxLevel ) -> ClpCpuLevel
+{
+  ClpCpuLevel level = std::min( maxLevel, supportedCpuLevel() );
+  g_iCpuLevel.store( static_cast<int>( level ), std::memory_order_relaxed );
+  return level;
+}
+
+auto calypCpuLevelName( ClpCpuLevel level ) -> std::string_view
+{
+  return kCpuLevelNames.at( static_cast<std::size_t>( level ) );
+}
+
+auto calypFindCpuLevel( std::string_view name ) -> std::optional<ClpCpuLevel>
+{
+  std::string lowerName = clpLowercase( std::string( name ) );
+  for( std::size_t i = 0; i < kCpuLevelNames.size(); i++ )
+  {
+    if( kCpuLevelNames[i] == lowerName )
+      return static_cast<ClpCpuLevel>( i );
+  }
+  return {};
+}
+
+auto calypCpuLevelsList() -> std::vector<ClpCpuLevel>
+{
+  std::vector<ClpCpuLevel> levels;
+  for( int i = 0; i <= static_cast<int>( kBestCpuLevel ); i++ )
+    levels.push_back( static_cast<ClpCpuLevel>( i ) );
+  return levels;
+}
@@ -0,0 +1,73 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2021  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     CalypCpuFeatures.h
+ * \ingroup  CalypLibGrp
+ * \brief    CPU feature detection used to dispatch the SIMD kernels
+ */
+
+#ifndef __CALYPCPUFEATURES_H__
+#define __CALYPCPUFEATURES_H__
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/**
+ * \enum ClpCpuLevel
+ * \brief Instruction set levels with dedicated kernels
+ * \ingroup CalypLibGrp
+ */
+enum class ClpCpuLevel : int
+{
+  Generic = 0,  //!< Plain C++ code
+  SSE2,         //!< x86 SSE2
+  SSE41,        //!< x86 SSE4.1 (includes SSSE3)
+  AVX2,         //!< x86 AVX2
+  AVX512,       //!< x86 AVX-512 (F and BW)
+};
+
+/**
+ * Check if both the build (USE_SSE) and the running cpu support a level
+ */
+auto calypCpuSupports( ClpCpuLevel level ) -> bool;
+
+/**
+ * Get the level used by the kernels.
+ * By default it is the best level supported, the environment variable
+ * CALYP_CPU can be used to limit it (e.g., CALYP_CPU=sse2)
+ */
+auto calypCpuLevel() -> ClpCpuLevel;
+
+/**
+ * Limit the level used by the kernels
+ * @param maxLevel highest level that can be used
+ * @return the level actually in use
+ */
+auto calypSetCpuLevel( ClpCpuLevel maxLevel ) -> ClpCpuLevel;
+
+/**
+ * Conversion between levels and their names (generic, sse2, sse4.1, avx2, avx512)
+ */
+auto calypCpuLevelName( ClpCpuLevel level ) -> std::string_view;
+auto calypFindCpuLevel( std::string_view name ) -> std::optional<ClpCpuLevel>;
+auto calypCpuLevelsList() -> std::vector<ClpCpuLevel>;
+
+#endif  // __CALYPCPUFEATURES_H__
@@ -26,14 +26,22 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <type_traits>
 #include <vector>
 
 #include "CalypDefs.h"
+#include "CalypFrameKernels.h"
+#include "CalypThreadPool.h"
 #include "config.h"
 
 #ifdef USE_OPENCV
@@ -45,15 +53,184 @@
 #include "PixelFormats.h"
 #include "config.h"
 
-#define DATA_ALIGN 1  ///< use 32-bit aligned malloc/free
-#if DATA_ALIGN && _WIN32 && ( _MSC_VER > 1300 )
-#define xMalloc( len ) _aligned_malloc( len, 32 )
+constexpr std::size_t kDataAlignment = CalypFrame::getDataAlignment();  ///< alignment of each row (bytes)
+#if _WIN32 && ( _MSC_VER > 1300 )
+#define xMalloc( len ) _aligned_malloc( len, kDataAlignment )
 #define xFreeMem( ptr ) _aligned_free( ptr )
 #else
-#define xMalloc( len ) malloc( len )
-#define xFreeMem( ptr ) free( ptr )
+#define xMalloc( len ) std::aligned_alloc( kDataAlignment, len )
+#define xFreeMem( ptr ) std::free( ptr )
 #endif
 
+constexpr auto alignSize( std::size_t size ) -> std::size_t
+{
+  return ( size + kDataAlignment - 1 ) / kDataAlignment * kDataAlignment;
+}
+
+template <typename T>
+constexpr auto alignedStride( unsigned int width ) -> unsigned int
+{
+  return alignSize( width * sizeof( T ) ) / sizeof( T );
+}
+
+namespace
+{
+/**
+ * Copy a row between planes of possibly different sample types
+ */
+template <typename Dst, typename Src>
+inline void copyRow( Dst* dst, const Src* src, std::size_t n )
+{
+  if constexpr( std::is_same_v<Dst, Src> )
+    std::memcpy( dst, src, n * sizeof( Dst ) );
+  else
+    std::transform( src, src + n, dst, []( Src v ) { return static_cast<Dst>( v ); } );
+}
+
+/*
+ * Select the kernel matching the sample storage (ClpPel or ClpByte)
+ */
+inline void unpack8( const CalypFrameKernels& k, const ClpByte* src, ClpPel* dst, std::size_t n )
+{
+  k.unpack8( src, dst, n );
+}
+inline void unpack8( const CalypFrameKernels&, const ClpByte* src, ClpByte* dst, std::size_t n )
+{
+  std::memcpy( dst, src, n );
+}
+inline void unpackYUYV8( const CalypFrameKernels& k, const ClpByte* src, ClpPel* y, ClpPel* u, ClpPel* v,
+                         std::size_t n )
+{
+  k.unpackYUYV8( src, y, u, v, n );
+}
+inline void unpackYUYV8( const CalypFrameKernels& k, const ClpByte* src, ClpByte* y, ClpByte* u, ClpByte* v,
+                         std::size_t n )
+{
+  k.unpackYUYV8Byte( src, y, u, v, n );
+}
+inline void unpackPacked8( const CalypFrameKernels& k, unsigned comps, const ClpByte* src, ClpPel* const* dst,
+                           std::size_t n )
+{
+  comps == 3 ? k.unpackPacked3x8( src, dst, n ) : k.unpackPacked4x8( src, dst, n );
+}
+inline void unpackPacked8( const CalypFrameKernels& k, unsigned comps, const ClpByte* src, ClpByte* const* dst,
+                           std::size_t n )
+{
+  comps == 3 ? k.unpackPacked3x8Byte( src, dst, n ) : k.unpackPacked4x8Byte( src, dst, n );
+}
+inline void pack8( const CalypFrameKernels& k, const ClpPel* src, ClpByte* dst, std::size_t n )
+{
+  k.pack8( src, dst, n );
+}
+inline void pack8( const CalypFrameKernels&, const ClpByte* src, ClpByte* dst, std::size_t n )
+{
+  std::memcpy( dst, src, n );
+}
+inline void packYUYV8( const CalypFrameKernels& k, const ClpPel* y, const ClpPel* u, const ClpPel* v, ClpByte* dst,
+                       std::size_t n )
+{
+  k.packYUYV8( y, u, v, dst, n );
+}
+inline void packYUYV8( const CalypFrameKernels& k, const ClpByte* y, const ClpByte* u, const ClpByte* v, ClpByte* dst,
+                       std::size_t n )
+{
+  k.packYUYV8Byte( y, u, v, dst, n );
+}
+inline void packPacked8( const CalypFrameKernels& k, unsigned comps, const ClpPel* const* src, ClpByte* dst,
+                         std::size_t n )
+{
+  comps == 3 ? k.packPacked3x8( src, dst, n ) : k.packPacked4x8( src, dst, n );
+}
+inline void packPacked8( const CalypFrameKernels& k, unsigned comps, const ClpByte* const* src, ClpByte* dst,
+                         std::size_t n )
+{
+  comps == 3 ? k.packPacked3x8Byte( src, dst, n ) : k.packPacked4x8Byte( src, dst, n );
+}
+inline void yuvToArgb( const CalypFrameKernels& k, const ClpPel* y, const ClpPel* u, const ClpPel* v,
+                       std::uint32_t* dst, std::size_t width, unsigned log2ChromaWidth,
+                       const CalypYuvToRgbCoeffs& coeffs )
+{
+  k.yuvToArgb( y, u, v, dst, width, log2ChromaWidth, coeffs );
+}
+inline void yuvToArgb( const CalypFrameKernels& k, const ClpByte* y, const ClpByte* u, const ClpByte* v,
+                       std::uint32_t* dst, std::size_t width, unsigned log2ChromaWidth,
+                       const CalypYuvToRgbCoeffs& coeffs )
+{
+  k.yuvToArgbByte( y, u, v, dst, width, log2ChromaWidth, coeffs );
+}
+inline void histogram( const CalypFrameKernels& k, const ClpPel* src, std::size_t n, unsigned int* bins,
+                       std::size_t bankStride )
+{
+  k.histogram( src, n, bins, bankStride );
+}
+inline void histogram( const CalypFrameKernels& k, const ClpByte* src, std::size_t n, unsigned int* bins,
+                       std::size_t bankStride )
+{
+  k.histogramByte( src, n, bins, bankStride );
+}
+inline void rgbToLuma( const CalypFrameKernels& k, const ClpPel* r, const ClpPel* g, const ClpPel* b, ClpPel* dst,
+                       std::size_t n )
+{
+  k.rgbToLuma( r, g, b, dst, n );
+}
+inline void rgbToLuma( const CalypFrameKernels& k, const ClpByte* r, const ClpByte* g, const ClpByte* b, ClpByte* dst,
+                       std::size_t n )
+{
+  k.rgbToLumaByte( r, g, b, dst, n );
+}
+inline auto ssd( const CalypFrameKernels& k, const ClpPel* a, const ClpPel* b, std::size_t n ) -> std::uint64_t
+{
+  return k.ssd( a, b, n );
+}
+inline auto ssd( const CalypFrameKernels& k, const ClpByte* a, const ClpByte* b, std::size_t n ) -> std::uint64_t
+{
+  return k.ssdByte( a, b, n );
+}
+inline auto sad( const CalypFrameKernels& k, const ClpPel* a, const ClpPel* b, std::size_t n ) -> std::uint64_t
+{
+  return k.sad( a, b, n );
+}
+inline auto sad( const CalypFrameKernels& k, const ClpByte* a, const ClpByte* b, std::size_t n ) -> std::uint64_t
+{
+  return k.sadByte( a, b, n );
+}
+inline void ssimColumns( const CalypFrameKernels& k, const ClpPel* const* a, const ClpPel* const* b,
+                         const float* weights, std::size_t taps, std::size_t n, float* sums )
+{
+  k.ssimColumns( a, b, weights, taps, n, sums );
+}
+inline void ssimColumns( const CalypFrameKernels& k, const ClpByte* const* a, const ClpByte* const* b,
+                         const float* weights, std::size_t taps, std::size_t n, float* sums )
+{
+  k.ssimColumnsByte( a, b, weights, taps, n, sums );
+}
+
+/**
+ * Extend a region so that it starts and ends on chroma sample boundaries
+ */
+void alignToChroma( const CalypPixelFormatDescriptor& fmt, unsigned int& x, unsigned int& y, unsigned int& width,
+                    unsigned int& height )
+{
+  if( fmt.log2ChromaWidth )
+  {
+    if( x % ( 1 << fmt.log2ChromaWidth ) )
+      x--;
+    if( ( x + width ) % ( 1 << fmt.log2ChromaWidth ) )
+      width++;
+  }
+
+  if( fmt.log2ChromaHeight )
+  {
+    if( y % ( 1 << fmt.log2ChromaHeight ) )
+      y--;
+
+    if( ( y + height ) % ( 1 << fmt.log2ChromaHeight ) )
+      height++;
+  }
+}
+
+}  // namespace
+
 constexpr auto kNumBitsInByte = 8;
 constexpr auto kMinBitsPerPixel = 8;
 constexpr auto kMaxBitsPerPixel = 16;
@@ -130,6 +307,114 @@ auto CalypFrame::pixelFormatName( ClpPixelFormats idx ) -> const std::string_vie
   return g_CalypPixFmtDescriptorsMap.at( idx ).name;
 }
 
+/**
+ * Integral histogram of the tiles of a frame: the entry of tile (tx, ty)
+ * holds the histogram of all the tiles above and to the left of it,
+ * so that the histogram of any block of tiles is made of 4 entries
+ */
+struct CalypHistogramIndex
+{
+  unsigned int width{ 0 };  //!< Size of the frame the tiles cover
+  unsigned int height{ 0 };
+  unsigned int log2TileSize{ 0 };  //!< Tiles are squares of luma samples
+  unsigned int tilesX{ 0 };
+  unsigned int tilesY{ 0 };
+  std::size_t segments{ 0 };
+  std::uint64_t generation{ 0 };  //!< Generation of the samples that were counted
+  std::vector<unsigned int> bins;
+
+  //! Histogram of tiles [0, tx) x [0, ty) of a histogram channel
+  auto entry( unsigned int channel, unsigned int tx, unsigned int ty ) -> unsigned int*
+  {
+    return &bins[( ( std::size_t( channel ) * ( tilesY + 1 ) + ty ) * ( tilesX + 1 ) + tx ) * segments];
+  }
+  auto entry( unsigned int channel, unsigned int tx, unsigned int ty ) const -> const unsigned int*
+  {
+    return &bins[( ( std::size_t( channel ) * ( tilesY + 1 ) + ty ) * ( tilesX + 1 ) + tx ) * segments];
+  }
+};
+
+/**
+ * Sample planes of a frame, shared by its copies until one of them writes
+ * (copy-on-write)
+ */
+class CalypFrameStorage
+{
+public:
+  //! 8 bits frames keep their samples in ClpByte planes
+  bool m_bByteStorage{ false };
+  ClpByte*** m_pppcBytePel{ nullptr };
+
+  //! Incremented on every write, data derived from the samples keeps the value it was computed from
+  std::atomic<std::uint64_t> m_uiGeneration{ 0 };
+
+  //! ClpPel planes of the other frames
+  ClpPel*** m_pppcInputPel{ nullptr };
+
+  //! Number of frames sharing the planes (views only keep them alive)
+  std::atomic<int> m_iOwners{ 1 };
+  //! Set once a copy shares the planes, views stop writing into them from then on
+  std::atomic<bool> m_bShared{ false };
+
+  //! Views only own their row pointers, the samples belong to the planes of another frame
+  bool m_bIsView{ false };
+  std::shared_ptr<CalypFrameStorage> m_pcViewParent;
+  //! Position of the view in the planes of its parent
+  unsigned int m_uiViewX{ 0 };
+  unsigned int m_uiViewY{ 0 };
+
+  //! Tile histograms of the planes (see CalypFrame::calcHistogramIndex())
+  std::mutex m_indexMutex;
+  std::shared_ptr<const CalypHistogramIndex> m_pcHistogramIndex;
+
+  auto histogramIndex() -> std::shared_ptr<const CalypHistogramIndex>
+  {
+    std::lock_guard<std::mutex> lock( m_indexMutex );
+    return m_pcHistogramIndex;
+  }
+
+  void setHistogramIndex( std::shared_ptr<const CalypHistogramIndex> index )
+  {
+    std::lock_guard<std::mutex> lock( m_indexMutex );
+    m_pcHistogramIndex = std::move( index );
+  }
+
+  /**
+   * Generation of the samples seen through the planes,
+   * a view changes when its parents are written
+   */
+  auto generation() const -> std::uint64_t
+  {
+    std::uint64_t generation = 0;
+    for( const CalypFrameStorage* storage = this; storage; storage = storage->m_pcViewParent.get() )
+      generation += storage->m_uiGeneration.load( std::memory_order_acquire );
+    return generation;
+  }
+
+  template <typename T>
+  auto rows() -> T***
+  {
+    if constexpr( std::is_same_v<T, ClpByte> )
+      return m_pppcBytePel;
+    else
+      return m_pppcInputPel;
+  }
+
+  CalypFrameStorage() = default;
+  CalypFrameStorage( const CalypFrameStorage& ) = delete;
+  CalypFrameStorage( CalypFrameStorage&& ) = delete;
+  CalypFrameStorage& operator=( const CalypFrameStorage& ) = delete;
+  CalypFrameStorage& operator=( CalypFrameStorage&& ) = delete;
+
+  ~CalypFrameStorage()
+  {
+    if( m_pppcInputPel )
+      xFreeMem( m_pppcInputPel );  // NOLINT
+    if( m_pppcBytePel )
+      xFreeMem( m_pppcBytePel );  // NOLINT
+  }
+};
+
 class CalypFrame::CalypFramePrivate
 {
 public:
@@ -146,20 +431,41 @@ public:
   unsigned int m_uiHalfPelValue{ 0 };  //!< Bits per pixel/channel
   bool m_bHasNegativeValues{ false };  //!< Half of the scale correspond to negative values
 
-  ClpPel*** m_pppcInputPel{ nullptr };
+  std::shared_ptr<CalypFrameStorage> m_pcStorage;
+  //! Distance between rows of each channel (pixels) in the ClpByte and ClpPel planes
+  std::array<unsigned int, CalypPixel::getMaxNumberOfComponents()> m_auiByteStride{};
+  std::array<unsigned int, CalypPixel::getMaxNumberOfComponents()> m_auiStride{};
+
+  CalypColorMatrix m_eColorMatrix{ CLP_MATRIX_BT601 };
+  CalypColorRange m_eColorRange{ CLP_RANGE_FULL };
+
+  //! ClpPel copy of the byte planes built by the const accessors, kept by this frame only
+  static constexpr std::uint64_t kNoGeneration = std::numeric_limits<std::uint64_t>::max();
+  ClpPel*** m_pppcShadowPel{ nullptr };
+  std::mutex m_shadowMutex;
+  std::atomic<std::uint64_t> m_uiShadowGeneration{ kNoGeneration };
 
   bool m_bHasRGBPel{ false };            //!< Flag indicating that the ARGB buffer was computed
-  std::vector<std::uint8_t> m_pcARGB32;  //!< Buffer with the ARGB pixels used in Qt libs
+  std::uint64_t m_uiRGBGeneration{ 0 };  //!< Generation of the samples in the ARGB buffer
+  //! Buffer with the ARGB pixels used in Qt libs, shared by copies until one of them fills it again
+  std::shared_ptr<std::vector<std::uint8_t>> m_pcARGB32;
 
   /** Histogram control variables **/
   bool m_bHasHistogram{ false };
   bool m_bHistogramRunning{ false };
+  std::uint64_t m_uiHistogramGeneration{ 0 };
   /** The histogram data.*/
   std::vector<unsigned int> m_puiHistogram;
   /** If the image is RGB and calcLuma is true, we have 1 more channel */
   unsigned int m_uiHistoChannels{ 0 };
   /** Numbers of histogram segments depending of image bytes depth*/
   unsigned int m_uiHistoSegments{ 0 };
+  /** Cumulative sums of the histogram (entry i of a channel covers bins [0, i)) for the range statistics */
+  bool m_bHasHistogramSums{ false };
+  std::mutex m_histogramSumsMutex;
+  std::vector<std::uint64_t> m_auiHistogramCount;
+  std::vector<double> m_adHistogramSum;
+  std::vector<double> m_adHistogramSquares;
 
   CalypFramePrivate() = default;
   CalypFramePrivate( const CalypFramePrivate& ) = delete;
@@ -174,6 +480,74 @@ public:
 
   void init( unsigned int width, unsigned int height, ClpPixelFormats pelFormat, unsigned bitsPixel,
              bool has_negative_values )
+  {
+    initFormat( width, height, pelFormat, bitsPixel, has_negative_values );
+    for( unsigned ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+    {
+      m_auiStride[ch] = alignedStride<ClpPel>( channelWidth( ch ) );
+      m_auiByteStride[ch] = alignedStride<ClpByte>( channelWidth( ch ) );
+    }
+
+    setStorage( newStorage( m_uiBitsPel == kNumBitsInByte ) );
+    m_bInit = true;
+  }
+
+  /**
+   * Share the samples of another frame, they are only copied
+   * when one of the frames is written
+   */
+  void initShared( CalypFramePrivate& other )
+  {
+    initFormat( other.m_uiWidth, other.m_uiHeight, other.m_iPixelFormat, other.m_uiBitsPel,
+                other.m_bHasNegativeValues );
+    m_auiStride = other.m_auiStride;
+    m_auiByteStride = other.m_auiByteStride;
+    m_eColorMatrix = other.m_eColorMatrix;
+    m_eColorRange = other.m_eColorRange;
+    other.m_pcStorage->m_iOwners++;
+    other.m_pcStorage->m_bShared = true;
+    setStorage( other.m_pcStorage );
+    if( other.hasHistogram() && !other.m_bHistogramRunning )
+    {
+      m_puiHistogram = other.m_puiHistogram;
+      m_uiHistogramGeneration = other.m_uiHistogramGeneration;
+      m_bHasHistogram = true;
+    }
+    if( other.hasRGB() )
+    {
+      m_pcARGB32 = other.m_pcARGB32;
+      m_uiRGBGeneration = other.m_uiRGBGeneration;
+      m_bHasRGBPel = true;
+    }
+    m_bInit = true;
+  }
+
+  /**
+   * Setup a view of the region of parent starting at (x, y)
+   */
+  void initView( CalypFramePrivate& parent, unsigned int x, unsigned int y, unsigned int width, unsigned int height )
+  {
+    initFormat( width, height, parent.m_iPixelFormat, parent.m_uiBitsPel, parent.m_bHasNegativeValues );
+    m_auiStride = parent.m_auiStride;
+    m_auiByteStride = parent.m_auiByteStride;
+    m_eColorMatrix = parent.m_eColorMatrix;
+    m_eColorRange = parent.m_eColorRange;
+    auto storage = std::make_shared<CalypFrameStorage>();
+    storage->m_bByteStorage = parent.m_pcStorage->m_bByteStorage;
+    if( storage->m_bByteStorage )
+      storage->m_pppcBytePel = viewRows( parent.m_pcStorage->m_pppcBytePel, x, y );
+    else
+      storage->m_pppcInputPel = viewRows( parent.m_pcStorage->m_pppcInputPel, x, y );
+    storage->m_bIsView = true;
+    storage->m_pcViewParent = parent.m_pcStorage;
+    storage->m_uiViewX = x;
+    storage->m_uiViewY = y;
+    setStorage( std::move( storage ) );
+    m_bInit = true;
+  }
+
+  void initFormat( unsigned int width, unsigned int height, ClpPixelFormats pelFormat, unsigned bitsPixel,
+                   bool has_negative_values )
   {
     m_uiWidth = width;
     m_uiHeight = height;
@@ -189,54 +563,344 @@ public:
     }
 
     m_pcPelFormat = &( g_CalypPixFmtDescriptorsMap.at( pelFormat ) );
-    int iNumberChannels = m_pcPelFormat->numberChannels;
 
+    m_bHasHistogram = false;
+    m_bHistogramRunning = false;
+
+    m_uiHistoSegments = 1 << m_uiBitsPel;
+
+    if( m_pcPelFormat->colorSpace == CLP_COLOR_RGB || m_pcPelFormat->colorSpace == CLP_COLOR_RGBA )
+      m_uiHistoChannels = m_pcPelFormat->numberChannels + 1;
+    else
+      m_uiHistoChannels = m_pcPelFormat->numberChannels;
+
+    // Allocated by the first calcHistogram()
+    m_puiHistogram.clear();
+  }
+
+  unsigned int channelWidth( unsigned ch ) const
+  {
+    return CHROMASHIFT( m_uiWidth, ch > 0 ? m_pcPelFormat->log2ChromaWidth : 0 );
+  }
+
+  unsigned int channelHeight( unsigned ch ) const
+  {
+    return CHROMASHIFT( m_uiHeight, ch > 0 ? m_pcPelFormat->log2ChromaHeight : 0 );
+  }
+
+  /**
+   * Allocate the planes of all channels in a single block.
+   * Pointers to the rows come first, followed by the planes.
+   * Every row is padded to start at a kDataAlignment boundary
+   */
+  template <typename T>
+  auto allocPlanes( const std::array<unsigned int, CalypPixel::getMaxNumberOfComponents()>& stride ) -> T***
+  {
+    const unsigned numberChannels = m_pcPelFormat->numberChannels;
     std::size_t mem_size = 0;
     std::size_t num_of_ptrs = 0;
-    for( int ch = 0; ch < iNumberChannels; ch++ )
+    for( unsigned ch = 0; ch < numberChannels; ch++ )
     {
-      int ratioW = ch > 0 ? m_pcPelFormat->log2ChromaWidth : 0;
-      int ratioH = ch > 0 ? m_pcPelFormat->log2ChromaHeight : 0;
-      // Add pointers mem
-      num_of_ptrs += CHROMASHIFT( m_uiHeight, ratioH );
-      // Add pixel mem
-      mem_size += CHROMASHIFT( m_uiHeight, ratioH ) * CHROMASHIFT( m_uiWidth, ratioW ) * sizeof( ClpPel );
+      num_of_ptrs += channelHeight( ch );
+      mem_size += channelHeight( ch ) * stride[ch] * sizeof( T );
     }
-    mem_size += num_of_ptrs * sizeof( ClpPel* ) + sizeof( ClpPel** ) * iNumberChannels;
+    const std::size_t ptrs_size = alignSize( num_of_ptrs * sizeof( T* ) + sizeof( T** ) * numberChannels );
+    mem_size += ptrs_size;
 
-    m_pppcInputPel = (ClpPel***)xMalloc( mem_size );  // NOLINT
+    T*** planes = (T***)xMalloc( mem_size );  // NOLINT
+    if( !planes )
+      throw CalypFailure( "CalypFrame", "Cannot allocate the frame buffer" );
 
-    ClpPel** pelPtrMem = (ClpPel**)( m_pppcInputPel + iNumberChannels );  // NOLINT
-    ClpPel* pelMem = (ClpPel*)( pelPtrMem + num_of_ptrs );                // NOLINT
-    for( int ch = 0; ch < iNumberChannels; ch++ )
+    T** pelPtrMem = (T**)( planes + numberChannels );               // NOLINT
+    T* pelMem = (T*)( (std::uint8_t*)planes + ptrs_size );  // NOLINT
+    for( unsigned ch = 0; ch < numberChannels; ch++ )
     {
-      int ratioW = ch > 0 ? m_pcPelFormat->log2ChromaWidth : 0;
-      int ratioH = ch > 0 ? m_pcPelFormat->log2ChromaHeight : 0;
-      m_pppcInputPel[ch] = pelPtrMem;
-      for( unsigned int h = 0; h < CHROMASHIFT( m_uiHeight, ratioH ); h++ )
+      planes[ch] = pelPtrMem;
+      for( unsigned int h = 0; h < channelHeight( ch ); h++ )
       {
         *pelPtrMem = pelMem;
+        // Keep the padding deterministic for kernels reading whole vectors
+        std::fill( pelMem + channelWidth( ch ), pelMem + stride[ch], 0 );
         pelPtrMem++;
-        pelMem += CHROMASHIFT( m_uiWidth, ratioW );
+        pelMem += stride[ch];
       }
     }
+    return planes;
+  }
 
-    /* Alloc ARGB memory */
-    m_pcARGB32.resize( m_uiHeight * m_uiWidth * 4 );
+  /**
+   * Allocate new planes with the geometry of the frame
+   */
+  auto newStorage( bool byteStorage ) -> std::shared_ptr<CalypFrameStorage>
+  {
+    auto storage = std::make_shared<CalypFrameStorage>();
+    storage->m_bByteStorage = byteStorage;
+    if( byteStorage )
+      storage->m_pppcBytePel = allocPlanes<ClpByte>( m_auiByteStride );
+    else
+      storage->m_pppcInputPel = allocPlanes<ClpPel>( m_auiStride );
+    return storage;
+  }
 
+  /**
+   * Replace the planes of the frame, releasing the previous ones
+   */
+  void setStorage( std::shared_ptr<CalypFrameStorage> storage )
+  {
+    if( m_pcStorage )
+      m_pcStorage->m_iOwners--;
+    m_pcStorage = std::move( storage );
+    m_bHasRGBPel = false;
     m_bHasHistogram = false;
-    m_bHistogramRunning = false;
+    freeShadow();
+  }
 
-    m_uiHistoSegments = 1 << m_uiBitsPel;
+  bool isByteStorage() const { return m_pcStorage->m_bByteStorage; }
 
-    if( m_pcPelFormat->colorSpace == CLP_COLOR_RGB || m_pcPelFormat->colorSpace == CLP_COLOR_RGBA )
-      m_uiHistoChannels = m_pcPelFormat->numberChannels + 1;
-    else
-      m_uiHistoChannels = m_pcPelFormat->numberChannels;
+  //! The ARGB buffer and the histogram are only valid for the samples they were computed from
+  bool hasRGB() const { return m_bHasRGBPel && m_uiRGBGeneration == m_pcStorage->generation(); }
+  bool hasHistogram() const { return m_bHasHistogram && m_uiHistogramGeneration == m_pcStorage->generation(); }
 
-    m_puiHistogram.resize( m_uiHistoSegments * m_uiHistoChannels );
+  /**
+   * Allocate row pointers into the planes of another frame
+   */
+  template <typename T>
+  auto viewRows( T*** parentRows, unsigned int x, unsigned int y ) -> T***
+  {
+    const unsigned numberChannels = m_pcPelFormat->numberChannels;
+    std::size_t num_of_ptrs = numberChannels;
+    for( unsigned ch = 0; ch < numberChannels; ch++ )
+      num_of_ptrs += channelHeight( ch );
 
-    m_bInit = true;
+    T*** rows = (T***)xMalloc( alignSize( num_of_ptrs * sizeof( T* ) ) );  // NOLINT
+    if( !rows )
+      throw CalypFailure( "CalypFrame", "Cannot allocate the frame buffer" );
+
+    T** rowPtr = (T**)( rows + numberChannels );  // NOLINT
+    for( unsigned ch = 0; ch < numberChannels; ch++ )
+    {
+      const unsigned ratioW = ch > 0 ? m_pcPelFormat->log2ChromaWidth : 0;
+      const unsigned ratioH = ch > 0 ? m_pcPelFormat->log2ChromaHeight : 0;
+      rows[ch] = rowPtr;
+      for( unsigned int h = 0; h < channelHeight( ch ); h++ )
+        *rowPtr++ = parentRows[ch][( y >> ratioH ) + h] + ( x >> ratioW );
+    }
+    return rows;
+  }
+
+  /**
+   * Call f with the rows of the storage in use (ClpByte*** or ClpPel***)
+   */
+  template <typename F>
+  decltype( auto ) visitRows( F&& f )
+  {
+    if( m_pcStorage->m_bByteStorage )
+      return f( m_pcStorage->m_pppcBytePel );
+    return f( m_pcStorage->m_pppcInputPel );
+  }
+
+  /**
+   * Get the samples as ClpPel rows, widening the byte planes if needed
+   * (the copy belongs to this frame, copies sharing the planes build their own)
+   */
+  auto pelRows() -> ClpPel***
+  {
+    if( !isByteStorage() )
+      return m_pcStorage->m_pppcInputPel;
+    const std::uint64_t generation = m_pcStorage->generation();
+    if( m_uiShadowGeneration.load( std::memory_order_acquire ) == generation )
+      return m_pppcShadowPel;
+
+    std::lock_guard<std::mutex> lock( m_shadowMutex );
+    if( m_uiShadowGeneration.load( std::memory_order_relaxed ) != generation )
+    {
+      if( !m_pppcShadowPel )
+        m_pppcShadowPel = allocPlanes<ClpPel>( m_auiStride );
+      widenRows( m_pcStorage->m_pppcBytePel, m_pppcShadowPel );
+      m_uiShadowGeneration.store( generation, std::memory_order_release );
+    }
+    return m_pppcShadowPel;
+  }
+
+  void freeShadow()
+  {
+    m_uiShadowGeneration = kNoGeneration;
+    if( m_pppcShadowPel )
+      xFreeMem( m_pppcShadowPel );  // NOLINT
+    m_pppcShadowPel = nullptr;
+  }
+
+  /**
+   * ClpPel copy of a byte channel that only lives during a computation
+   */
+  struct PelChannel
+  {
+    std::vector<ClpPel> samples;
+    std::vector<ClpPel*> rows;
+  };
+
+  /**
+   * Get the ClpPel rows of a channel, widening a byte channel into copy
+   * instead of keeping a ClpPel copy of the whole frame
+   */
+  auto channelPelRows( unsigned ch, PelChannel& copy ) -> ClpPel**
+  {
+    if( !isByteStorage() )
+      return m_pcStorage->m_pppcInputPel[ch];
+    if( m_uiShadowGeneration.load( std::memory_order_acquire ) == m_pcStorage->generation() )
+      return m_pppcShadowPel[ch];
+
+    const CalypFrameKernels& kernels = calypFrameKernels();
+    const unsigned int width = channelWidth( ch );
+    const std::size_t stride = alignedStride<ClpPel>( width );
+    copy.samples.assign( stride * channelHeight( ch ), 0 );
+    copy.rows.resize( channelHeight( ch ) );
+    for( unsigned int y = 0; y < channelHeight( ch ); y++ )
+    {
+      copy.rows[y] = &copy.samples[y * stride];
+      kernels.unpack8( m_pcStorage->m_pppcBytePel[ch][y], copy.rows[y], width );
+    }
+    return copy.rows.data();
+  }
+
+  void widenRows( ClpByte*** src, ClpPel*** dst ) const
+  {
+    const CalypFrameKernels& kernels = calypFrameKernels();
+    for( unsigned ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+      for( unsigned int y = 0; y < channelHeight( ch ); y++ )
+        kernels.unpack8( src[ch][y], dst[ch][y], channelWidth( ch ) );
+  }
+
+  /**
+   * Move an 8 bits frame to ClpPel storage, so that its samples
+   * can be written through the legacy ClpPel accessors
+   * (views of 8 bits frames are detached from their parent)
+   */
+  void promoteToPel()
+  {
+    if( !isByteStorage() )
+      return;
+    // The ClpPel copy of the samples becomes the planes
+    ClpPel*** planes = pelRows();
+    m_pppcShadowPel = nullptr;
+    m_uiShadowGeneration = kNoGeneration;
+    if( m_pcStorage.use_count() > 1 )
+    {
+      // Other frames or views still read the byte planes
+      auto storage = std::make_shared<CalypFrameStorage>();
+      storage->m_pppcInputPel = planes;
+      setStorage( std::move( storage ) );
+      return;
+    }
+    CalypFrameStorage& storage = *m_pcStorage;
+    storage.m_pppcInputPel = planes;
+    xFreeMem( storage.m_pppcBytePel );  // NOLINT
+    storage.m_pppcBytePel = nullptr;
+    storage.m_bByteStorage = false;
+    // A view of a byte frame now owns a copy of the samples
+    storage.m_bIsView = false;
+    storage.m_pcViewParent.reset();
+  }
+
+  /**
+   * Check if writing the samples would change what other frames read
+   * (views write the planes of their parent until a copy shares them)
+   */
+  bool isShared() const
+  {
+    if( m_pcStorage->m_iOwners.load() > 1 )
+      return true;
+    for( const CalypFrameStorage* parent = m_pcStorage->m_pcViewParent.get(); parent;
+         parent = parent->m_pcViewParent.get() )
+    {
+      if( parent->m_bShared.load() )
+        return true;
+    }
+    return false;
+  }
+
+  /**
+   * Get planes only used by this frame before writing its samples,
+   * copying the shared ones unless they are about to be overwritten
+   * (a view becomes a regular frame)
+   */
+  void makeWritable( bool keepSamples = true )
+  {
+    if( isShared() )
+    {
+      if( m_pcStorage->m_bIsView )
+      {
+        for( unsigned ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+        {
+          m_auiStride[ch] = alignedStride<ClpPel>( channelWidth( ch ) );
+          m_auiByteStride[ch] = alignedStride<ClpByte>( channelWidth( ch ) );
+        }
+      }
+      // Overwritten 8 bits frames also go back to byte storage
+      auto storage = newStorage( keepSamples ? isByteStorage() : m_uiBitsPel == kNumBitsInByte );
+      if( keepSamples )
+      {
+        visitRows( [&]<typename T>( T*** src ) {
+          T*** dst = storage->rows<T>();
+          for( unsigned ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+            for( unsigned int y = 0; y < channelHeight( ch ); y++ )
+              copyRow( dst[ch][y], src[ch][y], channelWidth( ch ) );
+        } );
+      }
+      setStorage( std::move( storage ) );
+    }
+    markModified();
+  }
+
+  /**
+   * Invalidate everything derived from the samples
+   */
+  void markModified()
+  {
+    m_bHasRGBPel = false;
+    m_bHasHistogram = false;
+    // Views write the samples of their parents, which drops the data the parents
+    // (and their other views) derived from them
+    for( CalypFrameStorage* storage = m_pcStorage.get(); storage; storage = storage->m_pcViewParent.get() )
+    {
+      storage->m_uiGeneration++;
+      storage->setHistogramIndex( nullptr );
+    }
+  }
+
+  enum InterleavedLayout
+  {
+    LAYOUT_NONE,
+    LAYOUT_YUYV,    //!< Y0 U Y1 V (even widths only)
+    LAYOUT_PACKED,  //!< one byte per component, all components of a pixel together
+  };
+
+  /**
+   * Check if the buffer layout of the frame can be split by a
+   * dedicated kernel instead of the per component loop
+   */
+  InterleavedLayout interleavedLayout() const
+  {
+    if( m_pcPelFormat->numberPlanes != 1 || m_pcPelFormat->numberChannels < 3 )
+      return LAYOUT_NONE;
+
+    const auto& comp = m_pcPelFormat->comp;
+    if( m_pcPelFormat->numberChannels == 3 && comp[0].step_minus1 == 1 && comp[0].offset_plus1 == 1 &&
+        comp[1].step_minus1 == 3 && comp[1].offset_plus1 == 2 && comp[2].step_minus1 == 3 &&
+        comp[2].offset_plus1 == 4 )
+    {
+      return m_uiWidth % 2 == 0 ? LAYOUT_YUYV : LAYOUT_NONE;
+    }
+
+    unsigned offsetMask = 0;
+    for( unsigned ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+    {
+      if( comp[ch].step_minus1 + 1u != m_pcPelFormat->numberChannels || m_pcPelFormat->log2ChromaWidth ||
+          m_pcPelFormat->log2ChromaHeight )
+        return LAYOUT_NONE;
+      offsetMask |= 1 << ( comp[ch].offset_plus1 - 1 );
+    }
+    return offsetMask == ( 1u << m_pcPelFormat->numberChannels ) - 1 ? LAYOUT_PACKED : LAYOUT_NONE;
   }
 
   int getRealHistogramChannel( int channel )
@@ -277,14 +941,209 @@ public:
     return 0;
   }
 
+  /**
+   * Count the samples of the region [x, x + width) x [y, y + height) (luma coordinates)
+   * in the histogram channels, channel k is counted in bins + k * channelStride
+   */
+  template <typename T>
+  void countRegion( T*** rows, unsigned int x, unsigned int y, unsigned int width, unsigned int height,
+                    unsigned int* bins, std::size_t channelStride ) const
+  {
+    if( !width || !height )
+      return;
+    const CalypFrameKernels& kernels = calypFrameKernels();
+    for( unsigned ch = 0; ch < m_pcPelFormat->numberChannels; ch++ )
+    {
+      const unsigned ratioW = ch > 0 ? m_pcPelFormat->log2ChromaWidth : 0;
+      const unsigned ratioH = ch > 0 ? m_pcPelFormat->log2ChromaHeight : 0;
+      const unsigned int x0 = x >> ratioW;
+      const unsigned int x1 = CHROMASHIFT( x + width, ratioW );
+      for( unsigned int yc = y >> ratioH; yc < CHROMASHIFT( y + height, ratioH ); yc++ )
+        histogram( kernels, rows[ch][yc] + x0, x1 - x0, bins + ch * channelStride, 0 );
+    }
+    if( m_uiHistoChannels > m_pcPelFormat->numberChannels )
+    {
+      std::vector<T> luma( width );
+      unsigned int* lumaBins = bins + ( m_uiHistoChannels - 1 ) * channelStride;
+      for( unsigned int yl = y; yl < y + height; yl++ )
+      {
+        rgbToLuma( kernels, rows[CLP_COLOR_R][yl] + x, rows[CLP_COLOR_G][yl] + x, rows[CLP_COLOR_B][yl] + x,
+                   luma.data(), width );
+        histogram( kernels, luma.data(), width, lumaBins, 0 );
+      }
+    }
+  }
+
+  /**
+   * Histogram of each tile, accumulated into the integral histogram
+   */
+  auto buildHistogramIndex() -> std::shared_ptr<const CalypHistogramIndex>
+  {
+    // Smallest tiles and memory budget of the index
+    constexpr unsigned int kMinLog2TileSize = 5;
+    constexpr std::size_t kMaxIndexBytes = std::size_t( 64 ) << 20;
+
+    const auto numTiles = [&]( unsigned int size, unsigned int log2TileSize ) {
+      return ( ( size - 1 ) >> log2TileSize ) + 1;
+    };
+    const auto indexBytes = [&]( unsigned int log2TileSize ) {
+      return std::size_t( numTiles( m_uiWidth, log2TileSize ) + 1 ) * ( numTiles( m_uiHeight, log2TileSize ) + 1 ) *
+             m_uiHistoChannels * m_uiHistoSegments * sizeof( unsigned int );
+    };
+
+    auto index = std::make_shared<CalypHistogramIndex>();
+    index->width = m_uiWidth;
+    index->height = m_uiHeight;
+    index->segments = m_uiHistoSegments;
+    index->generation = m_pcStorage->generation();
+    index->log2TileSize = kMinLog2TileSize;
+    while( indexBytes( index->log2TileSize ) > kMaxIndexBytes &&
+           ( 1u << index->log2TileSize ) < std::max( m_uiWidth, m_uiHeight ) )
+      index->log2TileSize++;
+    index->tilesX = numTiles( m_uiWidth, index->log2TileSize );
+    index->tilesY = numTiles( m_uiHeight, index->log2TileSize );
+    index->bins.assign( indexBytes( index->log2TileSize ) / sizeof( unsigned int ), 0 );
+
+    const unsigned int tileSize = 1u << index->log2TileSize;
+    const std::size_t channelStride = std::size_t( index->tilesX + 1 ) * ( index->tilesY + 1 ) * index->segments;
+    visitRows( [&]<typename T>( T*** rows ) {
+      calypThreadPool().parallelFor( index->tilesY, 1, [&]( std::size_t begin, std::size_t end ) {
+        for( auto ty = static_cast<unsigned int>( begin ); ty < end; ty++ )
+        {
+          // Each tile is counted in the entry of the next one, then added along the row
+          const unsigned int y = ty << index->log2TileSize;
+          for( unsigned int tx = 0; tx < index->tilesX; tx++ )
+          {
+            const unsigned int x = tx << index->log2TileSize;
+            countRegion( rows, x, y, std::min( tileSize, m_uiWidth - x ), std::min( tileSize, m_uiHeight - y ),
+                         index->entry( 0, tx + 1, ty + 1 ), channelStride );
+          }
+          for( unsigned int ch = 0; ch < m_uiHistoChannels; ch++ )
+            for( unsigned int tx = 1; tx < index->tilesX; tx++ )
+            {
+              const unsigned int* left = index->entry( ch, tx, ty + 1 );
+              unsigned int* dst = index->entry( ch, tx + 1, ty + 1 );
+              for( std::size_t i = 0; i < index->segments; i++ )
+                dst[i] += left[i];
+            }
+        }
+      } );
+    } );
+
+    // Add the rows above
+    const std::size_t rowBins = std::size_t( index->tilesX + 1 ) * index->segments;
+    calypThreadPool().parallelFor( rowBins, index->segments, [&]( std::size_t begin, std::size_t end ) {
+      for( unsigned int ch = 0; ch < m_uiHistoChannels; ch++ )
+        for( unsigned int ty = 1; ty < index->tilesY; ty++ )
+        {
+          const unsigned int* above = index->entry( ch, 0, ty );
+          unsigned int* dst = index->entry( ch, 0, ty + 1 );
+          for( std::size_t i = begin; i < end; i++ )
+            dst[i] += above[i];
+        }
+    } );
+    return index;
+  }
+
+  /**
+   * Find the tile histograms covering the samples of the frame
+   * and the position (x, y) of the frame in them
+   */
+  auto findHistogramIndex( unsigned int& x, unsigned int& y ) const -> std::shared_ptr<const CalypHistogramIndex>
+  {
+    x = 0;
+    y = 0;
+    for( CalypFrameStorage* storage = m_pcStorage.get(); storage; storage = storage->m_pcViewParent.get() )
+    {
+      if( auto index = storage->histogramIndex(); index && index->generation == storage->generation() )
+        return index->segments == m_uiHistoSegments ? index : nullptr;
+      x += storage->m_uiViewX;
+      y += storage->m_uiViewY;
+    }
+    return nullptr;
+  }
+
+  /**
+   * Fill the histogram from the whole tiles of the index inside the frame, placed at (x, y),
+   * and the samples around them
+   * @return false if the frame does not cover any whole tile
+   */
+  bool histogramFromIndex( const CalypHistogramIndex& index, unsigned int x, unsigned int y )
+  {
+    const unsigned int log2TileSize = index.log2TileSize;
+    const unsigned int tx0 = ( x + ( 1u << log2TileSize ) - 1 ) >> log2TileSize;
+    const unsigned int ty0 = ( y + ( 1u << log2TileSize ) - 1 ) >> log2TileSize;
+    const unsigned int tx1 = x + m_uiWidth == index.width ? index.tilesX : ( x + m_uiWidth ) >> log2TileSize;
+    const unsigned int ty1 = y + m_uiHeight == index.height ? index.tilesY : ( y + m_uiHeight ) >> log2TileSize;
+    if( tx0 >= tx1 || ty0 >= ty1 )
+      return false;
+
+    const std::size_t segments = m_uiHistoSegments;
+    for( unsigned int ch = 0; ch < m_uiHistoChannels; ch++ )
+    {
+      const unsigned int* all = index.entry( ch, tx1, ty1 );
+      const unsigned int* left = index.entry( ch, tx0, ty1 );
+      const unsigned int* above = index.entry( ch, tx1, ty0 );
+      const unsigned int* corner = index.entry( ch, tx0, ty0 );
+      unsigned int* dst = &m_puiHistogram[ch * segments];
+      for( std::size_t i = 0; i < segments; i++ )
+        dst[i] = all[i] - left[i] - above[i] + corner[i];
+    }
+
+    // Borders of the frame outside the tiles
+    const unsigned int left = ( tx0 << log2TileSize ) - x;
+    const unsigned int right = std::min( tx1 << log2TileSize, index.width ) - x;
+    const unsigned int top = ( ty0 << log2TileSize ) - y;
+    const unsigned int bottom = std::min( ty1 << log2TileSize, index.height ) - y;
+    visitRows( [&]<typename T>( T*** rows ) {
+      countRegion( rows, 0, 0, m_uiWidth, top, m_puiHistogram.data(), segments );
+      countRegion( rows, 0, bottom, m_uiWidth, m_uiHeight - bottom, m_puiHistogram.data(), segments );
+      countRegion( rows, 0, top, left, bottom - top, m_puiHistogram.data(), segments );
+      countRegion( rows, right, top, m_uiWidth - right, bottom - top, m_puiHistogram.data(), segments );
+    } );
+    return true;
+  }
+
+  /**
+   * Get the offset of a histogram channel in the cumulative sums,
+   * computing them on the first call after the histogram
+   */
+  auto histogramSums( unsigned int channel ) -> std::size_t
+  {
+    std::lock_guard<std::mutex> lock( m_histogramSumsMutex );
+    const std::size_t entries = m_uiHistoSegments + 1;
+    if( !m_bHasHistogramSums )
+    {
+      m_auiHistogramCount.resize( m_uiHistoChannels * entries );
+      m_adHistogramSum.resize( m_uiHistoChannels * entries );
+      m_adHistogramSquares.resize( m_uiHistoChannels * entries );
+      for( unsigned int ch = 0; ch < m_uiHistoChannels; ch++ )
+      {
+        const unsigned int* bins = &m_puiHistogram[ch * m_uiHistoSegments];
+        std::uint64_t* count = &m_auiHistogramCount[ch * entries];
+        double* sum = &m_adHistogramSum[ch * entries];
+        double* squares = &m_adHistogramSquares[ch * entries];
+        count[0] = 0;
+        sum[0] = 0.0;
+        squares[0] = 0.0;
+        for( unsigned int i = 0; i < m_uiHistoSegments; i++ )
+        {
+          count[i + 1] = count[i] + bins[i];
+          sum[i + 1] = sum[i] + double( i ) * bins[i];
+          squares[i + 1] = squares[i] + double( i ) * i * bins[i];
+        }
+      }
+      m_bHasHistogramSums = true;
+    }
+    return channel * entries;
+  }
+
   ~CalypFramePrivate()
   {
     while( m_bHistogramRunning )
       ;
     m_bHasHistogram = false;
-
-    if( m_pppcInputPel )
-      xFreeMem( m_pppcInputPel );  // NOLINT
+    setStorage( nullptr );
   }
 };
 
@@ -320,8 +1179,14 @@ CalypFrame& CalypFrame::operator=( CalypFrame&& other ) noexcept
 
 CalypFrame::CalypFrame( const CalypFrame& other ) : d{ std::make_unique<CalypFramePrivate>() }
 {
+  if( !other.isView() )
+  {
+    d->initShared( *other.d );
+    return;
+  }
   d->init( other.getWidth(), other.getHeight(), other.getPelFormat(), other.getBitsPel(),
            other.getHasNegativeValues() );
+  setColorMatrix( other.getColorMatrix(), other.getColorRange() );
   copyFrom( &other );
 }
 
@@ -333,8 +1198,14 @@ CalypFrame& CalypFrame::operator=( const CalypFrame& other )
 
   // Copy the resource
   d = std::make_unique<CalypFramePrivate>();
+  if( !other.isView() )
+  {
+    d->initShared( *other.d );
+    return *this;
+  }
   d->init( other.getWidth(), other.getHeight(), other.getPelFormat(), other.getBitsPel(),
            other.getHasNegativeValues() );
+  setColorMatrix( other.getColorMatrix(), other.getColorRange() );
   copyFrom( &other );
 
   return *this;
@@ -344,25 +1215,9 @@ CalypFrame::CalypFrame( const CalypFrame& other, unsigned int x, unsigned int y,
                         unsigned int height )
     : d{ std::make_unique<CalypFramePrivate>() }
 {
-  const CalypPixelFormatDescriptor* pcPelFormat = &( g_CalypPixFmtDescriptorsMap.at( other.getPelFormat() ) );
-  if( pcPelFormat->log2ChromaWidth )
-  {
-    if( x % ( 1 << pcPelFormat->log2ChromaWidth ) )
-      x--;
-    if( ( x + width ) % ( 1 << pcPelFormat->log2ChromaWidth ) )
-      width++;
-  }
-
-  if( pcPelFormat->log2ChromaHeight )
-  {
-    if( y % ( 1 << pcPelFormat->log2ChromaHeight ) )
-      y--;
-
-    if( ( y + height ) % ( 1 << pcPelFormat->log2ChromaHeight ) )
-      height++;
-  }
-
+  alignToChroma( *other.d->m_pcPelFormat, x, y, width, height );
   d->init( width, height, other.getPelFormat(), other.getBitsPel() );
+  setColorMatrix( other.getColorMatrix(), other.getColorRange() );
   copyFrom( other, x, y );
 }
 
@@ -373,26 +1228,37 @@ CalypFrame::CalypFrame( const CalypFrame* other, unsigned int posX, unsigned int
   if( !other )
     return;
 
-  const CalypPixelFormatDescriptor* pcPelFormat = &( g_CalypPixFmtDescriptorsMap.at( other->getPelFormat() ) );
-  if( pcPelFormat->log2ChromaWidth )
-  {
-    if( posX % ( 1 << pcPelFormat->log2ChromaWidth ) )
-      posX--;
-    if( ( posX + areaWidth ) % ( 1 << pcPelFormat->log2ChromaWidth ) )
-      areaWidth++;
-  }
+  alignToChroma( *other->d->m_pcPelFormat, posX, posY, areaWidth, areaHeight );
+  d->init( areaWidth, areaHeight, other->getPelFormat(), other->getBitsPel() );
+  setColorMatrix( other->getColorMatrix(), other->getColorRange() );
+  copyFrom( other, posX, posY );
+}
 
-  if( pcPelFormat->log2ChromaHeight )
-  {
-    if( posY % ( 1 << pcPelFormat->log2ChromaHeight ) )
-      posY--;
+CalypFrame::CalypFrame() : d{ std::make_unique<CalypFramePrivate>() } {}
 
-    if( ( posY + areaHeight ) % ( 1 << pcPelFormat->log2ChromaHeight ) )
-      areaHeight++;
-  }
+auto CalypFrame::createView( const CalypFrame& other, unsigned int x, unsigned int y, unsigned int width,
+                             unsigned int height ) -> CalypFrame
+{
+  if( x >= other.getWidth() || y >= other.getHeight() )
+    throw CalypFailure( "CalypFrame", "The view region is outside of the frame" );
+  alignToChroma( *other.d->m_pcPelFormat, x, y, width, height );
+  width = std::min( width, other.getWidth() - x );
+  height = std::min( height, other.getHeight() - y );
 
-  d->init( areaWidth, areaHeight, other->getPelFormat(), other->getBitsPel() );
-  copyFrom( other, posX, posY );
+  CalypFrame view;
+  view.d->initView( *other.d, x, y, width, height );
+  return view;
+}
+
+auto CalypFrame::createView( const std::shared_ptr<CalypFrame>& other, unsigned int x, unsigned int y,
+                             unsigned int width, unsigned int height ) -> std::shared_ptr<CalypFrame>
+{
+  return std::make_shared<CalypFrame>( createView( *other, x, y, width, height ) );
+}
+
+bool CalypFrame::isView() const
+{
+  return d->m_pcStorage->m_bIsView;
 }
 
 CalypFrame::~CalypFrame() = default;
@@ -517,37 +1383,73 @@ std::uint64_t CalypFrame::getBytesPerFrame( unsigned int uiWidth, unsigned int u
 void CalypFrame::reset()
 {
   const ClpPel pelValue = 1 << ( d->m_uiBitsPel - 1 );
-  for( std::size_t ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
-  {
-    int ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
-    int ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
-    ClpPel* pPel = d->m_pppcInputPel[ch][0];
-    for( std::size_t i = 0; i < CHROMASHIFT( d->m_uiHeight, ratioH ) * CHROMASHIFT( d->m_uiWidth, ratioW ); i++ )
-    {
-      *pPel++ = pelValue;
-    }
-  }
+  d->makeWritable( false );
+  d->visitRows( [&]<typename T>( T*** rows ) {
+    for( unsigned ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
+      for( unsigned int y = 0; y < getHeight( ch ); y++ )
+        std::fill( rows[ch][y], rows[ch][y] + getWidth( ch ), T( pelValue ) );
+  } );
+}
+
+unsigned int CalypFrame::getSampleBytes() const
+{
+  return d->isByteStorage() ? sizeof( ClpByte ) : sizeof( ClpPel );
+}
+
+unsigned int CalypFrame::getStride( unsigned channel ) const
+{
+  return d->m_auiStride[channel];
 }
 
 ClpPel*** CalypFrame::getPelBufferYUV() const
 {
-  return d->m_pppcInputPel;
+  return d->pelRows();
 }
 
 ClpPel*** CalypFrame::getPelBufferYUV()
 {
-  d->m_bHasHistogram = false;
-  d->m_bHasRGBPel = false;
-  return d->m_pppcInputPel;
+  d->promoteToPel();
+  d->makeWritable();
+  return d->m_pcStorage->m_pppcInputPel;
+}
+
+auto CalypFrame::getPlane( unsigned channel ) const -> CalypPlaneView<const ClpPel>
+{
+  return { d->pelRows()[channel][0], getWidth( channel ), getHeight( channel ), getStride( channel ) };
+}
+
+auto CalypFrame::getPlane( unsigned channel ) -> CalypPlaneView<ClpPel>
+{
+  d->promoteToPel();
+  d->makeWritable();
+  ClpPel* plane = d->m_pcStorage->m_pppcInputPel[channel][0];
+  return { plane, getWidth( channel ), getHeight( channel ), getStride( channel ) };
+}
+
+auto CalypFrame::getBytePlane( unsigned channel ) const -> CalypPlaneView<const ClpByte>
+{
+  if( !d->isByteStorage() )
+    throw CalypFailure( "CalypFrame", "The frame samples are not stored in bytes" );
+  ClpByte* plane = d->m_pcStorage->m_pppcBytePel[channel][0];
+  return { plane, getWidth( channel ), getHeight( channel ), d->m_auiByteStride[channel] };
+}
+
+auto CalypFrame::getBytePlane( unsigned channel ) -> CalypPlaneView<ClpByte>
+{
+  if( !d->isByteStorage() )
+    throw CalypFailure( "CalypFrame", "The frame samples are not stored in bytes" );
+  d->makeWritable();
+  ClpByte* plane = d->m_pcStorage->m_pppcBytePel[channel][0];
+  return { plane, getWidth( channel ), getHeight( channel ), d->m_auiByteStride[channel] };
 }
 
 auto CalypFrame::getRGBBuffer() const -> std::optional<std::span<const std::uint8_t>>
 {
-  if( !d->m_bHasRGBPel )
+  if( !d->hasRGB() )
   {
     return std::nullopt;
   }
-  return std::span{ d->m_pcARGB32 };
+  return std::span<const std::uint8_t>{ *d->m_pcARGB32 };
 }
 
 ClpPel CalypFrame::operator()( unsigned int ch, unsigned int xPos, unsigned int yPos, bool absolute ) const
@@ -555,7 +1457,7 @@ ClpPel CalypFrame::operator()( unsigned int ch, unsigned int xPos, unsigned int
   int retValue = 0;
   if( ch < d->m_pcPelFormat->numberChannels )
   {
-    retValue = d->m_pppcInputPel[ch][yPos][xPos];
+    retValue = d->visitRows( [&]( auto rows ) -> int { return rows[ch][yPos][xPos]; } );
     if( !absolute && d->m_bHasNegativeValues )
       retValue = retValue - int( d->m_uiHalfPelValue );
   }
@@ -576,7 +1478,8 @@ CalypPixel CalypFrame::getPixel( unsigned int xPos, unsigned int yPos ) const
   {
     int ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
     int ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
-    PixelValue[ch] = d->m_pppcInputPel[ch][( yPos >> ratioH )][( xPos >> ratioW )];
+    PixelValue[ch] =
+        d->visitRows( [&]( auto rows ) -> ClpPel { return rows[ch][( yPos >> ratioH )][( xPos >> ratioW )]; } );
   }
   return PixelValue;
 }
@@ -588,24 +1491,38 @@ CalypPixel CalypFrame::getPixel( unsigned int xPos, unsigned int yPos, CalypColo
 
 void CalypFrame::setPixel( unsigned int xPos, unsigned int yPos, CalypPixel pixel )
 {
+  d->makeWritable();
   for( unsigned int ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
   {
     int ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
     int ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
-    d->m_pppcInputPel[ch][( yPos >> ratioH )][( xPos >> ratioW )] = pixel[ch];
+    d->visitRows( [&]<typename T>( T*** rows ) { rows[ch][( yPos >> ratioH )][( xPos >> ratioW )] = T( pixel[ch] ); } );
   }
-  d->m_bHasHistogram = false;
-  d->m_bHasRGBPel = false;
 }
 
 void CalypFrame::copyFrom( const CalypFrame& other )
 {
   if( !haveSameFmt( other, MATCH_COLOR_SPACE | MATCH_BYTES_PER_FRAME | MATCH_BITS ) )
     return;
-  d->m_bHasRGBPel = false;
-  d->m_bHasHistogram = false;
-  memcpy( &( d->m_pppcInputPel[0][0][0] ), &( other.getPelBufferYUV()[0][0][0] ),
-          getTotalNumberOfPixels() * sizeof( ClpPel ) );
+  d->makeWritable();
+  d->visitRows( [&]<typename T>( T*** dst ) {
+    other.d->visitRows( [&]<typename S>( S*** src ) {
+      for( unsigned int ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
+      {
+        const unsigned int width = getWidth( ch );
+        const unsigned int otherWidth = other.getWidth( ch );
+        if( width == otherWidth )
+        {
+          for( unsigned int y = 0; y < getHeight( ch ); y++ )
+            copyRow( dst[ch][y], src[ch][y], width );
+          continue;
+        }
+        // Same number of pixels with a different geometry: copy in raster order
+        for( std::uint64_t i = 0; i < std::min( getPixels( ch ), other.getPixels( ch ) ); i++ )
+          dst[ch][i / width][i % width] = T( src[ch][i / otherWidth][i % otherWidth] );
+      }
+    } );
+  } );
 }
 
 void CalypFrame::copyFrom( const CalypFrame* other )
@@ -619,19 +1536,18 @@ void CalypFrame::copyFrom( const CalypFrame& other, unsigned x, unsigned y )
   if( !haveSameFmt( other, MATCH_COLOR_SPACE | MATCH_BITS ) )
     return;
   // TODO: Protect width and height
-  ClpPel*** pInput = other.getPelBufferYUV();
-  for( unsigned int ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
-  {
-    int ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
-    int ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
-    for( unsigned int i = 0; i < CHROMASHIFT( d->m_uiHeight, ratioH ); i++ )
-    {
-      memcpy( &( d->m_pppcInputPel[ch][i][0] ), &( pInput[ch][( y >> ratioH ) + i][( x >> ratioW )] ),
-              ( d->m_uiWidth >> ratioW ) * sizeof( ClpPel ) );
-    }
-  }
-  d->m_bHasRGBPel = false;
-  d->m_bHasHistogram = false;
+  d->makeWritable();
+  d->visitRows( [&]( auto dst ) {
+    other.d->visitRows( [&]( auto src ) {
+      for( unsigned int ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
+      {
+        int ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
+        int ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
+        for( unsigned int i = 0; i < CHROMASHIFT( d->m_uiHeight, ratioH ); i++ )
+          copyRow( dst[ch][i], &( src[ch][( y >> ratioH ) + i][( x >> ratioW )] ), d->m_uiWidth >> ratioW );
+      }
+    } );
+  } );
 }
 
 void CalypFrame::copyFrom( const CalypFrame* other, unsigned x, unsigned y )
@@ -644,21 +1560,20 @@ void CalypFrame::copyTo( const CalypFrame& other, unsigned x, unsigned y ) const
 {
   if( !haveSameFmt( other, MATCH_COLOR_SPACE | MATCH_PEL_FMT | MATCH_BITS ) )
     return;
-  ClpPel*** pInput = other.getPelBufferYUV();
   unsigned width = other.getWidth();
   // TODO: Protect width and height
-  for( unsigned int ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
-  {
-    int ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
-    int ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
-    for( unsigned int i = 0; i < other.getHeight( ch ); i++ )
-    {
-      memcpy( &( d->m_pppcInputPel[ch][( y >> ratioH ) + i][( x >> ratioW )] ), &( pInput[ch][i][0] ),
-              ( width >> ratioW ) * sizeof( ClpPel ) );
-    }
-  }
-  d->m_bHasRGBPel = false;
-  d->m_bHasHistogram = false;
+  d->makeWritable();
+  d->visitRows( [&]( auto dst ) {
+    other.d->visitRows( [&]( auto src ) {
+      for( unsigned int ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
+      {
+        int ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
+        int ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
+        for( unsigned int i = 0; i < other.getHeight( ch ); i++ )
+          copyRow( &( dst[ch][( y >> ratioH ) + i][( x >> ratioW )] ), src[ch][i], width >> ratioW );
+      }
+    } );
+  } );
 }
 
 void CalypFrame::copyTo( const CalypFrame* other, unsigned x, unsigned y ) const
@@ -677,14 +1592,17 @@ void CalypFrame::frameFromBuffer( std::span<const ClpByte> Buff, int iEndianness
 
 void CalypFrame::frameFromBuffer( std::span<const ClpByte> Buff, int iEndianness )
 {
+  const CalypPixelFormatDescriptor* pcFmt = d->m_pcPelFormat;
+  const CalypFrameKernels& kernels = calypFrameKernels();
   std::array<const ClpByte*, CalypPixel::getMaxNumberOfComponents()> ppBuff{ nullptr };
   int bytesPixel = ( d->m_uiBitsPel - 1 ) / kNumBitsInByte + 1;
   int startByte = 0;
   int endByte = bytesPixel;
   int incByte = 1;
   int maxval = ( 1 << d->m_uiBitsPel ) - 1;
+  bool bigEndian = iEndianness == CLP_BIG_ENDIAN;
 
-  if( iEndianness == CLP_BIG_ENDIAN )
+  if( bigEndian )
   {
     startByte = bytesPixel - 1;
     endByte = -1;
@@ -694,51 +1612,139 @@ void CalypFrame::frameFromBuffer( std::span<const ClpByte> Buff, int iEndianness
   ppBuff[0] = Buff.data();
   for( std::size_t i = 1; i < CalypPixel::getMaxNumberOfComponents(); i++ )
   {
-    int ratioW = i > 1 ? d->m_pcPelFormat->log2ChromaWidth : 0;
-    int ratioH = i > 1 ? d->m_pcPelFormat->log2ChromaHeight : 0;
+    int ratioW = i > 1 ? pcFmt->log2ChromaWidth : 0;
+    int ratioH = i > 1 ? pcFmt->log2ChromaHeight : 0;
     ppBuff[i] = ppBuff[i - 1] + CHROMASHIFT( d->m_uiHeight, ratioH ) * CHROMASHIFT( d->m_uiWidth, ratioW ) * bytesPixel;
   }
 
-  memset( d->m_pppcInputPel[0][0], 0, getTotalNumberOfPixels() * sizeof( ClpPel ) );
+  d->makeWritable( false );
+
+  d->visitRows( [&]<typename T>( T*** rows ) {
+    // Interleaved 8 bits formats are split in a single pass
+    if( bytesPixel == 1 )
+    {
+      switch( d->interleavedLayout() )
+      {
+      case CalypFramePrivate::LAYOUT_YUYV:
+        for( unsigned int y = 0; y < d->m_uiHeight; y++ )
+        {
+          unpackYUYV8( kernels, ppBuff[0] + y * d->m_uiWidth * 2, rows[CLP_LUMA][y], rows[CLP_CHROMA_U][y],
+                       rows[CLP_CHROMA_V][y], getWidth( CLP_CHROMA_U ) );
+        }
+        return;
+      case CalypFramePrivate::LAYOUT_PACKED:
+      {
+        std::array<T*, CalypPixel::getMaxNumberOfComponents()> dst{ nullptr };
+        for( unsigned int y = 0; y < d->m_uiHeight; y++ )
+        {
+          const ClpByte* pBuffLine = ppBuff[0] + std::size_t( y ) * d->m_uiWidth * pcFmt->numberChannels;
+          for( std::size_t ch = 0; ch < pcFmt->numberChannels; ch++ )
+            dst[pcFmt->comp[ch].offset_plus1 - 1] = rows[ch][y];
+          unpackPacked8( kernels, pcFmt->numberChannels, pBuffLine, dst.data(), d->m_uiWidth );
+        }
+        return;
+      }
+      default:
+        break;
+      }
+    }
+
+    for( std::size_t ch = 0; ch < pcFmt->numberChannels; ch++ )
+    {
+      unsigned step = pcFmt->comp[ch].step_minus1 * bytesPixel;
+
+      const ClpByte* pTmpBuff = ppBuff[pcFmt->comp[ch].plane] + ( pcFmt->comp[ch].offset_plus1 - 1 ) * bytesPixel;
+      const unsigned int width = getWidth( ch );
+
+      for( unsigned int y = 0; y < getHeight( ch ); y++ )
+      {
+        T* pPel = rows[ch][y];
+        if( step == 0 )
+        {
+          if( bytesPixel == 1 )
+            unpack8( kernels, pTmpBuff, pPel, width );
+          else if constexpr( std::is_same_v<T, ClpPel> )
+            kernels.unpack16( pTmpBuff, pPel, width, bigEndian, ClpPel( maxval ) );
+          pTmpBuff += width * bytesPixel;
+          continue;
+        }
+
+        for( unsigned int x = 0; x < width; x++ )
+        {
+          int value = 0;
+          for( int b = startByte; b != endByte; b += incByte )
+          {
+            value += *pTmpBuff << ( b * kNumBitsInByte );
+            pTmpBuff++;
+          }
+          // Check max value and bound it to "maxval" to prevent segfault when
+          // calculating histogram
+          pPel[x] = value > maxval ? 0 : T( value );
+          pTmpBuff += step;
+        }
+      }
+    }
+  } );
+}
+
+void CalypFrame::frameFromPlanes( std::span<const CalypPlaneSource> planes, int iEndianness, unsigned int shift )
+{
+  const unsigned numberChannels = d->m_pcPelFormat->numberChannels;
+  if( planes.size() < numberChannels )
+    throw CalypFailure( "CalypFrame", "Missing planes to fill the frame" );
 
-  for( std::size_t ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
-  {
-    int ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
-    int ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
-    unsigned step = d->m_pcPelFormat->comp[ch].step_minus1 * bytesPixel;
+  const CalypFrameKernels& kernels = calypFrameKernels();
+  const unsigned bytesPixel = ( d->m_uiBitsPel - 1 ) / kNumBitsInByte + 1;
+  const bool bigEndian = iEndianness == CLP_BIG_ENDIAN;
+  const unsigned maxval = ( 1u << d->m_uiBitsPel ) - 1;
 
-    ClpPel* pPel = d->m_pppcInputPel[ch][0];
-    const ClpByte* pTmpBuff =
-        ppBuff[d->m_pcPelFormat->comp[ch].plane] + ( d->m_pcPelFormat->comp[ch].offset_plus1 - 1 ) * bytesPixel;
+  d->makeWritable( false );
 
-    for( std::size_t p = 0; p < CHROMASHIFT( d->m_uiHeight, ratioH ) * CHROMASHIFT( d->m_uiWidth, ratioW ); p++ )
+  d->visitRows( [&]<typename T>( T*** rows ) {
+    for( unsigned ch = 0; ch < numberChannels; ch++ )
     {
-      for( int b = startByte; b != endByte; b += incByte )
+      const CalypPlaneSource& plane = planes[ch];
+      const unsigned int width = getWidth( ch );
+      for( unsigned int y = 0; y < getHeight( ch ); y++ )
       {
-        pPel[p] += *pTmpBuff << ( b * kNumBitsInByte );
-        pTmpBuff++;
+        const ClpByte* src = plane.data + std::ptrdiff_t( y ) * plane.stride;
+        T* dst = rows[ch][y];
+        if( plane.step == 1 && shift == 0 )
+        {
+          if( bytesPixel == 1 )
+            unpack8( kernels, src, dst, width );
+          else if constexpr( std::is_same_v<T, ClpPel> )
+            kernels.unpack16( src, dst, width, bigEndian, ClpPel( maxval ) );
+          continue;
+        }
+        for( unsigned int x = 0; x < width; x++ )
+        {
+          const ClpByte* sample = src + std::size_t( x ) * plane.step * bytesPixel;
+          unsigned value = sample[0];
+          if( bytesPixel > 1 )
+            value = bigEndian ? ( value << kNumBitsInByte ) | sample[1] : value | ( sample[1] << kNumBitsInByte );
+          value >>= shift;
+          // Same bound as frameFromBuffer()
+          dst[x] = value > maxval ? 0 : T( value );
+        }
       }
-      // Check max value and bound it to "maxval" to prevent segfault when
-      // calculating histogram
-      if( pPel[p] > maxval )
-        pPel[p] = 0;
-      pTmpBuff += step;
     }
-  }
-  d->m_bHasRGBPel = false;
-  d->m_bHasHistogram = false;
+  } );
 }
 
 void CalypFrame::frameToBuffer( std::span<ClpByte> output_buffer, int iEndianness ) const
 {
+  const CalypPixelFormatDescriptor* pcFmt = d->m_pcPelFormat;
+  const CalypFrameKernels& kernels = calypFrameKernels();
   const int bytesPixel = ( d->m_uiBitsPel - 1 ) / kNumBitsInByte + 1;
   std::array<ClpByte*, CalypPixel::getMaxNumberOfComponents()> ppBuff{ nullptr };
 
   int startByte = 0;
   int endByte = bytesPixel;
   int incByte = 1;
+  bool bigEndian = iEndianness == CLP_BIG_ENDIAN;
 
-  if( iEndianness == CLP_BIG_ENDIAN )
+  if( bigEndian )
   {
     startByte = bytesPixel - 1;
     endByte = -1;
@@ -748,32 +1754,74 @@ void CalypFrame::frameToBuffer( std::span<ClpByte> output_buffer, int iEndiannes
   ppBuff[0] = output_buffer.data();
   for( std::size_t i = 1; i < CalypPixel::getMaxNumberOfComponents(); i++ )
   {
-    int ratioW = i > 1 ? d->m_pcPelFormat->log2ChromaWidth : 0;
-    int ratioH = i > 1 ? d->m_pcPelFormat->log2ChromaHeight : 0;
+    int ratioW = i > 1 ? pcFmt->log2ChromaWidth : 0;
+    int ratioH = i > 1 ? pcFmt->log2ChromaHeight : 0;
     ppBuff[i] = ppBuff[i - 1] + CHROMASHIFT( d->m_uiHeight, ratioH ) * CHROMASHIFT( d->m_uiWidth, ratioW ) * bytesPixel;
   }
 
-  for( std::size_t ch = 0; ch < d->m_pcPelFormat->numberChannels; ch++ )
-  {
-    int ratioW = ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0;
-    int ratioH = ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0;
-    int step = ( d->m_pcPelFormat->comp[ch].step_minus1 ) * bytesPixel;
-
-    ClpPel* pTmpPel = d->m_pppcInputPel[ch][0];
-    ClpByte* pTmpBuff =
-        ppBuff[d->m_pcPelFormat->comp[ch].plane] + ( d->m_pcPelFormat->comp[ch].offset_plus1 - 1 ) * bytesPixel;
+  d->visitRows( [&]<typename T>( T*** rows ) {
+    // Interleaved 8 bits formats are merged in a single pass
+    if( bytesPixel == 1 )
+    {
+      switch( d->interleavedLayout() )
+      {
+      case CalypFramePrivate::LAYOUT_YUYV:
+        for( unsigned int y = 0; y < d->m_uiHeight; y++ )
+        {
+          packYUYV8( kernels, rows[CLP_LUMA][y], rows[CLP_CHROMA_U][y], rows[CLP_CHROMA_V][y],
+                     ppBuff[0] + y * d->m_uiWidth * 2, getWidth( CLP_CHROMA_U ) );
+        }
+        return;
+      case CalypFramePrivate::LAYOUT_PACKED:
+      {
+        std::array<const T*, CalypPixel::getMaxNumberOfComponents()> src{ nullptr };
+        for( unsigned int y = 0; y < d->m_uiHeight; y++ )
+        {
+          ClpByte* pBuffLine = ppBuff[0] + std::size_t( y ) * d->m_uiWidth * pcFmt->numberChannels;
+          for( std::size_t ch = 0; ch < pcFmt->numberChannels; ch++ )
+            src[pcFmt->comp[ch].offset_plus1 - 1] = rows[ch][y];
+          packPacked8( kernels, pcFmt->numberChannels, src.data(), pBuffLine, d->m_uiWidth );
+        }
+        return;
+      }
+      default:
+        break;
+      }
+    }
 
-    for( std::size_t i = 0; i < CHROMASHIFT( d->m_uiHeight, ratioH ) * CHROMASHIFT( d->m_uiWidth, ratioW ); i++ )
+    for( std::size_t ch = 0; ch < pcFmt->numberChannels; ch++ )
     {
-      for( int b = startByte; b != endByte; b += incByte )
+      int step = pcFmt->comp[ch].step_minus1 * bytesPixel;
+
+      ClpByte* pTmpBuff = ppBuff[pcFmt->comp[ch].plane] + ( pcFmt->comp[ch].offset_plus1 - 1 ) * bytesPixel;
+      const unsigned int width = getWidth( ch );
+
+      for( unsigned int y = 0; y < getHeight( ch ); y++ )
       {
-        *pTmpBuff = *pTmpPel >> ( kNumBitsInByte * b );
-        pTmpBuff++;
+        const T* pTmpPel = rows[ch][y];
+        if( step == 0 )
+        {
+          if( bytesPixel == 1 )
+            pack8( kernels, pTmpPel, pTmpBuff, width );
+          else if constexpr( std::is_same_v<T, ClpPel> )
+            kernels.pack16( pTmpPel, pTmpBuff, width, bigEndian );
+          pTmpBuff += width * bytesPixel;
+          continue;
+        }
+
+        for( unsigned int x = 0; x < width; x++ )
+        {
+          for( int b = startByte; b != endByte; b += incByte )
+          {
+            *pTmpBuff = *pTmpPel >> ( kNumBitsInByte * b );
+            pTmpBuff++;
+          }
+          pTmpPel++;
+          pTmpBuff += step;
+        }
       }
-      pTmpPel++;
-      pTmpBuff += step;
     }
-  }
+  } );
 }
 
 template <typename T>
@@ -788,160 +1836,115 @@ inline constexpr auto convert_to_pel_argb( const T r, const T g, const T b ) ->
   return convert_to_pel_argb<T>( 0xffu, r, g, b );  // NOLINT
 }
 
-template <typename T>
-inline constexpr void convert_yuv_to_rgb( const T iY, const T iU, const T iV, T& iR, T& iG, T& iB )
+void CalypFrame::setColorMatrix( CalypColorMatrix matrix, CalypColorRange range )
 {
-  auto clamp_pel_value = []( auto X ) {
-    if( X < 0 )
-      return 0;
-    if( X > 255 )
-      return 255;
-    return X;
-  };
-
-  iR = iY + ( ( 1436 * ( iV - 128 ) ) >> 10 );
-  iG = iY - ( ( 352 * ( iU - 128 ) + 731 * ( iV - 128 ) ) >> 10 );
-  iB = iY + ( ( 1812 * ( iU - 128 ) ) >> 10 );
-  iR = clamp_pel_value( iR );
-  iG = clamp_pel_value( iG );
-  iB = clamp_pel_value( iB );
+  if( matrix == d->m_eColorMatrix && range == d->m_eColorRange )
+    return;
+  d->m_eColorMatrix = matrix;
+  d->m_eColorRange = range;
+  d->m_bHasRGBPel = false;
 }
 
-void fillRGBBufferYUV420p( ClpPel*** pppInputPel, uint32_t* pARGB, unsigned uiWidth, unsigned uiHeight, int shiftBits )
+auto CalypFrame::getColorMatrix() const -> CalypColorMatrix
 {
-  ClpPel* pY = pppInputPel[CLP_LUMA][0];
-  ClpPel* pU = pppInputPel[CLP_CHROMA_U][0];
-  ClpPel* pV = pppInputPel[CLP_CHROMA_V][0];
+  return d->m_eColorMatrix;
+}
 
-  for( unsigned y = 0; y < uiHeight; y += 2 )
-  {
-    for( unsigned x = 0; x < uiWidth; x += 2 )
-    {
-      int iR, iG, iB;  // NOLINT
-      int iY = pY[y * uiWidth + x] >> shiftBits;
-      int iU = pU[y * uiWidth / 4 + x / 2] >> shiftBits;
-      int iV = pV[y * uiWidth / 4 + x / 2] >> shiftBits;
-      convert_yuv_to_rgb( iY, iU, iV, iR, iG, iB );
-      pARGB[y * uiWidth + x] = convert_to_pel_argb( iR, iG, iB );
-
-      iY = pY[y * uiWidth + x + 1] >> shiftBits;
-      convert_yuv_to_rgb( iY, iU, iV, iR, iG, iB );
-      pARGB[y * uiWidth + x + 1] = convert_to_pel_argb( iR, iG, iB );
-
-      iY = pY[y * uiWidth + uiWidth + x] >> shiftBits;
-      convert_yuv_to_rgb( iY, iU, iV, iR, iG, iB );
-      pARGB[y * uiWidth + uiWidth + x] = convert_to_pel_argb( iR, iG, iB );
-
-      iY = pY[y * uiWidth + uiWidth + x + 1] >> shiftBits;
-      convert_yuv_to_rgb( iY, iU, iV, iR, iG, iB );
-      pARGB[y * uiWidth + uiWidth + x + 1] = convert_to_pel_argb( iR, iG, iB );
-    }
-  }
+auto CalypFrame::getColorRange() const -> CalypColorRange
+{
+  return d->m_eColorRange;
 }
 
 void CalypFrame::fillRGBBuffer( std::optional<std::size_t> channel ) const
 {
+  // Minimum number of rows converted by each thread
+  constexpr std::size_t kMinRowsPerBand = 16;
+
   auto shiftBits = static_cast<int>( d->m_uiBitsPel ) - 8;
+  const std::size_t width = d->m_uiWidth;
 
   d->m_bHasRGBPel = true;
-  // 4 bytes for A, R, G and B
-  uint32_t* pARGB = (uint32_t*)d->m_pcARGB32.data();
-  if( d->m_pcPelFormat->colorSpace == CLP_COLOR_GRAY || ( channel.has_value() && *channel == 0 ) )
-  {
-    ClpPel* pY = d->m_pppcInputPel[0][0];
-    for( unsigned int i = 0; i < d->m_uiHeight * d->m_uiWidth; i++ )
+  d->m_uiRGBGeneration = d->m_pcStorage->generation();
+  // 4 bytes for A, R, G and B, the copies keep the buffer they share
+  if( d->m_pcARGB32.use_count() != 1 )
+    d->m_pcARGB32 = std::make_shared<std::vector<std::uint8_t>>();
+  d->m_pcARGB32->resize( std::size_t( d->m_uiHeight ) * width * 4 );
+  uint32_t* pARGB = (uint32_t*)d->m_pcARGB32->data();
+  d->visitRows( [&]<typename T>( T*** rows ) {
+    if( d->m_pcPelFormat->colorSpace == CLP_COLOR_GRAY || ( channel.has_value() && *channel == 0 ) )
     {
-      unsigned char finalPel = ( *pY++ ) >> shiftBits;
-      *pARGB++ = convert_to_pel_argb( finalPel, finalPel, finalPel );
+      calypThreadPool().parallelFor( d->m_uiHeight, kMinRowsPerBand, [&]( std::size_t begin, std::size_t end ) {
+        for( std::size_t y = begin; y < end; y++ )
+        {
+          const T* pY = rows[0][y];
+          uint32_t* pDst = pARGB + y * width;
+          for( std::size_t x = 0; x < width; x++ )
+          {
+            unsigned char finalPel = ( *pY++ ) >> shiftBits;
+            *pDst++ = convert_to_pel_argb( finalPel, finalPel, finalPel );
+          }
+        }
+      } );
     }
-  }
-  else if( channel.has_value() && *channel > 0 )
-  {
-    ClpPel* pLine = d->m_pppcInputPel[*channel][0];
-    for( unsigned y = 0; y < CHROMASHIFT( d->m_uiHeight, d->m_pcPelFormat->log2ChromaHeight ); y++ )
+    else if( channel.has_value() && *channel > 0 )
     {
-      for( int i = 0; i < 1 << d->m_pcPelFormat->log2ChromaHeight; i++ )
+      for( unsigned y = 0; y < CHROMASHIFT( d->m_uiHeight, d->m_pcPelFormat->log2ChromaHeight ); y++ )
       {
-        ClpPel* pPel = pLine;
-        for( unsigned x = 0; x < CHROMASHIFT( d->m_uiWidth, d->m_pcPelFormat->log2ChromaWidth ); x++ )
+        const T* pLine = rows[*channel][y];
+        for( int i = 0; i < 1 << d->m_pcPelFormat->log2ChromaHeight; i++ )
         {
-          unsigned char finalPel = ( *pPel++ ) >> shiftBits;
-          for( int j = 0; j < ( 1 << d->m_pcPelFormat->log2ChromaWidth ); j++ )
+          const T* pPel = pLine;
+          for( unsigned x = 0; x < CHROMASHIFT( d->m_uiWidth, d->m_pcPelFormat->log2ChromaWidth ); x++ )
           {
-            *pARGB++ = convert_to_pel_argb( finalPel, finalPel, finalPel );
+            unsigned char finalPel = ( *pPel++ ) >> shiftBits;
+            for( int j = 0; j < ( 1 << d->m_pcPelFormat->log2ChromaWidth ); j++ )
+            {
+              *pARGB++ = convert_to_pel_argb( finalPel, finalPel, finalPel );
+            }
           }
         }
       }
-      pLine += CHROMASHIFT( d->m_uiWidth, d->m_pcPelFormat->log2ChromaWidth );
-    }
-  }
-  else if( d->m_pcPelFormat->colorSpace == CLP_COLOR_RGB )
-  {
-    ClpPel* pR = d->m_pppcInputPel[CLP_COLOR_R][0];
-    ClpPel* pG = d->m_pppcInputPel[CLP_COLOR_G][0];
-    ClpPel* pB = d->m_pppcInputPel[CLP_COLOR_B][0];
-    for( unsigned int i = 0; i < d->m_uiHeight * d->m_uiWidth; i++ )
-      *pARGB++ = convert_to_pel_argb( ( *pR++ ) >> shiftBits, ( *pG++ ) >> shiftBits, ( *pB++ ) >> shiftBits );
-  }
-  else if( d->m_pcPelFormat->colorSpace == CLP_COLOR_RGBA )
-  {
-    ClpPel* pR = d->m_pppcInputPel[CLP_COLOR_R][0];
-    ClpPel* pG = d->m_pppcInputPel[CLP_COLOR_G][0];
-    ClpPel* pB = d->m_pppcInputPel[CLP_COLOR_B][0];
-    ClpPel* pA = d->m_pppcInputPel[CLP_COLOR_A][0];
-    for( unsigned int i = 0; i < d->m_uiHeight * d->m_uiWidth; i++ )
-      *pARGB++ = convert_to_pel_argb( ( *pA++ ) >> shiftBits, ( *pR++ ) >> shiftBits, ( *pG++ ) >> shiftBits,
-                                      ( *pB++ ) >> shiftBits );
-  }
-  else if( d->m_pcPelFormat->colorSpace == CLP_COLOR_YUV )
-  {
-    if( d->m_iPixelFormat == ClpPixelFormats::YUV420p )
-    {
-      fillRGBBufferYUV420p( d->m_pppcInputPel, pARGB, d->m_uiWidth, d->m_uiHeight, shiftBits );
-      return;
     }
-    ClpPel* pLineY = d->m_pppcInputPel[CLP_LUMA][0];
-    ClpPel* pLineU = d->m_pppcInputPel[CLP_CHROMA_U][0];
-    ClpPel* pLineV = d->m_pppcInputPel[CLP_CHROMA_V][0];
-    unsigned int uiChromaStride = CHROMASHIFT( d->m_uiWidth, d->m_pcPelFormat->log2ChromaWidth );
-
-    int iR, iG, iB;  // NOLINT
-    uint32_t* pARGBLine = pARGB;
-
-    for( unsigned y = 0; y < CHROMASHIFT( d->m_uiHeight, d->m_pcPelFormat->log2ChromaHeight ); y++ )
+    else if( d->m_pcPelFormat->colorSpace == CLP_COLOR_RGB || d->m_pcPelFormat->colorSpace == CLP_COLOR_RGBA )
     {
-      for( int i = 0; i < 1 << d->m_pcPelFormat->log2ChromaHeight; i++ )
-      {
-        ClpPel* pY = pLineY;
-        ClpPel* pU = pLineU;
-        ClpPel* pV = pLineV;
-        uint32_t* pARGBAux = pARGBLine;
-        for( unsigned x = 0; x < CHROMASHIFT( d->m_uiWidth, d->m_pcPelFormat->log2ChromaWidth ); x++ )
+      const bool hasAlpha = d->m_pcPelFormat->colorSpace == CLP_COLOR_RGBA;
+      calypThreadPool().parallelFor( d->m_uiHeight, kMinRowsPerBand, [&]( std::size_t begin, std::size_t end ) {
+        for( std::size_t y = begin; y < end; y++ )
         {
-          int iU = *pU++;
-          iU >>= shiftBits;
-          int iV = *pV++;
-          iV >>= shiftBits;
-          for( int j = 0; j < ( 1 << d->m_pcPelFormat->log2ChromaWidth ); j++ )
+          const T* pR = rows[CLP_COLOR_R][y];
+          const T* pG = rows[CLP_COLOR_G][y];
+          const T* pB = rows[CLP_COLOR_B][y];
+          const T* pA = hasAlpha ? rows[CLP_COLOR_A][y] : nullptr;
+          uint32_t* pDst = pARGB + y * width;
+          for( std::size_t x = 0; x < width; x++ )
           {
-            int iY = *pY++;
-            iY >>= shiftBits;
-            convert_yuv_to_rgb( iY, iU, iV, iR, iG, iB );
-            *pARGBAux++ = convert_to_pel_argb( iR, iG, iB );
+            const int alpha = hasAlpha ? ( *pA++ ) >> shiftBits : 0xFF;
+            *pDst++ = convert_to_pel_argb( alpha, ( *pR++ ) >> shiftBits, ( *pG++ ) >> shiftBits,
+                                           ( *pB++ ) >> shiftBits );
           }
         }
-        pLineY += d->m_uiWidth;
-        pARGBLine += d->m_uiWidth;
-      }
-      pLineU += uiChromaStride;
-      pLineV += uiChromaStride;
+      } );
     }
-  }
+    else if( d->m_pcPelFormat->colorSpace == CLP_COLOR_YUV )
+    {
+      const CalypFrameKernels& kernels = calypFrameKernels();
+      const CalypYuvToRgbCoeffs coeffs = calypYuvToRgbCoeffs( d->m_eColorMatrix, d->m_eColorRange, d->m_uiBitsPel );
+      const unsigned int log2ChromaWidth = d->m_pcPelFormat->log2ChromaWidth;
+      const unsigned int log2ChromaHeight = d->m_pcPelFormat->log2ChromaHeight;
+      calypThreadPool().parallelFor( d->m_uiHeight, kMinRowsPerBand, [&]( std::size_t begin, std::size_t end ) {
+        for( std::size_t y = begin; y < end; y++ )
+        {
+          yuvToArgb( kernels, rows[CLP_LUMA][y], rows[CLP_CHROMA_U][y >> log2ChromaHeight],
+                     rows[CLP_CHROMA_V][y >> log2ChromaHeight], pARGB + y * width, width, log2ChromaWidth, coeffs );
+        }
+      } );
+    }
+  } );
 }
 
 void CalypFrame::fillRGBBuffer() const
 {
-  if( d->m_bHasRGBPel )
+  if( d->hasRGB() )
     return;
 
   fillRGBBuffer( {} );
@@ -953,40 +1956,91 @@ void CalypFrame::fillRGBBuffer() const
 
 void CalypFrame::calcHistogram()
 {
-  if( d->m_bHasHistogram || d->m_puiHistogram.empty() )
+  if( !d->m_bInit || d->hasHistogram() )
     return;
 
   d->m_bHistogramRunning = true;
+  d->m_bHasHistogramSums = false;
+  d->m_uiHistogramGeneration = d->m_pcStorage->generation();
 
-  std::fill( d->m_puiHistogram.begin(), d->m_puiHistogram.end(), 0 );
+  d->m_puiHistogram.assign( std::size_t( d->m_uiHistoSegments ) * d->m_uiHistoChannels, 0 );
 
-  unsigned int numberChannels = d->m_pcPelFormat->numberChannels;
-  for( unsigned int ch = 0; ch < numberChannels; ch++ )
+  unsigned int indexX{ 0 };
+  unsigned int indexY{ 0 };
+  if( auto index = d->findHistogramIndex( indexX, indexY ) )
   {
-    unsigned int size = CHROMASHIFT( d->m_uiWidth, ch > 0 ? d->m_pcPelFormat->log2ChromaWidth : 0 ) *
-                        CHROMASHIFT( d->m_uiHeight, ch > 0 ? d->m_pcPelFormat->log2ChromaHeight : 0 );
-
-    ClpPel* chPel = &( d->m_pppcInputPel[ch][0][0] );
-    for( unsigned int i = 0; i < size; i++ )
+    if( d->histogramFromIndex( *index, indexX, indexY ) )
     {
-      d->m_puiHistogram[*chPel + ch * d->m_uiHistoSegments]++;
-      chPel++;
+      d->m_bHasHistogram = true;
+      d->m_bHistogramRunning = false;
+      return;
     }
   }
 
-  if( d->m_pcPelFormat->colorSpace == CLP_COLOR_RGB || d->m_pcPelFormat->colorSpace == CLP_COLOR_RGBA )
-  {
-    for( unsigned int y = 0; y < d->m_uiHeight; y++ )
-      for( unsigned int x = 0; x < d->m_uiWidth; x++ )
+  // Minimum number of chroma rows counted by each thread
+  constexpr std::size_t kMinRowsPerBand = 16;
+  // Sub-histograms only pay off while they fit in the cache
+  constexpr unsigned int kMaxBankedBits = 12;
+
+  const CalypFrameKernels& kernels = calypFrameKernels();
+  const unsigned int numberChannels = d->m_pcPelFormat->numberChannels;
+  const bool hasLuma = d->m_pcPelFormat->colorSpace == CLP_COLOR_RGB || d->m_pcPelFormat->colorSpace == CLP_COLOR_RGBA;
+  const unsigned int log2ChromaHeight = d->m_pcPelFormat->log2ChromaHeight;
+  const std::size_t segments = d->m_uiHistoSegments;
+  const std::size_t numBanks = d->m_uiBitsPel <= kMaxBankedBits ? kCalypHistogramBanks : 1;
+  const std::size_t bankStride = numBanks > 1 ? segments : 0;
+  const std::size_t channelBins = numBanks * segments;
+
+  std::mutex mergeMutex;
+  d->visitRows( [&]<typename T>( T*** rows ) {
+    // Bands cover the same region of all the channels
+    const std::size_t chromaRows = CHROMASHIFT( d->m_uiHeight, log2ChromaHeight );
+    calypThreadPool().parallelFor( chromaRows, kMinRowsPerBand, [&]( std::size_t begin, std::size_t end ) {
+      std::vector<unsigned int> bins( d->m_uiHistoChannels * channelBins, 0 );
+      for( unsigned int ch = 0; ch < numberChannels; ch++ )
       {
-        ClpPel luma = getPixel( x, y ).convertPixel( CLP_COLOR_YUV )[0];
-        d->m_puiHistogram[luma + ( d->m_uiHistoChannels - 1 ) * d->m_uiHistoSegments]++;
+        const unsigned int ratioH = ch > 0 ? log2ChromaHeight : 0;
+        const std::size_t lastRow = std::min<std::size_t>( end << ( log2ChromaHeight - ratioH ), getHeight( ch ) );
+        for( std::size_t y = begin << ( log2ChromaHeight - ratioH ); y < lastRow; y++ )
+          histogram( kernels, rows[ch][y], getWidth( ch ), &bins[ch * channelBins], bankStride );
       }
-  }
+      if( hasLuma )
+      {
+        std::vector<T> luma( d->m_uiWidth );
+        unsigned int* lumaBins = &bins[( d->m_uiHistoChannels - 1 ) * channelBins];
+        for( std::size_t y = begin; y < end; y++ )
+        {
+          rgbToLuma( kernels, rows[CLP_COLOR_R][y], rows[CLP_COLOR_G][y], rows[CLP_COLOR_B][y], luma.data(),
+                     d->m_uiWidth );
+          histogram( kernels, luma.data(), d->m_uiWidth, lumaBins, bankStride );
+        }
+      }
+
+      std::lock_guard<std::mutex> lock( mergeMutex );
+      for( unsigned int ch = 0; ch < d->m_uiHistoChannels; ch++ )
+      {
+        unsigned int* dst = &d->m_puiHistogram[ch * segments];
+        for( std::size_t bank = 0; bank < numBanks; bank++ )
+        {
+          const unsigned int* src = &bins[ch * channelBins + bank * segments];
+          for( std::size_t i = 0; i < segments; i++ )
+            dst[i] += src[i];
+        }
+      }
+    } );
+  } );
+
   d->m_bHasHistogram = true;
   d->m_bHistogramRunning = false;
 }
 
+void CalypFrame::calcHistogramIndex()
+{
+  if( auto index = d->m_pcStorage->histogramIndex(); index && index->generation == d->m_pcStorage->generation() )
+    return;
+  d->m_pcStorage->setHistogramIndex( d->buildHistogramIndex() );
+}
+
 int CalypFrame::getNumHistogramSegment() const
 {
   return d->m_uiHistoSegments;
@@ -994,7 +2048,7 @@ int CalypFrame::getNumHistogramSegment() const
 
 unsigned int CalypFrame::getMinimumPelValue( unsigned channel ) const
 {
-  if( !d->m_bHasHistogram )
+  if( !d->hasHistogram() )
     return 0;
 
   channel = d->getRealHistogramChannel( channel );
@@ -1026,7 +2080,7 @@ unsigned int CalypFrame::getMinimumPelValue( unsigned channel ) const
 
 unsigned int CalypFrame::getMaximumPelValue( unsigned channel ) const
 {
-  if( !d->m_bHasHistogram )
+  if( !d->hasHistogram() )
     return 0;
 
   channel = d->getRealHistogramChannel( channel );
@@ -1058,7 +2112,7 @@ unsigned int CalypFrame::getMaximumPelValue( unsigned channel ) const
 
 unsigned int CalypFrame::getNEBins( unsigned channel ) const
 {
-  if( !d->m_bHasHistogram )
+  if( !d->hasHistogram() )
     return 0;
 
   channel = d->getRealHistogramChannel( channel );
@@ -1091,7 +2145,7 @@ unsigned int CalypFrame::getNEBins( unsigned channel ) const
 
 unsigned int CalypFrame::getMaximum( unsigned channel ) const
 {
-  if( !d->m_bHasHistogram )
+  if( !d->hasHistogram() )
     return 0;
 
   channel = d->getRealHistogramChannel( channel );
@@ -1124,44 +2178,34 @@ unsigned int CalypFrame::getMaximum( unsigned channel ) const
 
 unsigned int CalypFrame::getNumPixelsRange( unsigned channel, unsigned int start, unsigned int end ) const
 {
-  if( !d->m_bHasHistogram || start < 0 || end > d->m_uiHistoSegments - 1 || start > end )
+  if( !d->hasHistogram() || start < 0 || end > d->m_uiHistoSegments - 1 || start > end )
   {
     return 0;
   }
   channel = d->getRealHistogramChannel( channel );
-  if( channel < 0 )
+  if( channel >= d->m_uiHistoChannels )
   {
     return 0;
   }
 
-  unsigned int count = 0;
-  int indexStart{ 0 };
-  indexStart = channel * d->m_uiHistoSegments;
-  for( unsigned int i = start; i <= end; i++ )
-  {
-    count += d->m_puiHistogram[indexStart + i];
-  }
-  return count;
+  const std::uint64_t* count = &d->m_auiHistogramCount[d->histogramSums( channel )];
+  return static_cast<unsigned int>( count[end + 1] - count[start] );
 }
 
 double CalypFrame::getMean( unsigned channel, unsigned int start, unsigned int end ) const
 {
-  if( !d->m_bHasHistogram || start < 0 || end > d->m_uiHistoSegments - 1 || start > end )
+  if( !d->hasHistogram() || start < 0 || end > d->m_uiHistoSegments - 1 || start > end )
   {
     return 0.0;
   }
   channel = d->getRealHistogramChannel( channel );
-  if( channel < 0 )
+  if( channel >= d->m_uiHistoChannels )
   {
     return 0.0;
   }
 
-  double mean{ 0.0 };
-  int indexStart = channel * d->m_uiHistoSegments;
-  for( unsigned int i = start; i <= end; i++ )
-  {
-    mean += i * d->m_puiHistogram[indexStart + i];
-  }
+  const std::size_t sums = d->histogramSums( channel );
+  double mean = d->m_adHistogramSum[sums + end + 1] - d->m_adHistogramSum[sums + start];
 
   auto count = getNumPixelsRange( channel, start, end );
 
@@ -1175,47 +2219,42 @@ double CalypFrame::getMean( unsigned channel, unsigned int start, unsigned int e
 
 int CalypFrame::getMedian( unsigned channel, unsigned int start, unsigned int end ) const
 {
-  if( !d->m_bHasHistogram || start < 0 || end > d->m_uiHistoSegments - 1 || start > end )
+  if( !d->hasHistogram() || start < 0 || end > d->m_uiHistoSegments - 1 || start > end )
   {
     return 0;
   }
 
   channel = d->getRealHistogramChannel( channel );
-  if( channel < 0 )
+  if( channel >= d->m_uiHistoChannels )
   {
     return 0;
   }
 
-  double sum = 0.0;
-  int indexStart = channel * d->m_uiHistoSegments;
-  double count = getNumPixelsRange( channel, start, end );
-  for( unsigned int i = start; i <= end; i++ )
-  {
-    sum += d->m_puiHistogram[indexStart + i];
-    if( sum * 2 > count )
-      return i;
-  }
+  // First bin where the cumulative count goes above half of the range
+  const std::uint64_t* count = &d->m_auiHistogramCount[d->histogramSums( channel )];
+  const std::uint64_t half = count[start] + ( count[end + 1] - count[start] ) / 2;
+  const std::uint64_t* bin = std::upper_bound( count + start + 1, count + end + 2, half );
+  if( bin == count + end + 2 )
+    return 0;
 
-  return 0;
+  return static_cast<int>( bin - count ) - 1;
 }
 
 double CalypFrame::getStdDev( unsigned channel, unsigned int start, unsigned int end ) const
 {
-  if( !d->m_bHasHistogram || start < 0 || end > d->m_uiHistoSegments - 1 || start > end )
+  if( !d->hasHistogram() || start < 0 || end > d->m_uiHistoSegments - 1 || start > end )
   {
     return 0.0;
   }
 
   channel = d->getRealHistogramChannel( channel );
-  if( channel < 0 )
+  if( channel >= d->m_uiHistoChannels )
   {
     return 0.0;
   }
 
-  int indexStart = channel * d->m_uiHistoSegments;
   double mean = getMean( channel, start, end );
   double count = getNumPixelsRange( channel, start, end );
-  double dev = 0.0;
   if( count == 0.0 )
     count = 1.0;
 
@@ -1230,17 +2269,15 @@ double CalypFrame::getStdDev( unsigned channel, unsigned int start, unsigned int
 
      -----------------------*/
 
-  for( unsigned int i = start; i <= end; i++ )
-  {
-    dev += ( i * i ) * d->m_puiHistogram[indexStart + i];
-  }
+  const std::size_t sums = d->histogramSums( channel );
+  double dev = d->m_adHistogramSquares[sums + end + 1] - d->m_adHistogramSquares[sums + start];
 
   return sqrt( ( dev - count * mean * mean ) / ( count - 1 ) );
 }
 
 double CalypFrame::getHistogramValue( unsigned channel, unsigned int bin ) const
 {
-  if( !d->m_bHasHistogram || bin < 0 || bin > d->m_uiHistoSegments - 1 )
+  if( !d->hasHistogram() || bin < 0 || bin > d->m_uiHistoSegments - 1 )
     return 0.0;
 
   channel = d->getRealHistogramChannel( channel );
@@ -1255,7 +2292,7 @@ double CalypFrame::getHistogramValue( unsigned channel, unsigned int bin ) const
 
 double CalypFrame::getEntropy( unsigned channel, unsigned int start, unsigned int end ) const
 {
-  if( !d->m_bHasHistogram )
+  if( !d->hasHistogram() )
     return 0;
 
   channel = d->getRealHistogramChannel( channel );
@@ -1347,13 +2384,18 @@ bool CalypFrame::toMat( cv::Mat& cvMat, bool convertToGray, bool scale, unsigned
   else
   {
     unsigned char* cv_data = cvMat.data;
-    ClpPel* pel = getPelBufferYUV()[channel][0];
-    for( unsigned y = 0; y < imgHeight * imgWidth; y++ )
-    {
-      ClpPel currPel = static_cast<ClpPel>( *pel++ * scaleFactor );
-      for( auto b = 0; b < numBytes; b++ )
-        *cv_data++ = currPel >> ( kNumBitsInByte * b );
-    }
+    d->visitRows( [&]<typename T>( T*** rows ) {
+      for( unsigned y = 0; y < imgHeight; y++ )
+      {
+        const T* pel = rows[channel][y];
+        for( unsigned x = 0; x < imgWidth; x++ )
+        {
+          ClpPel currPel = static_cast<ClpPel>( *pel++ * scaleFactor );
+          for( auto b = 0; b < numBytes; b++ )
+            *cv_data++ = currPel >> ( kNumBitsInByte * b );
+        }
+      }
+    } );
   }
   bRet = true;
 #endif
@@ -1389,8 +2431,7 @@ bool CalypFrame::fromMat( cv::Mat& cvMat, int channel )
     d->init( cvMat.cols, cvMat.rows, d->m_iPixelFormat, d->m_uiBitsPel );
   }
 
-  d->m_bHasRGBPel = false;
-  d->m_bHasHistogram = false;
+  d->makeWritable();
 
   if( channel >= 0 )
     numChannels = 1;
@@ -1437,14 +2478,19 @@ bool CalypFrame::fromMat( cv::Mat& cvMat, int channel )
   else
   {
     unsigned char* cv_data = cvMat.data;
-    ClpPel* pel = getPelBufferYUV()[channel][0];
-    for( unsigned int y = 0; y < imgHeight * imgWidth; y++ )
-    {
-      ClpPel curr_pel{ 0 };
-      for( unsigned b = 0; b < numBytes; b++ )
-        curr_pel += ( *cv_data++ ) << ( kNumBitsInByte * b );
-      *pel++ = curr_pel;
-    }
+    d->visitRows( [&]<typename T>( T*** rows ) {
+      for( unsigned int y = 0; y < imgHeight; y++ )
+      {
+        T* pel = rows[channel][y];
+        for( unsigned int x = 0; x < imgWidth; x++ )
+        {
+          ClpPel curr_pel{ 0 };
+          for( unsigned b = 0; b < numBytes; b++ )
+            curr_pel += ( *cv_data++ ) << ( kNumBitsInByte * b );
+          *pel++ = T( curr_pel );
+        }
+      }
+    } );
   }
 
   bRet = true;
@@ -1478,166 +2524,446 @@ std::vector<std::string> CalypFrame::supportedQualityMetricsUnitsList()
   };
 }
 
-double CalypFrame::getQuality( int Metric, CalypFrame* Org, unsigned int component )
+namespace
 {
-  if( component >= getNumberChannels() )
+// SSIM stabilising constants, relative to the peak sample value (Wang et al.)
+constexpr double kSsimK1 = 0.01;
+constexpr double kSsimK2 = 0.03;
+// Minimum number of window rows computed by each thread
+constexpr std::size_t kMinSsimRowsPerBand = 8;
+
+/**
+ * SSIM of a window from the sums of its samples
+ */
+inline auto windowSsim( double sumA, double sumB, double sumAA, double sumBB, double sumAB, double numPixels,
+                        double c1, double c2 ) -> double
+{
+  const double meanA = sumA / numPixels;
+  const double meanB = sumB / numPixels;
+  const double varA = ( sumAA - sumA * meanA ) / numPixels;
+  const double varB = ( sumBB - sumB * meanB ) / numPixels;
+  const double covAB = ( sumAB - sumA * meanB ) / numPixels;
+  return ( ( 2.0 * meanA * meanB + c1 ) * ( 2.0 * covAB + c2 ) ) /
+         ( ( meanA * meanA + meanB * meanB + c1 ) * ( varA + varB + c2 ) );
+}
+
+/**
+ * Sum of the SSIM of the non-overlapping windows of the window row wy (as in the JM reference software).
+ * The columns of the window row are summed first, then each window adds its columns.
+ * sums is a scratch buffer of 5 * columns elements
+ */
+template <typename T>
+auto ssimWindowRow( T** ref, T** enc, unsigned int columns, unsigned int window, std::size_t wy, double c1,
+                    double c2, std::uint64_t* sums ) -> double
+{
+  std::uint64_t* sumA = sums;
+  std::uint64_t* sumB = sumA + columns;
+  std::uint64_t* sumAA = sumB + columns;
+  std::uint64_t* sumBB = sumAA + columns;
+  std::uint64_t* sumAB = sumBB + columns;
+  std::fill( sums, sums + 5 * std::size_t( columns ), 0 );
+  for( std::size_t y = wy * window; y < ( wy + 1 ) * window; y++ )
+  {
+    const T* a = ref[y];
+    const T* b = enc[y];
+    for( unsigned int x = 0; x < columns; x++ )
+    {
+      const std::uint64_t sampleA = a[x];
+      const std::uint64_t sampleB = b[x];
+      sumA[x] += sampleA;
+      sumB[x] += sampleB;
+      sumAA[x] += sampleA * sampleA;
+      sumBB[x] += sampleB * sampleB;
+      sumAB[x] += sampleA * sampleB;
+    }
+  }
+  double ssim = 0.0;
+  for( unsigned int x = 0; x < columns; x += window )
   {
-    return 0;
+    std::uint64_t windowSums[5] = {};
+    for( unsigned int i = x; i < x + window; i++ )
+    {
+      windowSums[0] += sumA[i];
+      windowSums[1] += sumB[i];
+      windowSums[2] += sumAA[i];
+      windowSums[3] += sumBB[i];
+      windowSums[4] += sumAB[i];
+    }
+    ssim += windowSsim( double( windowSums[0] ), double( windowSums[1] ), double( windowSums[2] ),
+                        double( windowSums[3] ), double( windowSums[4] ), double( window * window ), c1, c2 );
   }
-  switch( Metric )
-  {
-  case PSNR_METRIC:
-    return getPSNR( Org, component );
-    break;
-  case MSE_METRIC:
-    return getMSE( Org, component );
-    break;
-  case SSIM_METRIC:
-    return getSSIM( Org, component );
-    break;
-  case WSPSNR_METRIC:
-    return getWSPNR( Org, component );
-    break;
-  default:
-    assert( 0 );
-  };
-  return 0;
+  return ssim;
 }
 
-double CalypFrame::getMSE( CalypFrame* Org, unsigned int component )
+/**
+ * Mean SSIM from the sums of each window row
+ */
+auto meanSsim( const std::vector<double>& rowSsim, unsigned int windowsX ) -> double
+{
+  double ssim = 0.0;
+  for( double row : rowSsim )
+    ssim += row;
+  ssim /= double( windowsX ) * rowSsim.size();
+  // avoid float accuracy problem at very low QP(e.g.2)
+  if( ssim >= 1.0 && ssim < 1.01 )
+    ssim = 1.0;
+  return ssim;
+}
+
+/**
+ * Mean SSIM of non-overlapping square windows
+ */
+template <typename T>
+auto blockSsim( T** ref, T** enc, unsigned int width, unsigned int height, unsigned int window, double peak )
+    -> double
+{
+  window = std::min( { window, width, height } );
+  const double c1 = ( kSsimK1 * peak ) * ( kSsimK1 * peak );
+  const double c2 = ( kSsimK2 * peak ) * ( kSsimK2 * peak );
+  const unsigned int windowsX = width / window;
+  const unsigned int columns = windowsX * window;
+
+  std::vector<double> rowSsim( height / window );
+  calypThreadPool().parallelFor( rowSsim.size(), kMinSsimRowsPerBand, [&]( std::size_t begin, std::size_t end ) {
+    std::vector<std::uint64_t> sums( 5 * std::size_t( columns ) );
+    for( std::size_t wy = begin; wy < end; wy++ )
+      rowSsim[wy] = ssimWindowRow( ref, enc, columns, window, wy, c1, c2, sums.data() );
+  } );
+  return meanSsim( rowSsim, windowsX );
+}
+
+/**
+ * Mean SSIM of 11x11 gaussian windows (sigma 1.5) centred on each sample away from the borders.
+ * The window is separable: each row of results filters the columns of 11 rows and then
+ * filters that row horizontally (see CalypFrameKernels::ssimColumns and ssimRow)
+ */
+template <typename T>
+auto gaussianSsim( T** ref, T** enc, unsigned int width, unsigned int height, double peak ) -> double
 {
-  ClpPel* pPelYUV = getPelBufferYUV()[component][0];
-  ClpPel* pOrgPelYUV = Org->getPelBufferYUV()[component][0];
-  std::uint64_t numberOfPixels = Org->getHeight( component ) * Org->getWidth( component );
-  std::uint64_t ssd = 0;
-  for( unsigned int i = 0; i < numberOfPixels; i++ )
+  constexpr unsigned int kTaps = 11;
+  constexpr double kSigma = 1.5;
+  if( width < kTaps || height < kTaps )
+    return blockSsim( ref, enc, width, height, kTaps, peak );
+
+  std::array<float, kTaps> weights{};
+  double weightSum = 0.0;
+  for( unsigned int k = 0; k < kTaps; k++ )
   {
-    int diff = int( *pPelYUV++ ) - int( *pOrgPelYUV++ );
-    ssd += diff * diff;
+    const double dist = double( k ) - ( kTaps - 1 ) / 2;
+    weightSum += std::exp( -dist * dist / ( 2.0 * kSigma * kSigma ) );
   }
-  if( ssd == 0.0 )
+  for( unsigned int k = 0; k < kTaps; k++ )
   {
-    return 0.0;
+    const double dist = double( k ) - ( kTaps - 1 ) / 2;
+    weights[k] = static_cast<float>( std::exp( -dist * dist / ( 2.0 * kSigma * kSigma ) ) / weightSum );
   }
-  return double( ssd ) / double( numberOfPixels );
+
+  const auto c1 = static_cast<float>( ( kSsimK1 * peak ) * ( kSsimK1 * peak ) );
+  const auto c2 = static_cast<float>( ( kSsimK2 * peak ) * ( kSsimK2 * peak ) );
+  const unsigned int outWidth = width - kTaps + 1;
+  const unsigned int outHeight = height - kTaps + 1;
+
+  const CalypFrameKernels& kernels = calypFrameKernels();
+  std::vector<double> rowSsim( outHeight );
+  calypThreadPool().parallelFor( outHeight, kMinSsimRowsPerBand, [&]( std::size_t begin, std::size_t end ) {
+    std::vector<float> sums( 5 * std::size_t( width ) );
+    for( std::size_t y = begin; y < end; y++ )
+    {
+      ssimColumns( kernels, ref + y, enc + y, weights.data(), kTaps, width, sums.data() );
+      rowSsim[y] = kernels.ssimRow( sums.data(), width, outWidth, weights.data(), kTaps, c1, c2 );
+    }
+  } );
+
+  double ssim = 0.0;
+  for( double row : rowSsim )
+    ssim += row;
+  return ssim / ( double( outWidth ) * outHeight );
 }
 
-double CalypFrame::getPSNR( CalypFrame* Org, unsigned int component )
+/**
+ * Weight of each row of an equirectangular frame in the WS-PSNR,
+ * computed once for each height
+ */
+auto wsPsnrRowWeights( unsigned int height ) -> std::shared_ptr<const std::vector<double>>
 {
-  std::uint64_t uiMaxValue = ( 1 << Org->getBitsPel() ) - 1;
-  double dPSNR = 100;
-  double dMSE = getMSE( Org, component );
-  if( dMSE != 0 )
-    dPSNR = 10 * log10( double( uiMaxValue * uiMaxValue ) / dMSE );
-  return dPSNR;
+  static std::mutex cacheMutex;
+  static std::map<unsigned int, std::shared_ptr<const std::vector<double>>> cache;
+  std::lock_guard<std::mutex> lock( cacheMutex );
+  auto& weights = cache[height];
+  if( !weights )
+  {
+    auto table = std::make_shared<std::vector<double>>( height );
+    for( unsigned y = 0; y < height; y++ )
+      ( *table )[y] = cos( double( ( y + 0.5 - height / 2.0 ) * S_PI / height ) );
+    weights = std::move( table );
+  }
+  return weights;
 }
 
-float compute_ssim( ClpPel** refImg, ClpPel** encImg, int width, int height, int win_width, int win_height,
-                    int max_pel_value_comp, int overlapSize )
-{
-  static const float K1 = 0.01f, K2 = 0.03f;
-  float max_pix_value_sqd;
-  float C1, C2;
-  float win_pixels = (float)( win_width * win_height );
-#ifdef UNBIASED_VARIANCE
-  float win_pixels_bias = win_pixels - 1;
-#else
-  float win_pixels_bias = win_pixels;
-#endif
-  float mb_ssim, meanOrg, meanEnc;
-  float varOrg, varEnc, covOrgEnc;
-  int imeanOrg, imeanEnc, ivarOrg, ivarEnc, icovOrgEnc;
-  float cur_distortion = 0.0;
-  int i, j, n, m, win_cnt = 0;
+}  // namespace
 
-  max_pix_value_sqd = (float)( max_pel_value_comp * max_pel_value_comp );
-  C1 = K1 * K1 * max_pix_value_sqd;
-  C2 = K2 * K2 * max_pix_value_sqd;
+auto CalypFrame::computeQuality( CalypFrame* Org, const std::vector<int>& metrics,
+                                 const std::vector<unsigned int>& components ) -> QualityResults
+{
+  QualityResults results;
+  for( int metric : metrics )
+    if( metric >= 0 && metric < NUMBER_METRICS )
+      results.hasMetric[metric] = true;
+  const bool needSsd =
+      results.hasMetric[PSNR_METRIC] || results.hasMetric[MSE_METRIC] || results.hasMetric[WSPSNR_METRIC];
+  const bool needSsim = results.hasMetric[SSIM_METRIC];
 
-  for( j = 0; j <= height - win_height; j += overlapSize )
+  const CalypFrameKernels& kernels = calypFrameKernels();
+  const double peak = ( 1 << Org->getBitsPel() ) - 1;
+  const double c1 = ( kSsimK1 * peak ) * ( kSsimK1 * peak );
+  const double c2 = ( kSsimK2 * peak ) * ( kSsimK2 * peak );
+  for( unsigned int component : components )
   {
-    for( i = 0; i <= width - win_width; i += overlapSize )
-    {
-      imeanOrg = 0;
-      imeanEnc = 0;
-      ivarOrg = 0;
-      ivarEnc = 0;
-      icovOrgEnc = 0;
+    if( component >= getNumberChannels() || component >= CalypPixel::getMaxNumberOfComponents() )
+      continue;
+    results.hasComponent[component] = true;
 
-      for( n = j; n < j + win_height; n++ )
-      {
-        for( m = i; m < i + win_width; m++ )
+    const unsigned int width = getWidth( component );
+    const unsigned int height = getHeight( component );
+    if( !width || !height )
+      continue;
+    const unsigned int window = std::min( { component == CLP_LUMA ? 8u : 4u, width, height } );
+    const unsigned int windowsX = width / window;
+    const unsigned int columns = windowsX * window;
+    const std::size_t windowsY = height / window;
+
+    // Each band of window rows computes the SSD of its rows and the SSIM of its windows,
+    // the last band also takes the rows below the last window row
+    std::vector<std::uint64_t> rowSsd( needSsd ? height : 0 );
+    std::vector<double> rowSsim( needSsim ? windowsY : 0 );
+    const auto evaluate = [&]<typename T>( T** rows, T** orgRows ) {
+      calypThreadPool().parallelFor( windowsY, kMinSsimRowsPerBand, [&]( std::size_t begin, std::size_t end ) {
+        std::vector<std::uint64_t> sums( needSsim ? 5 * std::size_t( columns ) : 0 );
+        for( std::size_t wy = begin; wy < end; wy++ )
         {
-          imeanOrg += refImg[n][m];
-          imeanEnc += encImg[n][m];
-          ivarOrg += refImg[n][m] * refImg[n][m];
-          ivarEnc += encImg[n][m] * encImg[n][m];
-          icovOrgEnc += refImg[n][m] * encImg[n][m];
+          if( needSsd )
+            for( std::size_t y = wy * window; y < ( wy + 1 ) * window; y++ )
+              rowSsd[y] = ssd( kernels, rows[y], orgRows[y], width );
+          if( needSsim )
+            rowSsim[wy] = ssimWindowRow( rows, orgRows, columns, window, wy, c1, c2, sums.data() );
         }
-      }
-
-      meanOrg = (float)imeanOrg / win_pixels;
-      meanEnc = (float)imeanEnc / win_pixels;
-
-      varOrg = ( (float)ivarOrg - ( (float)imeanOrg ) * meanOrg ) / win_pixels_bias;
-      varEnc = ( (float)ivarEnc - ( (float)imeanEnc ) * meanEnc ) / win_pixels_bias;
-      covOrgEnc = ( (float)icovOrgEnc - ( (float)imeanOrg ) * meanEnc ) / win_pixels_bias;
-
-      mb_ssim = (float)( ( 2.0 * meanOrg * meanEnc + C1 ) * ( 2.0 * covOrgEnc + C2 ) );
-      mb_ssim /= (float)( meanOrg * meanOrg + meanEnc * meanEnc + C1 ) * ( varOrg + varEnc + C2 );
+        if( needSsd && end == windowsY )
+          for( std::size_t y = windowsY * window; y < height; y++ )
+            rowSsd[y] = ssd( kernels, rows[y], orgRows[y], width );
+      } );
+    };
+    if( d->isByteStorage() && Org->d->isByteStorage() )
+    {
+      evaluate( d->m_pcStorage->m_pppcBytePel[component], Org->d->m_pcStorage->m_pppcBytePel[component] );
+    }
+    else
+    {
+      CalypFramePrivate::PelChannel copy;
+      CalypFramePrivate::PelChannel orgCopy;
+      evaluate( d->channelPelRows( component, copy ), Org->d->channelPelRows( component, orgCopy ) );
+    }
 
-      cur_distortion += mb_ssim;
-      win_cnt++;
+    if( needSsd )
+    {
+      std::uint64_t ssd = 0;
+      for( std::uint64_t row : rowSsd )
+        ssd += row;
+      const double mse = ssd ? double( ssd ) / ( double( width ) * height ) : 0.0;
+      results.value[MSE_METRIC][component] = mse;
+      results.value[PSNR_METRIC][component] = mse != 0 ? 10 * log10( peak * peak / mse ) : 100;
+
+      const auto weights = wsPsnrRowWeights( height );
+      double weightedSsd = 0;
+      double weightSum = 0;
+      for( unsigned int y = 0; y < height; y++ )
+      {
+        weightedSsd += double( rowSsd[y] ) * ( *weights )[y];
+        weightSum += ( *weights )[y];
+      }
+      results.value[WSPSNR_METRIC][component] =
+          weightedSsd != 0.0 ? 10 * log10( peak * peak * weightSum * width / weightedSsd ) : 100.00;
     }
+    if( needSsim )
+      results.value[SSIM_METRIC][component] = meanSsim( rowSsim, windowsX );
   }
+  return results;
+}
 
-  cur_distortion /= (float)win_cnt;
-
-  if( cur_distortion >= 1.0 && cur_distortion < 1.01 )  // avoid float accuracy problem at very low QP(e.g.2)
-    cur_distortion = 1.0;
-
-  return cur_distortion;
+double CalypFrame::getQuality( int Metric, CalypFrame* Org, unsigned int component )
+{
+  if( component >= getNumberChannels() )
+  {
+    return 0;
+  }
+  if( Metric < 0 || Metric >= NUMBER_METRICS )
+  {
+    assert( 0 );
+    return 0;
+  }
+  return computeQuality( Org, { Metric }, { component } )( Metric, component );
 }
 
-double CalypFrame::getSSIM( CalypFrame* Org, unsigned int component )
+auto CalypFrame::getRowSSD( CalypFrame* Org, unsigned int component, CalypFrame* weights )
+    -> std::vector<std::uint64_t>
 {
-  double dSSIM = 1;
-  if( component == CLP_LUMA )
+  // Minimum number of rows compared by each thread
+  constexpr std::size_t kMinRowsPerBand = 32;
+
+  const CalypFrameKernels& kernels = calypFrameKernels();
+  const unsigned int width = Org->getWidth( component );
+  std::vector<std::uint64_t> rowSsd( Org->getHeight( component ) );
+  const auto compare = [&]<typename T>( T** rows, T** orgRows ) {
+    calypThreadPool().parallelFor( rowSsd.size(), kMinRowsPerBand, [&]( std::size_t begin, std::size_t end ) {
+      for( std::size_t y = begin; y < end; y++ )
+        rowSsd[y] = ssd( kernels, rows[y], orgRows[y], width );
+    } );
+  };
+
+  CalypFramePrivate::PelChannel copy;
+  CalypFramePrivate::PelChannel orgCopy;
+  if( weights )
+  {
+    CalypFramePrivate::PelChannel weightCopy;
+    ClpPel** rows = d->channelPelRows( component, copy );
+    ClpPel** orgRows = Org->d->channelPelRows( component, orgCopy );
+    ClpPel** weightRows = weights->d->channelPelRows( CLP_LUMA, weightCopy );
+    calypThreadPool().parallelFor( rowSsd.size(), kMinRowsPerBand, [&]( std::size_t begin, std::size_t end ) {
+      for( std::size_t y = begin; y < end; y++ )
+        rowSsd[y] = kernels.ssdWeighted( rows[y], orgRows[y], weightRows[y], width );
+    } );
+  }
+  else if( d->isByteStorage() && Org->d->isByteStorage() )
   {
-    dSSIM = compute_ssim( d->m_pppcInputPel[component], Org->getPelBufferYUV()[component], d->m_uiWidth, d->m_uiHeight,
-                          8, 8, 255, 8 );
+    compare( d->m_pcStorage->m_pppcBytePel[component], Org->d->m_pcStorage->m_pppcBytePel[component] );
   }
   else
   {
-    dSSIM = compute_ssim( d->m_pppcInputPel[component], Org->getPelBufferYUV()[component], getWidth( component ),
-                          getHeight( component ), 4, 4, 255, 4 );
+    compare( d->channelPelRows( component, copy ), Org->d->channelPelRows( component, orgCopy ) );
   }
-  return dSSIM;
+  return rowSsd;
 }
 
-double CalypFrame::getWSPNR( CalypFrame* Org, unsigned int component )
+double CalypFrame::getMSE( CalypFrame* Org, unsigned int component )
+{
+  return getQuality( MSE_METRIC, Org, component );
+}
+
+double CalypFrame::getPSNR( CalypFrame* Org, unsigned int component )
 {
-  ClpPel* pPelYUV = getPelBufferYUV()[component][0];
-  ClpPel* pOrgPelYUV = Org->getPelBufferYUV()[component][0];
+  return getQuality( PSNR_METRIC, Org, component );
+}
 
-  unsigned height = getHeight( component );
-  unsigned width = getWidth( component );
-  double ssd = 0;
-  double weight_sum = 0;
+double CalypFrame::getSSIM( CalypFrame* Org, unsigned int component, bool gaussianWindow )
+{
+  if( !gaussianWindow )
+    return getQuality( SSIM_METRIC, Org, component );
+  const double peak = ( 1 << Org->getBitsPel() ) - 1;
+  if( d->isByteStorage() && Org->d->isByteStorage() )
+    return gaussianSsim( d->m_pcStorage->m_pppcBytePel[component], Org->d->m_pcStorage->m_pppcBytePel[component],
+                         getWidth( component ), getHeight( component ), peak );
+  CalypFramePrivate::PelChannel copy;
+  CalypFramePrivate::PelChannel orgCopy;
+  return gaussianSsim( d->channelPelRows( component, copy ), Org->d->channelPelRows( component, orgCopy ),
+                       getWidth( component ), getHeight( component ), peak );
+}
 
-  for( unsigned y = 0; y < height; y++ )
-    for( unsigned x = 0; x < width; x++ )
-    {
-      int diff = int( *pPelYUV++ ) - int( *pOrgPelYUV++ );
-      double weight = cos( double( ( y + 0.5 - height / 2.0 ) * S_PI / height ) );
-      ssd += (double)( diff * diff * 1000 ) * weight;
-      weight_sum += weight * 1000;
-    }
+double CalypFrame::getWSPNR( CalypFrame* Org, unsigned int component )
+{
+  return getQuality( WSPSNR_METRIC, Org, component );
+}
+
+std::vector<std::string> CalypFrame::supportedQualityMapsList()
+{
+  return std::vector<std::string>{
+      "MSE",
+      "SSIM",
+      "AbsDiff",
+  };
+}
 
-  if( ssd == 0.0 )
+auto CalypFrame::getQualityMap( int map, CalypFrame* Org, unsigned int component, unsigned int blockSize )
+    -> CalypPlane<float>
+{
+  if( map < 0 || map >= NUMBER_MAPS || !blockSize || component >= getNumberChannels() )
+    throw CalypFailure( "CalypFrame", "Invalid quality map" );
+
+  const CalypFrameKernels& kernels = calypFrameKernels();
+  const unsigned int width = getWidth( component );
+  const unsigned int height = getHeight( component );
+  const unsigned int blocksX = ( width + blockSize - 1 ) / blockSize;
+  const unsigned int blocksY = ( height + blockSize - 1 ) / blockSize;
+  const double peak = ( 1 << Org->getBitsPel() ) - 1;
+  const double c1 = ( kSsimK1 * peak ) * ( kSsimK1 * peak );
+  const double c2 = ( kSsimK2 * peak ) * ( kSsimK2 * peak );
+  const unsigned int window = component == CLP_LUMA ? 8 : 4;
+
+  CalypPlane<float> values( blocksX, blocksY );
+  const auto compute = [&]<typename T>( T** rows, T** orgRows ) {
+    calypThreadPool().parallelFor( blocksY, 1, [&]( std::size_t begin, std::size_t end ) {
+      std::vector<std::uint64_t> sums;
+      std::vector<T*> blockRows;
+      std::vector<T*> blockOrgRows;
+      for( std::size_t by = begin; by < end; by++ )
+      {
+        const unsigned int y0 = by * blockSize;
+        const unsigned int blockHeight = std::min( blockSize, height - y0 );
+        std::span<float>& out = values[by];
+        if( map == SSIM_MAP )
+        {
+          // each block is an image of its own, with the windows of getSSIM() fitted inside
+          blockRows.resize( blockHeight );
+          blockOrgRows.resize( blockHeight );
+          for( unsigned int bx = 0; bx < blocksX; bx++ )
+          {
+            const unsigned int x0 = bx * blockSize;
+            const unsigned int blockWidth = std::min( blockSize, width - x0 );
+            const unsigned int blockWindow = std::min( { window, blockWidth, blockHeight } );
+            const unsigned int windowsX = blockWidth / blockWindow;
+            const unsigned int windowsY = blockHeight / blockWindow;
+            for( unsigned int k = 0; k < blockHeight; k++ )
+            {
+              blockRows[k] = rows[y0 + k] + x0;
+              blockOrgRows[k] = orgRows[y0 + k] + x0;
+            }
+            sums.resize( 5 * std::size_t( windowsX ) * blockWindow );
+            double ssim = 0.0;
+            for( unsigned int wy = 0; wy < windowsY; wy++ )
+              ssim += ssimWindowRow( blockRows.data(), blockOrgRows.data(), windowsX * blockWindow, blockWindow, wy,
+                                     c1, c2, sums.data() );
+            out[bx] = static_cast<float>( ssim / ( double( windowsX ) * windowsY ) );
+          }
+        }
+        else
+        {
+          sums.assign( blocksX, 0 );
+          for( unsigned int y = y0; y < y0 + blockHeight; y++ )
+          {
+            for( unsigned int bx = 0; bx < blocksX; bx++ )
+            {
+              const unsigned int x0 = bx * blockSize;
+              const unsigned int blockWidth = std::min( blockSize, width - x0 );
+              sums[bx] += map == MSE_MAP ? ssd( kernels, rows[y] + x0, orgRows[y] + x0, blockWidth )
+                                         : sad( kernels, rows[y] + x0, orgRows[y] + x0, blockWidth );
+            }
+          }
+          for( unsigned int bx = 0; bx < blocksX; bx++ )
+          {
+            const unsigned int blockWidth = std::min( blockSize, width - bx * blockSize );
+            out[bx] = static_cast<float>( double( sums[bx] ) / ( double( blockWidth ) * blockHeight ) );
+          }
+        }
+      }
+    } );
+  };
+  if( d->isByteStorage() && Org->d->isByteStorage() )
+  {
+    compute( d->m_pcStorage->m_pppcBytePel[component], Org->d->m_pcStorage->m_pppcBytePel[component] );
+  }
+  else
   {
-    return 100.00;
+    CalypFramePrivate::PelChannel copy;
+    CalypFramePrivate::PelChannel orgCopy;
+    compute( d->channelPelRows( component, copy ), Org->d->channelPelRows( component, orgCopy ) );
   }
-  unsigned long uiMaxValue = ( 1 << Org->getBitsPel() ) - 1;
-  return 10 * log10( double( uiMaxValue * uiMaxValue ) * weight_sum / ssd );
+  return values;
 }
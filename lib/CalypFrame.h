@@ -100,6 +100,29 @@ enum CLP_Endianness
   CLP_LITTLE_ENDIAN = 1,
 };
 
+/**
+ * \enum CalypColorMatrix
+ * \brief Matrix used to convert YUV samples to RGB
+ * \ingroup CalypLibGrp
+ */
+enum CalypColorMatrix
+{
+  CLP_MATRIX_BT601 = 0,  //!< ITU-R BT.601 (SD)
+  CLP_MATRIX_BT709,      //!< ITU-R BT.709 (HD)
+  CLP_MATRIX_BT2020,     //!< ITU-R BT.2020 non-constant luminance (UHD)
+};
+
+/**
+ * \enum CalypColorRange
+ * \brief Range of the YUV samples
+ * \ingroup CalypLibGrp
+ */
+enum CalypColorRange
+{
+  CLP_RANGE_FULL = 0,  //!< Samples use the whole scale
+  CLP_RANGE_LIMITED,   //!< Luma in [16, 235] and chroma in [16, 240] (scaled for more than 8 bits)
+};
+
 #define CHROMASHIFT( SIZE, SHIFT ) (unsigned int)( -( ( -( (int)( SIZE ) ) ) >> ( SHIFT ) ) )
 
 /**
@@ -200,6 +223,45 @@ private:
   std::vector<std::span<T>> m_rows;
 };
 
+/**
+ * \class    CalypPlaneView
+ * \ingroup	 CalypLibGrp CalypPlaneGrp
+ * \brief    Non-owning view of the rows of a (strided) plane
+ */
+template <typename T>
+class CalypPlaneView
+{
+public:
+  CalypPlaneView() noexcept = default;
+  CalypPlaneView( T* data, std::size_t width, std::size_t height, std::size_t stride ) noexcept
+      : m_data{ data }, m_width{ width }, m_height{ height }, m_stride{ stride }
+  {
+  }
+
+  auto operator[]( std::size_t row ) const noexcept { return std::span<T>( m_data + row * m_stride, m_width ); }
+
+  auto data() const noexcept { return m_data; }
+  auto width() const noexcept { return m_width; }
+  auto height() const noexcept { return m_height; }
+  auto stride() const noexcept { return m_stride; }
+
+private:
+  T* m_data{ nullptr };
+  std::size_t m_width{ 0 };
+  std::size_t m_height{ 0 };
+  std::size_t m_stride{ 0 };
+};
+
+/**
+ * Rows of a channel stored outside of a frame (see CalypFrame::frameFromPlanes())
+ */
+struct CalypPlaneSource
+{
+  const ClpByte* data{ nullptr };  //!< First sample of the channel
+  std::ptrdiff_t stride{ 0 };      //!< Bytes between the start of two rows
+  unsigned int step{ 1 };          //!< Samples between two samples of a row (2 for interleaved chroma)
+};
+
 /**
  * \class    CalypFrame
  * \ingroup	 CalypLibGrp CalypFrameGrp
@@ -267,6 +329,9 @@ public:
 
   /**
    * Copy contructor
+   * The copy shares the samples of other until one of them is written
+   * (copy-on-write), so copying is cheap. Copies of views are deep.
+   * A valid ARGB buffer (see fillRGBBuffer()) is shared the same way.
    *
    * @param other existing frame to copy from
    */
@@ -293,6 +358,36 @@ public:
   CalypFrame( const CalypFrame& other, unsigned int x, unsigned int y, unsigned int width, unsigned int height );
   CalypFrame( const CalypFrame* other, unsigned int x, unsigned int y, unsigned int width, unsigned int height );
 
+  /**
+   * Creates a view of a region of an existing frame. The view references
+   * the samples of other (no pixels are copied) and can be used as any
+   * other frame, e.g., for the histogram, statistics and quality functions.
+   * The region is aligned to the chroma subsampling as in the crop constructors
+   * and limited to the size of other.
+   *
+   * @param other existing frame, the view keeps its samples alive
+   * @param posX position X of the region
+   * @param posY position Y of the region
+   * @param areaWidth region width
+   * @param areaHeight region height
+   *
+   * @note writing into a view modifies other, and writing into other
+   * modifies the view. Once a copy of other shares its samples, writing
+   * into the view first copies the region (the view becomes a regular frame),
+   * so copies of other never change. If other later gets new samples
+   * (e.g., it was sharing them with a copy and is written) the view keeps
+   * referencing the previous ones. Copying a view creates a regular frame.
+   */
+  static auto createView( const CalypFrame& other, unsigned int x, unsigned int y, unsigned int width,
+                          unsigned int height ) -> CalypFrame;
+  static auto createView( const std::shared_ptr<CalypFrame>& other, unsigned int x, unsigned int y, unsigned int width,
+                          unsigned int height ) -> std::shared_ptr<CalypFrame>;
+
+  /**
+   * Check if the frame references the samples of another frame (see createView())
+   */
+  bool isView() const;
+
   ~CalypFrame();
 
   /** Format match opts
@@ -411,14 +506,59 @@ public:
   static std::uint64_t getBytesPerFrame( unsigned int uiWidth, unsigned int uiHeight, ClpPixelFormats pelFormat,
                                          unsigned int bitsPixel );
 
+  /**
+   * Alignment in bytes of the first pixel of each row (except for views)
+   */
+  static constexpr std::size_t getDataAlignment() { return 64; }
+
+  /**
+   * Get the size of the samples kept in memory.
+   * 8 bits frames store their samples in ClpByte planes (see getBytePlane()),
+   * other frames use ClpPel planes
+   * @return 1 or 2 bytes
+   */
+  unsigned int getSampleBytes() const;
+
+  /**
+   * Get the distance between the start of two consecutive rows
+   * of the ClpPel planes (see getPlane())
+   * @param channel/component
+   * @return number of pixels (including the padding)
+   */
+  unsigned int getStride( unsigned channel = 0 ) const;
+
   /**
    * Reset frame pixels to zero
    */
   void reset();
 
+  /**
+   * Get the rows of a channel
+   * @note rows are padded, use getPlane() or getStride() instead of
+   * assuming that the pixels of a channel are contiguous
+   * @note for frames stored in bytes the const version returns a
+   * ClpPel copy of the samples that must only be read (the copy belongs
+   * to this frame, not to the copies sharing its samples), while the
+   * non-const version moves the frame to ClpPel storage
+   * @note the non-const version stops sharing the samples with copies of
+   * the frame, the rows it returns must not be kept after copying the frame
+   */
   ClpPel*** getPelBufferYUV() const;
   ClpPel*** getPelBufferYUV();
 
+  /**
+   * Get a channel as ClpPel samples (same rules as getPelBufferYUV())
+   */
+  auto getPlane( unsigned channel ) const -> CalypPlaneView<const ClpPel>;
+  auto getPlane( unsigned channel ) -> CalypPlaneView<ClpPel>;
+
+  /**
+   * Get a channel of a frame stored in bytes (getSampleBytes() == 1)
+   * Throws CalypFailure for other frames
+   */
+  auto getBytePlane( unsigned channel ) const -> CalypPlaneView<const ClpByte>;
+  auto getBytePlane( unsigned channel ) -> CalypPlaneView<ClpByte>;
+
   auto getRGBBuffer() const -> std::optional<std::span<const std::uint8_t>>;
 
   /**
@@ -495,6 +635,23 @@ public:
   void frameFromBuffer( std::span<const ClpByte>, int iEndianness );
   void frameToBuffer( std::span<ClpByte>, int iEndianness ) const;
 
+  /**
+   * Copy the samples of each channel from its own rows (e.g. the planes of
+   * a decoded picture) instead of a packed buffer (see frameFromBuffer())
+   * @param planes rows of each channel of the frame
+   * @param iEndianness of the samples with more than 8 bits
+   * @param shift right shift of the samples (e.g. 6 for the 10 most significant bits of P010)
+   */
+  void frameFromPlanes( std::span<const CalypPlaneSource> planes, int iEndianness, unsigned int shift = 0 );
+
+  /**
+   * Set the matrix and range used by fillRGBBuffer() to convert
+   * YUV frames (BT.601 full range by default)
+   */
+  void setColorMatrix( CalypColorMatrix matrix, CalypColorRange range );
+  auto getColorMatrix() const -> CalypColorMatrix;
+  auto getColorRange() const -> CalypColorRange;
+
   void fillRGBBuffer( std::optional<std::size_t> channel ) const;
   void fillRGBBuffer() const;
 
@@ -519,6 +676,13 @@ public:
   };
   void calcHistogram();
 
+  /**
+   * Build the histograms of square tiles of the frame (kept until its samples are written),
+   * so that calcHistogram() of the frame, its copies and its views only counts
+   * the samples outside whole tiles (e.g., fast histograms of selections)
+   */
+  void calcHistogramIndex();
+
   unsigned int getMinimumPelValue( unsigned channel ) const;
   unsigned int getMaximumPelValue( unsigned channel ) const;
 
@@ -558,16 +722,77 @@ public:
 
   static std::vector<std::string> supportedQualityMetricsList();
   static std::vector<std::string> supportedQualityMetricsUnitsList();
+
+  /**
+   * Results of computeQuality(), indexed by metric and component
+   */
+  struct QualityResults
+  {
+    std::array<std::array<double, CalypPixel::getMaxNumberOfComponents()>, NUMBER_METRICS> value{};
+    std::array<bool, NUMBER_METRICS> hasMetric{};
+    std::array<bool, CalypPixel::getMaxNumberOfComponents()> hasComponent{};
+
+    double operator()( int metric, unsigned int component ) const
+    {
+      if( metric < 0 || metric >= NUMBER_METRICS || component >= hasComponent.size() )
+        return 0;
+      return value[metric][component];
+    }
+  };
+
+  /**
+   * Compute several metrics of several components in a single pass over each plane:
+   * the squared differences of each row and the SSIM windows are accumulated
+   * while the rows are in cache, then each metric is reduced from them.
+   * Unknown metrics and components beyond getNumberChannels() are skipped
+   */
+  auto computeQuality( CalypFrame* Org, const std::vector<int>& metrics, const std::vector<unsigned int>& components )
+      -> QualityResults;
+
   double getQuality( int Metric, CalypFrame* Org, unsigned int component );
+  /**
+   * Sum of squared differences of each row of a component (in parallel, with the SIMD kernels),
+   * MSE, PSNR and WS-PSNR are reductions of it.
+   * @param weights optional frame with the size of the component, the squared differences
+   * are multiplied by its luma samples
+   */
+  auto getRowSSD( CalypFrame* Org, unsigned int component, CalypFrame* weights = nullptr )
+      -> std::vector<std::uint64_t>;
   double getMSE( CalypFrame* Org, unsigned int component );
   double getPSNR( CalypFrame* Org, unsigned int component );
-  double getSSIM( CalypFrame* Org, unsigned int component );
+  /**
+   * Mean SSIM of the component, the peak value follows the bit depth of Org.
+   * By default it uses non-overlapping windows (8x8 luma, 4x4 chroma),
+   * gaussianWindow uses 11x11 gaussian windows at every sample (Wang et al.)
+   */
+  double getSSIM( CalypFrame* Org, unsigned int component, bool gaussianWindow = false );
   double getWSPNR( CalypFrame* Org, unsigned int component );
+
+  enum QualityMaps
+  {
+    MSE_MAP = 0,
+    SSIM_MAP,
+    ABS_DIFF_MAP,
+    NUMBER_MAPS,
+  };
+
+  static std::vector<std::string> supportedQualityMapsList();
+
+  /**
+   * Map of a metric over the blocks of a component, e.g. per-CTU or per-8x8 distortion:
+   * the mean squared error, the mean SSIM of the windows inside each block or the mean
+   * absolute difference. Blocks at the right and bottom borders may be smaller.
+   * @return plane of ceil( width / blockSize ) x ceil( height / blockSize ) values
+   */
+  auto getQualityMap( int map, CalypFrame* Org, unsigned int component, unsigned int blockSize )
+      -> CalypPlane<float>;
   /** @} */
 
 private:
   class CalypFramePrivate;
   std::unique_ptr<CalypFramePrivate> d;
+
+  CalypFrame();
 };
 
 #endif  // __CALYPFRAME_H__
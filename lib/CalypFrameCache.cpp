@@ -0,0 +1,163 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2021  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     CalypFrameCache.cpp
+ * \brief    Decoded frames shared by all the input streams
+ */
+
+#include "CalypFrameCache.h"
+
+#include <cstdlib>
+#include <iterator>
+#include <string>
+
+#include "CalypFrame.h"
+
+namespace
+{
+auto defaultBudget() -> std::size_t
+{
+  if( const char* env = std::getenv( "CALYP_FRAME_CACHE" ) )
+  {
+    try
+    {
+      return static_cast<std::size_t>( std::stoull( env ) ) << 20;
+    }
+    catch( ... )
+    {
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+CalypFrameCache::CalypFrameCache( std::size_t budget )
+    : m_uiBudget{ budget }
+{
+}
+
+CalypFrameCache::~CalypFrameCache() = default;
+
+void CalypFrameCache::setBudget( std::size_t budget )
+{
+  const std::lock_guard<std::mutex> lock( m_mutex );
+  m_uiBudget = budget;
+  evict();
+}
+
+auto CalypFrameCache::budget() const -> std::size_t
+{
+  return m_uiBudget.load();
+}
+
+auto CalypFrameCache::usage() const -> std::size_t
+{
+  const std::lock_guard<std::mutex> lock( m_mutex );
+  return m_uiUsage;
+}
+
+auto CalypFrameCache::newStream() -> std::uint64_t
+{
+  const std::lock_guard<std::mutex> lock( m_mutex );
+  return m_uiNextStream++;
+}
+
+void CalypFrameCache::dropStream( std::uint64_t stream )
+{
+  const std::lock_guard<std::mutex> lock( m_mutex );
+  m_playheads.erase( stream );
+  auto it = m_index.lower_bound( { stream, 0 } );
+  while( it != m_index.end() && it->first.first == stream )
+  {
+    auto entry = it->second;
+    ++it;
+    erase( entry );
+  }
+}
+
+auto CalypFrameCache::find( std::uint64_t stream, std::uint64_t frameNum ) -> std::shared_ptr<CalypFrame>
+{
+  const std::lock_guard<std::mutex> lock( m_mutex );
+  auto it = m_index.find( { stream, frameNum } );
+  if( it == m_index.end() )
+    return nullptr;
+  m_lruList.splice( m_lruList.begin(), m_lruList, it->second );
+  return it->second->frame;
+}
+
+void CalypFrameCache::insert( std::uint64_t stream, std::uint64_t frameNum, std::shared_ptr<CalypFrame> frame,
+                              std::size_t bytes )
+{
+  const std::lock_guard<std::mutex> lock( m_mutex );
+  if( bytes > m_uiBudget.load() )
+    return;
+  auto it = m_index.find( { stream, frameNum } );
+  if( it != m_index.end() )
+    erase( it->second );
+  m_lruList.push_front( Entry{ stream, frameNum, std::move( frame ), bytes } );
+  m_index[{ stream, frameNum }] = m_lruList.begin();
+  m_uiUsage += bytes;
+  evict();
+}
+
+void CalypFrameCache::setPlayhead( std::uint64_t stream, std::uint64_t frameNum )
+{
+  const std::lock_guard<std::mutex> lock( m_mutex );
+  m_playheads[stream] = frameNum;
+}
+
+auto CalypFrameCache::nearPlayhead( const Entry& entry ) const -> bool
+{
+  auto it = m_playheads.find( entry.stream );
+  if( it == m_playheads.end() )
+    return false;
+  const std::uint64_t playhead = it->second;
+  const std::uint64_t distance = entry.frameNum > playhead ? entry.frameNum - playhead : playhead - entry.frameNum;
+  return distance <= kPlayheadFrames;
+}
+
+void CalypFrameCache::erase( EntryList::iterator it )
+{
+  m_uiUsage -= it->bytes;
+  m_index.erase( { it->stream, it->frameNum } );
+  m_lruList.erase( it );
+}
+
+void CalypFrameCache::evict()
+{
+  const std::size_t budget = m_uiBudget.load();
+
+  // The frames around the playheads go last
+  for( auto it = m_lruList.end(); m_uiUsage > budget && it != m_lruList.begin(); )
+  {
+    --it;
+    if( !nearPlayhead( *it ) )
+      erase( it++ );
+  }
+  while( m_uiUsage > budget )
+    erase( std::prev( m_lruList.end() ) );
+}
+
+auto calypFrameCache() -> CalypFrameCache&
+{
+  static CalypFrameCache cache( defaultBudget() );
+  return cache;
+}
@@ -0,0 +1,133 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2021  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     CalypFrameCache.h
+ * \ingroup  CalypLibGrp
+ * \brief    Decoded frames shared by all the input streams
+ */
+
+#ifndef __CALYPFRAMECACHE_H__
+#define __CALYPFRAMECACHE_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+class CalypFrame;
+
+/**
+ * \class    CalypFrameCache
+ * \ingroup  CalypLibGrp
+ * \brief    Least recently used frames of the streams, up to a byte budget
+ *
+ * Frames are indexed by stream (see newStream()) and frame number.
+ * When the budget is exceeded the least recently used frames are evicted,
+ * the ones close to the playhead of their stream are evicted last
+ */
+class CalypFrameCache
+{
+public:
+  /**
+   * Frames on each side of a playhead evicted last
+   */
+  static constexpr std::uint64_t kPlayheadFrames = 16;
+
+  /**
+   * @param budget size of the cache in bytes, 0 disables it
+   */
+  explicit CalypFrameCache( std::size_t budget );
+  ~CalypFrameCache();
+
+  CalypFrameCache( const CalypFrameCache& ) = delete;
+  CalypFrameCache( CalypFrameCache&& ) = delete;
+  CalypFrameCache& operator=( const CalypFrameCache& ) = delete;
+  CalypFrameCache& operator=( CalypFrameCache&& ) = delete;
+
+  void setBudget( std::size_t budget );
+  auto budget() const -> std::size_t;
+
+  /**
+   * Bytes used by the cached frames
+   */
+  auto usage() const -> std::size_t;
+
+  /**
+   * Get a new identifier for the frames of a stream
+   */
+  auto newStream() -> std::uint64_t;
+
+  /**
+   * Evict all the frames of a stream
+   */
+  void dropStream( std::uint64_t stream );
+
+  /**
+   * Get a frame and mark it as the most recently used
+   * @return nullptr if it is not cached
+   */
+  auto find( std::uint64_t stream, std::uint64_t frameNum ) -> std::shared_ptr<CalypFrame>;
+
+  /**
+   * Cache a frame accounted as bytes, evicting others to keep the budget
+   */
+  void insert( std::uint64_t stream, std::uint64_t frameNum, std::shared_ptr<CalypFrame> frame, std::size_t bytes );
+
+  /**
+   * Set the frame displayed by a stream
+   */
+  void setPlayhead( std::uint64_t stream, std::uint64_t frameNum );
+
+private:
+  struct Entry
+  {
+    std::uint64_t stream;
+    std::uint64_t frameNum;
+    std::shared_ptr<CalypFrame> frame;
+    std::size_t bytes;
+  };
+  using EntryList = std::list<Entry>;
+
+  auto nearPlayhead( const Entry& entry ) const -> bool;
+  void erase( EntryList::iterator it );
+  void evict();
+
+  mutable std::mutex m_mutex;
+  std::atomic<std::size_t> m_uiBudget;
+  std::size_t m_uiUsage{ 0 };
+  std::uint64_t m_uiNextStream{ 0 };
+  //! Most recently used first
+  EntryList m_lruList;
+  std::map<std::pair<std::uint64_t, std::uint64_t>, EntryList::iterator> m_index;
+  std::map<std::uint64_t, std::uint64_t> m_playheads;
+};
+
+/**
+ * Get the cache shared by the library.
+ * It is disabled by default, the environment variable
+ * CALYP_FRAME_CACHE sets its budget in MiB (e.g., CALYP_FRAME_CACHE=2048)
+ */
+auto calypFrameCache() -> CalypFrameCache&;
+
+#endif  // __CALYPFRAMECACHE_H__
@@ -0,0 +1,1688 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2021  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     CalypFrameKernels.cpp
+ * \brief    Low level pixel kernels used by CalypFrame (runtime dispatched)
+ */
+
+#include "CalypFrameKernels.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+#include "config.h"
+
+#if defined( USE_SSE ) && ( defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 ) )
+#define CLP_X86_SIMD 1
+#include <immintrin.h>
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+#endif
+
+#if defined( __GNUC__ ) || defined( __clang__ )
+#define CLP_TARGET( isa ) __attribute__( ( target( isa ) ) )
+#else
+#define CLP_TARGET( isa )
+#endif
+
+namespace
+{
+/*
+ **************************************************************
+ * Generic kernels
+ **************************************************************
+ */
+
+void unpack8Generic( const ClpByte* src, ClpPel* dst, std::size_t n )
+{
+  for( std::size_t i = 0; i < n; i++ )
+    dst[i] = src[i];
+}
+
+void unpack16Generic( const ClpByte* src, ClpPel* dst, std::size_t n, bool bigEndian, ClpPel maxval )
+{
+  const int lsb = bigEndian ? 1 : 0;
+  const int msb = bigEndian ? 0 : 1;
+  for( std::size_t i = 0; i < n; i++ )
+  {
+    ClpPel value = ClpPel( src[2 * i + lsb] | ( src[2 * i + msb] << 8 ) );
+    dst[i] = value > maxval ? 0 : value;
+  }
+}
+
+// Kernels templated on T are shared by the ClpPel and ClpByte storages
+template <typename T>
+void unpackYUYV8Generic( const ClpByte* src, T* dstY, T* dstU, T* dstV, std::size_t n )
+{
+  for( std::size_t i = 0; i < n; i++ )
+  {
+    dstY[2 * i] = src[4 * i];
+    dstU[i] = src[4 * i + 1];
+    dstY[2 * i + 1] = src[4 * i + 2];
+    dstV[i] = src[4 * i + 3];
+  }
+}
+
+template <std::size_t N, typename T>
+void unpackPackedGeneric( const ClpByte* src, T* const* dst, std::size_t n )
+{
+  for( std::size_t i = 0; i < n; i++ )
+    for( std::size_t k = 0; k < N; k++ )
+      dst[k][i] = src[N * i + k];
+}
+
+void pack8Generic( const ClpPel* src, ClpByte* dst, std::size_t n )
+{
+  for( std::size_t i = 0; i < n; i++ )
+    dst[i] = static_cast<ClpByte>( src[i] );
+}
+
+void pack16Generic( const ClpPel* src, ClpByte* dst, std::size_t n, bool bigEndian )
+{
+  const int lsb = bigEndian ? 1 : 0;
+  const int msb = bigEndian ? 0 : 1;
+  for( std::size_t i = 0; i < n; i++ )
+  {
+    dst[2 * i + lsb] = static_cast<ClpByte>( src[i] );
+    dst[2 * i + msb] = static_cast<ClpByte>( src[i] >> 8 );
+  }
+}
+
+template <typename T>
+void packYUYV8Generic( const T* srcY, const T* srcU, const T* srcV, ClpByte* dst, std::size_t n )
+{
+  for( std::size_t i = 0; i < n; i++ )
+  {
+    dst[4 * i] = static_cast<ClpByte>( srcY[2 * i] );
+    dst[4 * i + 1] = static_cast<ClpByte>( srcU[i] );
+    dst[4 * i + 2] = static_cast<ClpByte>( srcY[2 * i + 1] );
+    dst[4 * i + 3] = static_cast<ClpByte>( srcV[i] );
+  }
+}
+
+template <std::size_t N, typename T>
+void packPackedGeneric( const T* const* src, ClpByte* dst, std::size_t n )
+{
+  for( std::size_t i = 0; i < n; i++ )
+    for( std::size_t k = 0; k < N; k++ )
+      dst[N * i + k] = static_cast<ClpByte>( src[k][i] );
+}
+
+inline auto yuvToArgbPel( int iY, int iU, int iV, const CalypYuvToRgbCoeffs& c ) -> std::uint32_t
+{
+  const int y = c.luma * ( iY - c.lumaOffset ) + ( 1 << ( c.shift - 1 ) );
+  const int u = iU - c.chromaOffset;
+  const int v = iV - c.chromaOffset;
+  int iR = ( y + c.crR * v ) >> c.shift;
+  int iG = ( y - ( c.cbG * u + c.crG * v ) ) >> c.shift;
+  int iB = ( y + c.cbB * u ) >> c.shift;
+  iR = std::clamp( iR, 0, 255 );
+  iG = std::clamp( iG, 0, 255 );
+  iB = std::clamp( iB, 0, 255 );
+  return 0xFF000000u | ( std::uint32_t( iR ) << 16 ) | ( std::uint32_t( iG ) << 8 ) | std::uint32_t( iB );
+}
+
+template <typename T>
+void yuvToArgbGeneric( const T* srcY, const T* srcU, const T* srcV, std::uint32_t* dst, std::size_t width,
+                       unsigned log2ChromaWidth, const CalypYuvToRgbCoeffs& coeffs )
+{
+  for( std::size_t x = 0; x < width; x++ )
+    dst[x] = yuvToArgbPel( srcY[x], srcU[x >> log2ChromaWidth], srcV[x >> log2ChromaWidth], coeffs );
+}
+
+static_assert( kCalypHistogramBanks == 4, "histogramGeneric fills 4 banks" );
+
+template <typename T>
+void histogramGeneric( const T* src, std::size_t n, unsigned int* bins, std::size_t bankStride )
+{
+  // Neighbour samples are usually equal, counting them in different banks
+  // avoids waiting for the previous increment of the same bin
+  unsigned int* bins1 = bins + bankStride;
+  unsigned int* bins2 = bins1 + bankStride;
+  unsigned int* bins3 = bins2 + bankStride;
+  std::size_t i = 0;
+  for( ; i + 4 <= n; i += 4 )
+  {
+    bins[src[i]]++;
+    bins1[src[i + 1]]++;
+    bins2[src[i + 2]]++;
+    bins3[src[i + 3]]++;
+  }
+  for( ; i < n; i++ )
+    bins[src[i]]++;
+}
+
+template <typename T>
+void rgbToLumaGeneric( const T* srcR, const T* srcG, const T* srcB, T* dst, std::size_t n )
+{
+  for( std::size_t i = 0; i < n; i++ )
+    dst[i] = static_cast<T>( ( 299 * int( srcR[i] ) + 587 * int( srcG[i] ) + 114 * int( srcB[i] ) + 500 ) / 1000 );
+}
+
+template <typename T>
+auto ssdGeneric( const T* a, const T* b, std::size_t n ) -> std::uint64_t
+{
+  std::uint64_t ssd = 0;
+  for( std::size_t i = 0; i < n; i++ )
+  {
+    std::int64_t diff = std::int64_t( a[i] ) - std::int64_t( b[i] );
+    ssd += std::uint64_t( diff * diff );
+  }
+  return ssd;
+}
+
+auto ssdWeightedGeneric( const ClpPel* a, const ClpPel* b, const ClpPel* weights, std::size_t n ) -> std::uint64_t
+{
+  std::uint64_t ssd = 0;
+  for( std::size_t i = 0; i < n; i++ )
+  {
+    std::int64_t diff = std::int64_t( a[i] ) - std::int64_t( b[i] );
+    ssd += std::uint64_t( diff * diff ) * weights[i];
+  }
+  return ssd;
+}
+
+template <typename T>
+auto sadGeneric( const T* a, const T* b, std::size_t n ) -> std::uint64_t
+{
+  std::uint64_t sad = 0;
+  for( std::size_t i = 0; i < n; i++ )
+    sad += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+  return sad;
+}
+
+template <typename T>
+void ssimColumnsGeneric( const T* const* a, const T* const* b, const float* weights, std::size_t taps, std::size_t n,
+                         float* sums )
+{
+  float* meanA = sums;
+  float* meanB = meanA + n;
+  float* meanAA = meanB + n;
+  float* meanBB = meanAA + n;
+  float* meanAB = meanBB + n;
+  std::fill( sums, sums + 5 * n, 0.0f );
+  for( std::size_t k = 0; k < taps; k++ )
+  {
+    const float w = weights[k];
+    for( std::size_t i = 0; i < n; i++ )
+    {
+      const float sampleA = a[k][i];
+      const float sampleB = b[k][i];
+      const float weightedA = w * sampleA;
+      const float weightedB = w * sampleB;
+      meanA[i] += weightedA;
+      meanB[i] += weightedB;
+      meanAA[i] += weightedA * sampleA;
+      meanBB[i] += weightedB * sampleB;
+      meanAB[i] += weightedA * sampleB;
+    }
+  }
+}
+
+inline auto ssimFromMeans( float meanA, float meanB, float meanAA, float meanBB, float meanAB, float c1, float c2 )
+    -> float
+{
+  const float varA = meanAA - meanA * meanA;
+  const float varB = meanBB - meanB * meanB;
+  const float covAB = meanAB - meanA * meanB;
+  return ( ( 2.0f * meanA * meanB + c1 ) * ( 2.0f * covAB + c2 ) ) /
+         ( ( meanA * meanA + meanB * meanB + c1 ) * ( varA + varB + c2 ) );
+}
+
+auto ssimRowGeneric( const float* sums, std::size_t stride, std::size_t n, const float* weights, std::size_t taps,
+                     float c1, float c2 ) -> double
+{
+  double ssim = 0.0;
+  for( std::size_t i = 0; i < n; i++ )
+  {
+    float means[5] = {};
+    for( std::size_t k = 0; k < taps; k++ )
+      for( std::size_t stat = 0; stat < 5; stat++ )
+        means[stat] += weights[k] * sums[stat * stride + i + k];
+    ssim += ssimFromMeans( means[0], means[1], means[2], means[3], means[4], c1, c2 );
+  }
+  return ssim;
+}
+
+constexpr CalypFrameKernels kGenericKernels{
+    .level = ClpCpuLevel::Generic,
+    .unpack8 = unpack8Generic,
+    .unpack16 = unpack16Generic,
+    .unpackYUYV8 = unpackYUYV8Generic<ClpPel>,
+    .unpackPacked3x8 = unpackPackedGeneric<3, ClpPel>,
+    .unpackPacked4x8 = unpackPackedGeneric<4, ClpPel>,
+    .pack8 = pack8Generic,
+    .pack16 = pack16Generic,
+    .packYUYV8 = packYUYV8Generic<ClpPel>,
+    .packPacked3x8 = packPackedGeneric<3, ClpPel>,
+    .packPacked4x8 = packPackedGeneric<4, ClpPel>,
+    .yuvToArgb = yuvToArgbGeneric<ClpPel>,
+    .histogram = histogramGeneric<ClpPel>,
+    .rgbToLuma = rgbToLumaGeneric<ClpPel>,
+    .ssd = ssdGeneric<ClpPel>,
+    .ssdWeighted = ssdWeightedGeneric,
+    .sad = sadGeneric<ClpPel>,
+    .ssimColumns = ssimColumnsGeneric<ClpPel>,
+    .ssimRow = ssimRowGeneric,
+    .unpackYUYV8Byte = unpackYUYV8Generic<ClpByte>,
+    .unpackPacked3x8Byte = unpackPackedGeneric<3, ClpByte>,
+    .unpackPacked4x8Byte = unpackPackedGeneric<4, ClpByte>,
+    .packYUYV8Byte = packYUYV8Generic<ClpByte>,
+    .packPacked3x8Byte = packPackedGeneric<3, ClpByte>,
+    .packPacked4x8Byte = packPackedGeneric<4, ClpByte>,
+    .yuvToArgbByte = yuvToArgbGeneric<ClpByte>,
+    .histogramByte = histogramGeneric<ClpByte>,
+    .rgbToLumaByte = rgbToLumaGeneric<ClpByte>,
+    .ssdByte = ssdGeneric<ClpByte>,
+    .sadByte = sadGeneric<ClpByte>,
+    .ssimColumnsByte = ssimColumnsGeneric<ClpByte>,
+};
+
+#ifdef CLP_X86_SIMD
+
+/*
+ **************************************************************
+ * SSE2 kernels
+ **************************************************************
+ */
+
+CLP_TARGET( "sse2" ) void unpack8SSE2( const ClpByte* src, ClpPel* dst, std::size_t n )
+{
+  const __m128i zero = _mm_setzero_si128();
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m128i v = _mm_loadu_si128( (const __m128i*)( src + i ) );
+    _mm_storeu_si128( (__m128i*)( dst + i ), _mm_unpacklo_epi8( v, zero ) );
+    _mm_storeu_si128( (__m128i*)( dst + i + 8 ), _mm_unpackhi_epi8( v, zero ) );
+  }
+  unpack8Generic( src + i, dst + i, n - i );
+}
+
+CLP_TARGET( "sse2" ) void unpack16SSE2( const ClpByte* src, ClpPel* dst, std::size_t n, bool bigEndian, ClpPel maxval )
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i max = _mm_set1_epi16( static_cast<short>( maxval ) );
+  std::size_t i = 0;
+  for( ; i + 8 <= n; i += 8 )
+  {
+    __m128i v = _mm_loadu_si128( (const __m128i*)( src + 2 * i ) );
+    if( bigEndian )
+      v = _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+    // unsigned v > max <=> saturated (v - max) != 0
+    __m128i keep = _mm_cmpeq_epi16( _mm_subs_epu16( v, max ), zero );
+    _mm_storeu_si128( (__m128i*)( dst + i ), _mm_and_si128( v, keep ) );
+  }
+  unpack16Generic( src + 2 * i, dst + i, n - i, bigEndian, maxval );
+}
+
+CLP_TARGET( "sse2" )
+void unpackYUYV8SSE2( const ClpByte* src, ClpPel* dstY, ClpPel* dstU, ClpPel* dstV, std::size_t n )
+{
+  const __m128i lowByte = _mm_set1_epi16( 0x00FF );
+  const __m128i lowWord = _mm_set1_epi32( 0x0000FFFF );
+  std::size_t i = 0;
+  for( ; i + 8 <= n; i += 8 )
+  {
+    __m128i a = _mm_loadu_si128( (const __m128i*)( src + 4 * i ) );
+    __m128i b = _mm_loadu_si128( (const __m128i*)( src + 4 * i + 16 ) );
+    _mm_storeu_si128( (__m128i*)( dstY + 2 * i ), _mm_and_si128( a, lowByte ) );
+    _mm_storeu_si128( (__m128i*)( dstY + 2 * i + 8 ), _mm_and_si128( b, lowByte ) );
+    // U0 V0 U1 V1 ... as 16-bit words
+    __m128i uvA = _mm_srli_epi16( a, 8 );
+    __m128i uvB = _mm_srli_epi16( b, 8 );
+    _mm_storeu_si128( (__m128i*)( dstU + i ),
+                      _mm_packs_epi32( _mm_and_si128( uvA, lowWord ), _mm_and_si128( uvB, lowWord ) ) );
+    _mm_storeu_si128( (__m128i*)( dstV + i ), _mm_packs_epi32( _mm_srli_epi32( uvA, 16 ), _mm_srli_epi32( uvB, 16 ) ) );
+  }
+  unpackYUYV8Generic( src + 4 * i, dstY + 2 * i, dstU + i, dstV + i, n - i );
+}
+
+CLP_TARGET( "sse2" ) void unpackPacked4x8SSE2( const ClpByte* src, ClpPel* const* dst, std::size_t n )
+{
+  const __m128i lowByte = _mm_set1_epi32( 0xFF );
+  std::size_t i = 0;
+  for( ; i + 8 <= n; i += 8 )
+  {
+    __m128i a = _mm_loadu_si128( (const __m128i*)( src + 4 * i ) );
+    __m128i b = _mm_loadu_si128( (const __m128i*)( src + 4 * i + 16 ) );
+    for( int k = 0; k < 4; k++ )
+    {
+      __m128i compA = _mm_and_si128( _mm_srli_epi32( a, 8 * k ), lowByte );
+      __m128i compB = _mm_and_si128( _mm_srli_epi32( b, 8 * k ), lowByte );
+      _mm_storeu_si128( (__m128i*)( dst[k] + i ), _mm_packs_epi32( compA, compB ) );
+    }
+  }
+  ClpPel* const tail[4] = { dst[0] + i, dst[1] + i, dst[2] + i, dst[3] + i };
+  unpackPackedGeneric<4>( src + 4 * i, tail, n - i );
+}
+
+CLP_TARGET( "sse2" ) void pack8SSE2( const ClpPel* src, ClpByte* dst, std::size_t n )
+{
+  const __m128i lowByte = _mm_set1_epi16( 0x00FF );
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m128i a = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( src + i ) ), lowByte );
+    __m128i b = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( src + i + 8 ) ), lowByte );
+    _mm_storeu_si128( (__m128i*)( dst + i ), _mm_packus_epi16( a, b ) );
+  }
+  pack8Generic( src + i, dst + i, n - i );
+}
+
+CLP_TARGET( "sse2" ) void pack16SSE2( const ClpPel* src, ClpByte* dst, std::size_t n, bool bigEndian )
+{
+  std::size_t i = 0;
+  for( ; i + 8 <= n; i += 8 )
+  {
+    __m128i v = _mm_loadu_si128( (const __m128i*)( src + i ) );
+    if( bigEndian )
+      v = _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+    _mm_storeu_si128( (__m128i*)( dst + 2 * i ), v );
+  }
+  pack16Generic( src + i, dst + 2 * i, n - i, bigEndian );
+}
+
+CLP_TARGET( "sse2" )
+void packYUYV8SSE2( const ClpPel* srcY, const ClpPel* srcU, const ClpPel* srcV, ClpByte* dst, std::size_t n )
+{
+  const __m128i lowByte = _mm_set1_epi16( 0x00FF );
+  std::size_t i = 0;
+  for( ; i + 8 <= n; i += 8 )
+  {
+    __m128i yA = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( srcY + 2 * i ) ), lowByte );
+    __m128i yB = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( srcY + 2 * i + 8 ) ), lowByte );
+    __m128i u = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( srcU + i ) ), lowByte );
+    __m128i v = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( srcV + i ) ), lowByte );
+    // Each 16-bit word holds a luma byte followed by a chroma byte
+    _mm_storeu_si128( (__m128i*)( dst + 4 * i ), _mm_or_si128( yA, _mm_slli_epi16( _mm_unpacklo_epi16( u, v ), 8 ) ) );
+    _mm_storeu_si128( (__m128i*)( dst + 4 * i + 16 ),
+                      _mm_or_si128( yB, _mm_slli_epi16( _mm_unpackhi_epi16( u, v ), 8 ) ) );
+  }
+  packYUYV8Generic( srcY + 2 * i, srcU + i, srcV + i, dst + 4 * i, n - i );
+}
+
+CLP_TARGET( "sse2" ) void packPacked4x8SSE2( const ClpPel* const* src, ClpByte* dst, std::size_t n )
+{
+  const __m128i lowByte = _mm_set1_epi16( 0x00FF );
+  std::size_t i = 0;
+  for( ; i + 8 <= n; i += 8 )
+  {
+    __m128i c[4];
+    for( int k = 0; k < 4; k++ )
+      c[k] = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( src[k] + i ) ), lowByte );
+    __m128i lo = _mm_or_si128( c[0], _mm_slli_epi16( c[1], 8 ) );
+    __m128i hi = _mm_or_si128( c[2], _mm_slli_epi16( c[3], 8 ) );
+    _mm_storeu_si128( (__m128i*)( dst + 4 * i ), _mm_unpacklo_epi16( lo, hi ) );
+    _mm_storeu_si128( (__m128i*)( dst + 4 * i + 16 ), _mm_unpackhi_epi16( lo, hi ) );
+  }
+  const ClpPel* const tail[4] = { src[0] + i, src[1] + i, src[2] + i, src[3] + i };
+  packPackedGeneric<4>( tail, dst + 4 * i, n - i );
+}
+
+CLP_TARGET( "sse2" ) auto ssdSSE2( const ClpPel* a, const ClpPel* b, std::size_t n ) -> std::uint64_t
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc = zero;
+  std::size_t i = 0;
+  for( ; i + 8 <= n; i += 8 )
+  {
+    __m128i va = _mm_loadu_si128( (const __m128i*)( a + i ) );
+    __m128i vb = _mm_loadu_si128( (const __m128i*)( b + i ) );
+    __m128i diff = _mm_or_si128( _mm_subs_epu16( va, vb ), _mm_subs_epu16( vb, va ) );
+    // 32-bit squares from the low and high halves of the 16x16 products
+    __m128i lo = _mm_mullo_epi16( diff, diff );
+    __m128i hi = _mm_mulhi_epu16( diff, diff );
+    __m128i sq0 = _mm_unpacklo_epi16( lo, hi );
+    __m128i sq1 = _mm_unpackhi_epi16( lo, hi );
+    acc = _mm_add_epi64( acc, _mm_unpacklo_epi32( sq0, zero ) );
+    acc = _mm_add_epi64( acc, _mm_unpackhi_epi32( sq0, zero ) );
+    acc = _mm_add_epi64( acc, _mm_unpacklo_epi32( sq1, zero ) );
+    acc = _mm_add_epi64( acc, _mm_unpackhi_epi32( sq1, zero ) );
+  }
+  alignas( 16 ) std::uint64_t lanes[2];
+  _mm_store_si128( (__m128i*)lanes, acc );
+  return lanes[0] + lanes[1] + ssdGeneric( a + i, b + i, n - i );
+}
+
+CLP_TARGET( "sse2" ) auto sadSSE2( const ClpPel* a, const ClpPel* b, std::size_t n ) -> std::uint64_t
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc = zero;
+  std::size_t i = 0;
+  for( ; i + 8 <= n; i += 8 )
+  {
+    __m128i va = _mm_loadu_si128( (const __m128i*)( a + i ) );
+    __m128i vb = _mm_loadu_si128( (const __m128i*)( b + i ) );
+    __m128i diff = _mm_or_si128( _mm_subs_epu16( va, vb ), _mm_subs_epu16( vb, va ) );
+    __m128i sum = _mm_add_epi32( _mm_unpacklo_epi16( diff, zero ), _mm_unpackhi_epi16( diff, zero ) );
+    acc = _mm_add_epi64( acc, _mm_unpacklo_epi32( sum, zero ) );
+    acc = _mm_add_epi64( acc, _mm_unpackhi_epi32( sum, zero ) );
+  }
+  alignas( 16 ) std::uint64_t lanes[2];
+  _mm_store_si128( (__m128i*)lanes, acc );
+  return lanes[0] + lanes[1] + sadGeneric( a + i, b + i, n - i );
+}
+
+CLP_TARGET( "sse2" )
+void unpackYUYV8ByteSSE2( const ClpByte* src, ClpByte* dstY, ClpByte* dstU, ClpByte* dstV, std::size_t n )
+{
+  const __m128i lowByte = _mm_set1_epi16( 0x00FF );
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m128i c[4];
+    for( int r = 0; r < 4; r++ )
+      c[r] = _mm_loadu_si128( (const __m128i*)( src + 4 * i + 16 * r ) );
+    for( int r = 0; r < 2; r++ )
+    {
+      __m128i y = _mm_packus_epi16( _mm_and_si128( c[2 * r], lowByte ), _mm_and_si128( c[2 * r + 1], lowByte ) );
+      _mm_storeu_si128( (__m128i*)( dstY + 2 * i + 16 * r ), y );
+    }
+    // U0 V0 U1 V1 ... as bytes, split them the same way
+    __m128i uvA = _mm_packus_epi16( _mm_srli_epi16( c[0], 8 ), _mm_srli_epi16( c[1], 8 ) );
+    __m128i uvB = _mm_packus_epi16( _mm_srli_epi16( c[2], 8 ), _mm_srli_epi16( c[3], 8 ) );
+    _mm_storeu_si128( (__m128i*)( dstU + i ),
+                      _mm_packus_epi16( _mm_and_si128( uvA, lowByte ), _mm_and_si128( uvB, lowByte ) ) );
+    _mm_storeu_si128( (__m128i*)( dstV + i ), _mm_packus_epi16( _mm_srli_epi16( uvA, 8 ), _mm_srli_epi16( uvB, 8 ) ) );
+  }
+  unpackYUYV8Generic( src + 4 * i, dstY + 2 * i, dstU + i, dstV + i, n - i );
+}
+
+CLP_TARGET( "sse2" ) void unpackPacked4x8ByteSSE2( const ClpByte* src, ClpByte* const* dst, std::size_t n )
+{
+  const __m128i lowByte = _mm_set1_epi32( 0xFF );
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m128i c[4];
+    for( int r = 0; r < 4; r++ )
+      c[r] = _mm_loadu_si128( (const __m128i*)( src + 4 * i + 16 * r ) );
+    for( int k = 0; k < 4; k++ )
+    {
+      __m128i lo = _mm_packs_epi32( _mm_and_si128( _mm_srli_epi32( c[0], 8 * k ), lowByte ),
+                                    _mm_and_si128( _mm_srli_epi32( c[1], 8 * k ), lowByte ) );
+      __m128i hi = _mm_packs_epi32( _mm_and_si128( _mm_srli_epi32( c[2], 8 * k ), lowByte ),
+                                    _mm_and_si128( _mm_srli_epi32( c[3], 8 * k ), lowByte ) );
+      _mm_storeu_si128( (__m128i*)( dst[k] + i ), _mm_packus_epi16( lo, hi ) );
+    }
+  }
+  ClpByte* const tail[4] = { dst[0] + i, dst[1] + i, dst[2] + i, dst[3] + i };
+  unpackPackedGeneric<4>( src + 4 * i, tail, n - i );
+}
+
+CLP_TARGET( "sse2" )
+void packYUYV8ByteSSE2( const ClpByte* srcY, const ClpByte* srcU, const ClpByte* srcV, ClpByte* dst, std::size_t n )
+{
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m128i yA = _mm_loadu_si128( (const __m128i*)( srcY + 2 * i ) );
+    __m128i yB = _mm_loadu_si128( (const __m128i*)( srcY + 2 * i + 16 ) );
+    __m128i u = _mm_loadu_si128( (const __m128i*)( srcU + i ) );
+    __m128i v = _mm_loadu_si128( (const __m128i*)( srcV + i ) );
+    __m128i uvA = _mm_unpacklo_epi8( u, v );
+    __m128i uvB = _mm_unpackhi_epi8( u, v );
+    _mm_storeu_si128( (__m128i*)( dst + 4 * i ), _mm_unpacklo_epi8( yA, uvA ) );
+    _mm_storeu_si128( (__m128i*)( dst + 4 * i + 16 ), _mm_unpackhi_epi8( yA, uvA ) );
+    _mm_storeu_si128( (__m128i*)( dst + 4 * i + 32 ), _mm_unpacklo_epi8( yB, uvB ) );
+    _mm_storeu_si128( (__m128i*)( dst + 4 * i + 48 ), _mm_unpackhi_epi8( yB, uvB ) );
+  }
+  packYUYV8Generic( srcY + 2 * i, srcU + i, srcV + i, dst + 4 * i, n - i );
+}
+
+CLP_TARGET( "sse2" ) void packPacked4x8ByteSSE2( const ClpByte* const* src, ClpByte* dst, std::size_t n )
+{
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m128i c[4];
+    for( int k = 0; k < 4; k++ )
+      c[k] = _mm_loadu_si128( (const __m128i*)( src[k] + i ) );
+    __m128i lo01 = _mm_unpacklo_epi8( c[0], c[1] );
+    __m128i hi01 = _mm_unpackhi_epi8( c[0], c[1] );
+    __m128i lo23 = _mm_unpacklo_epi8( c[2], c[3] );
+    __m128i hi23 = _mm_unpackhi_epi8( c[2], c[3] );
+    _mm_storeu_si128( (__m128i*)( dst + 4 * i ), _mm_unpacklo_epi16( lo01, lo23 ) );
+    _mm_storeu_si128( (__m128i*)( dst + 4 * i + 16 ), _mm_unpackhi_epi16( lo01, lo23 ) );
+    _mm_storeu_si128( (__m128i*)( dst + 4 * i + 32 ), _mm_unpacklo_epi16( hi01, hi23 ) );
+    _mm_storeu_si128( (__m128i*)( dst + 4 * i + 48 ), _mm_unpackhi_epi16( hi01, hi23 ) );
+  }
+  const ClpByte* const tail[4] = { src[0] + i, src[1] + i, src[2] + i, src[3] + i };
+  packPackedGeneric<4>( tail, dst + 4 * i, n - i );
+}
+
+CLP_TARGET( "sse2" ) auto ssdByteSSE2( const ClpByte* a, const ClpByte* b, std::size_t n ) -> std::uint64_t
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc = zero;
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m128i va = _mm_loadu_si128( (const __m128i*)( a + i ) );
+    __m128i vb = _mm_loadu_si128( (const __m128i*)( b + i ) );
+    __m128i diffLo = _mm_sub_epi16( _mm_unpacklo_epi8( va, zero ), _mm_unpacklo_epi8( vb, zero ) );
+    __m128i diffHi = _mm_sub_epi16( _mm_unpackhi_epi8( va, zero ), _mm_unpackhi_epi8( vb, zero ) );
+    // 8-bit differences fit madd, each 32-bit lane holds at most 4 * 255^2
+    __m128i sq = _mm_add_epi32( _mm_madd_epi16( diffLo, diffLo ), _mm_madd_epi16( diffHi, diffHi ) );
+    acc = _mm_add_epi64( acc, _mm_unpacklo_epi32( sq, zero ) );
+    acc = _mm_add_epi64( acc, _mm_unpackhi_epi32( sq, zero ) );
+  }
+  alignas( 16 ) std::uint64_t lanes[2];
+  _mm_store_si128( (__m128i*)lanes, acc );
+  return lanes[0] + lanes[1] + ssdGeneric( a + i, b + i, n - i );
+}
+
+CLP_TARGET( "sse2" ) auto sadByteSSE2( const ClpByte* a, const ClpByte* b, std::size_t n ) -> std::uint64_t
+{
+  __m128i acc = _mm_setzero_si128();
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m128i va = _mm_loadu_si128( (const __m128i*)( a + i ) );
+    __m128i vb = _mm_loadu_si128( (const __m128i*)( b + i ) );
+    acc = _mm_add_epi64( acc, _mm_sad_epu8( va, vb ) );
+  }
+  alignas( 16 ) std::uint64_t lanes[2];
+  _mm_store_si128( (__m128i*)lanes, acc );
+  return lanes[0] + lanes[1] + sadGeneric( a + i, b + i, n - i );
+}
+
+constexpr CalypFrameKernels kSSE2Kernels{
+    .level = ClpCpuLevel::SSE2,
+    .unpack8 = unpack8SSE2,
+    .unpack16 = unpack16SSE2,
+    .unpackYUYV8 = unpackYUYV8SSE2,
+    .unpackPacked4x8 = unpackPacked4x8SSE2,
+    .pack8 = pack8SSE2,
+    .pack16 = pack16SSE2,
+    .packYUYV8 = packYUYV8SSE2,
+    .packPacked4x8 = packPacked4x8SSE2,
+    .ssd = ssdSSE2,
+    .sad = sadSSE2,
+    .unpackYUYV8Byte = unpackYUYV8ByteSSE2,
+    .unpackPacked4x8Byte = unpackPacked4x8ByteSSE2,
+    .packYUYV8Byte = packYUYV8ByteSSE2,
+    .packPacked4x8Byte = packPacked4x8ByteSSE2,
+    .ssdByte = ssdByteSSE2,
+    .sadByte = sadByteSSE2,
+};
+
+/*
+ **************************************************************
+ * SSE4.1 kernels
+ **************************************************************
+ */
+
+//! pshufb masks gathering component k of 16 packed 3-byte pixels from register r
+constexpr auto kPacked3ShuffleMasks = []() {
+  std::array<std::array<std::array<std::int8_t, 16>, 3>, 3> masks{};
+  for( int k = 0; k < 3; k++ )
+    for( int r = 0; r < 3; r++ )
+      for( int j = 0; j < 16; j++ )
+      {
+        int idx = 3 * j + k - 16 * r;
+        masks[k][r][j] = static_cast<std::int8_t>( idx >= 0 && idx < 16 ? idx : -128 );
+      }
+  return masks;
+}();
+
+//! pshufb masks scattering component k of 16 pixels into output register r
+constexpr auto kPacked3InverseShuffleMasks = []() {
+  std::array<std::array<std::array<std::int8_t, 16>, 3>, 3> masks{};
+  for( int k = 0; k < 3; k++ )
+    for( int r = 0; r < 3; r++ )
+      for( int j = 0; j < 16; j++ )
+      {
+        int pos = 16 * r + j;
+        masks[k][r][j] = static_cast<std::int8_t>( pos % 3 == k ? pos / 3 : -128 );
+      }
+  return masks;
+}();
+
+CLP_TARGET( "sse4.1" ) void unpackPacked3x8SSE41( const ClpByte* src, ClpPel* const* dst, std::size_t n )
+{
+  __m128i masks[3][3];
+  for( int k = 0; k < 3; k++ )
+    for( int r = 0; r < 3; r++ )
+      masks[k][r] = _mm_loadu_si128( (const __m128i*)kPacked3ShuffleMasks[k][r].data() );
+
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m128i a = _mm_loadu_si128( (const __m128i*)( src + 3 * i ) );
+    __m128i b = _mm_loadu_si128( (const __m128i*)( src + 3 * i + 16 ) );
+    __m128i c = _mm_loadu_si128( (const __m128i*)( src + 3 * i + 32 ) );
+    for( int k = 0; k < 3; k++ )
+    {
+      __m128i comp = _mm_or_si128( _mm_shuffle_epi8( a, masks[k][0] ), _mm_shuffle_epi8( b, masks[k][1] ) );
+      comp = _mm_or_si128( comp, _mm_shuffle_epi8( c, masks[k][2] ) );
+      _mm_storeu_si128( (__m128i*)( dst[k] + i ), _mm_cvtepu8_epi16( comp ) );
+      _mm_storeu_si128( (__m128i*)( dst[k] + i + 8 ), _mm_cvtepu8_epi16( _mm_srli_si128( comp, 8 ) ) );
+    }
+  }
+  ClpPel* const tail[3] = { dst[0] + i, dst[1] + i, dst[2] + i };
+  unpackPackedGeneric<3>( src + 3 * i, tail, n - i );
+}
+
+CLP_TARGET( "sse4.1" ) void packPacked3x8SSE41( const ClpPel* const* src, ClpByte* dst, std::size_t n )
+{
+  __m128i masks[3][3];
+  for( int k = 0; k < 3; k++ )
+    for( int r = 0; r < 3; r++ )
+      masks[k][r] = _mm_loadu_si128( (const __m128i*)kPacked3InverseShuffleMasks[k][r].data() );
+
+  const __m128i lowByte = _mm_set1_epi16( 0x00FF );
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m128i comp[3];
+    for( int k = 0; k < 3; k++ )
+    {
+      __m128i a = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( src[k] + i ) ), lowByte );
+      __m128i b = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( src[k] + i + 8 ) ), lowByte );
+      comp[k] = _mm_packus_epi16( a, b );
+    }
+    for( int r = 0; r < 3; r++ )
+    {
+      __m128i out = _mm_or_si128( _mm_shuffle_epi8( comp[0], masks[0][r] ), _mm_shuffle_epi8( comp[1], masks[1][r] ) );
+      out = _mm_or_si128( out, _mm_shuffle_epi8( comp[2], masks[2][r] ) );
+      _mm_storeu_si128( (__m128i*)( dst + 3 * i + 16 * r ), out );
+    }
+  }
+  const ClpPel* const tail[3] = { src[0] + i, src[1] + i, src[2] + i };
+  packPackedGeneric<3>( tail, dst + 3 * i, n - i );
+}
+
+//! Load 4 samples as 32-bit lanes
+CLP_TARGET( "sse4.1" ) inline __m128i loadSamples4( const ClpPel* src )
+{
+  return _mm_cvtepu16_epi32( _mm_loadl_epi64( (const __m128i*)src ) );
+}
+CLP_TARGET( "sse4.1" ) inline __m128i loadSamples4( const ClpByte* src )
+{
+  std::int32_t quad;
+  std::memcpy( &quad, src, sizeof( quad ) );
+  return _mm_cvtepu8_epi32( _mm_cvtsi32_si128( quad ) );
+}
+
+//! Load the chroma samples of 4 pixels (2 samples repeated when L = 1)
+template <unsigned L>
+CLP_TARGET( "sse4.1" ) inline __m128i loadChroma4( const ClpPel* src )
+{
+  if constexpr( L == 0 )
+    return loadSamples4( src );
+  std::int32_t pair;
+  std::memcpy( &pair, src, sizeof( pair ) );
+  __m128i c = _mm_cvtsi32_si128( pair );
+  return _mm_cvtepu16_epi32( _mm_unpacklo_epi16( c, c ) );
+}
+template <unsigned L>
+CLP_TARGET( "sse4.1" ) inline __m128i loadChroma4( const ClpByte* src )
+{
+  if constexpr( L == 0 )
+    return loadSamples4( src );
+  std::int16_t pair;
+  std::memcpy( &pair, src, sizeof( pair ) );
+  __m128i c = _mm_cvtsi32_si128( pair );
+  return _mm_cvtepu8_epi32( _mm_unpacklo_epi8( c, c ) );
+}
+
+//! CalypYuvToRgbCoeffs in 32-bit lanes
+struct YuvToRgbCoeffs4
+{
+  __m128i lumaOffset, chromaOffset, luma, crR, cbG, crG, cbB, round, shift;
+};
+
+CLP_TARGET( "sse4.1" ) inline auto loadYuvToRgbCoeffs4( const CalypYuvToRgbCoeffs& c ) -> YuvToRgbCoeffs4
+{
+  return { _mm_set1_epi32( c.lumaOffset ), _mm_set1_epi32( c.chromaOffset ), _mm_set1_epi32( c.luma ),
+           _mm_set1_epi32( c.crR ),        _mm_set1_epi32( c.cbG ),          _mm_set1_epi32( c.crG ),
+           _mm_set1_epi32( c.cbB ),        _mm_set1_epi32( 1 << ( c.shift - 1 ) ), _mm_cvtsi32_si128( c.shift ) };
+}
+
+//! Conversion of 4 pixels (same arithmetic as yuvToArgbPel)
+CLP_TARGET( "sse4.1" ) inline __m128i argbFromYuv4( __m128i y, __m128i u, __m128i v, const YuvToRgbCoeffs4& c )
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i max = _mm_set1_epi32( 255 );
+  const __m128i alpha = _mm_set1_epi32( static_cast<int>( 0xFF000000 ) );
+  y = _mm_add_epi32( _mm_mullo_epi32( _mm_sub_epi32( y, c.lumaOffset ), c.luma ), c.round );
+  u = _mm_sub_epi32( u, c.chromaOffset );
+  v = _mm_sub_epi32( v, c.chromaOffset );
+  __m128i r = _mm_sra_epi32( _mm_add_epi32( y, _mm_mullo_epi32( v, c.crR ) ), c.shift );
+  __m128i uv = _mm_add_epi32( _mm_mullo_epi32( u, c.cbG ), _mm_mullo_epi32( v, c.crG ) );
+  __m128i g = _mm_sra_epi32( _mm_sub_epi32( y, uv ), c.shift );
+  __m128i b = _mm_sra_epi32( _mm_add_epi32( y, _mm_mullo_epi32( u, c.cbB ) ), c.shift );
+  r = _mm_min_epi32( _mm_max_epi32( r, zero ), max );
+  g = _mm_min_epi32( _mm_max_epi32( g, zero ), max );
+  b = _mm_min_epi32( _mm_max_epi32( b, zero ), max );
+  return _mm_or_si128( _mm_or_si128( alpha, _mm_slli_epi32( r, 16 ) ), _mm_or_si128( _mm_slli_epi32( g, 8 ), b ) );
+}
+
+//! Row conversion for chroma subsampled horizontally by 2^L
+template <unsigned L, typename T>
+CLP_TARGET( "sse4.1" )
+void yuvToArgbRowSSE41( const T* srcY, const T* srcU, const T* srcV, std::uint32_t* dst, std::size_t width,
+                        const CalypYuvToRgbCoeffs& coeffs )
+{
+  const YuvToRgbCoeffs4 c = loadYuvToRgbCoeffs4( coeffs );
+  std::size_t x = 0;
+  for( ; x + 4 <= width; x += 4 )
+  {
+    __m128i y = loadSamples4( srcY + x );
+    __m128i u = loadChroma4<L>( srcU + ( x >> L ) );
+    __m128i v = loadChroma4<L>( srcV + ( x >> L ) );
+    _mm_storeu_si128( (__m128i*)( dst + x ), argbFromYuv4( y, u, v, c ) );
+  }
+  yuvToArgbGeneric( srcY + x, srcU + ( x >> L ), srcV + ( x >> L ), dst + x, width - x, L, coeffs );
+}
+
+template <typename T>
+CLP_TARGET( "sse4.1" )
+void yuvToArgbSSE41( const T* srcY, const T* srcU, const T* srcV, std::uint32_t* dst, std::size_t width,
+                     unsigned log2ChromaWidth, const CalypYuvToRgbCoeffs& coeffs )
+{
+  switch( log2ChromaWidth )
+  {
+  case 0:
+    return yuvToArgbRowSSE41<0>( srcY, srcU, srcV, dst, width, coeffs );
+  case 1:
+    return yuvToArgbRowSSE41<1>( srcY, srcU, srcV, dst, width, coeffs );
+  default:
+    return yuvToArgbGeneric( srcY, srcU, srcV, dst, width, log2ChromaWidth, coeffs );
+  }
+}
+
+/**
+ * ( 299 R + 587 G + 114 B + 500 ) / 1000 of 4 pixels. The numerator is
+ * divided by 8 and then by 125, multiplying by ceil( 2^32 / 125 ) (exact
+ * for numerators below 2^26, i.e., 16 bits samples)
+ */
+CLP_TARGET( "sse4.1" ) inline __m128i lumaFromRgb4( __m128i r, __m128i g, __m128i b )
+{
+  const __m128i magic = _mm_set1_epi32( 34359739 );
+  __m128i x = _mm_add_epi32( _mm_mullo_epi32( r, _mm_set1_epi32( 299 ) ), _mm_mullo_epi32( g, _mm_set1_epi32( 587 ) ) );
+  x = _mm_add_epi32( x, _mm_add_epi32( _mm_mullo_epi32( b, _mm_set1_epi32( 114 ) ), _mm_set1_epi32( 500 ) ) );
+  x = _mm_srli_epi32( x, 3 );
+  __m128i even = _mm_srli_epi64( _mm_mul_epu32( x, magic ), 32 );
+  __m128i odd = _mm_mul_epu32( _mm_srli_epi64( x, 32 ), magic );
+  return _mm_blend_epi16( even, odd, 0xCC );
+}
+
+template <typename T>
+CLP_TARGET( "sse4.1" )
+void rgbToLumaSSE41( const T* srcR, const T* srcG, const T* srcB, T* dst, std::size_t n )
+{
+  std::size_t i = 0;
+  for( ; i + 4 <= n; i += 4 )
+  {
+    __m128i luma = lumaFromRgb4( loadSamples4( srcR + i ), loadSamples4( srcG + i ), loadSamples4( srcB + i ) );
+    luma = _mm_packus_epi32( luma, luma );
+    if constexpr( std::is_same_v<T, ClpByte> )
+    {
+      const std::int32_t quad = _mm_cvtsi128_si32( _mm_packus_epi16( luma, luma ) );
+      std::memcpy( dst + i, &quad, sizeof( quad ) );
+    }
+    else
+    {
+      _mm_storel_epi64( (__m128i*)( dst + i ), luma );
+    }
+  }
+  rgbToLumaGeneric( srcR + i, srcG + i, srcB + i, dst + i, n - i );
+}
+
+CLP_TARGET( "sse4.1" ) void unpackPacked3x8ByteSSE41( const ClpByte* src, ClpByte* const* dst, std::size_t n )
+{
+  __m128i masks[3][3];
+  for( int k = 0; k < 3; k++ )
+    for( int r = 0; r < 3; r++ )
+      masks[k][r] = _mm_loadu_si128( (const __m128i*)kPacked3ShuffleMasks[k][r].data() );
+
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m128i a = _mm_loadu_si128( (const __m128i*)( src + 3 * i ) );
+    __m128i b = _mm_loadu_si128( (const __m128i*)( src + 3 * i + 16 ) );
+    __m128i c = _mm_loadu_si128( (const __m128i*)( src + 3 * i + 32 ) );
+    for( int k = 0; k < 3; k++ )
+    {
+      __m128i comp = _mm_or_si128( _mm_shuffle_epi8( a, masks[k][0] ), _mm_shuffle_epi8( b, masks[k][1] ) );
+      _mm_storeu_si128( (__m128i*)( dst[k] + i ), _mm_or_si128( comp, _mm_shuffle_epi8( c, masks[k][2] ) ) );
+    }
+  }
+  ClpByte* const tail[3] = { dst[0] + i, dst[1] + i, dst[2] + i };
+  unpackPackedGeneric<3>( src + 3 * i, tail, n - i );
+}
+
+CLP_TARGET( "sse4.1" ) void packPacked3x8ByteSSE41( const ClpByte* const* src, ClpByte* dst, std::size_t n )
+{
+  __m128i masks[3][3];
+  for( int k = 0; k < 3; k++ )
+    for( int r = 0; r < 3; r++ )
+      masks[k][r] = _mm_loadu_si128( (const __m128i*)kPacked3InverseShuffleMasks[k][r].data() );
+
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m128i comp[3];
+    for( int k = 0; k < 3; k++ )
+      comp[k] = _mm_loadu_si128( (const __m128i*)( src[k] + i ) );
+    for( int r = 0; r < 3; r++ )
+    {
+      __m128i out = _mm_or_si128( _mm_shuffle_epi8( comp[0], masks[0][r] ), _mm_shuffle_epi8( comp[1], masks[1][r] ) );
+      out = _mm_or_si128( out, _mm_shuffle_epi8( comp[2], masks[2][r] ) );
+      _mm_storeu_si128( (__m128i*)( dst + 3 * i + 16 * r ), out );
+    }
+  }
+  const ClpByte* const tail[3] = { src[0] + i, src[1] + i, src[2] + i };
+  packPackedGeneric<3>( tail, dst + 3 * i, n - i );
+}
+
+constexpr CalypFrameKernels kSSE41Kernels{
+    .level = ClpCpuLevel::SSE41,
+    .unpackPacked3x8 = unpackPacked3x8SSE41,
+    .packPacked3x8 = packPacked3x8SSE41,
+    .yuvToArgb = yuvToArgbSSE41<ClpPel>,
+    .rgbToLuma = rgbToLumaSSE41<ClpPel>,
+    .unpackPacked3x8Byte = unpackPacked3x8ByteSSE41,
+    .packPacked3x8Byte = packPacked3x8ByteSSE41,
+    .yuvToArgbByte = yuvToArgbSSE41<ClpByte>,
+    .rgbToLumaByte = rgbToLumaSSE41<ClpByte>,
+};
+
+/*
+ **************************************************************
+ * AVX2 kernels
+ **************************************************************
+ */
+
+CLP_TARGET( "avx2" ) void unpack8AVX2( const ClpByte* src, ClpPel* dst, std::size_t n )
+{
+  std::size_t i = 0;
+  for( ; i + 32 <= n; i += 32 )
+  {
+    __m128i a = _mm_loadu_si128( (const __m128i*)( src + i ) );
+    __m128i b = _mm_loadu_si128( (const __m128i*)( src + i + 16 ) );
+    _mm256_storeu_si256( (__m256i*)( dst + i ), _mm256_cvtepu8_epi16( a ) );
+    _mm256_storeu_si256( (__m256i*)( dst + i + 16 ), _mm256_cvtepu8_epi16( b ) );
+  }
+  unpack8Generic( src + i, dst + i, n - i );
+}
+
+CLP_TARGET( "avx2" ) void unpack16AVX2( const ClpByte* src, ClpPel* dst, std::size_t n, bool bigEndian, ClpPel maxval )
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i max = _mm256_set1_epi16( static_cast<short>( maxval ) );
+  const __m256i swap = _mm256_setr_epi8( 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,  //
+                                         1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 );
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m256i v = _mm256_loadu_si256( (const __m256i*)( src + 2 * i ) );
+    if( bigEndian )
+      v = _mm256_shuffle_epi8( v, swap );
+    __m256i keep = _mm256_cmpeq_epi16( _mm256_subs_epu16( v, max ), zero );
+    _mm256_storeu_si256( (__m256i*)( dst + i ), _mm256_and_si256( v, keep ) );
+  }
+  unpack16Generic( src + 2 * i, dst + i, n - i, bigEndian, maxval );
+}
+
+CLP_TARGET( "avx2" )
+void unpackYUYV8AVX2( const ClpByte* src, ClpPel* dstY, ClpPel* dstU, ClpPel* dstV, std::size_t n )
+{
+  const __m256i lowByte = _mm256_set1_epi16( 0x00FF );
+  const __m256i lowWord = _mm256_set1_epi32( 0x0000FFFF );
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m256i a = _mm256_loadu_si256( (const __m256i*)( src + 4 * i ) );
+    __m256i b = _mm256_loadu_si256( (const __m256i*)( src + 4 * i + 32 ) );
+    _mm256_storeu_si256( (__m256i*)( dstY + 2 * i ), _mm256_and_si256( a, lowByte ) );
+    _mm256_storeu_si256( (__m256i*)( dstY + 2 * i + 16 ), _mm256_and_si256( b, lowByte ) );
+    __m256i uvA = _mm256_srli_epi16( a, 8 );
+    __m256i uvB = _mm256_srli_epi16( b, 8 );
+    // packs works per 128-bit lane, restore the order of the 64-bit blocks
+    __m256i u = _mm256_packs_epi32( _mm256_and_si256( uvA, lowWord ), _mm256_and_si256( uvB, lowWord ) );
+    __m256i v = _mm256_packs_epi32( _mm256_srli_epi32( uvA, 16 ), _mm256_srli_epi32( uvB, 16 ) );
+    _mm256_storeu_si256( (__m256i*)( dstU + i ), _mm256_permute4x64_epi64( u, 0xD8 ) );
+    _mm256_storeu_si256( (__m256i*)( dstV + i ), _mm256_permute4x64_epi64( v, 0xD8 ) );
+  }
+  unpackYUYV8SSE2( src + 4 * i, dstY + 2 * i, dstU + i, dstV + i, n - i );
+}
+
+CLP_TARGET( "avx2" ) void unpackPacked3x8AVX2( const ClpByte* src, ClpPel* const* dst, std::size_t n )
+{
+  __m128i masks[3][3];
+  for( int k = 0; k < 3; k++ )
+    for( int r = 0; r < 3; r++ )
+      masks[k][r] = _mm_loadu_si128( (const __m128i*)kPacked3ShuffleMasks[k][r].data() );
+
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m128i a = _mm_loadu_si128( (const __m128i*)( src + 3 * i ) );
+    __m128i b = _mm_loadu_si128( (const __m128i*)( src + 3 * i + 16 ) );
+    __m128i c = _mm_loadu_si128( (const __m128i*)( src + 3 * i + 32 ) );
+    for( int k = 0; k < 3; k++ )
+    {
+      __m128i comp = _mm_or_si128( _mm_shuffle_epi8( a, masks[k][0] ), _mm_shuffle_epi8( b, masks[k][1] ) );
+      comp = _mm_or_si128( comp, _mm_shuffle_epi8( c, masks[k][2] ) );
+      _mm256_storeu_si256( (__m256i*)( dst[k] + i ), _mm256_cvtepu8_epi16( comp ) );
+    }
+  }
+  ClpPel* const tail[3] = { dst[0] + i, dst[1] + i, dst[2] + i };
+  unpackPackedGeneric<3>( src + 3 * i, tail, n - i );
+}
+
+CLP_TARGET( "avx2" ) void unpackPacked4x8AVX2( const ClpByte* src, ClpPel* const* dst, std::size_t n )
+{
+  const __m256i lowByte = _mm256_set1_epi32( 0xFF );
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m256i a = _mm256_loadu_si256( (const __m256i*)( src + 4 * i ) );
+    __m256i b = _mm256_loadu_si256( (const __m256i*)( src + 4 * i + 32 ) );
+    for( int k = 0; k < 4; k++ )
+    {
+      __m256i compA = _mm256_and_si256( _mm256_srli_epi32( a, 8 * k ), lowByte );
+      __m256i compB = _mm256_and_si256( _mm256_srli_epi32( b, 8 * k ), lowByte );
+      _mm256_storeu_si256( (__m256i*)( dst[k] + i ),
+                           _mm256_permute4x64_epi64( _mm256_packs_epi32( compA, compB ), 0xD8 ) );
+    }
+  }
+  ClpPel* const tail[4] = { dst[0] + i, dst[1] + i, dst[2] + i, dst[3] + i };
+  unpackPacked4x8SSE2( src + 4 * i, tail, n - i );
+}
+
+CLP_TARGET( "avx2" ) void pack8AVX2( const ClpPel* src, ClpByte* dst, std::size_t n )
+{
+  const __m256i lowByte = _mm256_set1_epi16( 0x00FF );
+  std::size_t i = 0;
+  for( ; i + 32 <= n; i += 32 )
+  {
+    __m256i a = _mm256_and_si256( _mm256_loadu_si256( (const __m256i*)( src + i ) ), lowByte );
+    __m256i b = _mm256_and_si256( _mm256_loadu_si256( (const __m256i*)( src + i + 16 ) ), lowByte );
+    _mm256_storeu_si256( (__m256i*)( dst + i ), _mm256_permute4x64_epi64( _mm256_packus_epi16( a, b ), 0xD8 ) );
+  }
+  pack8SSE2( src + i, dst + i, n - i );
+}
+
+CLP_TARGET( "avx2" ) void pack16AVX2( const ClpPel* src, ClpByte* dst, std::size_t n, bool bigEndian )
+{
+  const __m256i swap = _mm256_setr_epi8( 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,  //
+                                         1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 );
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m256i v = _mm256_loadu_si256( (const __m256i*)( src + i ) );
+    if( bigEndian )
+      v = _mm256_shuffle_epi8( v, swap );
+    _mm256_storeu_si256( (__m256i*)( dst + 2 * i ), v );
+  }
+  pack16Generic( src + i, dst + 2 * i, n - i, bigEndian );
+}
+
+CLP_TARGET( "avx2" )
+void packYUYV8AVX2( const ClpPel* srcY, const ClpPel* srcU, const ClpPel* srcV, ClpByte* dst, std::size_t n )
+{
+  const __m256i lowByte = _mm256_set1_epi16( 0x00FF );
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m256i yA = _mm256_and_si256( _mm256_loadu_si256( (const __m256i*)( srcY + 2 * i ) ), lowByte );
+    __m256i yB = _mm256_and_si256( _mm256_loadu_si256( (const __m256i*)( srcY + 2 * i + 16 ) ), lowByte );
+    __m256i u = _mm256_and_si256( _mm256_loadu_si256( (const __m256i*)( srcU + i ) ), lowByte );
+    __m256i v = _mm256_and_si256( _mm256_loadu_si256( (const __m256i*)( srcV + i ) ), lowByte );
+    // unpack works per 128-bit lane, regroup U0..7 and U8..15 before merging with luma
+    __m256i uvLo = _mm256_unpacklo_epi16( u, v );
+    __m256i uvHi = _mm256_unpackhi_epi16( u, v );
+    __m256i uvA = _mm256_permute2x128_si256( uvLo, uvHi, 0x20 );
+    __m256i uvB = _mm256_permute2x128_si256( uvLo, uvHi, 0x31 );
+    _mm256_storeu_si256( (__m256i*)( dst + 4 * i ), _mm256_or_si256( yA, _mm256_slli_epi16( uvA, 8 ) ) );
+    _mm256_storeu_si256( (__m256i*)( dst + 4 * i + 32 ), _mm256_or_si256( yB, _mm256_slli_epi16( uvB, 8 ) ) );
+  }
+  packYUYV8SSE2( srcY + 2 * i, srcU + i, srcV + i, dst + 4 * i, n - i );
+}
+
+CLP_TARGET( "avx2" ) void packPacked3x8AVX2( const ClpPel* const* src, ClpByte* dst, std::size_t n )
+{
+  __m128i masks[3][3];
+  for( int k = 0; k < 3; k++ )
+    for( int r = 0; r < 3; r++ )
+      masks[k][r] = _mm_loadu_si128( (const __m128i*)kPacked3InverseShuffleMasks[k][r].data() );
+
+  const __m128i lowByte = _mm_set1_epi16( 0x00FF );
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m128i comp[3];
+    for( int k = 0; k < 3; k++ )
+    {
+      __m128i a = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( src[k] + i ) ), lowByte );
+      __m128i b = _mm_and_si128( _mm_loadu_si128( (const __m128i*)( src[k] + i + 8 ) ), lowByte );
+      comp[k] = _mm_packus_epi16( a, b );
+    }
+    for( int r = 0; r < 3; r++ )
+    {
+      __m128i out = _mm_or_si128( _mm_shuffle_epi8( comp[0], masks[0][r] ), _mm_shuffle_epi8( comp[1], masks[1][r] ) );
+      out = _mm_or_si128( out, _mm_shuffle_epi8( comp[2], masks[2][r] ) );
+      _mm_storeu_si128( (__m128i*)( dst + 3 * i + 16 * r ), out );
+    }
+  }
+  const ClpPel* const tail[3] = { src[0] + i, src[1] + i, src[2] + i };
+  packPackedGeneric<3>( tail, dst + 3 * i, n - i );
+}
+
+//! Load 8 samples as 32-bit lanes
+CLP_TARGET( "avx2" ) inline __m256i loadSamples8( const ClpPel* src )
+{
+  return _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i*)src ) );
+}
+CLP_TARGET( "avx2" ) inline __m256i loadSamples8( const ClpByte* src )
+{
+  return _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)src ) );
+}
+
+//! Load the chroma samples of 8 pixels (4 samples repeated when L = 1)
+template <unsigned L>
+CLP_TARGET( "avx2" ) inline __m256i loadChroma8( const ClpPel* src )
+{
+  if constexpr( L == 0 )
+    return loadSamples8( src );
+  __m128i c = _mm_loadl_epi64( (const __m128i*)src );
+  return _mm256_cvtepu16_epi32( _mm_unpacklo_epi16( c, c ) );
+}
+template <unsigned L>
+CLP_TARGET( "avx2" ) inline __m256i loadChroma8( const ClpByte* src )
+{
+  if constexpr( L == 0 )
+    return loadSamples8( src );
+  std::int32_t quad;
+  std::memcpy( &quad, src, sizeof( quad ) );
+  __m128i c = _mm_cvtsi32_si128( quad );
+  return _mm256_cvtepu8_epi32( _mm_unpacklo_epi8( c, c ) );
+}
+
+//! CalypYuvToRgbCoeffs in 32-bit lanes
+struct YuvToRgbCoeffs8
+{
+  __m256i lumaOffset, chromaOffset, luma, crR, cbG, crG, cbB, round;
+  __m128i shift;
+};
+
+CLP_TARGET( "avx2" ) inline auto loadYuvToRgbCoeffs8( const CalypYuvToRgbCoeffs& c ) -> YuvToRgbCoeffs8
+{
+  return { _mm256_set1_epi32( c.lumaOffset ),
+           _mm256_set1_epi32( c.chromaOffset ),
+           _mm256_set1_epi32( c.luma ),
+           _mm256_set1_epi32( c.crR ),
+           _mm256_set1_epi32( c.cbG ),
+           _mm256_set1_epi32( c.crG ),
+           _mm256_set1_epi32( c.cbB ),
+           _mm256_set1_epi32( 1 << ( c.shift - 1 ) ),
+           _mm_cvtsi32_si128( c.shift ) };
+}
+
+//! Conversion of 8 pixels (same arithmetic as yuvToArgbPel)
+CLP_TARGET( "avx2" ) inline __m256i argbFromYuv8( __m256i y, __m256i u, __m256i v, const YuvToRgbCoeffs8& c )
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i max = _mm256_set1_epi32( 255 );
+  const __m256i alpha = _mm256_set1_epi32( static_cast<int>( 0xFF000000 ) );
+  y = _mm256_add_epi32( _mm256_mullo_epi32( _mm256_sub_epi32( y, c.lumaOffset ), c.luma ), c.round );
+  u = _mm256_sub_epi32( u, c.chromaOffset );
+  v = _mm256_sub_epi32( v, c.chromaOffset );
+  __m256i r = _mm256_sra_epi32( _mm256_add_epi32( y, _mm256_mullo_epi32( v, c.crR ) ), c.shift );
+  __m256i uv = _mm256_add_epi32( _mm256_mullo_epi32( u, c.cbG ), _mm256_mullo_epi32( v, c.crG ) );
+  __m256i g = _mm256_sra_epi32( _mm256_sub_epi32( y, uv ), c.shift );
+  __m256i b = _mm256_sra_epi32( _mm256_add_epi32( y, _mm256_mullo_epi32( u, c.cbB ) ), c.shift );
+  r = _mm256_min_epi32( _mm256_max_epi32( r, zero ), max );
+  g = _mm256_min_epi32( _mm256_max_epi32( g, zero ), max );
+  b = _mm256_min_epi32( _mm256_max_epi32( b, zero ), max );
+  return _mm256_or_si256( _mm256_or_si256( alpha, _mm256_slli_epi32( r, 16 ) ),
+                          _mm256_or_si256( _mm256_slli_epi32( g, 8 ), b ) );
+}
+
+//! Row conversion for chroma subsampled horizontally by 2^L
+template <unsigned L, typename T>
+CLP_TARGET( "avx2" )
+void yuvToArgbRowAVX2( const T* srcY, const T* srcU, const T* srcV, std::uint32_t* dst, std::size_t width,
+                       const CalypYuvToRgbCoeffs& coeffs )
+{
+  const YuvToRgbCoeffs8 c = loadYuvToRgbCoeffs8( coeffs );
+  std::size_t x = 0;
+  for( ; x + 8 <= width; x += 8 )
+  {
+    __m256i y = loadSamples8( srcY + x );
+    __m256i u = loadChroma8<L>( srcU + ( x >> L ) );
+    __m256i v = loadChroma8<L>( srcV + ( x >> L ) );
+    _mm256_storeu_si256( (__m256i*)( dst + x ), argbFromYuv8( y, u, v, c ) );
+  }
+  yuvToArgbRowSSE41<L>( srcY + x, srcU + ( x >> L ), srcV + ( x >> L ), dst + x, width - x, coeffs );
+}
+
+template <typename T>
+CLP_TARGET( "avx2" )
+void yuvToArgbAVX2( const T* srcY, const T* srcU, const T* srcV, std::uint32_t* dst, std::size_t width,
+                    unsigned log2ChromaWidth, const CalypYuvToRgbCoeffs& coeffs )
+{
+  switch( log2ChromaWidth )
+  {
+  case 0:
+    return yuvToArgbRowAVX2<0>( srcY, srcU, srcV, dst, width, coeffs );
+  case 1:
+    return yuvToArgbRowAVX2<1>( srcY, srcU, srcV, dst, width, coeffs );
+  default:
+    return yuvToArgbGeneric( srcY, srcU, srcV, dst, width, log2ChromaWidth, coeffs );
+  }
+}
+
+//! Luma of 8 pixels (see lumaFromRgb4)
+CLP_TARGET( "avx2" ) inline __m256i lumaFromRgb8( __m256i r, __m256i g, __m256i b )
+{
+  const __m256i magic = _mm256_set1_epi32( 34359739 );
+  __m256i x = _mm256_add_epi32( _mm256_mullo_epi32( r, _mm256_set1_epi32( 299 ) ),
+                                _mm256_mullo_epi32( g, _mm256_set1_epi32( 587 ) ) );
+  x = _mm256_add_epi32( x, _mm256_add_epi32( _mm256_mullo_epi32( b, _mm256_set1_epi32( 114 ) ),
+                                             _mm256_set1_epi32( 500 ) ) );
+  x = _mm256_srli_epi32( x, 3 );
+  __m256i even = _mm256_srli_epi64( _mm256_mul_epu32( x, magic ), 32 );
+  __m256i odd = _mm256_mul_epu32( _mm256_srli_epi64( x, 32 ), magic );
+  return _mm256_blend_epi32( even, odd, 0xAA );
+}
+
+template <typename T>
+CLP_TARGET( "avx2" )
+void rgbToLumaAVX2( const T* srcR, const T* srcG, const T* srcB, T* dst, std::size_t n )
+{
+  std::size_t i = 0;
+  for( ; i + 8 <= n; i += 8 )
+  {
+    __m256i luma = lumaFromRgb8( loadSamples8( srcR + i ), loadSamples8( srcG + i ), loadSamples8( srcB + i ) );
+    __m128i packed = _mm_packus_epi32( _mm256_castsi256_si128( luma ), _mm256_extracti128_si256( luma, 1 ) );
+    if constexpr( std::is_same_v<T, ClpByte> )
+      _mm_storel_epi64( (__m128i*)( dst + i ), _mm_packus_epi16( packed, packed ) );
+    else
+      _mm_storeu_si128( (__m128i*)( dst + i ), packed );
+  }
+  rgbToLumaSSE41( srcR + i, srcG + i, srcB + i, dst + i, n - i );
+}
+
+CLP_TARGET( "avx2" ) auto ssdAVX2( const ClpPel* a, const ClpPel* b, std::size_t n ) -> std::uint64_t
+{
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i acc = zero;
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m256i va = _mm256_loadu_si256( (const __m256i*)( a + i ) );
+    __m256i vb = _mm256_loadu_si256( (const __m256i*)( b + i ) );
+    __m256i diff = _mm256_or_si256( _mm256_subs_epu16( va, vb ), _mm256_subs_epu16( vb, va ) );
+    __m256i lo = _mm256_mullo_epi16( diff, diff );
+    __m256i hi = _mm256_mulhi_epu16( diff, diff );
+    __m256i sq0 = _mm256_unpacklo_epi16( lo, hi );
+    __m256i sq1 = _mm256_unpackhi_epi16( lo, hi );
+    acc = _mm256_add_epi64( acc, _mm256_unpacklo_epi32( sq0, zero ) );
+    acc = _mm256_add_epi64( acc, _mm256_unpackhi_epi32( sq0, zero ) );
+    acc = _mm256_add_epi64( acc, _mm256_unpacklo_epi32( sq1, zero ) );
+    acc = _mm256_add_epi64( acc, _mm256_unpackhi_epi32( sq1, zero ) );
+  }
+  alignas( 32 ) std::uint64_t lanes[4];
+  _mm256_store_si256( (__m256i*)lanes, acc );
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + ssdSSE2( a + i, b + i, n - i );
+}
+
+CLP_TARGET( "avx2" ) auto ssdByteAVX2( const ClpByte* a, const ClpByte* b, std::size_t n ) -> std::uint64_t
+{
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i acc = zero;
+  std::size_t i = 0;
+  for( ; i + 32 <= n; i += 32 )
+  {
+    __m256i va = _mm256_loadu_si256( (const __m256i*)( a + i ) );
+    __m256i vb = _mm256_loadu_si256( (const __m256i*)( b + i ) );
+    __m256i diffLo = _mm256_sub_epi16( _mm256_unpacklo_epi8( va, zero ), _mm256_unpacklo_epi8( vb, zero ) );
+    __m256i diffHi = _mm256_sub_epi16( _mm256_unpackhi_epi8( va, zero ), _mm256_unpackhi_epi8( vb, zero ) );
+    __m256i sq = _mm256_add_epi32( _mm256_madd_epi16( diffLo, diffLo ), _mm256_madd_epi16( diffHi, diffHi ) );
+    acc = _mm256_add_epi64( acc, _mm256_unpacklo_epi32( sq, zero ) );
+    acc = _mm256_add_epi64( acc, _mm256_unpackhi_epi32( sq, zero ) );
+  }
+  alignas( 32 ) std::uint64_t lanes[4];
+  _mm256_store_si256( (__m256i*)lanes, acc );
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + ssdByteSSE2( a + i, b + i, n - i );
+}
+
+CLP_TARGET( "avx2" )
+auto ssdWeightedAVX2( const ClpPel* a, const ClpPel* b, const ClpPel* weights, std::size_t n ) -> std::uint64_t
+{
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i acc = zero;
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m256i va = _mm256_loadu_si256( (const __m256i*)( a + i ) );
+    __m256i vb = _mm256_loadu_si256( (const __m256i*)( b + i ) );
+    __m256i vw = _mm256_loadu_si256( (const __m256i*)( weights + i ) );
+    __m256i diff = _mm256_or_si256( _mm256_subs_epu16( va, vb ), _mm256_subs_epu16( vb, va ) );
+    __m256i lo = _mm256_mullo_epi16( diff, diff );
+    __m256i hi = _mm256_mulhi_epu16( diff, diff );
+    // 32 bits squares times 16 bits weights, as 64 bits products of the even and odd lanes
+    const __m256i sq[2] = { _mm256_unpacklo_epi16( lo, hi ), _mm256_unpackhi_epi16( lo, hi ) };
+    const __m256i w[2] = { _mm256_unpacklo_epi16( vw, zero ), _mm256_unpackhi_epi16( vw, zero ) };
+    for( int k = 0; k < 2; k++ )
+    {
+      acc = _mm256_add_epi64( acc, _mm256_mul_epu32( sq[k], w[k] ) );
+      acc = _mm256_add_epi64( acc, _mm256_mul_epu32( _mm256_srli_epi64( sq[k], 32 ), _mm256_srli_epi64( w[k], 32 ) ) );
+    }
+  }
+  alignas( 32 ) std::uint64_t lanes[4];
+  _mm256_store_si256( (__m256i*)lanes, acc );
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + ssdWeightedGeneric( a + i, b + i, weights + i, n - i );
+}
+
+CLP_TARGET( "avx2" ) auto sadAVX2( const ClpPel* a, const ClpPel* b, std::size_t n ) -> std::uint64_t
+{
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i acc = zero;
+  std::size_t i = 0;
+  for( ; i + 16 <= n; i += 16 )
+  {
+    __m256i va = _mm256_loadu_si256( (const __m256i*)( a + i ) );
+    __m256i vb = _mm256_loadu_si256( (const __m256i*)( b + i ) );
+    __m256i diff = _mm256_or_si256( _mm256_subs_epu16( va, vb ), _mm256_subs_epu16( vb, va ) );
+    __m256i sum = _mm256_add_epi32( _mm256_unpacklo_epi16( diff, zero ), _mm256_unpackhi_epi16( diff, zero ) );
+    acc = _mm256_add_epi64( acc, _mm256_unpacklo_epi32( sum, zero ) );
+    acc = _mm256_add_epi64( acc, _mm256_unpackhi_epi32( sum, zero ) );
+  }
+  alignas( 32 ) std::uint64_t lanes[4];
+  _mm256_store_si256( (__m256i*)lanes, acc );
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sadSSE2( a + i, b + i, n - i );
+}
+
+CLP_TARGET( "avx2" ) auto sadByteAVX2( const ClpByte* a, const ClpByte* b, std::size_t n ) -> std::uint64_t
+{
+  __m256i acc = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for( ; i + 32 <= n; i += 32 )
+  {
+    __m256i va = _mm256_loadu_si256( (const __m256i*)( a + i ) );
+    __m256i vb = _mm256_loadu_si256( (const __m256i*)( b + i ) );
+    acc = _mm256_add_epi64( acc, _mm256_sad_epu8( va, vb ) );
+  }
+  alignas( 32 ) std::uint64_t lanes[4];
+  _mm256_store_si256( (__m256i*)lanes, acc );
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sadByteSSE2( a + i, b + i, n - i );
+}
+
+template <typename T>
+CLP_TARGET( "avx2" )
+void ssimColumnsAVX2( const T* const* a, const T* const* b, const float* weights, std::size_t taps, std::size_t n,
+                      float* sums )
+{
+  std::size_t i = 0;
+  for( ; i + 8 <= n; i += 8 )
+  {
+    __m256 meanA = _mm256_setzero_ps();
+    __m256 meanB = _mm256_setzero_ps();
+    __m256 meanAA = _mm256_setzero_ps();
+    __m256 meanBB = _mm256_setzero_ps();
+    __m256 meanAB = _mm256_setzero_ps();
+    for( std::size_t k = 0; k < taps; k++ )
+    {
+      const __m256 w = _mm256_set1_ps( weights[k] );
+      const __m256 sampleA = _mm256_cvtepi32_ps( loadSamples8( a[k] + i ) );
+      const __m256 sampleB = _mm256_cvtepi32_ps( loadSamples8( b[k] + i ) );
+      const __m256 weightedA = _mm256_mul_ps( w, sampleA );
+      const __m256 weightedB = _mm256_mul_ps( w, sampleB );
+      meanA = _mm256_add_ps( meanA, weightedA );
+      meanB = _mm256_add_ps( meanB, weightedB );
+      meanAA = _mm256_add_ps( meanAA, _mm256_mul_ps( weightedA, sampleA ) );
+      meanBB = _mm256_add_ps( meanBB, _mm256_mul_ps( weightedB, sampleB ) );
+      meanAB = _mm256_add_ps( meanAB, _mm256_mul_ps( weightedA, sampleB ) );
+    }
+    _mm256_storeu_ps( sums + i, meanA );
+    _mm256_storeu_ps( sums + n + i, meanB );
+    _mm256_storeu_ps( sums + 2 * n + i, meanAA );
+    _mm256_storeu_ps( sums + 3 * n + i, meanBB );
+    _mm256_storeu_ps( sums + 4 * n + i, meanAB );
+  }
+  for( ; i < n; i++ )
+  {
+    float means[5] = {};
+    for( std::size_t k = 0; k < taps; k++ )
+    {
+      const float sampleA = a[k][i];
+      const float sampleB = b[k][i];
+      const float weightedA = weights[k] * sampleA;
+      const float weightedB = weights[k] * sampleB;
+      means[0] += weightedA;
+      means[1] += weightedB;
+      means[2] += weightedA * sampleA;
+      means[3] += weightedB * sampleB;
+      means[4] += weightedA * sampleB;
+    }
+    for( std::size_t stat = 0; stat < 5; stat++ )
+      sums[stat * n + i] = means[stat];
+  }
+}
+
+CLP_TARGET( "avx2" )
+auto ssimRowAVX2( const float* sums, std::size_t stride, std::size_t n, const float* weights, std::size_t taps,
+                  float c1, float c2 ) -> double
+{
+  const __m256 vc1 = _mm256_set1_ps( c1 );
+  const __m256 vc2 = _mm256_set1_ps( c2 );
+  const __m256 two = _mm256_set1_ps( 2.0f );
+  __m256d acc = _mm256_setzero_pd();
+  std::size_t i = 0;
+  for( ; i + 8 <= n; i += 8 )
+  {
+    __m256 means[5];
+    for( std::size_t stat = 0; stat < 5; stat++ )
+      means[stat] = _mm256_setzero_ps();
+    for( std::size_t k = 0; k < taps; k++ )
+    {
+      const __m256 w = _mm256_set1_ps( weights[k] );
+      for( std::size_t stat = 0; stat < 5; stat++ )
+        means[stat] = _mm256_add_ps( means[stat], _mm256_mul_ps( w, _mm256_loadu_ps( sums + stat * stride + i + k ) ) );
+    }
+    const __m256 meanAB2 = _mm256_mul_ps( means[0], means[1] );
+    const __m256 meanA2 = _mm256_mul_ps( means[0], means[0] );
+    const __m256 meanB2 = _mm256_mul_ps( means[1], means[1] );
+    const __m256 varA = _mm256_sub_ps( means[2], meanA2 );
+    const __m256 varB = _mm256_sub_ps( means[3], meanB2 );
+    const __m256 covAB = _mm256_sub_ps( means[4], meanAB2 );
+    const __m256 num = _mm256_mul_ps( _mm256_add_ps( _mm256_mul_ps( two, meanAB2 ), vc1 ),
+                                      _mm256_add_ps( _mm256_mul_ps( two, covAB ), vc2 ) );
+    const __m256 den = _mm256_mul_ps( _mm256_add_ps( _mm256_add_ps( meanA2, meanB2 ), vc1 ),
+                                      _mm256_add_ps( _mm256_add_ps( varA, varB ), vc2 ) );
+    const __m256 ssim = _mm256_div_ps( num, den );
+    acc = _mm256_add_pd( acc, _mm256_cvtps_pd( _mm256_castps256_ps128( ssim ) ) );
+    acc = _mm256_add_pd( acc, _mm256_cvtps_pd( _mm256_extractf128_ps( ssim, 1 ) ) );
+  }
+  alignas( 32 ) double lanes[4];
+  _mm256_store_pd( lanes, acc );
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + ssimRowGeneric( sums + i, stride, n - i, weights, taps, c1, c2 );
+}
+
+constexpr CalypFrameKernels kAVX2Kernels{
+    .level = ClpCpuLevel::AVX2,
+    .unpack8 = unpack8AVX2,
+    .unpack16 = unpack16AVX2,
+    .unpackYUYV8 = unpackYUYV8AVX2,
+    .unpackPacked3x8 = unpackPacked3x8AVX2,
+    .unpackPacked4x8 = unpackPacked4x8AVX2,
+    .pack8 = pack8AVX2,
+    .pack16 = pack16AVX2,
+    .packYUYV8 = packYUYV8AVX2,
+    .packPacked3x8 = packPacked3x8AVX2,
+    .yuvToArgb = yuvToArgbAVX2<ClpPel>,
+    .rgbToLuma = rgbToLumaAVX2<ClpPel>,
+    .ssd = ssdAVX2,
+    .ssdWeighted = ssdWeightedAVX2,
+    .sad = sadAVX2,
+    .ssimColumns = ssimColumnsAVX2<ClpPel>,
+    .ssimRow = ssimRowAVX2,
+    .yuvToArgbByte = yuvToArgbAVX2<ClpByte>,
+    .rgbToLumaByte = rgbToLumaAVX2<ClpByte>,
+    .ssdByte = ssdByteAVX2,
+    .sadByte = sadByteAVX2,
+    .ssimColumnsByte = ssimColumnsAVX2<ClpByte>,
+};
+
+/*
+ **************************************************************
+ * AVX-512 kernels
+ **************************************************************
+ */
+
+// GCC 12 headers trip on their own _mm512_undefined_*() placeholders
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+CLP_TARGET( "avx512f,avx512bw" ) void unpack8AVX512( const ClpByte* src, ClpPel* dst, std::size_t n )
+{
+  std::size_t i = 0;
+  for( ; i + 32 <= n; i += 32 )
+    _mm512_storeu_si512( dst + i, _mm512_cvtepu8_epi16( _mm256_loadu_si256( (const __m256i*)( src + i ) ) ) );
+  unpack8AVX2( src + i, dst + i, n - i );
+}
+
+CLP_TARGET( "avx512f,avx512bw" )
+void unpack16AVX512( const ClpByte* src, ClpPel* dst, std::size_t n, bool bigEndian, ClpPel maxval )
+{
+  const __m512i max = _mm512_set1_epi16( static_cast<short>( maxval ) );
+  const __m512i swap = _mm512_broadcast_i32x4( _mm_setr_epi8( 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 ) );
+  std::size_t i = 0;
+  for( ; i + 32 <= n; i += 32 )
+  {
+    __m512i v = _mm512_loadu_si512( src + 2 * i );
+    if( bigEndian )
+      v = _mm512_shuffle_epi8( v, swap );
+    _mm512_storeu_si512( dst + i, _mm512_maskz_mov_epi16( _mm512_cmple_epu16_mask( v, max ), v ) );
+  }
+  unpack16AVX2( src + 2 * i, dst + i, n - i, bigEndian, maxval );
+}
+
+CLP_TARGET( "avx512f,avx512bw" ) void pack8AVX512( const ClpPel* src, ClpByte* dst, std::size_t n )
+{
+  std::size_t i = 0;
+  for( ; i + 32 <= n; i += 32 )
+    _mm256_storeu_si256( (__m256i*)( dst + i ), _mm512_cvtepi16_epi8( _mm512_loadu_si512( src + i ) ) );
+  pack8AVX2( src + i, dst + i, n - i );
+}
+
+CLP_TARGET( "avx512f,avx512bw" ) void pack16AVX512( const ClpPel* src, ClpByte* dst, std::size_t n, bool bigEndian )
+{
+  const __m512i swap = _mm512_broadcast_i32x4( _mm_setr_epi8( 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 ) );
+  std::size_t i = 0;
+  for( ; i + 32 <= n; i += 32 )
+  {
+    __m512i v = _mm512_loadu_si512( src + i );
+    if( bigEndian )
+      v = _mm512_shuffle_epi8( v, swap );
+    _mm512_storeu_si512( dst + 2 * i, v );
+  }
+  pack16AVX2( src + i, dst + 2 * i, n - i, bigEndian );
+}
+
+CLP_TARGET( "avx512f,avx512bw" ) auto ssdAVX512( const ClpPel* a, const ClpPel* b, std::size_t n ) -> std::uint64_t
+{
+  const __m512i zero = _mm512_setzero_si512();
+  __m512i acc = zero;
+  std::size_t i = 0;
+  for( ; i + 32 <= n; i += 32 )
+  {
+    __m512i va = _mm512_loadu_si512( a + i );
+    __m512i vb = _mm512_loadu_si512( b + i );
+    __m512i diff = _mm512_or_si512( _mm512_subs_epu16( va, vb ), _mm512_subs_epu16( vb, va ) );
+    __m512i lo = _mm512_mullo_epi16( diff, diff );
+    __m512i hi = _mm512_mulhi_epu16( diff, diff );
+    __m512i sq0 = _mm512_unpacklo_epi16( lo, hi );
+    __m512i sq1 = _mm512_unpackhi_epi16( lo, hi );
+    acc = _mm512_add_epi64( acc, _mm512_unpacklo_epi32( sq0, zero ) );
+    acc = _mm512_add_epi64( acc, _mm512_unpackhi_epi32( sq0, zero ) );
+    acc = _mm512_add_epi64( acc, _mm512_unpacklo_epi32( sq1, zero ) );
+    acc = _mm512_add_epi64( acc, _mm512_unpackhi_epi32( sq1, zero ) );
+  }
+  return std::uint64_t( _mm512_reduce_add_epi64( acc ) ) + ssdAVX2( a + i, b + i, n - i );
+}
+
+constexpr CalypFrameKernels kAVX512Kernels{
+    .level = ClpCpuLevel::AVX512,
+    .unpack8 = unpack8AVX512,
+    .unpack16 = unpack16AVX512,
+    .pack8 = pack8AVX512,
+    .pack16 = pack16AVX512,
+    .ssd = ssdAVX512,
+};
+
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#pragma GCC diagnostic pop
+#endif
+
+#endif  // CLP_X86_SIMD
+
+//! Kernels registered by each level (indexed by ClpCpuLevel)
+constexpr std::array<const CalypFrameKernels*, 5> kRegisteredKernels{
+    &kGenericKernels,
+#ifdef CLP_X86_SIMD
+    &kSSE2Kernels,
+    &kSSE41Kernels,
+    &kAVX2Kernels,
+    &kAVX512Kernels,
+#else
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+#endif
+};
+
+template <typename T>
+void registerKernel( T& entry, T kernel )
+{
+  if( kernel )
+    entry = kernel;
+}
+
+/**
+ * Complete the kernels of a level with the ones registered by the levels below
+ */
+auto composeKernels( ClpCpuLevel level ) -> CalypFrameKernels
+{
+  CalypFrameKernels kernels;
+  for( int l = 0; l <= static_cast<int>( level ); l++ )
+  {
+    const CalypFrameKernels* registered = kRegisteredKernels[l];
+    if( !registered )
+      continue;
+    registerKernel( kernels.unpack8, registered->unpack8 );
+    registerKernel( kernels.unpack16, registered->unpack16 );
+    registerKernel( kernels.unpackYUYV8, registered->unpackYUYV8 );
+    registerKernel( kernels.unpackPacked3x8, registered->unpackPacked3x8 );
+    registerKernel( kernels.unpackPacked4x8, registered->unpackPacked4x8 );
+    registerKernel( kernels.pack8, registered->pack8 );
+    registerKernel( kernels.pack16, registered->pack16 );
+    registerKernel( kernels.packYUYV8, registered->packYUYV8 );
+    registerKernel( kernels.packPacked3x8, registered->packPacked3x8 );
+    registerKernel( kernels.packPacked4x8, registered->packPacked4x8 );
+    registerKernel( kernels.yuvToArgb, registered->yuvToArgb );
+    registerKernel( kernels.histogram, registered->histogram );
+    registerKernel( kernels.rgbToLuma, registered->rgbToLuma );
+    registerKernel( kernels.ssd, registered->ssd );
+    registerKernel( kernels.ssdWeighted, registered->ssdWeighted );
+    registerKernel( kernels.sad, registered->sad );
+    registerKernel( kernels.ssimColumns, registered->ssimColumns );
+    registerKernel( kernels.ssimRow, registered->ssimRow );
+    registerKernel( kernels.unpackYUYV8Byte, registered->unpackYUYV8Byte );
+    registerKernel( kernels.unpackPacked3x8Byte, registered->unpackPacked3x8Byte );
+    registerKernel( kernels.unpackPacked4x8Byte, registered->unpackPacked4x8Byte );
+    registerKernel( kernels.packYUYV8Byte, registered->packYUYV8Byte );
+    registerKernel( kernels.packPacked3x8Byte, registered->packPacked3x8Byte );
+    registerKernel( kernels.packPacked4x8Byte, registered->packPacked4x8Byte );
+    registerKernel( kernels.yuvToArgbByte, registered->yuvToArgbByte );
+    registerKernel( kernels.histogramByte, registered->histogramByte );
+    registerKernel( kernels.rgbToLumaByte, registered->rgbToLumaByte );
+    registerKernel( kernels.ssdByte, registered->ssdByte );
+    registerKernel( kernels.sadByte, registered->sadByte );
+    registerKernel( kernels.ssimColumnsByte, registered->ssimColumnsByte );
+  }
+  kernels.level = level;
+  return kernels;
+}
+
+auto composedKernels() -> const std::array<CalypFrameKernels, kRegisteredKernels.size()>&
+{
+  static const auto kernels = []() {
+    std::array<CalypFrameKernels, kRegisteredKernels.size()> composed;
+    for( std::size_t l = 0; l < composed.size(); l++ )
+      composed[l] = composeKernels( static_cast<ClpCpuLevel>( l ) );
+    return composed;
+  }();
+  return kernels;
+}
+
+}  // namespace
+
+auto calypYuvToRgbCoeffs( CalypColorMatrix matrix, CalypColorRange range, unsigned int bitsPel )
+    -> CalypYuvToRgbCoeffs
+{
+  // Luma weights of red and blue
+  double kr = 0.299;
+  double kb = 0.114;
+  if( matrix == CLP_MATRIX_BT709 )
+  {
+    kr = 0.2126;
+    kb = 0.0722;
+  }
+  else if( matrix == CLP_MATRIX_BT2020 )
+  {
+    kr = 0.2627;
+    kb = 0.0593;
+  }
+  const double kg = 1.0 - kr - kb;
+
+  const int extraBits = static_cast<int>( bitsPel ) - 8;
+  const double maxValue = ( 1 << bitsPel ) - 1;
+  double lumaScale = 255.0 / maxValue;
+  double chromaScale = 255.0 / maxValue;
+  int lumaOffset = 0;
+  if( range == CLP_RANGE_LIMITED )
+  {
+    lumaScale = 255.0 / ( 219 << extraBits );
+    chromaScale = 255.0 / ( 224 << extraBits );
+    lumaOffset = 16 << extraBits;
+  }
+
+  // Coefficients keep 13 fractional bits of the 8 bits results
+  const int shift = 13 + extraBits;
+  const auto fixed = [shift]( double value ) { return static_cast<int>( std::lround( std::ldexp( value, shift ) ) ); };
+  CalypYuvToRgbCoeffs coeffs{};
+  coeffs.lumaOffset = lumaOffset;
+  coeffs.chromaOffset = 1 << ( bitsPel - 1 );
+  coeffs.luma = fixed( lumaScale );
+  coeffs.crR = fixed( 2 * ( 1 - kr ) * chromaScale );
+  coeffs.cbG = fixed( 2 * kb * ( 1 - kb ) / kg * chromaScale );
+  coeffs.crG = fixed( 2 * kr * ( 1 - kr ) / kg * chromaScale );
+  coeffs.cbB = fixed( 2 * ( 1 - kb ) * chromaScale );
+  coeffs.shift = shift;
+  return coeffs;
+}
+
+auto calypFrameKernels() -> const CalypFrameKernels&
+{
+  return composedKernels()[static_cast<std::size_t>( calypCpuLevel() )];
+}
+
+auto calypFrameKernels( ClpCpuLevel level ) -> const CalypFrameKernels*
+{
+  if( !calypCpuSupports( level ) )
+    return nullptr;
+  return &composedKernels()[static_cast<std::size_t>( level )];
+}
@@ -0,0 +1,206 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2021  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     CalypFrameKernels.h
+ * \ingroup  CalypFrameGrp
+ * \brief    Low level pixel kernels used by CalypFrame (runtime dispatched)
+ */
+
+#ifndef __CALYPFRAMEKERNELS_H__
+#define __CALYPFRAMEKERNELS_H__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "CalypCpuFeatures.h"
+#include "CalypFrame.h"
+
+/**
+ * Fixed point YUV to RGB conversion of samples of a given bit depth:
+ *   y = luma * ( Y - lumaOffset ) + 2^(shift - 1)
+ *   R = ( y + crR * V' ) >> shift
+ *   G = ( y - cbG * U' - crG * V' ) >> shift
+ *   B = ( y + cbB * U' ) >> shift
+ * with U' and V' the chroma samples minus chromaOffset.
+ * The results are 8 bits and fit in 32 bits for samples up to 16 bits
+ */
+struct CalypYuvToRgbCoeffs
+{
+  int lumaOffset;
+  int chromaOffset;
+  int luma;
+  int crR;
+  int cbG;
+  int crG;
+  int cbB;
+  int shift;
+};
+
+/**
+ * Get the coefficients of a matrix and range for samples with bitsPel bits
+ */
+auto calypYuvToRgbCoeffs( CalypColorMatrix matrix, CalypColorRange range, unsigned int bitsPel )
+    -> CalypYuvToRgbCoeffs;
+
+/**
+ * Number of sub-histograms filled by the histogram kernels
+ */
+constexpr std::size_t kCalypHistogramBanks = 4;
+
+/**
+ * Table of kernels for a given instruction set level.
+ * Each level only registers the kernels it specialises, the table returned
+ * by calypFrameKernels() is completed with the kernels of the levels below.
+ */
+struct CalypFrameKernels
+{
+  ClpCpuLevel level{ ClpCpuLevel::Generic };
+
+  /**
+   * Widen n 8-bit samples
+   */
+  void ( *unpack8 )( const ClpByte* src, ClpPel* dst, std::size_t n ){ nullptr };
+
+  /**
+   * Read n 16-bit samples, swapping bytes for big endian input.
+   * Samples above maxval are set to zero (as the generic loop always did).
+   */
+  void ( *unpack16 )( const ClpByte* src, ClpPel* dst, std::size_t n, bool bigEndian, ClpPel maxval ){ nullptr };
+
+  /**
+   * Deinterleave n 8-bit YUYV macro-pixels (2 luma, 1 U and 1 V sample each)
+   */
+  void ( *unpackYUYV8 )( const ClpByte* src, ClpPel* dstY, ClpPel* dstU, ClpPel* dstV, std::size_t n ){ nullptr };
+
+  /**
+   * Deinterleave n pixels of 3 (or 4) 8-bit components.
+   * Byte k of each pixel is written into dst[k]
+   */
+  void ( *unpackPacked3x8 )( const ClpByte* src, ClpPel* const* dst, std::size_t n ){ nullptr };
+  void ( *unpackPacked4x8 )( const ClpByte* src, ClpPel* const* dst, std::size_t n ){ nullptr };
+
+  /**
+   * Narrow n samples to 8 bits (only the low byte is kept)
+   */
+  void ( *pack8 )( const ClpPel* src, ClpByte* dst, std::size_t n ){ nullptr };
+
+  /**
+   * Write n 16-bit samples in the requested endianness
+   */
+  void ( *pack16 )( const ClpPel* src, ClpByte* dst, std::size_t n, bool bigEndian ){ nullptr };
+
+  /**
+   * Interleave n 8-bit YUYV macro-pixels
+   */
+  void ( *packYUYV8 )( const ClpPel* srcY, const ClpPel* srcU, const ClpPel* srcV, ClpByte* dst,
+                       std::size_t n ){ nullptr };
+
+  /**
+   * Interleave n pixels of 3 (or 4) 8-bit components.
+   * Byte k of each pixel is read from src[k]
+   */
+  void ( *packPacked3x8 )( const ClpPel* const* src, ClpByte* dst, std::size_t n ){ nullptr };
+  void ( *packPacked4x8 )( const ClpPel* const* src, ClpByte* dst, std::size_t n ){ nullptr };
+
+  /**
+   * Convert a row of YUV samples to ARGB (8 bits per component).
+   * The chroma rows are horizontally subsampled by log2ChromaWidth
+   */
+  void ( *yuvToArgb )( const ClpPel* srcY, const ClpPel* srcU, const ClpPel* srcV, std::uint32_t* dst,
+                       std::size_t width, unsigned log2ChromaWidth, const CalypYuvToRgbCoeffs& coeffs ){ nullptr };
+
+  /**
+   * Accumulate the histogram of n samples.
+   * Consecutive samples are counted in kCalypHistogramBanks sub-histograms
+   * (bank k starts at bins + k * bankStride) to be added by the caller,
+   * with bankStride = 0 all samples are counted in the same bins
+   */
+  void ( *histogram )( const ClpPel* src, std::size_t n, unsigned int* bins, std::size_t bankStride ){ nullptr };
+
+  /**
+   * Luma of n RGB samples, ( 299 R + 587 G + 114 B + 500 ) / 1000
+   * as in CalypPixel::convertPixel()
+   */
+  void ( *rgbToLuma )( const ClpPel* srcR, const ClpPel* srcG, const ClpPel* srcB, ClpPel* dst,
+                       std::size_t n ){ nullptr };
+
+  /**
+   * Sum of squared differences between n samples
+   */
+  std::uint64_t ( *ssd )( const ClpPel* a, const ClpPel* b, std::size_t n ){ nullptr };
+
+  /**
+   * Sum of squared differences between n samples, each one multiplied by its weight
+   */
+  std::uint64_t ( *ssdWeighted )( const ClpPel* a, const ClpPel* b, const ClpPel* weights, std::size_t n ){ nullptr };
+
+  /**
+   * Sum of absolute differences between n samples
+   */
+  std::uint64_t ( *sad )( const ClpPel* a, const ClpPel* b, std::size_t n ){ nullptr };
+
+  /**
+   * Vertical pass of the gaussian SSIM: filter n columns of the taps rows a[k] and b[k]
+   * into the local means of a, b, a^2, b^2 and a*b (5 consecutive arrays of n floats at sums)
+   */
+  void ( *ssimColumns )( const ClpPel* const* a, const ClpPel* const* b, const float* weights, std::size_t taps,
+                         std::size_t n, float* sums ){ nullptr };
+
+  /**
+   * Horizontal pass of the gaussian SSIM: filter the 5 arrays of local means
+   * (stride floats apart, n + taps - 1 columns each) and sum the SSIM of the n windows
+   */
+  double ( *ssimRow )( const float* sums, std::size_t stride, std::size_t n, const float* weights, std::size_t taps,
+                       float c1, float c2 ){ nullptr };
+  /**
+   * Kernels for frames storing 8 bits samples in ClpByte planes
+   * (see CalypFrame::getSampleBytes()), same semantics as above
+   */
+  void ( *unpackYUYV8Byte )( const ClpByte* src, ClpByte* dstY, ClpByte* dstU, ClpByte* dstV,
+                             std::size_t n ){ nullptr };
+  void ( *unpackPacked3x8Byte )( const ClpByte* src, ClpByte* const* dst, std::size_t n ){ nullptr };
+  void ( *unpackPacked4x8Byte )( const ClpByte* src, ClpByte* const* dst, std::size_t n ){ nullptr };
+  void ( *packYUYV8Byte )( const ClpByte* srcY, const ClpByte* srcU, const ClpByte* srcV, ClpByte* dst,
+                           std::size_t n ){ nullptr };
+  void ( *packPacked3x8Byte )( const ClpByte* const* src, ClpByte* dst, std::size_t n ){ nullptr };
+  void ( *packPacked4x8Byte )( const ClpByte* const* src, ClpByte* dst, std::size_t n ){ nullptr };
+  void ( *yuvToArgbByte )( const ClpByte* srcY, const ClpByte* srcU, const ClpByte* srcV, std::uint32_t* dst,
+                           std::size_t width, unsigned log2ChromaWidth, const CalypYuvToRgbCoeffs& coeffs ){ nullptr };
+  void ( *histogramByte )( const ClpByte* src, std::size_t n, unsigned int* bins, std::size_t bankStride ){ nullptr };
+  void ( *rgbToLumaByte )( const ClpByte* srcR, const ClpByte* srcG, const ClpByte* srcB, ClpByte* dst,
+                           std::size_t n ){ nullptr };
+  std::uint64_t ( *ssdByte )( const ClpByte* a, const ClpByte* b, std::size_t n ){ nullptr };
+  std::uint64_t ( *sadByte )( const ClpByte* a, const ClpByte* b, std::size_t n ){ nullptr };
+  void ( *ssimColumnsByte )( const ClpByte* const* a, const ClpByte* const* b, const float* weights, std::size_t taps,
+                             std::size_t n, float* sums ){ nullptr };
+};
+
+/**
+ * Get the kernels table of the level in use (see calypCpuLevel())
+ */
+auto calypFrameKernels() -> const CalypFrameKernels&;
+
+/**
+ * Get the kernels table of a specific level
+ * @return nullptr if not supported by the build or by the running cpu
+ */
+auto calypFrameKernels( ClpCpuLevel level ) -> const CalypFrameKernels*;
+
+#endif  // __CALYPFRAMEKERNELS_H__
@@ -25,17 +25,24 @@
 // Self
 #include "CalypStream.h"
 
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <deque>
+#include <exception>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 
 #include "CalypFrame.h"
+#include "CalypFrameCache.h"
 #include "CalypStreamHandlerIf.h"
 #include "StreamHandlerPortableMap.h"
 #include "StreamHandlerRaw.h"
+#include "StreamHandlerY4m.h"
 #include "config.h"
 #ifdef USE_FFMPEG
 #include "StreamHandlerLibav.h"
@@ -49,11 +56,18 @@
 constexpr auto kDefaultBitsPerPixel = 8;
 constexpr auto kDefaultFrameRate = 30;
 
+// Frames of the pool besides the read-ahead ones: current, in flight and held by the users
+constexpr std::size_t kReadAheadSpareFrames = 4;
+
+// Position of a handler that must be sought before reading
+constexpr std::uint64_t kHandlerNotPositioned = std::numeric_limits<std::uint64_t>::max();
+
 auto find_stream_handler( const std::string& strFilename, bool bRead ) -> CalypStreamFormat::CreateStreamHandlerFn;
 
 std::vector<CalypStreamFormat> CalypStream::supportedReadFormats()
 {
   INI_REGIST_CALYP_SUPPORTED_FMT;
+  APPEND_CALYP_SUPPORTED_FMT( StreamHandlerY4m, Read );
   APPEND_CALYP_SUPPORTED_FMT( StreamHandlerRaw, Read );
   APPEND_CALYP_SUPPORTED_FMT( StreamHandlerPortableMap, Read );
 //#ifdef USE_OPENCV
@@ -68,6 +82,7 @@ std::vector<CalypStreamFormat> CalypStream::supportedReadFormats()
 std::vector<CalypStreamFormat> CalypStream::supportedWriteFormats()
 {
   INI_REGIST_CALYP_SUPPORTED_FMT;
+  APPEND_CALYP_SUPPORTED_FMT( StreamHandlerY4m, Write );
   APPEND_CALYP_SUPPORTED_FMT( StreamHandlerRaw, Write );
   APPEND_CALYP_SUPPORTED_FMT( StreamHandlerPortableMap, Write );
 #ifdef USE_FFMPEG
@@ -110,10 +125,18 @@ std::vector<CalypStandardResolution> CalypStream::stdResolutionSizes()
 struct CalypStreamFrameBuffer : std::enable_shared_from_this<CalypStreamFrameBuffer>
 {
   std::mutex buffer_mutex;
+  std::condition_variable frameReturned;
   std::vector<std::unique_ptr<CalypFrame>> framePool;
   std::size_t bufferIdx{ 0 };
 
+  unsigned int width;
+  unsigned int height;
+  ClpPixelFormats pelFormat;
+  unsigned int bitsPixel;
+  bool hasNegative;
+
   CalypStreamFrameBuffer( std::size_t size, unsigned int width, unsigned int height, ClpPixelFormats pelFormat, unsigned int bitsPixel, bool hasNegative )
+      : width{ width }, height{ height }, pelFormat{ pelFormat }, bitsPixel{ bitsPixel }, hasNegative{ hasNegative }
   {
     framePool.reserve( size );
     for( std::size_t i = 0; i < size; i++ )
@@ -132,24 +155,57 @@ struct CalypStreamFrameBuffer : std::enable_shared_from_this<CalypStreamFrameBuf
 
   void increase( std::size_t newSize )
   {
-    framePool.reserve( newSize );
-    auto oldSize = framePool.size();
-    for( std::size_t i = oldSize; i < newSize; i++ )
+    const std::lock_guard<std::mutex> lock( buffer_mutex );
+    if( newSize <= framePool.size() )
+      return;
+    // The free frames are the first bufferIdx ones, the slots above belong to the frames in use
+    const std::size_t newFrames = newSize - framePool.size();
+    for( std::size_t i = 0; i < newFrames; i++ )
     {
-      framePool.push_back( std::make_unique<CalypFrame>( framePool[0]->getWidth(),
-                                                         framePool[0]->getHeight(),
-                                                         framePool[0]->getPelFormat(),
-                                                         framePool[0]->getBitsPel(),
-                                                         framePool[0]->getHasNegativeValues() ) );
+      framePool.insert( framePool.begin() + bufferIdx,
+                        std::make_unique<CalypFrame>( width, height, pelFormat, bitsPixel, hasNegative ) );
     }
-    bufferIdx += newSize - oldSize;
+    bufferIdx += newFrames;
+    frameReturned.notify_all();
   }
 
   CalypFrame* ref() { return framePool[0].get(); }
 
+  /**
+   * Allocate a frame outside the pool
+   */
+  auto newFrame() const -> std::shared_ptr<CalypFrame>
+  {
+    return std::make_shared<CalypFrame>( width, height, pelFormat, bitsPixel, hasNegative );
+  }
+
   std::shared_ptr<CalypFrame> getFrame()
   {
     const std::lock_guard<std::mutex> lock( buffer_mutex );
+    return takeFrame();
+  }
+
+  /**
+   * Wait until a frame is free, returns nullptr if stop is set (see wake())
+   */
+  std::shared_ptr<CalypFrame> waitFrame( const std::atomic<bool>& stop )
+  {
+    std::unique_lock<std::mutex> lock( buffer_mutex );
+    frameReturned.wait( lock, [&] { return bufferIdx > 0 || stop.load(); } );
+    if( stop.load() )
+      return nullptr;
+    return takeFrame();
+  }
+
+  void wake()
+  {
+    const std::lock_guard<std::mutex> lock( buffer_mutex );
+    frameReturned.notify_all();
+  }
+
+private:
+  std::shared_ptr<CalypFrame> takeFrame()
+  {
     assert( bufferIdx > 0 );
     bufferIdx--;
     auto frame = framePool[bufferIdx].release();
@@ -157,6 +213,7 @@ struct CalypStreamFrameBuffer : std::enable_shared_from_this<CalypStreamFrameBuf
       const std::lock_guard<std::mutex> lock( buffer_mutex );
       framePool[bufferIdx].reset( p );
       bufferIdx++;
+      frameReturned.notify_all();
     };
     return std::shared_ptr<CalypFrame>{ frame, deleter };
   }
@@ -178,6 +235,39 @@ public:
   long long int iCurrFrameNum;
   bool bLoadAll;
 
+  // Read-ahead (see CalypStream::setReadAhead())
+  std::mutex handler_mutex;                   //!< Serialises the handler between the stream and its read-ahead thread
+  std::condition_variable_any fifoChanged;    //!< Waited with stream_mutex
+  std::atomic<std::uint64_t> fifoGeneration{ 0 };  //!< Bumped when the fifo restarts, drops the frames read before
+  std::thread readAheadThread;
+  std::atomic<bool> readAheadStop{ false };
+  std::exception_ptr readAheadError;
+  std::size_t readAheadDepth{ 0 };
+  bool readAheadFillRgb{ false };
+
+  // Write-behind (see CalypStream::setWriteBehind())
+  std::mutex write_mutex;
+  std::condition_variable writeQueueChanged;
+  std::deque<CalypFrame> writeQueue;  //!< The front one is being written
+  std::thread writeBehindThread;
+  bool writeBehindStop{ false };
+  std::exception_ptr writeBehindError;
+  std::size_t writeBehindDepth{ 0 };
+
+  unsigned int decoderThreads{ 0 };
+  bool decoderFrameThreads{ true };
+  std::string encoderName;
+  unsigned int encoderThreads{ 0 };
+
+  // Frame cache (see CalypStream::setFrameCacheBudget())
+  std::uint64_t cacheStream{ calypFrameCache().newStream() };  //!< Key of the frames of the stream in the cache
+  std::uint64_t handlerFrameNum{ kHandlerNotPositioned };      //!< Next frame read by the handler
+
+  //! Frames of the stream, grows as streams are read (see syncFrameNum())
+  std::uint64_t numFrames{ 0 };
+  //! numFrames is an estimate until the handler counts the frames
+  bool countingFrames{ false };
+
   CalypStreamPrivate( const CalypStreamPrivate& ) = delete;
   CalypStreamPrivate( CalypStreamPrivate&& ) = delete;
   CalypStreamPrivate& operator=( const CalypStreamPrivate& ) = delete;
@@ -197,7 +287,7 @@ public:
   }
 
   bool open( std::string filename, unsigned int width, unsigned int height, ClpPixelFormats input_format, unsigned int bitsPel, int endianness, bool hasNegative,
-             unsigned int frame_rate, bool forceRaw, CalypStream::Type type )
+             double frame_rate, bool forceRaw, CalypStream::Type type )
   {
     if( isInit )
     {
@@ -235,6 +325,10 @@ public:
     handler->m_uiBitsPerPixel = bitsPel;
     handler->m_iEndianness = bitsPel > 8 ? endianness : CLP_BIG_ENDIAN;
     handler->m_dFrameRate = frame_rate;
+    handler->m_uiDecoderThreads = decoderThreads;
+    handler->m_bDecoderFrameThreads = decoderFrameThreads;
+    handler->m_strEncoderName = encoderName;
+    handler->m_uiEncoderThreads = encoderThreads;
 
     if( !handler->openHandler( cFilename, isInput ) )
     {
@@ -276,8 +370,10 @@ public:
 
     // Some handlers need to know how long is a frame to get frame number
     handler->calculateFrameNumber();
+    numFrames = handler->m_uiTotalNumberFrames;
+    countingFrames = handler->m_bCountingFrames;
 
-    if( isInput && handler->m_uiTotalNumberFrames == 0 )
+    if( isInput && numFrames == 0 )
     {
       close();
       throw CalypFailure( "CalypStream", "Incorrect configuration: less than one frame" );
@@ -292,9 +388,12 @@ public:
     }
 
     iCurrFrameNum = -1;
+    handlerFrameNum = kHandlerNotPositioned;
     isInit = true;
 
     seekInput( 0 );
+    startReadAhead();
+    startWriteBehind();
 
     isInit = true;
     return isInit;
@@ -302,10 +401,13 @@ public:
 
   void close()
   {
+    stopReadAhead( false );
+    stopWriteBehind();
     if( handler )
     {
       handler->closeHandler();
     }
+    dropCachedFrames();
 
     bLoadAll = false;
     isInit = false;
@@ -315,23 +417,24 @@ public:
   {
     const std::lock_guard<std::recursive_mutex> lock( stream_mutex );
 
-    if( !isInit || new_frame_num >= handler->m_uiTotalNumberFrames || long( new_frame_num ) == iCurrFrameNum )
+    if( !isInit || new_frame_num >= numFrames || long( new_frame_num ) == iCurrFrameNum )
       return false;
 
     iCurrFrameNum = new_frame_num;
+    calypFrameCache().setPlayhead( cacheStream, iCurrFrameNum );
 
     if( bLoadAll )
       return true;
 
+    // The handler only seeks if the frame is not cached (see fetchFrame())
+    fifoGeneration++;
     frameFifo.clear();
-    if( !handler->seek( iCurrFrameNum ) )
-    {
-      throw CalypFailure( "CalypStream", "Cannot seek file into desired position" );
-    }
 
-    readNextFrame();
-    if( handler->m_uiTotalNumberFrames > 1 )
+    readNextFrame( readAheadThread.joinable() && readAheadFillRgb );
+    // The read-ahead thread reads the following ones
+    if( numFrames > 1 && !readAheadThread.joinable() )
       readNextFrame();
+    fifoChanged.notify_all();
     return true;
   }
 
@@ -339,26 +442,299 @@ public:
   {
     const std::lock_guard<std::recursive_mutex> lock( stream_mutex );
 
-    if( !isInit || streamType != CalypStream::Type::Input || handler->m_uiCurrFrameFileIdx >= handler->m_uiTotalNumberFrames )
+    if( !isInit || streamType != CalypStream::Type::Input || nextFrameNum() >= numFrames )
       return false;
 
     if( bLoadAll )
       return true;
 
-    auto frame = frameBuffer->getFrame();
+    const std::lock_guard<std::mutex> handlerLock( handler_mutex );
+    frameFifo.push_back( fetchFrame( nextFrameNum(), fillRgbBuffer, nullptr ) );
+    updateFrameNum();
+    return true;
+  }
 
-    if( !handler->read( *frame ) )
+  /**
+   * Get the frames found by a streaming handler (see CalypStream::isStreaming())
+   * or counted by the handler after opening, called with stream_mutex and handler_mutex held
+   */
+  void updateFrameNum()
+  {
+    if( countingFrames )
     {
-      throw CalypFailure( "CalypStream", "Cannot read frame from stream" );
-      return false;
+      handler->calculateFrameNumber();
+      countingFrames = handler->m_bCountingFrames;
+    }
+    else if( !handler->m_bStreaming )
+    {
+      return;
     }
-    frameFifo.push_back( frame );
+    numFrames = handler->m_uiTotalNumberFrames;
+  }
 
-    if( fillRgbBuffer )
+  /**
+   * updateFrameNum() called with stream_mutex held
+   */
+  void syncFrameNum()
+  {
+    if( !handler->m_bStreaming && !countingFrames )
+      return;
+    const std::lock_guard<std::mutex> handlerLock( handler_mutex );
+    updateFrameNum();
+  }
+
+  /**
+   * Number of the frame following the ones in the fifo
+   */
+  auto nextFrameNum() const -> std::uint64_t
+  {
+    return static_cast<std::uint64_t>( iCurrFrameNum ) + frameFifo.size();
+  }
+
+  /**
+   * Get a frame from the cache or read it from the handler into frame
+   * (a frame of the pool if nullptr), called with handler_mutex held.
+   * The cached frames are never handed out nor changed after being cached:
+   * they are read into frames of their own (outside the pool) with the ARGB
+   * buffer filled, and the stream gets copies sharing their samples
+   */
+  auto fetchFrame( std::uint64_t frameNum, bool fillRgbBuffer, std::shared_ptr<CalypFrame> frame )
+      -> std::shared_ptr<CalypFrame>
+  {
+    CalypFrameCache& cache = calypFrameCache();
+    const bool useCache = cache.budget() > 0;
+    if( useCache )
     {
+      if( auto cached = cache.find( cacheStream, frameNum ) )
+      {
+        frame = std::make_shared<CalypFrame>( *cached );
+        if( fillRgbBuffer && !frame->getRGBBuffer() )
+        {
+          frame->fillRGBBuffer();
+          cacheFrame( frameNum, *frame );
+        }
+        return frame;
+      }
+    }
+
+    if( handlerFrameNum != frameNum )
+    {
+      handlerFrameNum = kHandlerNotPositioned;
+      if( !handler->seek( frameNum ) )
+        throw CalypFailure( "CalypStream", "Cannot seek file into desired position" );
+      handlerFrameNum = frameNum;
+    }
+    // A cached copy of a pool frame would make the pool frame allocate new samples when read again
+    if( useCache )
+      frame = frameBuffer->newFrame();
+    else if( !frame )
+      frame = frameBuffer->getFrame();
+    handlerFrameNum = kHandlerNotPositioned;
+    if( !handler->read( *frame ) )
+      throw CalypFailure( "CalypStream", "Cannot read frame from stream" );
+    frame->setColorMatrix( handler->m_eColorMatrix, handler->m_eColorRange );
+    handlerFrameNum = frameNum + 1;
+
+    if( fillRgbBuffer )
       frame->fillRGBBuffer();
+    if( useCache )
+    {
+      cacheFrame( frameNum, *frame );
+      frame = std::make_shared<CalypFrame>( *frame );
     }
-    return true;
+    return frame;
+  }
+
+  /**
+   * Cache a copy of a frame, accounting its ARGB buffer
+   */
+  void cacheFrame( std::uint64_t frameNum, const CalypFrame& frame )
+  {
+    const auto rgbBuffer = frame.getRGBBuffer();
+    calypFrameCache().insert( cacheStream, frameNum, std::make_shared<CalypFrame>( frame ),
+                              frame.getBytesPerFrame() + ( rgbBuffer ? rgbBuffer->size() : 0 ) );
+  }
+
+  /**
+   * Evict the frames of the stream and get a new key for the following ones
+   */
+  void dropCachedFrames()
+  {
+    calypFrameCache().dropStream( cacheStream );
+    cacheStream = calypFrameCache().newStream();
+  }
+
+  void startReadAhead()
+  {
+    if( readAheadDepth == 0 || readAheadThread.joinable() || !isInit || streamType != CalypStream::Type::Input ||
+        bLoadAll )
+      return;
+    frameBuffer->increase( readAheadDepth + kReadAheadSpareFrames );
+    readAheadStop = false;
+    readAheadError = nullptr;
+    readAheadThread = std::thread( [this] { readAheadLoop(); } );
+  }
+
+  /**
+   * Stop the read-ahead thread, never called with stream_mutex held
+   * @param refillFifo read the next frame (as expected by setNextFrame()) if the thread had not,
+   * false when the handler is closed next
+   */
+  void stopReadAhead( bool refillFifo = true )
+  {
+    if( !readAheadThread.joinable() )
+      return;
+    {
+      const std::lock_guard<std::recursive_mutex> lock( stream_mutex );
+      readAheadStop = true;
+    }
+    fifoChanged.notify_all();
+    frameBuffer->wake();
+    readAheadThread.join();
+
+    if( !refillFifo )
+      return;
+    // setNextFrame() expects the next frame to be read
+    const std::lock_guard<std::recursive_mutex> lock( stream_mutex );
+    if( !bLoadAll && frameFifo.size() == 1 )
+      readNextFrame();
+  }
+
+  /**
+   * Keep readAheadDepth frames read after the current one.
+   * The handler is read without stream_mutex, the frames read before a seek are dropped
+   */
+  void readAheadLoop()
+  {
+    std::unique_lock<std::recursive_mutex> lock( stream_mutex );
+    while( true )
+    {
+      fifoChanged.wait( lock, [this] {
+        return readAheadStop.load() ||
+               ( frameFifo.size() <= readAheadDepth && nextFrameNum() < numFrames );
+      } );
+      if( readAheadStop.load() )
+        return;
+      const std::uint64_t generation = fifoGeneration.load();
+      const std::uint64_t frameNum = nextFrameNum();
+      lock.unlock();
+
+      auto frame = frameBuffer->waitFrame( readAheadStop );
+      if( !frame )
+        return;
+      bool frameRead = false;
+      try
+      {
+        // Frames sought meanwhile are fetched by seekInput()
+        const std::lock_guard<std::mutex> handlerLock( handler_mutex );
+        if( generation == fifoGeneration.load() )
+        {
+          frame = fetchFrame( frameNum, readAheadFillRgb, std::move( frame ) );
+          frameRead = true;
+        }
+      }
+      catch( ... )
+      {
+        lock.lock();
+        readAheadError = std::current_exception();
+        fifoChanged.notify_all();
+        return;
+      }
+
+      lock.lock();
+      syncFrameNum();
+      if( frameRead && generation == fifoGeneration.load() )
+      {
+        frameFifo.push_back( std::move( frame ) );
+        fifoChanged.notify_all();
+      }
+    }
+  }
+
+  void startWriteBehind()
+  {
+    if( writeBehindDepth == 0 || writeBehindThread.joinable() || !isInit || streamType != CalypStream::Type::Output )
+      return;
+    writeBehindStop = false;
+    writeBehindError = nullptr;
+    writeBehindThread = std::thread( [this] { writeBehindLoop(); } );
+  }
+
+  /**
+   * Write the queued frames and stop the write-behind thread,
+   * a failure is kept for flush()
+   */
+  void stopWriteBehind()
+  {
+    if( !writeBehindThread.joinable() )
+      return;
+    {
+      const std::lock_guard<std::mutex> lock( write_mutex );
+      writeBehindStop = true;
+    }
+    writeQueueChanged.notify_all();
+    writeBehindThread.join();
+  }
+
+  /**
+   * Write the queued frames in order, the queue is dropped after a failure
+   */
+  void writeBehindLoop()
+  {
+    std::unique_lock<std::mutex> lock( write_mutex );
+    while( true )
+    {
+      writeQueueChanged.wait( lock, [this] { return writeBehindStop || !writeQueue.empty(); } );
+      if( writeQueue.empty() )
+        return;
+      // Kept in the queue until written, so that flush() waits for it
+      const CalypFrame& frame = writeQueue.front();
+      lock.unlock();
+
+      std::exception_ptr error;
+      try
+      {
+        if( !handler->write( frame ) )
+          throw CalypFailure( "CalypStream", "Cannot write frame into the stream" );
+      }
+      catch( ... )
+      {
+        error = std::current_exception();
+      }
+
+      lock.lock();
+      writeQueue.pop_front();
+      if( error )
+      {
+        writeBehindError = error;
+        writeQueue.clear();
+      }
+      writeQueueChanged.notify_all();
+    }
+  }
+
+  /**
+   * Wait for the queued frames to be written and throw the failure of any of them
+   */
+  void flushWriteBehind()
+  {
+    std::unique_lock<std::mutex> lock( write_mutex );
+    writeQueueChanged.wait( lock, [this] { return writeQueue.empty(); } );
+    if( writeBehindError )
+      std::rethrow_exception( writeBehindError );
+  }
+
+  /**
+   * Wait for the read-ahead thread to read the next frame
+   */
+  void waitNextFrame( std::unique_lock<std::recursive_mutex>& lock )
+  {
+    if( !readAheadThread.joinable() )
+      return;
+    fifoChanged.wait( lock, [this] { return frameFifo.size() > 1 || readAheadError; } );
+    // The frames read before the failure come first
+    if( frameFifo.size() <= 1 )
+      std::rethrow_exception( readAheadError );
   }
 };
 
@@ -393,7 +769,7 @@ std::string CalypStream::getCodecName() const
 }
 
 bool CalypStream::open( std::string filename, std::string resolution, std::string input_format_name, unsigned int bitsPel, int endianness, bool hasNegative,
-                        unsigned int frame_rate, CalypStream::Type type )
+                        double frame_rate, CalypStream::Type type )
 {
   unsigned int width = 0;
   unsigned int height = 0;
@@ -416,19 +792,19 @@ bool CalypStream::open( std::string filename, std::string resolution, std::strin
 }
 
 bool CalypStream::open( std::string filename, unsigned int width, unsigned int height, ClpPixelFormats input_format, unsigned int bitsPel, int endianness,
-                        unsigned int frame_rate, CalypStream::Type type )
+                        double frame_rate, CalypStream::Type type )
 {
   return d->open( std::move( filename ), width, height, input_format, bitsPel, endianness, false, frame_rate, false, type );
 }
 
 bool CalypStream::open( std::string filename, unsigned int width, unsigned int height, ClpPixelFormats input_format, unsigned int bitsPel, int endianness, bool hasNegative,
-                        unsigned int frame_rate, CalypStream::Type type )
+                        double frame_rate, CalypStream::Type type )
 {
   return d->open( std::move( filename ), width, height, input_format, bitsPel, endianness, hasNegative, frame_rate, false, type );
 }
 
 bool CalypStream::open( std::string filename, unsigned int width, unsigned int height, ClpPixelFormats input_format, unsigned int bitsPel, int endianness,
-                        unsigned int frame_rate, bool forceRaw, CalypStream::Type type )
+                        double frame_rate, bool forceRaw, CalypStream::Type type )
 {
   return d->open( std::move( filename ), width, height, input_format, bitsPel, endianness, false, frame_rate, forceRaw, type );
 }
@@ -442,8 +818,14 @@ bool CalypStream::supportsFormatConfiguration()
 
 bool CalypStream::reload()
 {
+  // Streams cannot be read again
+  if( d->handler->m_bStreaming )
+    return false;
+  d->stopReadAhead( false );
   d->frameFifo.clear();
   d->handler->closeHandler();
+  d->handlerFrameNum = kHandlerNotPositioned;
+  d->dropCachedFrames();
   if( !d->handler->openHandler( d->cFilename, d->streamType == CalypStream::Type::Input ) )
   {
     throw CalypFailure( "CalypStream", "Cannot open stream " + d->cFilename + " with the " +
@@ -453,19 +835,22 @@ bool CalypStream::reload()
   d->handler->m_uiNBytesPerFrame = refFrame->getBytesPerFrame();
   d->handler->calculateFrameNumber();
   d->handler->configureBuffer( *refFrame );
+  d->numFrames = d->handler->m_uiTotalNumberFrames;
+  d->countingFrames = d->handler->m_bCountingFrames;
 
   if( d->handler->m_uiWidth <= 0 || d->handler->m_uiHeight <= 0 || d->handler->m_iPixelFormat == ClpPixelFormats::Invalid ||
-      d->handler->m_uiBitsPerPixel == 0 || d->handler->m_uiTotalNumberFrames == 0 )
+      d->handler->m_uiBitsPerPixel == 0 || d->numFrames == 0 )
   {
     return false;
   }
-  if( (unsigned int)( d->iCurrFrameNum ) >= d->handler->m_uiTotalNumberFrames )
+  if( (unsigned int)( d->iCurrFrameNum ) >= d->numFrames )
   {
     d->iCurrFrameNum = 0;
   }
   auto currFrameNum = d->iCurrFrameNum;
   d->iCurrFrameNum = -1;
   seekInput( currFrameNum );
+  d->startReadAhead();
   return true;
 }
 
@@ -481,7 +866,14 @@ bool CalypStream::isNative() const
 
 std::uint64_t CalypStream::getFrameNum() const
 {
-  return d->handler->m_uiTotalNumberFrames;
+  const std::lock_guard<std::recursive_mutex> lock( d->stream_mutex );
+  d->syncFrameNum();
+  return d->numFrames;
+}
+
+auto CalypStream::isStreaming() const -> bool
+{
+  return d->handler && d->handler->m_bStreaming;
 }
 unsigned int CalypStream::getWidth() const
 {
@@ -534,9 +926,63 @@ void CalypStream::getFormat( unsigned int& rWidth, unsigned int& rHeight, ClpPix
 
 auto CalypStream::hasNextFrame() -> bool
 {
+  const std::lock_guard<std::recursive_mutex> lock( d->stream_mutex );
   return d->frameFifo.size() > 1;
 }
 
+void CalypStream::setReadAhead( std::size_t depth, bool fillRgbBuffer )
+{
+  d->stopReadAhead();
+  d->readAheadDepth = depth;
+  d->readAheadFillRgb = fillRgbBuffer;
+  d->startReadAhead();
+}
+
+auto CalypStream::getReadAhead() const -> std::size_t
+{
+  return d->readAheadDepth;
+}
+
+void CalypStream::setWriteBehind( std::size_t depth )
+{
+  flush();
+  d->stopWriteBehind();
+  d->writeBehindDepth = depth;
+  d->startWriteBehind();
+}
+
+auto CalypStream::getWriteBehind() const -> std::size_t
+{
+  return d->writeBehindDepth;
+}
+
+void CalypStream::setDecoderThreads( unsigned int threads, bool frameThreads )
+{
+  d->decoderThreads = threads;
+  d->decoderFrameThreads = frameThreads;
+}
+
+void CalypStream::setEncoder( std::string name, unsigned int threads )
+{
+  d->encoderName = std::move( name );
+  d->encoderThreads = threads;
+}
+
+void CalypStream::setFrameCacheBudget( std::size_t bytes )
+{
+  calypFrameCache().setBudget( bytes );
+}
+
+auto CalypStream::getFrameCacheBudget() -> std::size_t
+{
+  return calypFrameCache().budget();
+}
+
+auto CalypStream::getFrameCacheUsage() -> std::size_t
+{
+  return calypFrameCache().usage();
+}
+
 auto CalypStream::hasWritingSlot() -> bool
 {
   return !d->bLoadAll && d->frameBuffer->bufferIdx > 0;
@@ -548,13 +994,16 @@ auto CalypStream::hasWritingSlot() -> bool
 
 void CalypStream::loadAll()
 {
+  // The whole stream is read at once
+  d->stopReadAhead();
   const std::lock_guard<std::recursive_mutex> lock( d->stream_mutex );
-  if( d->bLoadAll || d->streamType != CalypStream::Type::Input )
+  // The length of streams is not known
+  if( d->bLoadAll || d->streamType != CalypStream::Type::Input || d->handler->m_bStreaming )
     return;
 
   try
   {
-    d->frameBuffer->increase( d->handler->m_uiTotalNumberFrames );
+    d->frameBuffer->increase( d->numFrames );
   }
   catch( CalypFailure& e )
   {
@@ -562,7 +1011,7 @@ void CalypStream::loadAll()
     throw CalypFailure( "CalypStream", "Cannot allocated frame buffer for the whole stream" );
   }
   seekInput( 0 );
-  for( unsigned int i = 2; i < d->handler->m_uiTotalNumberFrames; i++ )
+  for( unsigned int i = 2; i < d->numFrames; i++ )
   {
     d->readNextFrame( false );
   }
@@ -572,15 +1021,18 @@ void CalypStream::loadAll()
 
 std::unique_ptr<CalypFrame> CalypStream::getCurrFrame( std::unique_ptr<CalypFrame> buffer )
 {
+  const std::lock_guard<std::recursive_mutex> lock( d->stream_mutex );
+  // Copies share the samples with the stream frame until one is written
   if( buffer == nullptr )
     buffer = std::make_unique<CalypFrame>( *d->frameFifo.front() );
   else
-    buffer->copyFrom( *d->frameFifo.front() );
+    *buffer = *d->frameFifo.front();
   return buffer;
 }
 
 auto CalypStream::getCurrFrameAsset() -> std::shared_ptr<CalypFrame>
 {
+  const std::lock_guard<std::recursive_mutex> lock( d->stream_mutex );
   if( d->bLoadAll )
     return d->frameFifo[d->iCurrFrameNum];
   return d->frameFifo.front();
@@ -588,6 +1040,7 @@ auto CalypStream::getCurrFrameAsset() -> std::shared_ptr<CalypFrame>
 
 auto CalypStream::getCurrFrame() -> CalypFrame*
 {
+  const std::lock_guard<std::recursive_mutex> lock( d->stream_mutex );
   if( d->bLoadAll )
     return d->frameFifo[d->iCurrFrameNum].get();
   return d->frameFifo.front().get();
@@ -595,7 +1048,8 @@ auto CalypStream::getCurrFrame() -> CalypFrame*
 
 bool CalypStream::isEof()
 {
-  if( d->iCurrFrameNum + 1 >= (long)( d->handler->m_uiTotalNumberFrames ) )
+  const std::lock_guard<std::recursive_mutex> lock( d->stream_mutex );
+  if( d->iCurrFrameNum + 1 >= (long)( d->numFrames ) )
   {
     return true;
   }
@@ -604,26 +1058,35 @@ bool CalypStream::isEof()
 
 bool CalypStream::setNextFrame()
 {
+  std::unique_lock<std::recursive_mutex> lock( d->stream_mutex );
   if( isEof() )
   {
     return true;
   }
-  d->iCurrFrameNum++;
   if( !d->bLoadAll )
   {
+    d->waitNextFrame( lock );
     assert( d->frameFifo.size() > 1 );
     d->frameFifo.pop_front();
+    d->fifoChanged.notify_all();
   }
+  d->iCurrFrameNum++;
+  calypFrameCache().setPlayhead( d->cacheStream, d->iCurrFrameNum );
   return false;
 }
 
 void CalypStream::readNextFrame()
 {
+  // Already done by the read-ahead thread
+  if( d->readAheadThread.joinable() )
+    return;
   d->readNextFrame();
 }
 
 void CalypStream::readNextFrameFillRGBBuffer()
 {
+  if( d->readAheadThread.joinable() )
+    return;
   d->readNextFrame( true );
 }
 
@@ -632,6 +1095,20 @@ void CalypStream::readNextFrameFillRGBBuffer()
  */
 void CalypStream::writeFrame( const CalypFrame& pcFrame )
 {
+  if( d->writeBehindThread.joinable() )
+  {
+    // Wait for the writer when it falls writeBehindDepth frames behind
+    std::unique_lock<std::mutex> lock( d->write_mutex );
+    d->writeQueueChanged.wait( lock,
+                               [this] { return d->writeQueue.size() < d->writeBehindDepth || d->writeBehindError; } );
+    if( d->writeBehindError )
+      std::rethrow_exception( d->writeBehindError );
+    // Shares the samples, copied only if the caller changes the frame before it is written
+    d->writeQueue.emplace_back( pcFrame );
+    lock.unlock();
+    d->writeQueueChanged.notify_all();
+    return;
+  }
   if( !d->handler->write( pcFrame ) )
   {
     throw CalypFailure( "CalypStream", "Cannot write frame into the stream" );
@@ -639,6 +1116,31 @@ void CalypStream::writeFrame( const CalypFrame& pcFrame )
   return;
 }
 
+void CalypStream::flush()
+{
+  if( d->writeBehindThread.joinable() )
+    d->flushWriteBehind();
+}
+
+void CalypStream::close()
+{
+  std::exception_ptr error;
+  try
+  {
+    flush();
+  }
+  catch( ... )
+  {
+    error = std::current_exception();
+  }
+  // The handler is closed anyway, finishing it after a failure could only write a broken trailer
+  if( !error && d->isInit && d->streamType == CalypStream::Type::Output && !d->handler->finishHandler() )
+    error = std::make_exception_ptr( CalypFailure( "CalypStream", "Cannot finish the stream " + d->cFilename ) );
+  d->close();
+  if( error )
+    std::rethrow_exception( error );
+}
+
 bool CalypStream::saveFrame( const std::string& filename )
 {
   return saveFrame( filename, *getCurrFrame() );
@@ -653,6 +1155,7 @@ bool CalypStream::saveFrame( const std::string& filename, const CalypFrame& save
     return false;
   }
   auxSaveStream.writeFrame( saveFrame );
+  auxSaveStream.close();
   return true;
 }
 
@@ -668,7 +1171,7 @@ bool CalypStream::seekInputRelative( bool bIsFoward )
   if( bIsFoward )
   {
     bRet = !setNextFrame();
-    d->readNextFrame();
+    readNextFrame();
   }
   else
   {
@@ -685,6 +1188,10 @@ bool CalypStream::seekInput( unsigned long new_frame_num )
 
 auto find_stream_handler( const std::string& strFilename, bool bRead ) -> CalypStreamFormat::CreateStreamHandlerFn
 {
+  // YUV4MPEG2 inputs are known by their header, the standard input ("-") is always one
+  if( bRead && StreamHandlerY4m::probe( strFilename ) )
+    return &StreamHandlerY4m::Create;
+
   std::string currExt = strFilename.substr( strFilename.find_last_of( "." ) + 1 );
   currExt = clpLowercase( currExt );
 
@@ -94,10 +94,10 @@ public:
              unsigned int bitsPel,
              int endianness,
              bool hasNegative,
-             unsigned int frame_rate,
+             double frame_rate,
              Type type );
   bool open( std::string filename, unsigned int width, unsigned int height, ClpPixelFormats input_format, unsigned int bitsPel, int endianness,
-             unsigned int frame_rate, CalypStream::Type type );
+             double frame_rate, CalypStream::Type type );
   bool open( std::string filename,
              unsigned int width,
              unsigned int height,
@@ -105,7 +105,7 @@ public:
              unsigned int bitsPel,
              int endianness,
              bool hasNegative,
-             unsigned int frame_rate,
+             double frame_rate,
              Type type );
   bool open( std::string filename,
              unsigned int width,
@@ -113,7 +113,7 @@ public:
              ClpPixelFormats input_format,
              unsigned int bitsPel,
              int endianness,
-             unsigned int frame_rate,
+             double frame_rate,
              bool forceRaw,
              Type type );
 
@@ -122,7 +122,21 @@ public:
 
   bool isNative() const;
   std::string getFileName() const;
+
+  /**
+   * Number of frames of the stream. The frames of compressed inputs are counted
+   * in the background, until then it is estimated from their duration
+   */
   std::uint64_t getFrameNum() const;
+
+  /**
+   * The input is read forward only and its length is unknown, as pipes and
+   * the standard input ("-"). getFrameNum() counts the frames known to exist,
+   * the ones read and the next one if there is one. Seeking backwards only
+   * reaches the frames kept in the frame cache
+   */
+  auto isStreaming() const -> bool;
+
   unsigned int getWidth() const;
   unsigned int getHeight() const;
   unsigned int getBitsPerPixel() const;
@@ -135,6 +149,54 @@ public:
   auto hasNextFrame() -> bool;
   auto hasWritingSlot() -> bool;
 
+  /**
+   * Read frames ahead in a dedicated thread (input streams only).
+   * Up to depth frames are kept read after the current one, setNextFrame()
+   * waits for the next one and readNextFrame() has nothing left to do.
+   * The setting is kept when the stream is opened again, 0 disables it
+   * @param fillRgbBuffer also convert the frames read ahead to RGB
+   */
+  void setReadAhead( std::size_t depth, bool fillRgbBuffer = false );
+  auto getReadAhead() const -> std::size_t;
+
+  /**
+   * Write the frames behind in a dedicated thread (output streams only).
+   * writeFrame() queues a copy of the frame, that shares its samples until
+   * one of them is changed, and waits while depth frames are queued.
+   * The failures are thrown by the following writeFrame(), flush() or close(),
+   * destroying the stream writes the queued frames but drops its failure.
+   * The setting is kept when the stream is opened again, 0 (default) disables it
+   */
+  void setWriteBehind( std::size_t depth );
+  auto getWriteBehind() const -> std::size_t;
+
+  /**
+   * Set the threads used by the decoders of compressed streams,
+   * applied when the stream is opened. 0 (default) uses one per core
+   * @param frameThreads decode several frames at once besides the slices of
+   * each frame, faster but each frame takes longer to come out after a seek
+   */
+  void setDecoderThreads( unsigned int threads, bool frameThreads = true );
+
+  /**
+   * Set the lossless encoder of compressed output streams (mkv and nut),
+   * applied when the stream is opened: ffv1 (default), libx264 or libx265
+   * when libav is built with them. The frames are encoded by writeFrame(),
+   * in the write-behind thread if any (see setWriteBehind())
+   * @param threads threads of the encoder, 0 (default) uses one per core
+   */
+  void setEncoder( std::string name, unsigned int threads = 0 );
+
+  /**
+   * Set the size in bytes of the cache of decoded frames shared by all the
+   * input streams, 0 (default) disables it. Seeking to a cached frame does
+   * not read the file, the least recently used frames are evicted first
+   * but the ones around the current frame of each stream are kept longer
+   */
+  static void setFrameCacheBudget( std::size_t bytes );
+  static auto getFrameCacheBudget() -> std::size_t;
+  static auto getFrameCacheUsage() -> std::size_t;
+
   void loadAll();
   std::unique_ptr<CalypFrame> getCurrFrame( std::unique_ptr<CalypFrame> buffer );
   auto getCurrFrameAsset() -> std::shared_ptr<CalypFrame>;
@@ -146,6 +208,20 @@ public:
 
   void writeFrame( const CalypFrame& pcFrame );
 
+  /**
+   * Wait for the frames written behind (see setWriteBehind()),
+   * throws the failure of any of them
+   */
+  void flush();
+
+  /**
+   * Write the frames written behind, finish the output (the frames held by
+   * the encoder and the container trailer) and close the stream,
+   * throws the failure of any of them. Destroying or opening the stream
+   * again also closes it but drops the failures
+   */
+  void close();
+
   bool saveFrame( const std::string& filename );
   static bool saveFrame( const std::string& filename, const CalypFrame& saveFrame );
 
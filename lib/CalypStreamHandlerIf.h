@@ -78,6 +78,13 @@ public:
   virtual bool read( CalypFrame& pcFrame ) = 0;
   virtual bool write( const CalypFrame& pcFrame ) = 0;
 
+  /**
+   * Write what an output handler still holds (frames kept by an encoder,
+   * container trailer), called once before closing it
+   * @return false if the stream could not be finished
+   */
+  virtual bool finishHandler() { return true; }
+
   virtual void calculateFrameNumber(){};
 
   std::string getFormatName()
@@ -109,11 +116,24 @@ protected:
   unsigned int m_uiBitsPerPixel{ 8 };
   int m_iEndianness{ CLP_INVALID_ENDIANESS };
   double m_dFrameRate{ 30 };
+  //! Matrix and range of the YUV samples, given to the frames read
+  CalypColorMatrix m_eColorMatrix{ CLP_MATRIX_BT601 };
+  CalypColorRange m_eColorRange{ CLP_RANGE_FULL };
   std::uint64_t m_uiCurrFrameFileIdx{ 0 };
   std::uint64_t m_uiTotalNumberFrames{ 0 };
   std::vector<ClpByte> m_pStreamBuffer;
   std::uint64_t m_uiNBytesPerFrame{ 0 };
   bool m_isEOF{ false };
+  //! Forward only input of unknown length, m_uiTotalNumberFrames counts the frames known to exist
+  bool m_bStreaming{ false };
+  //! m_uiTotalNumberFrames is an estimate while the handler counts the frames, calculateFrameNumber() updates it
+  bool m_bCountingFrames{ false };
+  //! Threads of the decoders (0 selects them automatically), see CalypStream::setDecoderThreads()
+  unsigned int m_uiDecoderThreads{ 0 };
+  bool m_bDecoderFrameThreads{ true };
+  //! Encoder of compressed outputs (empty selects the handler default), see CalypStream::setEncoder()
+  std::string m_strEncoderName;
+  unsigned int m_uiEncoderThreads{ 0 };
 };
 
 #endif  // __CALYPSTREAMHANDLERIF_H__
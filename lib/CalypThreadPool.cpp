@@ -0,0 +1,174 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2021  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     CalypThreadPool.cpp
+ * \brief    Pool of worker threads used to split the frame operations
+ */
+
+#include "CalypThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <string>
+
+namespace
+{
+auto defaultNumThreads() -> unsigned int
+{
+  unsigned int numThreads = std::max( 1u, std::thread::hardware_concurrency() );
+  if( const char* env = std::getenv( "CALYP_THREADS" ) )
+  {
+    try
+    {
+      const int envThreads = std::stoi( env );
+      if( envThreads > 0 )
+        numThreads = std::min( numThreads, static_cast<unsigned int>( envThreads ) );
+    }
+    catch( ... )
+    {
+    }
+  }
+  return numThreads;
+}
+
+}  // namespace
+
+CalypThreadPool::CalypThreadPool( unsigned int numThreads )
+{
+  for( unsigned int i = 1; i < numThreads; i++ )
+    m_workers.emplace_back( [this] { workerLoop(); } );
+}
+
+CalypThreadPool::~CalypThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_bStop = true;
+  }
+  m_wakeUp.notify_all();
+  for( auto& worker : m_workers )
+    worker.join();
+}
+
+auto CalypThreadPool::numThreads() const -> unsigned int
+{
+  return static_cast<unsigned int>( m_workers.size() ) + 1;
+}
+
+void CalypThreadPool::submit( std::function<void()> task )
+{
+  if( m_workers.empty() )
+  {
+    task();
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_tasks.push_back( std::move( task ) );
+  }
+  m_wakeUp.notify_one();
+}
+
+void CalypThreadPool::parallelFor( std::size_t count, std::size_t minBand,
+                                   const std::function<void( std::size_t, std::size_t )>& body )
+{
+  const std::size_t numBands = std::min<std::size_t>( numThreads(), count / std::max<std::size_t>( minBand, 1 ) );
+  if( numBands <= 1 )
+  {
+    if( count )
+      body( 0, count );
+    return;
+  }
+
+  std::atomic<std::size_t> pending{ numBands - 1 };
+  std::mutex doneMutex;
+  std::condition_variable done;
+  // First exception thrown by a band, rethrown once all bands are finished
+  std::exception_ptr error;
+  const auto runBand = [&]( std::size_t band ) {
+    try
+    {
+      body( count * band / numBands, count * ( band + 1 ) / numBands );
+    }
+    catch( ... )
+    {
+      std::lock_guard<std::mutex> lock( doneMutex );
+      if( !error )
+        error = std::current_exception();
+    }
+  };
+  for( std::size_t band = 1; band < numBands; band++ )
+  {
+    submit( [&, band] {
+      runBand( band );
+      // Decremented with doneMutex held, the caller cannot return (destroying the mutex) before it is released
+      std::lock_guard<std::mutex> lock( doneMutex );
+      if( --pending == 0 )
+        done.notify_all();
+    } );
+  }
+  runBand( 0 );
+
+  while( pending.load() && runPendingTask() )
+    ;
+  std::unique_lock<std::mutex> lock( doneMutex );
+  done.wait( lock, [&] { return pending.load() == 0; } );
+  if( error )
+    std::rethrow_exception( error );
+}
+
+auto CalypThreadPool::runPendingTask() -> bool
+{
+  std::function<void()> task;
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+    if( m_tasks.empty() )
+      return false;
+    task = std::move( m_tasks.front() );
+    m_tasks.pop_front();
+  }
+  task();
+  return true;
+}
+
+void CalypThreadPool::workerLoop()
+{
+  while( true )
+  {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock( m_mutex );
+      m_wakeUp.wait( lock, [this] { return m_bStop || !m_tasks.empty(); } );
+      if( m_tasks.empty() )
+        return;
+      task = std::move( m_tasks.front() );
+      m_tasks.pop_front();
+    }
+    task();
+  }
+}
+
+auto calypThreadPool() -> CalypThreadPool&
+{
+  static CalypThreadPool pool( defaultNumThreads() );
+  return pool;
+}
@@ -0,0 +1,91 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2021  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     CalypThreadPool.h
+ * \ingroup  CalypLibGrp
+ * \brief    Pool of worker threads used to split the frame operations
+ */
+
+#ifndef __CALYPTHREADPOOL_H__
+#define __CALYPTHREADPOOL_H__
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \class    CalypThreadPool
+ * \ingroup  CalypLibGrp
+ * \brief    Fixed number of worker threads running queued tasks
+ */
+class CalypThreadPool
+{
+public:
+  /**
+   * @param numThreads number of threads working on parallelFor(),
+   * the caller is one of them so numThreads - 1 workers are started
+   */
+  explicit CalypThreadPool( unsigned int numThreads );
+  ~CalypThreadPool();
+
+  CalypThreadPool( const CalypThreadPool& ) = delete;
+  CalypThreadPool( CalypThreadPool&& ) = delete;
+  CalypThreadPool& operator=( const CalypThreadPool& ) = delete;
+  CalypThreadPool& operator=( CalypThreadPool&& ) = delete;
+
+  auto numThreads() const -> unsigned int;
+
+  /**
+   * Queue a task to be run by one of the workers
+   */
+  void submit( std::function<void()> task );
+
+  /**
+   * Split [0, count) in contiguous bands of at least minBand items,
+   * call body( begin, end ) for each band and wait for all of them.
+   * The caller runs queued tasks while waiting, so it can be nested.
+   * An exception thrown by body is rethrown here after all bands finish
+   */
+  void parallelFor( std::size_t count, std::size_t minBand,
+                    const std::function<void( std::size_t, std::size_t )>& body );
+
+private:
+  auto runPendingTask() -> bool;
+  void workerLoop();
+
+  std::vector<std::thread> m_workers;
+  std::deque<std::function<void()>> m_tasks;
+  std::mutex m_mutex;
+  std::condition_variable m_wakeUp;
+  bool m_bStop{ false };
+};
+
+/**
+ * Get the pool shared by the library.
+ * It uses all the cpu cores, the environment variable
+ * CALYP_THREADS can be used to limit it (e.g., CALYP_THREADS=1)
+ */
+auto calypThreadPool() -> CalypThreadPool&;
+
+#endif  // __CALYPTHREADPOOL_H__
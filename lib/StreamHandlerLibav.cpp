@@ -24,8 +24,11 @@
 
 #include "StreamHandlerLibav.h"
 
+#include <algorithm>
+#include <array>
 #include <cstdio>
 #include <iostream>
+#include <iterator>
 
 #include "CalypFrame.h"
 #include "PixelFormats.h"
@@ -39,6 +42,77 @@
 #define FF_API_LAVF_AVCTX
 #endif
 
+struct StreamHandlerLibav::DirectFormat
+{
+  int ffmpegPelFormat;
+  ClpPixelFormats pixelFormat;
+  unsigned int bitsPerPixel;
+  int endianness;
+  //! Plane of each channel, U and V sharing one are interleaved
+  std::array<int, 3> planes;
+  //! Samples stored in the most significant bits (e.g., P010)
+  unsigned int shift;
+};
+
+auto StreamHandlerLibav::directFormats() -> std::span<const DirectFormat>
+{
+  static constexpr std::array<int, 3> kYuvPlanes{ 0, 1, 2 };
+  static constexpr std::array<int, 3> kSemiPlanar{ 0, 1, 1 };
+  static constexpr std::array<int, 3> kGbrPlanes{ 2, 0, 1 };
+
+  // clang-format off
+  static const DirectFormat kDirectFormats[] = {
+    { AV_PIX_FMT_YUV420P,     ClpPixelFormats::YUV420p,  8, CLP_BIG_ENDIAN,    kYuvPlanes,  0 },
+    { AV_PIX_FMT_YUVJ420P,    ClpPixelFormats::YUV420p,  8, CLP_BIG_ENDIAN,    kYuvPlanes,  0 },
+    { AV_PIX_FMT_YUV422P,     ClpPixelFormats::YUV422p,  8, CLP_BIG_ENDIAN,    kYuvPlanes,  0 },
+    { AV_PIX_FMT_YUVJ422P,    ClpPixelFormats::YUV422p,  8, CLP_BIG_ENDIAN,    kYuvPlanes,  0 },
+    { AV_PIX_FMT_YUV444P,     ClpPixelFormats::YUV444p,  8, CLP_BIG_ENDIAN,    kYuvPlanes,  0 },
+    { AV_PIX_FMT_YUVJ444P,    ClpPixelFormats::YUV444p,  8, CLP_BIG_ENDIAN,    kYuvPlanes,  0 },
+    { AV_PIX_FMT_YUV420P10LE, ClpPixelFormats::YUV420p, 10, CLP_LITTLE_ENDIAN, kYuvPlanes,  0 },
+    { AV_PIX_FMT_YUV422P10LE, ClpPixelFormats::YUV422p, 10, CLP_LITTLE_ENDIAN, kYuvPlanes,  0 },
+    { AV_PIX_FMT_YUV444P10LE, ClpPixelFormats::YUV444p, 10, CLP_LITTLE_ENDIAN, kYuvPlanes,  0 },
+    { AV_PIX_FMT_YUV420P12LE, ClpPixelFormats::YUV420p, 12, CLP_LITTLE_ENDIAN, kYuvPlanes,  0 },
+    { AV_PIX_FMT_YUV422P12LE, ClpPixelFormats::YUV422p, 12, CLP_LITTLE_ENDIAN, kYuvPlanes,  0 },
+    { AV_PIX_FMT_YUV444P12LE, ClpPixelFormats::YUV444p, 12, CLP_LITTLE_ENDIAN, kYuvPlanes,  0 },
+    { AV_PIX_FMT_YUV420P16LE, ClpPixelFormats::YUV420p, 16, CLP_LITTLE_ENDIAN, kYuvPlanes,  0 },
+    { AV_PIX_FMT_YUV422P16LE, ClpPixelFormats::YUV422p, 16, CLP_LITTLE_ENDIAN, kYuvPlanes,  0 },
+    { AV_PIX_FMT_YUV444P16LE, ClpPixelFormats::YUV444p, 16, CLP_LITTLE_ENDIAN, kYuvPlanes,  0 },
+    { AV_PIX_FMT_NV12,        ClpPixelFormats::YUV420p,  8, CLP_BIG_ENDIAN,    kSemiPlanar, 0 },
+    { AV_PIX_FMT_P010LE,      ClpPixelFormats::YUV420p, 10, CLP_LITTLE_ENDIAN, kSemiPlanar, 6 },
+    { AV_PIX_FMT_GRAY8,       ClpPixelFormats::Gray,     8, CLP_BIG_ENDIAN,    kYuvPlanes,  0 },
+    { AV_PIX_FMT_GRAY10LE,    ClpPixelFormats::Gray,    10, CLP_LITTLE_ENDIAN, kYuvPlanes,  0 },
+    { AV_PIX_FMT_GRAY12LE,    ClpPixelFormats::Gray,    12, CLP_LITTLE_ENDIAN, kYuvPlanes,  0 },
+    { AV_PIX_FMT_GRAY16LE,    ClpPixelFormats::Gray,    16, CLP_LITTLE_ENDIAN, kYuvPlanes,  0 },
+    { AV_PIX_FMT_GRAY16BE,    ClpPixelFormats::Gray,    16, CLP_BIG_ENDIAN,    kYuvPlanes,  0 },
+    { AV_PIX_FMT_GBRP,        ClpPixelFormats::RGB24p,   8, CLP_BIG_ENDIAN,    kGbrPlanes,  0 },
+    { AV_PIX_FMT_GBRP10LE,    ClpPixelFormats::RGB24p,  10, CLP_LITTLE_ENDIAN, kGbrPlanes,  0 },
+    { AV_PIX_FMT_GBRP12LE,    ClpPixelFormats::RGB24p,  12, CLP_LITTLE_ENDIAN, kGbrPlanes,  0 },
+    { AV_PIX_FMT_GBRP16LE,    ClpPixelFormats::RGB24p,  16, CLP_LITTLE_ENDIAN, kGbrPlanes,  0 },
+  };
+  // clang-format on
+  return kDirectFormats;
+}
+
+auto StreamHandlerLibav::findDirectFormat( int ffPixFmt ) -> const DirectFormat*
+{
+  const auto formats = directFormats();
+  auto it = std::find_if( formats.begin(), formats.end(),
+                          [ffPixFmt]( const DirectFormat& fmt ) { return fmt.ffmpegPelFormat == ffPixFmt; } );
+  return it != formats.end() ? &*it : nullptr;
+}
+
+auto StreamHandlerLibav::findEncoderFormat( ClpPixelFormats pixelFormat, unsigned int bitsPerPixel )
+    -> const DirectFormat*
+{
+  // The first planar layout of the frame format, the encoders take native endianness
+  const auto formats = directFormats();
+  auto it = std::find_if( formats.begin(), formats.end(), [=]( const DirectFormat& fmt ) {
+    return fmt.pixelFormat == pixelFormat && fmt.bitsPerPixel == bitsPerPixel && fmt.planes[1] != fmt.planes[2] &&
+           ( bitsPerPixel == 8 || fmt.endianness == CLP_LITTLE_ENDIAN );
+  } );
+  return it != formats.end() ? &*it : nullptr;
+}
+
 std::vector<CalypStreamFormat> StreamHandlerLibav::supportedReadFormats()
 {
   INI_REGIST_CALYP_SUPPORTED_FMT;
@@ -51,6 +125,7 @@ std::vector<CalypStreamFormat> StreamHandlerLibav::supportedReadFormats()
   REGIST_CALYP_SUPPORTED_FMT( &StreamHandlerLibav::Create, "Windows media video", "wmv" );
   REGIST_CALYP_SUPPORTED_FMT( &StreamHandlerLibav::Create, "MPEG-4", "mp4" );
   REGIST_CALYP_SUPPORTED_FMT( &StreamHandlerLibav::Create, "Matroska Multimedia Container", "mkv" );
+  REGIST_CALYP_SUPPORTED_FMT( &StreamHandlerLibav::Create, "NUT Open Container Format", "nut" );
   REGIST_CALYP_SUPPORTED_FMT( &StreamHandlerLibav::Create, "H.264 streams", "264,h264" );
   REGIST_CALYP_SUPPORTED_FMT( &StreamHandlerLibav::Create, "HEVC streams", "265,hevc" );
   END_REGIST_CALYP_SUPPORTED_FMT;
@@ -59,6 +134,8 @@ std::vector<CalypStreamFormat> StreamHandlerLibav::supportedReadFormats()
 std::vector<CalypStreamFormat> StreamHandlerLibav::supportedWriteFormats()
 {
   INI_REGIST_CALYP_SUPPORTED_FMT;
+  REGIST_CALYP_SUPPORTED_FMT( &StreamHandlerLibav::Create, "Matroska Multimedia Container (lossless)", "mkv" );
+  REGIST_CALYP_SUPPORTED_FMT( &StreamHandlerLibav::Create, "NUT Open Container Format (lossless)", "nut" );
   END_REGIST_CALYP_SUPPORTED_FMT;
 }
 
@@ -67,6 +144,15 @@ StreamHandlerLibav::StreamHandlerLibav()
   m_pchHandlerName = "FFmpeg";
 }
 
+StreamHandlerLibav::~StreamHandlerLibav()
+{
+  // Finishes the output (or joins the indexing thread) if the stream was not closed
+  if( !m_bIsInput )
+    closeEncoder();
+  else
+    stopFrameIndex();
+}
+
 bool StreamHandlerLibav::openHandler( std::string strFilename, bool bInput )
 {
   const char* filename = strFilename.c_str();
@@ -76,7 +162,19 @@ bool StreamHandlerLibav::openHandler( std::string strFilename, bool bInput )
 
   m_iStreamIdx = -1;
   m_cFrame = NULL;
+  m_cConvertedFrame = NULL;
+  m_ScalerCtx = NULL;
+  m_pcDirectFormat = nullptr;
   m_bHasStream = false;
+  m_bIsInput = bInput;
+  m_uiCurrFrameFileIdx = 0;
+  m_isEOF = false;
+  m_iSeekTargetPts = AV_NOPTS_VALUE;
+  m_uiSeekSkipFrames = 0;
+  m_bSeekFirstFrame = false;
+
+  if( !m_bIsInput )
+    return openEncoder( strFilename );
 
   //	AVDictionary* format_opts = NULL;
   //	if( m_uiWidth > 0 && m_uiHeight > 0 )
@@ -152,6 +250,10 @@ bool StreamHandlerLibav::openHandler( std::string strFilename, bool bInput )
   m_cCodedCtx = m_cStream->codec;
 #endif
 
+  // Frame threads decode several frames at once, slice threads split each frame
+  m_cCodedCtx->thread_count = static_cast<int>( m_uiDecoderThreads );
+  m_cCodedCtx->thread_type = m_bDecoderFrameThreads ? FF_THREAD_FRAME | FF_THREAD_SLICE : FF_THREAD_SLICE;
+
   if( avcodec_open2( m_cCodedCtx, dec, NULL ) < 0 )
   {
     std::cout << "Failed to open video codec" << std::endl;
@@ -175,42 +277,42 @@ bool StreamHandlerLibav::openHandler( std::string strFilename, bool bInput )
   // Set bits per pixel to default (8 bits)
   m_uiBitsPerPixel = 8;
 
-  /**
-   * Auxiliar conversation to re-use similar pixfmt
-   */
-  int auxPixFmt = m_ffPixFmt;
-  switch( m_ffPixFmt )
-  {
-  case AV_PIX_FMT_YUVJ420P:
-    auxPixFmt = AV_PIX_FMT_YUV420P;
-    break;
-  case AV_PIX_FMT_YUVJ422P:
-    auxPixFmt = AV_PIX_FMT_YUV422P;
-    break;
-  case AV_PIX_FMT_YUVJ444P:
-    auxPixFmt = AV_PIX_FMT_YUV444P;
-    break;
-  case AV_PIX_FMT_GRAY16LE:
-    m_uiBitsPerPixel = 16;
-    m_iEndianness = 1;
-    auxPixFmt = AV_PIX_FMT_GRAY8;
-    break;
-  case AV_PIX_FMT_GRAY16BE:
-    m_uiBitsPerPixel = 16;
-    m_iEndianness = 0;
-    auxPixFmt = AV_PIX_FMT_GRAY8;
-  }
-
   m_iPixelFormat = ClpPixelFormats::Invalid;
   m_bNative = false;
-  auto found_fmt = std::find_if( g_CalypPixFmtDescriptorsMap.begin(), g_CalypPixFmtDescriptorsMap.end(),
-                                 [auxPixFmt]( const auto& fmt ) { return fmt.second.ffmpegPelFormat == auxPixFmt; } );
-  if( found_fmt != g_CalypPixFmtDescriptorsMap.end() )
+  if( const DirectFormat* direct = findDirectFormat( m_ffPixFmt ) )
   {
     m_bNative = true;
-    m_iPixelFormat = found_fmt->first;
+    m_iPixelFormat = direct->pixelFormat;
+    m_uiBitsPerPixel = direct->bitsPerPixel;
+    m_iEndianness = direct->endianness;
+  }
+  else
+  {
+    auto found_fmt = std::find_if( g_CalypPixFmtDescriptorsMap.begin(), g_CalypPixFmtDescriptorsMap.end(),
+                                   [this]( const auto& fmt ) { return fmt.second.ffmpegPelFormat == m_ffPixFmt; } );
+    if( found_fmt != g_CalypPixFmtDescriptorsMap.end() )
+    {
+      m_bNative = true;
+      m_iPixelFormat = found_fmt->first;
+    }
   }
 
+  // Streams that do not signal them keep the default matrix and range
+  switch( m_cCodedCtx->colorspace )
+  {
+  case AVCOL_SPC_BT709:
+    m_eColorMatrix = CLP_MATRIX_BT709;
+    break;
+  case AVCOL_SPC_BT2020_NCL:
+  case AVCOL_SPC_BT2020_CL:
+    m_eColorMatrix = CLP_MATRIX_BT2020;
+    break;
+  default:
+    m_eColorMatrix = CLP_MATRIX_BT601;
+    break;
+  }
+  m_eColorRange = m_cCodedCtx->color_range == AVCOL_RANGE_MPEG ? CLP_RANGE_LIMITED : CLP_RANGE_FULL;
+
   double fr = 30;
   if( m_cStream->avg_frame_rate.den && m_cStream->avg_frame_rate.num )
     fr = av_q2d( m_cStream->avg_frame_rate );
@@ -227,6 +329,17 @@ bool StreamHandlerLibav::openHandler( std::string strFilename, bool bInput )
 
   m_dFrameRate = fr;
 
+  // Demuxing the whole stream takes long, the number of frames is estimated from the duration until it finishes
+  const bool addSeekEntries = ( m_cFmtCtx->iformat->flags & AVFMT_GENERIC_INDEX ) != 0;
+  m_bIndexStop = false;
+  m_bCountingFrames = true;
+  m_indexThread = std::thread( [this, path = strFilename, addSeekEntries] {
+    FrameIndex index;
+    if( !buildFrameIndex( path, addSeekEntries, index ) )
+      index = FrameIndex{};
+    const std::lock_guard<std::mutex> lock( m_indexMutex );
+    m_pendingIndex = std::move( index );
+  } );
   calculateFrameNumber();
 
   /* dump input information to stderr */
@@ -295,6 +408,8 @@ bool StreamHandlerLibav::openHandler( std::string strFilename, bool bInput )
     m_ffPixFmt = newAvFmt;
   }
 
+  // Planar frames are imported without the intermediate buffer
+  m_pcDirectFormat = findDirectFormat( m_ffPixFmt );
   m_uiFrameBufferSize = av_image_get_buffer_size( AVPixelFormat( m_ffPixFmt ), m_uiWidth, m_uiHeight, 1 );
 
   /* initialize packet, set data to NULL, let the demuxer fill it */
@@ -309,15 +424,32 @@ bool StreamHandlerLibav::openHandler( std::string strFilename, bool bInput )
 
 void StreamHandlerLibav::closeHandler()
 {
+  if( !m_bIsInput )
+  {
+    closeEncoder();
+    return;
+  }
+  stopFrameIndex();
   if( m_bHasStream )
   {
+#ifdef FF_API_LAVF_AVCTX
+    // Also joins the decoder threads
+    avcodec_free_context( &m_cCodedCtx );
+#else
     if( m_cCodedCtx )
       avcodec_close( m_cCodedCtx );
+#endif
 
     if( m_cFmtCtx )
       avformat_close_input( &m_cFmtCtx );
 
-    av_free( m_cFrame );
+    if( m_ScalerCtx )
+      sws_freeContext( m_ScalerCtx );
+    m_ScalerCtx = NULL;
+    if( m_cConvertedFrame )
+      av_freep( &m_cConvertedFrame->data[0] );
+    av_frame_free( &m_cConvertedFrame );
+    av_frame_free( &m_cFrame );
     av_packet_free( &m_cPacket );
   }
   m_bHasStream = false;
@@ -325,12 +457,16 @@ void StreamHandlerLibav::closeHandler()
 
 bool StreamHandlerLibav::configureBuffer( const CalypFrame& pcFrame )
 {
-  m_pStreamBuffer.resize( pcFrame.getBytesPerFrame() );
+  // The encoder converts the frames in m_pStreamBuffer
+  m_pStreamBuffer.resize( m_bIsInput && m_pcDirectFormat ? 0 : pcFrame.getBytesPerFrame() );
   return true;
 }
 
 void StreamHandlerLibav::calculateFrameNumber()
 {
+  if( !m_bIsInput )
+    return;
+  adoptFrameIndex();
   std::uint64_t num_frames;
   /*if( m_cStream->nb_frames )
   {
@@ -348,115 +484,541 @@ void StreamHandlerLibav::calculateFrameNumber()
   {
     num_frames = 0;
   }
+  if( !m_aFrameIndex.empty() )
+  {
+    num_frames = m_aFrameIndex.size();
+  }
   num_frames = num_frames == 0 ? 1 : num_frames;
   m_uiTotalNumberFrames = num_frames;
 }
 
-bool StreamHandlerLibav::read( CalypFrame& pcFrame )
+/**
+ * Demux the whole stream (without decoding it) to get its exact number of frames
+ * and its key frames. Runs on the indexing thread with a second context,
+ * so that the decoding one is not moved
+ */
+bool StreamHandlerLibav::buildFrameIndex( const std::string& filename, bool addSeekEntries, FrameIndex& index )
 {
-  int bGotFrame = 0;
-  bool bErrors = false;
-  bool bReadPkt = false;
+  AVFormatContext* fmtCtx = NULL;
+  if( avformat_open_input( &fmtCtx, filename.c_str(), NULL, NULL ) < 0 )
+    return false;
+  if( avformat_find_stream_info( fmtCtx, NULL ) < 0 || unsigned( m_iStreamIdx ) >= fmtCtx->nb_streams )
+  {
+    avformat_close_input( &fmtCtx );
+    return false;
+  }
+
+  bool hasPts = true;
   int iRet = 0;
+  AVPacket* packet = av_packet_alloc();
+  while( packet && !m_bIndexStop.load() && ( iRet = av_read_frame( fmtCtx, packet ) ) >= 0 )
+  {
+    if( packet->stream_index == m_iStreamIdx )
+    {
+      const bool keyFrame = ( packet->flags & AV_PKT_FLAG_KEY ) != 0;
+      index.frames.push_back( FrameIndexEntry{ packet->pts, packet->dts, keyFrame } );
+      hasPts = hasPts && packet->pts != AV_NOPTS_VALUE;
+      // Demuxers without an index of their own (e.g., raw streams) can then seek to every key frame
+      if( keyFrame && addSeekEntries && packet->dts != AV_NOPTS_VALUE )
+        index.seekEntries.push_back( SeekEntry{ packet->pos, packet->dts, packet->size } );
+    }
+    av_packet_unref( packet );
+  }
+  av_packet_free( &packet );
+  avformat_close_input( &fmtCtx );
+
+  if( iRet != AVERROR_EOF )
+    return false;
+
+  // Packets come in decoding order, without time stamps it is assumed to be the presentation one
+  index.hasPts = hasPts;
+  if( index.hasPts )
+  {
+    std::stable_sort( index.frames.begin(), index.frames.end(),
+                      []( const FrameIndexEntry& a, const FrameIndexEntry& b ) { return a.pts < b.pts; } );
+  }
+  for( std::uint64_t i = 0; i < index.frames.size(); i++ )
+  {
+    if( index.frames[i].keyFrame )
+      index.keyFrames.push_back( i );
+  }
+  return !index.frames.empty();
+}
+
+/**
+ * Use the index once the indexing thread finishes, the decoding context
+ * is only changed here (with the other handler calls)
+ */
+void StreamHandlerLibav::adoptFrameIndex()
+{
+  if( !m_bCountingFrames )
+    return;
+  std::optional<FrameIndex> index;
+  {
+    const std::lock_guard<std::mutex> lock( m_indexMutex );
+    index.swap( m_pendingIndex );
+  }
+  if( !index )
+    return;
+  m_indexThread.join();
+  m_bCountingFrames = false;
+  if( index->frames.empty() )
+  {
+    std::cout << "Could not index the stream, the number of frames is estimated from its duration" << std::endl;
+    return;
+  }
+  for( const SeekEntry& entry : index->seekEntries )
+    av_add_index_entry( m_cStream, entry.pos, entry.dts, entry.size, 0, AVINDEX_KEYFRAME );
+  m_aFrameIndex = std::move( index->frames );
+  m_aKeyFrames = std::move( index->keyFrames );
+  m_bIndexHasPts = index->hasPts;
+}
 
-  while( !bGotFrame && !bErrors )
+void StreamHandlerLibav::stopFrameIndex()
+{
+  if( m_indexThread.joinable() )
   {
+    m_bIndexStop = true;
+    m_indexThread.join();
+  }
+  m_pendingIndex.reset();
+  m_bCountingFrames = false;
+  m_aFrameIndex.clear();
+  m_aKeyFrames.clear();
+  m_bIndexHasPts = false;
+}
+
+auto StreamHandlerLibav::keyFrameBefore( std::uint64_t iFrameNum ) const -> std::uint64_t
+{
+  auto it = std::upper_bound( m_aKeyFrames.begin(), m_aKeyFrames.end(), iFrameNum );
+  return it == m_aKeyFrames.begin() ? 0 : *std::prev( it );
+}
+
+bool StreamHandlerLibav::seekKeyFrame( std::uint64_t iKeyFrame )
+{
+  const FrameIndexEntry& entry = m_aFrameIndex[iKeyFrame];
+  const std::int64_t timestamp = entry.dts != AV_NOPTS_VALUE ? entry.dts : entry.pts;
+  int iRet = 0;
+  if( timestamp != AV_NOPTS_VALUE )
+    iRet = av_seek_frame( m_cFmtCtx, m_iStreamIdx, timestamp, AVSEEK_FLAG_BACKWARD );
+  else
+    iRet = av_seek_frame( m_cFmtCtx, m_iStreamIdx, iKeyFrame, AVSEEK_FLAG_BACKWARD | AVSEEK_FLAG_FRAME );
+  if( iRet < 0 )
+    return false;
+  avcodec_flush_buffers( m_cCodedCtx );
+  m_isEOF = false;
+  m_uiSeekKeyFrame = iKeyFrame;
+  m_bSeekFirstFrame = true;
+  return true;
+}
+
+/**
+ * Get the next frame out of the decoder into m_cFrame
+ * @return false on errors or when all the frames were decoded (m_isEOF)
+ */
+bool StreamHandlerLibav::decodeFrame()
+{
+  int iRet = 0;
 #ifdef FF_SEND_RECEIVE_API
-    if( ( iRet = avcodec_receive_frame( m_cCodedCtx, m_cFrame ) ) < 0 )
+  while( true )
+  {
+    iRet = avcodec_receive_frame( m_cCodedCtx, m_cFrame );
+    if( iRet >= 0 )
+      return true;
+    if( iRet == AVERROR_EOF )
     {
-      if( iRet == AVERROR( EAGAIN ) || iRet == AVERROR_EOF )
-        bReadPkt = true;
-      else
-        return false;
-      // if( iRet == AVERROR_EOF )
-      //   m_isEOF = true;
+      m_isEOF = true;
+      return false;
     }
-    else
+    if( iRet != AVERROR( EAGAIN ) )
+      return false;
+
+    iRet = av_read_frame( m_cFmtCtx, m_cPacket );
+    if( iRet == AVERROR_EOF )
     {
-      bGotFrame = 1;
+      // Get the frames still inside the decoder (e.g., the ones of the other threads)
+      avcodec_send_packet( m_cCodedCtx, NULL );
+      continue;
     }
-#else
+    if( iRet < 0 )
+      return false;
     if( m_cPacket->stream_index == m_iStreamIdx )
+      iRet = avcodec_send_packet( m_cCodedCtx, m_cPacket );
+    av_packet_unref( m_cPacket );
+    if( iRet < 0 )
+      return false;
+  }
+#else
+  int bGotFrame = 0;
+  while( !bGotFrame )
+  {
+    if( m_cPacket->size <= 0 )
     {
-      if( ( iRet = avcodec_decode_video2( m_cCodedCtx, m_cFrame, &bGotFrame, m_cPacket ) ) < 0 )
-        return false;
-      m_cPacket->data += iRet;
-      m_cPacket->size -= iRet;
-      if( m_cPacket->size <= 0 )
-      {
-        bReadPkt = true;
-        av_packet_unref( &m_cOrgPacket );
-      }
-    }
-#endif
-    if( bGotFrame )
-      break;
-    if( bReadPkt )
-    {
-      bReadPkt = false;
       av_packet_unref( &m_cOrgPacket );
       if( ( iRet = av_read_frame( m_cFmtCtx, m_cPacket ) ) < 0 )
       {
         if( iRet == AVERROR_EOF )
-        {
           m_isEOF = true;
-          return true;
-        }
         return false;
       }
       m_cOrgPacket = *m_cPacket;
-#ifdef FF_SEND_RECEIVE_API
-      if( m_cPacket->stream_index == m_iStreamIdx )
-        if( ( iRet = avcodec_send_packet( m_cCodedCtx, m_cPacket ) ) < 0 )
-          return false;
-#endif
     }
+    if( m_cPacket->stream_index != m_iStreamIdx )
+    {
+      m_cPacket->size = 0;
+      continue;
+    }
+    if( ( iRet = avcodec_decode_video2( m_cCodedCtx, m_cFrame, &bGotFrame, m_cPacket ) ) < 0 )
+      return false;
+    m_cPacket->data += iRet;
+    m_cPacket->size -= iRet;
   }
+  return true;
+#endif
+}
+
+void StreamHandlerLibav::importPlanes( const AVFrame* picture, CalypFrame& pcFrame ) const
+{
+  const DirectFormat& fmt = *m_pcDirectFormat;
+  const bool interleaved = fmt.planes[1] == fmt.planes[2];
+  const unsigned int bytesPerSample = fmt.bitsPerPixel > 8 ? 2 : 1;
 
-  if( bGotFrame )
+  std::array<CalypPlaneSource, 3> planes;
+  for( std::size_t ch = 0; ch < planes.size(); ch++ )
   {
-    AVFrame* decFrame = m_cFrame;
-    if( !m_bNative )
+    const int plane = fmt.planes[ch];
+    planes[ch].data = picture->data[plane];
+    planes[ch].stride = picture->linesize[plane];
+    if( interleaved && ch > 0 )
     {
-      sws_scale( m_ScalerCtx, (const uint8_t* const*)decFrame->data, decFrame->linesize, 0, decFrame->height,
-                 (uint8_t* const*)m_cConvertedFrame->data, m_cConvertedFrame->linesize );
+      planes[ch].data += ch == 2 ? bytesPerSample : 0;
+      planes[ch].step = 2;
+    }
+  }
+  pcFrame.frameFromPlanes( planes, fmt.endianness, fmt.shift );
+}
+
+bool StreamHandlerLibav::read( CalypFrame& pcFrame )
+{
+  while( true )
+  {
+    if( !decodeFrame() )
+      return m_isEOF;
 
-      decFrame = m_cConvertedFrame;
+#ifdef FF_SEND_RECEIVE_API
+    const std::int64_t pts = m_cFrame->best_effort_timestamp;
+#else
+    const std::int64_t pts = AV_NOPTS_VALUE;
+#endif
+    // Drop the frames between the key frame sought and the one asked
+    if( m_iSeekTargetPts != AV_NOPTS_VALUE && pts != AV_NOPTS_VALUE )
+    {
+      if( m_bSeekFirstFrame && pts > m_iSeekTargetPts && m_uiSeekKeyFrame > 0 )
+      {
+        // The demuxer went past the key frame, try the previous one
+        if( !seekKeyFrame( keyFrameBefore( m_uiSeekKeyFrame - 1 ) ) )
+          return false;
+        continue;
+      }
+      m_bSeekFirstFrame = false;
+      if( pts < m_iSeekTargetPts )
+        continue;
+      m_iSeekTargetPts = AV_NOPTS_VALUE;
+      m_uiSeekSkipFrames = 0;
+    }
+    else if( m_uiSeekSkipFrames > 0 )
+    {
+      m_bSeekFirstFrame = false;
+      m_uiSeekSkipFrames--;
+      continue;
     }
+    break;
+  }
+
+  AVFrame* decFrame = m_cFrame;
+  if( !m_bNative )
+  {
+    sws_scale( m_ScalerCtx, (const uint8_t* const*)decFrame->data, decFrame->linesize, 0, decFrame->height,
+               (uint8_t* const*)m_cConvertedFrame->data, m_cConvertedFrame->linesize );
+
+    decFrame = m_cConvertedFrame;
+  }
+  if( m_pcDirectFormat )
+  {
+    importPlanes( decFrame, pcFrame );
+  }
+  else
+  {
     av_image_copy_to_buffer( m_pStreamBuffer.data(), m_uiFrameBufferSize, decFrame->data, decFrame->linesize,
                              AVPixelFormat( m_ffPixFmt ), m_uiWidth, m_uiHeight, 1 );
-
     pcFrame.frameFromBuffer( m_pStreamBuffer, m_iEndianness );
-    m_uiCurrFrameFileIdx++;
+  }
+  m_uiCurrFrameFileIdx++;
+  return true;
+}
+
+/**
+ * Lossless encoder (FFV1 by default, see CalypStream::setEncoder())
+ * fed by a thread so write() does not wait for the encoding
+ */
+bool StreamHandlerLibav::openEncoder( const std::string& strFilename )
+{
+#ifndef FF_SEND_RECEIVE_API
+  std::cout << "Encoding needs libavcodec 57.37 or newer" << std::endl;
+  return false;
+#else
+  const DirectFormat* encFormat = findEncoderFormat( m_iPixelFormat, m_uiBitsPerPixel );
+  if( !encFormat )
+  {
+    std::cout << "Pixel format not supported by the lossless encoders" << std::endl;
+    return false;
+  }
+  const AVPixelFormat encPixFmt = AVPixelFormat( encFormat->ffmpegPelFormat );
+
+  const std::string encoderName = m_strEncoderName.empty() ? "ffv1" : m_strEncoderName;
+  const AVCodec* enc = avcodec_find_encoder_by_name( encoderName.c_str() );
+  if( !enc )
+  {
+    std::cout << "Failed to find the " << encoderName << " encoder" << std::endl;
+    return false;
+  }
+  // A null list means any pixel format, AVCodec::pix_fmts is deprecated since libavcodec 61.13
+  const AVPixelFormat* pixFmts = NULL;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT( 61, 13, 100 )
+  if( avcodec_get_supported_config( NULL, enc, AV_CODEC_CONFIG_PIX_FORMAT, 0,
+                                    reinterpret_cast<const void**>( &pixFmts ), NULL ) < 0 )
+    pixFmts = NULL;
+#else
+  pixFmts = enc->pix_fmts;
+#endif
+  if( pixFmts )
+  {
+    const AVPixelFormat* pixFmt = pixFmts;
+    while( *pixFmt != AV_PIX_FMT_NONE && *pixFmt != encPixFmt )
+      pixFmt++;
+    if( *pixFmt == AV_PIX_FMT_NONE )
+    {
+      std::cout << "The " << encoderName << " encoder does not support " << av_get_pix_fmt_name( encPixFmt )
+                << std::endl;
+      return false;
+    }
+  }
+
+  if( avformat_alloc_output_context2( &m_cFmtCtx, NULL, NULL, strFilename.c_str() ) < 0 || !m_cFmtCtx )
+  {
+    std::cout << "Failed to allocate the output container" << std::endl;
+    return false;
+  }
+
+  m_cStream = avformat_new_stream( m_cFmtCtx, NULL );
+  m_cCodedCtx = avcodec_alloc_context3( enc );
+  if( !m_cStream || !m_cCodedCtx )
+  {
+    closeEncoder();
+    return false;
+  }
+
+  // Fractional rates (e.g., 29.97) are kept exactly, one time base unit per frame
+  AVRational frameRate = av_d2q( m_dFrameRate, 1001000 );
+  if( frameRate.num <= 0 || frameRate.den <= 0 )
+    frameRate = AVRational{ 30, 1 };
+  m_cCodedCtx->width = m_uiWidth;
+  m_cCodedCtx->height = m_uiHeight;
+  m_cCodedCtx->pix_fmt = encPixFmt;
+  m_cCodedCtx->time_base = av_inv_q( frameRate );
+  m_cCodedCtx->framerate = frameRate;
+  m_cCodedCtx->thread_count = static_cast<int>( m_uiEncoderThreads );
+  if( m_cFmtCtx->oformat->flags & AVFMT_GLOBALHEADER )
+    m_cCodedCtx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+  if( encoderName == "ffv1" )
+  {
+    // Version 3 encodes the slices in parallel and checks them with a CRC
+    m_cCodedCtx->level = 3;
+    av_opt_set( m_cCodedCtx->priv_data, "slicecrc", "1", 0 );
+  }
+  else if( encoderName == "libx264" )
+  {
+    av_opt_set( m_cCodedCtx->priv_data, "qp", "0", 0 );
+  }
+  else if( encoderName == "libx265" )
+  {
+    av_opt_set( m_cCodedCtx->priv_data, "x265-params", "lossless=1", 0 );
+  }
+
+  if( avcodec_open2( m_cCodedCtx, enc, NULL ) < 0 )
+  {
+    std::cout << "Failed to open the " << encoderName << " encoder" << std::endl;
+    closeEncoder();
+    return false;
+  }
+  m_cStream->time_base = m_cCodedCtx->time_base;
+  avcodec_parameters_from_context( m_cStream->codecpar, m_cCodedCtx );
+
+  const bool needsFile = !( m_cFmtCtx->oformat->flags & AVFMT_NOFILE );
+  if( needsFile && avio_open( &m_cFmtCtx->pb, strFilename.c_str(), AVIO_FLAG_WRITE ) < 0 )
+  {
+    std::cout << "Failed to open " << strFilename << std::endl;
+    closeEncoder();
+    return false;
+  }
+  if( avformat_write_header( m_cFmtCtx, NULL ) < 0 )
+  {
+    std::cout << "Failed to write the container header" << std::endl;
+    closeEncoder();
+    return false;
+  }
+  m_bHasStream = true;
+  m_bEncodeFailed = false;
+  m_iEncodedFrames = 0;
+
+  m_cFrame = av_frame_alloc();
+  m_cPacket = av_packet_alloc();
+  if( !m_cFrame || !m_cPacket )
+  {
+    // Only the trailer is written
+    m_bEncodeFailed = true;
+    closeEncoder();
+    return false;
+  }
+  m_cFrame->format = encPixFmt;
+  m_cFrame->width = m_uiWidth;
+  m_cFrame->height = m_uiHeight;
+
+  m_pcDirectFormat = encFormat;
+  m_iEndianness = encFormat->endianness;
+  m_strFormatName = clpUppercase( strFilename.substr( strFilename.find_last_of( "." ) + 1 ) );
+  m_strCodecName = enc->name;
+  return true;
+#endif
+}
+
+void StreamHandlerLibav::closeEncoder()
+{
+  if( m_bHasStream && !finishHandler() )
+    std::cout << "Failed to finish the " << m_strFormatName << " stream" << std::endl;
+
+  if( m_cFmtCtx )
+  {
+    if( !( m_cFmtCtx->oformat->flags & AVFMT_NOFILE ) )
+      avio_closep( &m_cFmtCtx->pb );
+    avformat_free_context( m_cFmtCtx );
+    m_cFmtCtx = NULL;
+    m_cStream = NULL;
+  }
+  avcodec_free_context( &m_cCodedCtx );
+  av_frame_free( &m_cFrame );
+  av_packet_free( &m_cPacket );
+  m_bHasStream = false;
+}
+
+/**
+ * Drain the frames held by the encoder and write the trailer,
+ * also written after a failure so that the packets already muxed can be read
+ */
+bool StreamHandlerLibav::finishHandler()
+{
+  if( m_bIsInput || !m_bHasStream )
     return true;
+  bool bOk = !m_bEncodeFailed && encodeFrame( nullptr );
+  bOk = av_write_trailer( m_cFmtCtx ) >= 0 && bOk;
+  m_bHasStream = false;
+  return bOk;
+}
+
+/**
+ * Encode a frame (nullptr flushes the encoder) and write its packets
+ */
+bool StreamHandlerLibav::encodeFrame( const CalypFrame* pcFrame )
+{
+  AVFrame* picture = NULL;
+  if( pcFrame )
+  {
+    pcFrame->frameToBuffer( m_pStreamBuffer, m_iEndianness );
+
+    // The planes are contiguous in the buffer, libavcodec copies them as the frame is not reference counted
+    const unsigned int bytesPerSample = m_pcDirectFormat->bitsPerPixel > 8 ? 2 : 1;
+    ClpByte* plane = m_pStreamBuffer.data();
+    for( unsigned int ch = 0; ch < pcFrame->getNumberChannels(); ch++ )
+    {
+      const int idx = m_pcDirectFormat->planes[ch];
+      m_cFrame->data[idx] = plane;
+      m_cFrame->linesize[idx] = static_cast<int>( pcFrame->getWidth( ch ) * bytesPerSample );
+      plane += std::size_t( pcFrame->getWidth( ch ) ) * pcFrame->getHeight( ch ) * bytesPerSample;
+    }
+    m_cFrame->pts = m_iEncodedFrames++;
+    picture = m_cFrame;
+  }
+
+#ifdef FF_SEND_RECEIVE_API
+  if( avcodec_send_frame( m_cCodedCtx, picture ) < 0 )
+    return false;
+  for( ;; )
+  {
+    int iRet = avcodec_receive_packet( m_cCodedCtx, m_cPacket );
+    if( iRet == AVERROR( EAGAIN ) || iRet == AVERROR_EOF )
+      return true;
+    if( iRet < 0 )
+      return false;
+    av_packet_rescale_ts( m_cPacket, m_cCodedCtx->time_base, m_cStream->time_base );
+    m_cPacket->stream_index = m_cStream->index;
+    if( av_interleaved_write_frame( m_cFmtCtx, m_cPacket ) < 0 )
+      return false;
   }
+#else
   return false;
+#endif
 }
 
 bool StreamHandlerLibav::write( const CalypFrame& pcFrame )
 {
-  return false;
+  if( m_bIsInput || !m_bHasStream || m_bEncodeFailed )
+    return false;
+  // A failed encoder or muxer cannot take the following frames
+  if( !encodeFrame( &pcFrame ) )
+    m_bEncodeFailed = true;
+  return !m_bEncodeFailed;
 }
 
 bool StreamHandlerLibav::seek( std::uint64_t iFrameNum )
 {
+  adoptFrameIndex();
   if( m_uiTotalNumberFrames == 1 )
     return true;
 
   if( m_uiCurrFrameFileIdx == iFrameNum )
     return true;
 
-  int flags = AVSEEK_FLAG_ANY | AVSEEK_FLAG_FRAME;
-  if( iFrameNum < m_uiCurrFrameFileIdx )
+  if( iFrameNum >= m_aFrameIndex.size() )
+  {
+    int flags = AVSEEK_FLAG_ANY | AVSEEK_FLAG_FRAME;
+    if( iFrameNum < m_uiCurrFrameFileIdx )
+    {
+      flags |= AVSEEK_FLAG_BACKWARD;
+    }
+    int iRet = av_seek_frame( m_cFmtCtx, m_iStreamIdx, iFrameNum, flags );
+    if( iRet < 0 )
+    {
+      return false;
+    }
+    avcodec_flush_buffers( m_cCodedCtx );
+    m_uiCurrFrameFileIdx = iFrameNum;
+    return true;
+  }
+
+  // Decode forward from the key frame, or from the current frame if the key frame is not after it
+  const std::uint64_t keyFrame = keyFrameBefore( iFrameNum );
+  if( iFrameNum < m_uiCurrFrameFileIdx || keyFrame > m_uiCurrFrameFileIdx )
   {
-    flags |= AVSEEK_FLAG_BACKWARD;
+    if( !seekKeyFrame( keyFrame ) )
+      return false;
+    m_uiSeekSkipFrames = iFrameNum - keyFrame;
   }
-  int iRet = av_seek_frame( m_cFmtCtx, m_iStreamIdx, iFrameNum, flags );
-  if( iRet < 0 )
+  else
   {
-    return false;
+    m_uiSeekSkipFrames += iFrameNum - m_uiCurrFrameFileIdx;
   }
-  avcodec_flush_buffers( m_cCodedCtx );
+  m_iSeekTargetPts = m_bIndexHasPts ? m_aFrameIndex[iFrameNum].pts : AV_NOPTS_VALUE;
   m_uiCurrFrameFileIdx = iFrameNum;
   return true;
 }
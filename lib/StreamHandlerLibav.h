@@ -28,7 +28,13 @@
 
 #include <inttypes.h>
 
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
+#include <thread>
 #include <vector>
 
 #ifndef __PRI64_PREFIX
@@ -44,10 +50,12 @@ extern "C" {
 #include <libavformat/avformat.h>
 #include <libavutil/avutil.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/opt.h>
 #include <libavutil/samplefmt.h>
 #include <libswscale/swscale.h>
 }
 
+#include "CalypFrame.h"
 #include "CalypStream.h"
 #include "CalypStreamHandlerIf.h"
 
@@ -63,7 +71,7 @@ class StreamHandlerLibav : public CalypStreamHandlerIf
 
 public:
   StreamHandlerLibav();
-  ~StreamHandlerLibav() {}
+  ~StreamHandlerLibav();
   bool openHandler( std::string strFilename, bool bInput );
   void closeHandler();
   bool configureBuffer( const CalypFrame& pcFrame );
@@ -71,24 +79,95 @@ public:
   bool seek( std::uint64_t iFrameNum );
   bool read( CalypFrame& pcFrame );
   bool write( const CalypFrame& pcFrame );
+  bool finishHandler();
 
   unsigned int getStreamDuration() { return m_uiSecs; }
   unsigned char* m_pchFrameBuffer;
   unsigned long long int m_uiFrameBufferSize;
 
 private:
-  AVFormatContext* m_cFmtCtx;
-  AVStream* m_cStream;
+  /**
+   * Frame of the stream as found by the demuxer (no decoding)
+   */
+  struct FrameIndexEntry
+  {
+    std::int64_t pts;  //!< Presentation time stamp (stream time base)
+    std::int64_t dts;  //!< Decoding time stamp (stream time base)
+    bool keyFrame;
+  };
+
+  /**
+   * Key frame added to the index of the demuxers without one of their own
+   */
+  struct SeekEntry
+  {
+    std::int64_t pos;
+    std::int64_t dts;
+    int size;
+  };
+
+  /**
+   * Index built by the indexing thread, see adoptFrameIndex()
+   */
+  struct FrameIndex
+  {
+    std::vector<FrameIndexEntry> frames;
+    std::vector<std::uint64_t> keyFrames;
+    std::vector<SeekEntry> seekEntries;
+    bool hasPts{ false };
+  };
+
+  /**
+   * Decoded pixel format imported plane by plane into the frames
+   */
+  struct DirectFormat;
+  static auto directFormats() -> std::span<const DirectFormat>;
+  static auto findDirectFormat( int ffPixFmt ) -> const DirectFormat*;
+  static auto findEncoderFormat( ClpPixelFormats pixelFormat, unsigned int bitsPerPixel ) -> const DirectFormat*;
+
+  bool buildFrameIndex( const std::string& filename, bool addSeekEntries, FrameIndex& index );
+  void adoptFrameIndex();
+  void stopFrameIndex();
+  auto keyFrameBefore( std::uint64_t iFrameNum ) const -> std::uint64_t;
+  bool seekKeyFrame( std::uint64_t iKeyFrame );
+  bool decodeFrame();
+  void importPlanes( const AVFrame* picture, CalypFrame& pcFrame ) const;
+
+  bool openEncoder( const std::string& strFilename );
+  void closeEncoder();
+  bool encodeFrame( const CalypFrame* pcFrame );
+
+  //! Frames in presentation order, empty if the stream could not be indexed
+  std::vector<FrameIndexEntry> m_aFrameIndex;
+  //! Frame numbers of the key frames
+  std::vector<std::uint64_t> m_aKeyFrames;
+  //! The index frames are sorted by presentation time stamp
+  bool m_bIndexHasPts{ false };
+
+  // Indexing thread, started by openHandler()
+  std::thread m_indexThread;
+  std::mutex m_indexMutex;
+  std::atomic<bool> m_bIndexStop{ false };
+  std::optional<FrameIndex> m_pendingIndex;  //!< Set by the indexing thread when it finishes
+
+  // Decoded frames dropped after a seek
+  std::int64_t m_iSeekTargetPts{ AV_NOPTS_VALUE };
+  std::uint64_t m_uiSeekSkipFrames{ 0 };
+  std::uint64_t m_uiSeekKeyFrame{ 0 };
+  bool m_bSeekFirstFrame{ false };
+
+  AVFormatContext* m_cFmtCtx{ nullptr };
+  AVStream* m_cStream{ nullptr };
   int m_iStreamIdx;
 
   struct SwsContext* m_ScalerCtx;
 
-  AVCodecContext* m_cCodedCtx;
+  AVCodecContext* m_cCodedCtx{ nullptr };
 
   int m_ffPixFmt;
-  AVFrame* m_cFrame;
+  AVFrame* m_cFrame{ nullptr };
   AVPacket m_cOrgPacket;
-  AVPacket* m_cPacket;
+  AVPacket* m_cPacket{ nullptr };
 
   bool m_bHasStream;
 
@@ -96,6 +175,12 @@ private:
   unsigned long long int m_uiMicroSec;
 
   AVFrame* m_cConvertedFrame;
+  //! Layout of the decoded (or converted) frames, nullptr if they are copied through m_pStreamBuffer
+  const DirectFormat* m_pcDirectFormat{ nullptr };
+
+  // Encoder, fed by write() (in the write-behind thread of the stream if any)
+  bool m_bEncodeFailed{ false };
+  std::int64_t m_iEncodedFrames{ 0 };
 };
 
 #endif  // __STREAMHANDLERLIBAV_H__
@@ -24,11 +24,38 @@
 
 #include "StreamHandlerRaw.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <filesystem>
 
 #include "CalypFrame.h"
 
+#if defined( __unix__ ) || defined( __APPLE__ )
+#define CALYP_RAW_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+// Frames paged in ahead of the play direction
+constexpr std::uint64_t kReadAheadFrames = 2;
+
+// Reads after a seek that are still part of it (see CalypStream::seekInput())
+constexpr unsigned int kSeekReads = 2;
+
+auto seekFile( FILE* file, std::uint64_t offset ) -> bool
+{
+#if defined( _WIN32 )
+  return _fseeki64( file, static_cast<long long>( offset ), SEEK_SET ) == 0;
+#else
+  return fseeko( file, static_cast<off_t>( offset ), SEEK_SET ) == 0;
+#endif
+}
+
+}  // namespace
+
 std::vector<CalypStreamFormat> StreamHandlerRaw::supportedReadFormats()
 {
   INI_REGIST_CALYP_SUPPORTED_FMT;
@@ -55,11 +82,23 @@ StreamHandlerRaw::StreamHandlerRaw()
 bool StreamHandlerRaw::openHandler( std::string strFilename, bool bInput )
 {
   m_bIsInput = bInput;
-  m_pFile = NULL;
-  m_pFile = fopen( strFilename.c_str(), bInput ? "rb" : "wb" );
-  if( m_pFile == NULL )
+  m_bReverse = false;
+  m_uiReadsSinceSeek = 0;
+  m_uiFileSize = 0;
+  if( !bInput || !mapFile( strFilename ) )
   {
-    return false;
+    m_pFile = fopen( strFilename.c_str(), bInput ? "rb" : "wb" );
+    if( m_pFile == NULL )
+    {
+      return false;
+    }
+    if( bInput )
+    {
+      std::error_code ec;
+      m_uiFileSize = std::filesystem::file_size( strFilename, ec );
+      if( ec )
+        m_uiFileSize = 0;
+    }
   }
   calculateFrameNumber();
   std::string fileExtension = std::filesystem::path{ strFilename }.extension().string();
@@ -71,41 +110,144 @@ bool StreamHandlerRaw::openHandler( std::string strFilename, bool bInput )
 
 void StreamHandlerRaw::closeHandler()
 {
+  unmapFile();
   if( m_pFile )
     fclose( m_pFile );
+  m_pFile = nullptr;
+}
+
+bool StreamHandlerRaw::mapFile( const std::string& strFilename )
+{
+#if defined( CALYP_RAW_MMAP )
+  int fd = ::open( strFilename.c_str(), O_RDONLY );
+  if( fd < 0 )
+    return false;
+  std::error_code ec;
+  const std::uint64_t fileSize = std::filesystem::file_size( strFilename, ec );
+  // Empty files cannot be mapped and 32 bits builds cannot map large ones
+  if( ec || fileSize == 0 || fileSize > std::uint64_t( SIZE_MAX ) )
+  {
+    ::close( fd );
+    return false;
+  }
+  void* mapping = mmap( nullptr, std::size_t( fileSize ), PROT_READ, MAP_SHARED, fd, 0 );
+  // The mapping holds its own reference to the file
+  ::close( fd );
+  if( mapping == MAP_FAILED )
+    return false;
+  m_pMapping = static_cast<const ClpByte*>( mapping );
+  m_uiFileSize = fileSize;
+  madvise( mapping, std::size_t( fileSize ), MADV_SEQUENTIAL );
+  return true;
+#else
+  return false;
+#endif
+}
+
+void StreamHandlerRaw::unmapFile()
+{
+#if defined( CALYP_RAW_MMAP )
+  if( m_pMapping )
+    munmap( const_cast<ClpByte*>( m_pMapping ), std::size_t( m_uiFileSize ) );
+#endif
+  m_pMapping = nullptr;
+}
+
+/**
+ * Sequential access lets the kernel read ahead, backwards playback
+ * relies on the hints of adviseNextFrames() instead
+ */
+void StreamHandlerRaw::setReverse( bool bReverse )
+{
+  if( bReverse == m_bReverse )
+    return;
+  m_bReverse = bReverse;
+#if defined( CALYP_RAW_MMAP )
+  if( m_pMapping )
+  {
+    madvise( const_cast<ClpByte*>( m_pMapping ), std::size_t( m_uiFileSize ),
+             bReverse ? MADV_RANDOM : MADV_SEQUENTIAL );
+  }
+#endif
+}
+
+/**
+ * Page in the next frames in the play direction
+ */
+void StreamHandlerRaw::adviseNextFrames()
+{
+#if defined( CALYP_RAW_MMAP )
+  if( !m_pMapping || m_uiNBytesPerFrame == 0 )
+    return;
+  std::uint64_t firstFrame = m_uiCurrFrameFileIdx;
+  std::uint64_t lastFrame = std::min( m_uiCurrFrameFileIdx + kReadAheadFrames, m_uiTotalNumberFrames );
+  if( m_bReverse )
+  {
+    // m_uiCurrFrameFileIdx is the frame sought last
+    firstFrame = m_uiCurrFrameFileIdx - std::min( m_uiCurrFrameFileIdx, kReadAheadFrames );
+    lastFrame = m_uiCurrFrameFileIdx;
+  }
+  if( firstFrame >= lastFrame )
+    return;
+  static const std::uint64_t pageSize = std::uint64_t( sysconf( _SC_PAGESIZE ) );
+  const std::uint64_t start = firstFrame * m_uiNBytesPerFrame / pageSize * pageSize;
+  const std::uint64_t end = lastFrame * m_uiNBytesPerFrame;
+  madvise( const_cast<ClpByte*>( m_pMapping ) + start, std::size_t( end - start ), MADV_WILLNEED );
+#endif
 }
 
 bool StreamHandlerRaw::configureBuffer( const CalypFrame& pcFrame )
 {
-  m_pStreamBuffer.resize( pcFrame.getBytesPerFrame() );
+  // Mapped files are unpacked in place
+  if( m_pMapping )
+    m_pStreamBuffer.clear();
+  else
+    m_pStreamBuffer.resize( pcFrame.getBytesPerFrame() );
   return true;
 }
 
 void StreamHandlerRaw::calculateFrameNumber()
 {
-  if( m_pFile && m_uiNBytesPerFrame > 0 )
+  if( m_bIsInput && m_uiNBytesPerFrame > 0 )
   {
-    fseek( m_pFile, 0, SEEK_END );
-    unsigned long long fileSize = ftell( m_pFile );
-    fseek( m_pFile, 0, SEEK_SET );
-    m_uiTotalNumberFrames = fileSize / m_uiNBytesPerFrame;
+    m_uiTotalNumberFrames = m_uiFileSize / m_uiNBytesPerFrame;
   }
 }
 
 bool StreamHandlerRaw::seek( std::uint64_t iFrameNum )
 {
-  if( m_bIsInput && m_pFile )
-  {
-    fseek( m_pFile, iFrameNum >= 0 ? iFrameNum * m_uiNBytesPerFrame : 0, SEEK_SET );
-    m_uiCurrFrameFileIdx = iFrameNum;
-    return true;
-  }
-  return false;
+  if( !m_bIsInput || ( !m_pFile && !m_pMapping ) )
+    return false;
+  if( m_pFile && !seekFile( m_pFile, iFrameNum * m_uiNBytesPerFrame ) )
+    return false;
+  setReverse( iFrameNum < m_uiCurrFrameFileIdx );
+  m_uiReadsSinceSeek = 0;
+  m_uiCurrFrameFileIdx = iFrameNum;
+  if( m_bReverse )
+    adviseNextFrames();
+  return true;
 }
 
 bool StreamHandlerRaw::read( CalypFrame& pcFrame )
 {
-  if( !m_pFile || m_pStreamBuffer.empty() || m_uiNBytesPerFrame == 0 )
+  if( m_uiNBytesPerFrame == 0 )
+    return false;
+  if( m_pMapping )
+  {
+    const std::uint64_t offset = m_uiCurrFrameFileIdx * m_uiNBytesPerFrame;
+    if( offset + m_uiNBytesPerFrame > m_uiFileSize )
+      return false;
+    m_uiCurrFrameFileIdx++;
+    // Reading on after a seek means playing forward again
+    if( ++m_uiReadsSinceSeek > kSeekReads )
+      setReverse( false );
+    if( !m_bReverse )
+      adviseNextFrames();
+    pcFrame.frameFromBuffer( std::span<const ClpByte>( m_pMapping + offset, std::size_t( m_uiNBytesPerFrame ) ),
+                             m_iEndianness );
+    return true;
+  }
+  if( !m_pFile || m_pStreamBuffer.empty() )
     return false;
   unsigned long long int processed_bytes = fread( m_pStreamBuffer.data(), sizeof( ClpByte ), m_uiNBytesPerFrame, m_pFile );
   if( processed_bytes != m_uiNBytesPerFrame )
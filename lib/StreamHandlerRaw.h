@@ -26,22 +26,38 @@
 #ifndef __STREAMHANDLERRAW_H__
 #define __STREAMHANDLERRAW_H__
 
+#include <cstdio>
+
 #include "CalypStreamHandlerIf.h"
 
 /**
  * \class StreamHandlerRaw
  * \brief    Class to handle raw video format
+ *
+ * Input files are memory mapped when the platform allows it, frames are
+ * then unpacked straight from the mapping and seeking is free.
+ * Otherwise (and for output files) the file is accessed with stdio.
  */
 class StreamHandlerRaw : public CalypStreamHandlerIf
 {
   REGISTER_CALYP_STREAM_HANDLER( StreamHandlerRaw )
 
 private:
-  FILE* m_pFile; /**< The input file pointer >*/
+  FILE* m_pFile{ nullptr }; /**< The file pointer when the file is not mapped >*/
+  std::uint64_t m_uiFileSize{ 0 };
+
+  const ClpByte* m_pMapping{ nullptr }; /**< The mapped input file >*/
+  bool m_bReverse{ false };             /**< Frames are being read backwards >*/
+  unsigned int m_uiReadsSinceSeek{ 0 };
+
+  bool mapFile( const std::string& strFilename );
+  void unmapFile();
+  void setReverse( bool bReverse );
+  void adviseNextFrames();
 
 public:
   StreamHandlerRaw();
-  ~StreamHandlerRaw() {}
+  ~StreamHandlerRaw() { closeHandler(); }
   bool openHandler( std::string strFilename, bool bInput );
   void closeHandler();
   bool configureBuffer( const CalypFrame& pcFrame );
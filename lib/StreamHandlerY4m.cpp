@@ -0,0 +1,353 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2021  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     StreamHandlerY4m.cpp
+ * \brief    Handling YUV4MPEG2 streams
+ */
+
+#include "StreamHandlerY4m.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <sstream>
+#include <string_view>
+
+#include "CalypFrame.h"
+
+#if defined( _WIN32 )
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace
+{
+constexpr std::string_view kStreamMagic{ "YUV4MPEG2" };
+constexpr std::string_view kFrameMagic{ "FRAME" };
+
+// Longest header line accepted, they are tens of bytes unless they carry extensions
+constexpr std::size_t kMaxHeaderLength = 4096;
+
+struct Y4mColorSpace
+{
+  std::string_view tag;
+  ClpPixelFormats pixelFormat;
+  unsigned int bitsPerPixel;
+};
+
+// The first tag of each format is the one written
+constexpr Y4mColorSpace kColorSpaces[] = {
+    { "420jpeg", ClpPixelFormats::YUV420p, 8 },  { "420mpeg2", ClpPixelFormats::YUV420p, 8 },
+    { "420paldv", ClpPixelFormats::YUV420p, 8 }, { "420", ClpPixelFormats::YUV420p, 8 },
+    { "422", ClpPixelFormats::YUV422p, 8 },      { "444", ClpPixelFormats::YUV444p, 8 },
+    { "mono", ClpPixelFormats::Gray, 8 },        { "420p9", ClpPixelFormats::YUV420p, 9 },
+    { "420p10", ClpPixelFormats::YUV420p, 10 },  { "420p12", ClpPixelFormats::YUV420p, 12 },
+    { "420p14", ClpPixelFormats::YUV420p, 14 },  { "420p16", ClpPixelFormats::YUV420p, 16 },
+    { "422p9", ClpPixelFormats::YUV422p, 9 },    { "422p10", ClpPixelFormats::YUV422p, 10 },
+    { "422p12", ClpPixelFormats::YUV422p, 12 },  { "422p14", ClpPixelFormats::YUV422p, 14 },
+    { "422p16", ClpPixelFormats::YUV422p, 16 },  { "444p9", ClpPixelFormats::YUV444p, 9 },
+    { "444p10", ClpPixelFormats::YUV444p, 10 },  { "444p12", ClpPixelFormats::YUV444p, 12 },
+    { "444p14", ClpPixelFormats::YUV444p, 14 },  { "444p16", ClpPixelFormats::YUV444p, 16 },
+    { "mono9", ClpPixelFormats::Gray, 9 },       { "mono10", ClpPixelFormats::Gray, 10 },
+    { "mono12", ClpPixelFormats::Gray, 12 },     { "mono14", ClpPixelFormats::Gray, 14 },
+    { "mono16", ClpPixelFormats::Gray, 16 },
+};
+
+/**
+ * Read a header line without its line feed
+ */
+auto readLine( FILE* file, std::string& line ) -> bool
+{
+  line.clear();
+  int c;
+  while( ( c = fgetc( file ) ) != EOF && c != '\n' )
+  {
+    if( line.size() == kMaxHeaderLength )
+      return false;
+    line.push_back( char( c ) );
+  }
+  return c == '\n';
+}
+
+auto seekFile( FILE* file, std::uint64_t offset ) -> bool
+{
+#if defined( _WIN32 )
+  return _fseeki64( file, static_cast<long long>( offset ), SEEK_SET ) == 0;
+#else
+  return fseeko( file, static_cast<off_t>( offset ), SEEK_SET ) == 0;
+#endif
+}
+
+}  // namespace
+
+std::vector<CalypStreamFormat> StreamHandlerY4m::supportedReadFormats()
+{
+  INI_REGIST_CALYP_SUPPORTED_FMT;
+  REGIST_CALYP_SUPPORTED_FMT( &StreamHandlerY4m::Create, "YUV4MPEG2 Video", "y4m" );
+  END_REGIST_CALYP_SUPPORTED_FMT;
+}
+
+std::vector<CalypStreamFormat> StreamHandlerY4m::supportedWriteFormats()
+{
+  INI_REGIST_CALYP_SUPPORTED_FMT;
+  REGIST_CALYP_SUPPORTED_FMT( &StreamHandlerY4m::Create, "YUV4MPEG2 Video", "y4m" );
+  END_REGIST_CALYP_SUPPORTED_FMT;
+}
+
+bool StreamHandlerY4m::probe( const std::string& strFilename )
+{
+  if( strFilename == "-" )
+    return true;
+  std::error_code ec;
+  if( !std::filesystem::is_regular_file( strFilename, ec ) )
+    return false;
+  FILE* file = fopen( strFilename.c_str(), "rb" );
+  if( !file )
+    return false;
+  char magic[kStreamMagic.size()];
+  const bool isY4m = fread( magic, 1, sizeof( magic ), file ) == sizeof( magic ) &&
+                     std::memcmp( magic, kStreamMagic.data(), sizeof( magic ) ) == 0;
+  fclose( file );
+  return isY4m;
+}
+
+bool StreamHandlerY4m::openHandler( std::string strFilename, bool bInput )
+{
+  m_bIsInput = bInput;
+  m_bStreaming = false;
+  m_bStdio = bInput && strFilename == "-";
+  m_uiCurrFrameFileIdx = 0;
+  m_uiTotalNumberFrames = 0;
+  m_uiFileSize = 0;
+  m_uiDataOffset = 0;
+  m_uiFrameHeaderSize = 0;
+  m_strFormatName = "Y4M";
+  m_strCodecName = "Raw Video";
+
+  if( m_bStdio )
+  {
+    m_pFile = stdin;
+#if defined( _WIN32 )
+    _setmode( _fileno( stdin ), _O_BINARY );
+#endif
+  }
+  else
+  {
+    m_pFile = fopen( strFilename.c_str(), bInput ? "rb" : "wb" );
+  }
+  if( m_pFile == NULL )
+    return false;
+
+  if( !m_bIsInput )
+  {
+    auto colorSpace =
+        std::find_if( std::begin( kColorSpaces ), std::end( kColorSpaces ), [this]( const Y4mColorSpace& cs ) {
+          return cs.pixelFormat == m_iPixelFormat && cs.bitsPerPixel == m_uiBitsPerPixel;
+        } );
+    if( colorSpace == std::end( kColorSpaces ) )
+    {
+      closeHandler();
+      throw CalypFailure( "CalypStream", "Invalid format for YUV4MPEG2" );
+      return false;
+    }
+    // Frame rates such as 29.97 are written as 30000:1001
+    long fpsNum = std::lround( m_dFrameRate );
+    long fpsDen = 1;
+    if( fpsNum <= 0 )
+      fpsNum = 30;
+    else if( std::abs( m_dFrameRate - double( fpsNum ) ) > 1e-3 )
+    {
+      fpsNum = std::lround( m_dFrameRate * 1001 );
+      fpsDen = 1001;
+    }
+    m_iEndianness = m_uiBitsPerPixel > 8 ? CLP_LITTLE_ENDIAN : CLP_BIG_ENDIAN;
+    return fprintf( m_pFile, "%s W%u H%u F%ld:%ld Ip A0:0 C%s\n", kStreamMagic.data(), m_uiWidth, m_uiHeight, fpsNum,
+                    fpsDen, std::string( colorSpace->tag ).c_str() ) > 0;
+  }
+
+  std::string header;
+  if( !readLine( m_pFile, header ) || !parseHeader( header ) )
+  {
+    closeHandler();
+    return false;
+  }
+  m_uiDataOffset = header.size() + 1;
+
+  std::error_code ec;
+  m_bStreaming = m_bStdio || !std::filesystem::is_regular_file( strFilename, ec );
+  if( m_bStreaming )
+  {
+    // The header of the next frame is always read ahead to know whether there is one
+    m_uiTotalNumberFrames = readFrameHeader() ? 1 : 0;
+    return true;
+  }
+
+  m_uiFileSize = std::filesystem::file_size( strFilename, ec );
+  std::string frameHeader;
+  if( !ec && readLine( m_pFile, frameHeader ) && frameHeader.starts_with( kFrameMagic ) )
+    m_uiFrameHeaderSize = frameHeader.size() + 1;
+  return true;
+}
+
+void StreamHandlerY4m::closeHandler()
+{
+  if( m_pFile && !m_bStdio )
+    fclose( m_pFile );
+  m_pFile = nullptr;
+  m_bStdio = false;
+}
+
+/**
+ * Parse the stream header, e.g., "YUV4MPEG2 W352 H288 F30000:1001 Ip A1:1 C420jpeg"
+ */
+bool StreamHandlerY4m::parseHeader( const std::string& strHeader )
+{
+  std::istringstream tokens( strHeader );
+  std::string token;
+  if( !( tokens >> token ) || token != kStreamMagic )
+    return false;
+
+  std::string colorSpaceTag{ kColorSpaces[0].tag };
+  unsigned int fpsNum = 0;
+  unsigned int fpsDen = 0;
+  m_uiWidth = 0;
+  m_uiHeight = 0;
+  while( tokens >> token )
+  {
+    const char* value = token.c_str() + 1;
+    switch( token[0] )
+    {
+    case 'W':
+      m_uiWidth = std::strtoul( value, nullptr, 10 );
+      break;
+    case 'H':
+      m_uiHeight = std::strtoul( value, nullptr, 10 );
+      break;
+    case 'F':
+      if( sscanf( value, "%u:%u", &fpsNum, &fpsDen ) != 2 )
+        fpsNum = fpsDen = 0;
+      break;
+    case 'C':
+      colorSpaceTag = value;
+      break;
+    case 'X':
+      if( token == "XCOLORRANGE=LIMITED" )
+        m_eColorRange = CLP_RANGE_LIMITED;
+      else if( token == "XCOLORRANGE=FULL" )
+        m_eColorRange = CLP_RANGE_FULL;
+      break;
+    default:
+      // Interlacing, aspect ratio and extensions
+      break;
+    }
+  }
+
+  auto colorSpace = std::find_if( std::begin( kColorSpaces ), std::end( kColorSpaces ),
+                                  [&colorSpaceTag]( const Y4mColorSpace& cs ) { return cs.tag == colorSpaceTag; } );
+  if( colorSpace == std::end( kColorSpaces ) || m_uiWidth == 0 || m_uiHeight == 0 )
+    return false;
+  m_iPixelFormat = colorSpace->pixelFormat;
+  m_uiBitsPerPixel = colorSpace->bitsPerPixel;
+  m_iEndianness = m_uiBitsPerPixel > 8 ? CLP_LITTLE_ENDIAN : CLP_BIG_ENDIAN;
+  if( fpsNum > 0 && fpsDen > 0 )
+    m_dFrameRate = double( fpsNum ) / double( fpsDen );
+  return true;
+}
+
+bool StreamHandlerY4m::readFrameHeader()
+{
+  std::string frameHeader;
+  return readLine( m_pFile, frameHeader ) && frameHeader.starts_with( kFrameMagic );
+}
+
+/**
+ * Read the samples of the next frame (dropped if pcFrame is nullptr),
+ * streams also read the header of the following one
+ */
+bool StreamHandlerY4m::readFrameData( CalypFrame* pcFrame )
+{
+  if( fread( m_pStreamBuffer.data(), sizeof( ClpByte ), m_uiNBytesPerFrame, m_pFile ) != m_uiNBytesPerFrame )
+    return false;
+  if( pcFrame )
+    pcFrame->frameFromBuffer( m_pStreamBuffer, m_iEndianness );
+  m_uiCurrFrameFileIdx++;
+  if( m_bStreaming )
+    m_uiTotalNumberFrames = m_uiCurrFrameFileIdx + ( readFrameHeader() ? 1 : 0 );
+  return true;
+}
+
+bool StreamHandlerY4m::configureBuffer( const CalypFrame& pcFrame )
+{
+  m_pStreamBuffer.resize( pcFrame.getBytesPerFrame() );
+  return true;
+}
+
+void StreamHandlerY4m::calculateFrameNumber()
+{
+  // Streams count the frames as they are read
+  if( m_bIsInput && !m_bStreaming && m_uiFrameHeaderSize > 0 && m_uiNBytesPerFrame > 0 )
+  {
+    m_uiTotalNumberFrames = ( m_uiFileSize - m_uiDataOffset ) / ( m_uiFrameHeaderSize + m_uiNBytesPerFrame );
+  }
+}
+
+bool StreamHandlerY4m::seek( std::uint64_t iFrameNum )
+{
+  if( !m_bIsInput || !m_pFile )
+    return false;
+  if( m_bStreaming )
+  {
+    // Forward only, the frames in between are dropped
+    if( iFrameNum < m_uiCurrFrameFileIdx || iFrameNum > m_uiTotalNumberFrames )
+      return false;
+    while( m_uiCurrFrameFileIdx < iFrameNum )
+    {
+      if( m_uiCurrFrameFileIdx >= m_uiTotalNumberFrames || !readFrameData( nullptr ) )
+        return false;
+    }
+    return true;
+  }
+  // Every frame header is assumed to be as long as the first one
+  if( !seekFile( m_pFile, m_uiDataOffset + iFrameNum * ( m_uiFrameHeaderSize + m_uiNBytesPerFrame ) ) )
+    return false;
+  m_uiCurrFrameFileIdx = iFrameNum;
+  return true;
+}
+
+bool StreamHandlerY4m::read( CalypFrame& pcFrame )
+{
+  if( !m_pFile || m_pStreamBuffer.empty() )
+    return false;
+  if( m_bStreaming ? m_uiCurrFrameFileIdx >= m_uiTotalNumberFrames : !readFrameHeader() )
+    return false;
+  return readFrameData( &pcFrame );
+}
+
+bool StreamHandlerY4m::write( const CalypFrame& pcFrame )
+{
+  pcFrame.frameToBuffer( m_pStreamBuffer, m_iEndianness );
+  if( fprintf( m_pFile, "%s\n", kFrameMagic.data() ) < 0 )
+    return false;
+  return fwrite( m_pStreamBuffer.data(), sizeof( ClpByte ), m_uiNBytesPerFrame, m_pFile ) == m_uiNBytesPerFrame;
+}
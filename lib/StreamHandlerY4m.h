@@ -0,0 +1,74 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2021  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     StreamHandlerY4m.h
+ * \ingroup  CalypStreamGrp
+ * \brief    Handling YUV4MPEG2 streams
+ */
+
+#ifndef __STREAMHANDLERY4M_H__
+#define __STREAMHANDLERY4M_H__
+
+#include <cstdio>
+
+#include "CalypStreamHandlerIf.h"
+
+/**
+ * \class StreamHandlerY4m
+ * \brief    Class to handle YUV4MPEG2 streams
+ *
+ * The size, pixel format and frame rate come from the stream header.
+ * Files are read at any position, pipes and the standard input
+ * (filename "-") are read forward only (see CalypStream::isStreaming())
+ */
+class StreamHandlerY4m : public CalypStreamHandlerIf
+{
+  REGISTER_CALYP_STREAM_HANDLER( StreamHandlerY4m )
+
+public:
+  /**
+   * Check if an input is a YUV4MPEG2 stream without consuming it,
+   * pipes are not probed and only the standard input is accepted
+   */
+  static bool probe( const std::string& strFilename );
+
+  StreamHandlerY4m() { m_pchHandlerName = "YUV4MPEG2"; }
+  ~StreamHandlerY4m() { closeHandler(); }
+  bool openHandler( std::string strFilename, bool bInput );
+  void closeHandler();
+  bool configureBuffer( const CalypFrame& pcFrame );
+  void calculateFrameNumber();
+  bool seek( std::uint64_t iFrameNum );
+  bool read( CalypFrame& pcFrame );
+  bool write( const CalypFrame& pcFrame );
+
+private:
+  bool parseHeader( const std::string& strHeader );
+  bool readFrameHeader();
+  bool readFrameData( CalypFrame* pcFrame );
+
+  FILE* m_pFile{ nullptr };
+  bool m_bStdio{ false };                  /**< m_pFile is the standard input >*/
+  std::uint64_t m_uiFileSize{ 0 };
+  std::uint64_t m_uiDataOffset{ 0 };       /**< Position of the first frame header >*/
+  std::uint64_t m_uiFrameHeaderSize{ 0 };  /**< Size of the first frame header >*/
+};
+
+#endif  // __STREAMHANDLERY4M_H__
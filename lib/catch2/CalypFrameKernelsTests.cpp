@@ -0,0 +1,441 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2021  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     CalypFrameKernelsTests.cpp
+ * \brief    Check the dispatched frame kernels against the generic code
+ */
+
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "CalypFrame.h"
+#include "CalypFrameKernels.h"
+#include "CalypThreadPool.h"
+#include "PixelFormats.h"
+
+namespace
+{
+const auto kAllLevels = calypCpuLevelsList();
+
+auto randomBuffer( std::size_t size ) -> std::vector<ClpByte>
+{
+  std::mt19937 gen( 1234 );
+  std::uniform_int_distribution<int> dist( 0, 255 );
+  std::vector<ClpByte> buffer( size );
+  for( auto& b : buffer )
+    b = static_cast<ClpByte>( dist( gen ) );
+  return buffer;
+}
+
+auto samePixels( const CalypFrame& a, const CalypFrame& b ) -> bool
+{
+  for( unsigned ch = 0; ch < a.getNumberChannels(); ch++ )
+    for( unsigned y = 0; y < a.getHeight( ch ); y++ )
+      for( unsigned x = 0; x < a.getWidth( ch ); x++ )
+        if( a( ch, x, y ) != b( ch, x, y ) )
+          return false;
+  return true;
+}
+
+}  // namespace
+
+TEST_CASE( "frameFromBuffer kernels are bit-exact with the generic path", "CalypFrameKernels" )
+{
+  const auto defaultLevel = calypCpuLevel();
+
+  for( const auto& [fmt, descriptor] : g_CalypPixFmtDescriptorsMap )
+  {
+    for( unsigned bits : { 8u, 10u, 12u, 16u } )
+    {
+      for( auto [width, height] : { std::pair{ 64u, 32u }, std::pair{ 70u, 34u }, std::pair{ 67u, 35u } } )
+      {
+        // Interleaved subsampled formats (YUYV) do not support odd widths
+        if( width % 2 && descriptor.numberPlanes == 1 && descriptor.log2ChromaWidth )
+          continue;
+        const auto buffer = randomBuffer( CalypFrame::getBytesPerFrame( width, height, fmt, bits ) );
+        for( int endianness : { CLP_LITTLE_ENDIAN, CLP_BIG_ENDIAN } )
+        {
+          CAPTURE( descriptor.name, bits, width, height, endianness );
+
+          REQUIRE( calypSetCpuLevel( ClpCpuLevel::Generic ) == ClpCpuLevel::Generic );
+          CalypFrame reference( width, height, fmt, bits );
+          reference.frameFromBuffer( buffer, endianness );
+
+          for( auto level : kAllLevels )
+          {
+            if( !calypFrameKernels( level ) )
+              continue;
+            CAPTURE( static_cast<int>( level ) );
+            REQUIRE( calypSetCpuLevel( level ) == level );
+            CalypFrame frame( width, height, fmt, bits );
+            frame.frameFromBuffer( buffer, endianness );
+            CHECK( samePixels( reference, frame ) );
+          }
+        }
+      }
+    }
+  }
+
+  calypSetCpuLevel( defaultLevel );
+}
+
+TEST_CASE( "frameFromBuffer zeroes samples above the maximum value", "CalypFrameKernels" )
+{
+  const auto defaultLevel = calypCpuLevel();
+  const std::vector<ClpByte> buffer( CalypFrame::getBytesPerFrame( 32, 8, ClpPixelFormats::Gray, 10 ), 0xFF );
+  for( auto level : kAllLevels )
+  {
+    if( !calypFrameKernels( level ) )
+      continue;
+    calypSetCpuLevel( level );
+    CalypFrame frame( 32, 8, ClpPixelFormats::Gray, 10 );
+    frame.frameFromBuffer( buffer, CLP_LITTLE_ENDIAN );
+    CHECK( frame( 0, 31, 7 ) == 0 );
+  }
+  calypSetCpuLevel( defaultLevel );
+}
+
+TEST_CASE( "frameToBuffer kernels are bit-exact with the generic path", "CalypFrameKernels" )
+{
+  const auto defaultLevel = calypCpuLevel();
+
+  for( const auto& [fmt, descriptor] : g_CalypPixFmtDescriptorsMap )
+  {
+    for( unsigned bits : { 8u, 10u, 16u } )
+    {
+      for( auto [width, height] : { std::pair{ 64u, 32u }, std::pair{ 70u, 34u }, std::pair{ 67u, 35u } } )
+      {
+        // Interleaved subsampled formats (YUYV) do not support odd widths
+        if( width % 2 && descriptor.numberPlanes == 1 && descriptor.log2ChromaWidth )
+          continue;
+        // Samples use all 16 bits to also check the narrowing of 8 bits formats
+        CalypFrame frame( width, height, fmt, bits );
+        const auto bytesPerFrame = frame.getBytesPerFrame();
+        frame.frameFromBuffer( randomBuffer( bytesPerFrame * 2 ), CLP_LITTLE_ENDIAN );
+        if( bits == 8 )
+        {
+          CalypFrame wide( width, height, fmt, 16 );
+          wide.frameFromBuffer( randomBuffer( wide.getBytesPerFrame() ), CLP_LITTLE_ENDIAN );
+          for( unsigned ch = 0; ch < frame.getNumberChannels(); ch++ )
+            for( unsigned y = 0; y < frame.getHeight( ch ); y++ )
+              for( unsigned x = 0; x < frame.getWidth( ch ); x++ )
+                frame.getPelBufferYUV()[ch][y][x] = wide( ch, x, y );
+        }
+
+        for( int endianness : { CLP_LITTLE_ENDIAN, CLP_BIG_ENDIAN } )
+        {
+          CAPTURE( descriptor.name, bits, width, height, endianness );
+
+          calypSetCpuLevel( ClpCpuLevel::Generic );
+          std::vector<ClpByte> reference( bytesPerFrame );
+          frame.frameToBuffer( reference, endianness );
+
+          for( auto level : kAllLevels )
+          {
+            if( !calypFrameKernels( level ) )
+              continue;
+            CAPTURE( static_cast<int>( level ) );
+            REQUIRE( calypSetCpuLevel( level ) == level );
+            std::vector<ClpByte> buffer( bytesPerFrame, 0 );
+            frame.frameToBuffer( buffer, endianness );
+            CHECK( buffer == reference );
+          }
+        }
+      }
+    }
+  }
+
+  calypSetCpuLevel( defaultLevel );
+}
+
+TEST_CASE( "fillRGBBuffer, histogram and mse kernels are bit-exact with the generic path", "CalypFrameKernels" )
+{
+  const auto defaultLevel = calypCpuLevel();
+
+  for( auto fmt : { ClpPixelFormats::YUV420p, ClpPixelFormats::YUV422p, ClpPixelFormats::YUV444p,
+                    ClpPixelFormats::YUYV422, ClpPixelFormats::Gray, ClpPixelFormats::RGB24p } )
+  {
+    for( unsigned bits : { 8u, 10u } )
+    {
+      for( auto [width, height] : { std::pair{ 64u, 32u }, std::pair{ 70u, 34u } } )
+      {
+        CAPTURE( static_cast<int>( fmt ), bits, width, height );
+        CalypFrame frame( width, height, fmt, bits );
+        CalypFrame other( width, height, fmt, bits );
+        const auto buffer = randomBuffer( frame.getBytesPerFrame() * 2 );
+        frame.frameFromBuffer( buffer, CLP_LITTLE_ENDIAN );
+        other.frameFromBuffer( { buffer.data() + frame.getBytesPerFrame(), frame.getBytesPerFrame() },
+                               CLP_LITTLE_ENDIAN );
+
+        calypSetCpuLevel( ClpCpuLevel::Generic );
+        CalypFrame reference( frame );
+        reference.fillRGBBuffer();
+        reference.calcHistogram();
+        std::vector<double> referenceMse;
+        for( unsigned ch = 0; ch < frame.getNumberChannels(); ch++ )
+          referenceMse.push_back( frame.getMSE( &other, ch ) );
+
+        for( auto level : kAllLevels )
+        {
+          if( !calypFrameKernels( level ) )
+            continue;
+          CAPTURE( static_cast<int>( level ) );
+          REQUIRE( calypSetCpuLevel( level ) == level );
+          CalypFrame test( frame );
+          test.fillRGBBuffer();
+          CHECK( std::ranges::equal( *test.getRGBBuffer(), *reference.getRGBBuffer() ) );
+          test.calcHistogram();
+          for( unsigned ch = 0; ch < frame.getNumberChannels(); ch++ )
+          {
+            for( int bin = 0; bin < test.getNumHistogramSegment(); bin++ )
+              REQUIRE( test.getHistogramValue( ch, bin ) == reference.getHistogramValue( ch, bin ) );
+            CHECK( frame.getMSE( &other, ch ) == referenceMse[ch] );
+          }
+        }
+      }
+    }
+  }
+
+  calypSetCpuLevel( defaultLevel );
+}
+
+TEST_CASE( "8 bits frames stored in bytes round trip through the buffer kernels", "CalypFrameKernels" )
+{
+  const auto defaultLevel = calypCpuLevel();
+
+  for( const auto& [fmt, descriptor] : g_CalypPixFmtDescriptorsMap )
+  {
+    for( auto [width, height] : { std::pair{ 64u, 32u }, std::pair{ 70u, 34u } } )
+    {
+      const auto buffer = randomBuffer( CalypFrame::getBytesPerFrame( width, height, fmt, 8 ) );
+      for( auto level : kAllLevels )
+      {
+        if( !calypFrameKernels( level ) )
+          continue;
+        CAPTURE( descriptor.name, width, height, static_cast<int>( level ) );
+        REQUIRE( calypSetCpuLevel( level ) == level );
+        CalypFrame frame( width, height, fmt, 8 );
+        frame.frameFromBuffer( buffer, CLP_LITTLE_ENDIAN );
+        REQUIRE( frame.getSampleBytes() == 1 );
+        std::vector<ClpByte> output( buffer.size(), 0 );
+        frame.frameToBuffer( output, CLP_LITTLE_ENDIAN );
+        CHECK( output == buffer );
+      }
+    }
+  }
+
+  calypSetCpuLevel( defaultLevel );
+}
+
+TEST_CASE( "yuvToArgb kernels are bit-exact with the generic path for all matrices", "CalypFrameKernels" )
+{
+  const auto defaultLevel = calypCpuLevel();
+
+  for( auto fmt : { ClpPixelFormats::YUV420p, ClpPixelFormats::YUV422p, ClpPixelFormats::YUV444p } )
+  {
+    for( unsigned bits : { 8u, 10u, 12u, 16u } )
+    {
+      CalypFrame frame( 70, 34, fmt, bits );
+      frame.frameFromBuffer( randomBuffer( frame.getBytesPerFrame() ), CLP_LITTLE_ENDIAN );
+      for( auto matrix : { CLP_MATRIX_BT601, CLP_MATRIX_BT709, CLP_MATRIX_BT2020 } )
+      {
+        for( auto range : { CLP_RANGE_FULL, CLP_RANGE_LIMITED } )
+        {
+          CAPTURE( static_cast<int>( fmt ), bits, static_cast<int>( matrix ), static_cast<int>( range ) );
+          calypSetCpuLevel( ClpCpuLevel::Generic );
+          CalypFrame reference( frame );
+          reference.setColorMatrix( matrix, range );
+          reference.fillRGBBuffer();
+
+          for( auto level : kAllLevels )
+          {
+            if( !calypFrameKernels( level ) )
+              continue;
+            CAPTURE( static_cast<int>( level ) );
+            REQUIRE( calypSetCpuLevel( level ) == level );
+            CalypFrame test( frame );
+            test.setColorMatrix( matrix, range );
+            test.fillRGBBuffer();
+            CHECK( std::ranges::equal( *test.getRGBBuffer(), *reference.getRGBBuffer() ) );
+          }
+        }
+      }
+    }
+  }
+
+  calypSetCpuLevel( defaultLevel );
+}
+
+TEST_CASE( "histograms match a plain count of the samples", "CalypFrameKernels" )
+{
+  const auto defaultLevel = calypCpuLevel();
+
+  for( auto fmt : { ClpPixelFormats::YUV420p, ClpPixelFormats::Gray, ClpPixelFormats::RGB24p } )
+  {
+    for( unsigned bits : { 8u, 12u, 16u } )
+    {
+      CalypFrame frame( 67, 45, fmt, bits );
+      frame.frameFromBuffer( randomBuffer( frame.getBytesPerFrame() ), CLP_LITTLE_ENDIAN );
+      const int segments = 1 << bits;
+      std::vector<unsigned int> expected( segments * ( frame.getNumberChannels() + 1 ), 0 );
+      for( unsigned ch = 0; ch < frame.getNumberChannels(); ch++ )
+        for( unsigned y = 0; y < frame.getHeight( ch ); y++ )
+          for( unsigned x = 0; x < frame.getWidth( ch ); x++ )
+            expected[ch * segments + frame( ch, x, y )]++;
+      if( fmt == ClpPixelFormats::RGB24p )
+      {
+        for( unsigned y = 0; y < frame.getHeight(); y++ )
+          for( unsigned x = 0; x < frame.getWidth(); x++ )
+            expected[3 * segments + frame.getPixel( x, y ).convertPixel( CLP_COLOR_YUV )[0]]++;
+      }
+
+      for( auto level : kAllLevels )
+      {
+        if( !calypFrameKernels( level ) )
+          continue;
+        CAPTURE( static_cast<int>( fmt ), bits, static_cast<int>( level ) );
+        REQUIRE( calypSetCpuLevel( level ) == level );
+        CalypFrame test( frame );
+        test.calcHistogram();
+        std::vector<unsigned int> histogram( expected.size(), 0 );
+        for( unsigned ch = 0; ch < frame.getNumberChannels(); ch++ )
+          for( int bin = 0; bin < segments; bin++ )
+            histogram[ch * segments + bin] = test.getHistogramValue( ch, bin );
+        if( fmt == ClpPixelFormats::RGB24p )
+          for( int bin = 0; bin < segments; bin++ )
+            histogram[3 * segments + bin] = test.getHistogramValue( CalypFrame::HIST_LUMA, bin );
+        CHECK( histogram == expected );
+      }
+    }
+  }
+
+  calypSetCpuLevel( defaultLevel );
+}
+
+TEST_CASE( "gaussian SSIM kernels match the generic path", "CalypFrameKernels" )
+{
+  const auto defaultLevel = calypCpuLevel();
+
+  for( unsigned bits : { 8u, 10u, 16u } )
+  {
+    CalypFrame a( 83, 37, ClpPixelFormats::YUV420p, bits );
+    CalypFrame b( 83, 37, ClpPixelFormats::YUV420p, bits );
+    a.frameFromBuffer( randomBuffer( a.getBytesPerFrame() ), CLP_LITTLE_ENDIAN );
+    b.frameFromBuffer( randomBuffer( b.getBytesPerFrame() ), CLP_LITTLE_ENDIAN );
+
+    REQUIRE( calypSetCpuLevel( ClpCpuLevel::Generic ) == ClpCpuLevel::Generic );
+    std::vector<double> expected;
+    for( unsigned ch = 0; ch < a.getNumberChannels(); ch++ )
+      expected.push_back( a.getSSIM( &b, ch, true ) );
+
+    for( auto level : kAllLevels )
+    {
+      if( !calypFrameKernels( level ) )
+        continue;
+      CAPTURE( bits, static_cast<int>( level ) );
+      REQUIRE( calypSetCpuLevel( level ) == level );
+      for( unsigned ch = 0; ch < a.getNumberChannels(); ch++ )
+        CHECK( std::abs( a.getSSIM( &b, ch, true ) - expected[ch] ) < 1e-9 );
+    }
+  }
+
+  calypSetCpuLevel( defaultLevel );
+}
+
+TEST_CASE( "weighted ssd kernels are bit-exact with the generic path", "CalypFrameKernels" )
+{
+  const auto defaultLevel = calypCpuLevel();
+
+  CalypFrame a( 83, 37, ClpPixelFormats::Gray, 16 );
+  CalypFrame b( 83, 37, ClpPixelFormats::Gray, 16 );
+  CalypFrame weights( 83, 37, ClpPixelFormats::Gray, 16 );
+  a.frameFromBuffer( randomBuffer( a.getBytesPerFrame() ), CLP_LITTLE_ENDIAN );
+  b.frameFromBuffer( randomBuffer( b.getBytesPerFrame() ), CLP_LITTLE_ENDIAN );
+  weights.frameFromBuffer( randomBuffer( weights.getBytesPerFrame() ), CLP_LITTLE_ENDIAN );
+
+  REQUIRE( calypSetCpuLevel( ClpCpuLevel::Generic ) == ClpCpuLevel::Generic );
+  const auto expected = a.getRowSSD( &b, 0, &weights );
+  for( auto level : kAllLevels )
+  {
+    if( !calypFrameKernels( level ) )
+      continue;
+    CAPTURE( static_cast<int>( level ) );
+    REQUIRE( calypSetCpuLevel( level ) == level );
+    CHECK( a.getRowSSD( &b, 0, &weights ) == expected );
+  }
+
+  calypSetCpuLevel( defaultLevel );
+}
+
+TEST_CASE( "sad kernels are bit-exact with the generic path", "CalypFrameKernels" )
+{
+  const auto defaultLevel = calypCpuLevel();
+
+  for( unsigned bits : { 8u, 16u } )
+  {
+    CAPTURE( bits );
+    CalypFrame a( 83, 37, ClpPixelFormats::Gray, bits );
+    CalypFrame b( 83, 37, ClpPixelFormats::Gray, bits );
+    a.frameFromBuffer( randomBuffer( a.getBytesPerFrame() ), CLP_LITTLE_ENDIAN );
+    b.frameFromBuffer( randomBuffer( b.getBytesPerFrame() ), CLP_LITTLE_ENDIAN );
+
+    REQUIRE( calypSetCpuLevel( ClpCpuLevel::Generic ) == ClpCpuLevel::Generic );
+    const auto expected = a.getQualityMap( CalypFrame::ABS_DIFF_MAP, &b, 0, 40 );
+    for( auto level : kAllLevels )
+    {
+      if( !calypFrameKernels( level ) )
+        continue;
+      CAPTURE( static_cast<int>( level ) );
+      REQUIRE( calypSetCpuLevel( level ) == level );
+      const auto map = a.getQualityMap( CalypFrame::ABS_DIFF_MAP, &b, 0, 40 );
+      // 3x1 blocks of 40x37, 40x37 and 3x37 samples
+      for( unsigned x = 0; x < 3; x++ )
+        CHECK( map[0][x] == expected[0][x] );
+    }
+  }
+
+  calypSetCpuLevel( defaultLevel );
+}
+
+TEST_CASE( "thread pool rethrows the exceptions of the bands", "CalypFrameKernels" )
+{
+  CalypThreadPool pool( 4 );
+  std::atomic<std::size_t> visited{ 0 };
+  const auto body = [&]( std::size_t begin, std::size_t end ) {
+    for( std::size_t i = begin; i < end; i++ )
+    {
+      if( i == 40 )
+        throw std::runtime_error( "band failed" );
+      visited++;
+    }
+  };
+  CHECK_THROWS_AS( pool.parallelFor( 64, 1, body ), std::runtime_error );
+
+  // The pool keeps working after a failed call
+  visited = 0;
+  pool.parallelFor( 64, 1, [&]( std::size_t begin, std::size_t end ) { visited += end - begin; } );
+  CHECK( visited == 64 );
+}
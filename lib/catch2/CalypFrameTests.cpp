@@ -24,6 +24,11 @@
 
 #include <catch2/catch_all.hpp>
 
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include <vector>
+
 #include "CalypFrame.h"
 
 TEST_CASE( "create a 256x128 frame with 8 bits in YUV420 format", "CalypFrame" )
@@ -58,3 +63,640 @@ TEST_CASE( "create a 256x128 frame with 16 bits in YUV420 format", "CalypFrame"
   CHECK( testFrame.getPelFormat() == ClpPixelFormats::YUV420p );
   CHECK( testFrame.getBitsPel() == 16 );
 }
+
+TEST_CASE( "rows of a 100x50 frame are aligned and padded", "CalypFrame" )
+{
+  CalypFrame testFrame( 100, 50, ClpPixelFormats::YUV420p, 10 );
+  const auto alignment = CalypFrame::getDataAlignment();
+
+  for( unsigned ch = 0; ch < testFrame.getNumberChannels(); ch++ )
+  {
+    CHECK( testFrame.getStride( ch ) >= testFrame.getWidth( ch ) );
+    CHECK( testFrame.getStride( ch ) * sizeof( ClpPel ) % alignment == 0 );
+
+    auto plane = testFrame.getPlane( ch );
+    CHECK( plane.width() == testFrame.getWidth( ch ) );
+    CHECK( plane.height() == testFrame.getHeight( ch ) );
+    CHECK( plane.stride() == testFrame.getStride( ch ) );
+    for( unsigned y = 0; y < plane.height(); y++ )
+    {
+      CHECK( reinterpret_cast<std::uintptr_t>( plane[y].data() ) % alignment == 0 );
+      CHECK( plane[y].data() == testFrame.getPelBufferYUV()[ch][y] );
+      plane[y][plane.width() - 1] = ClpPel( y );
+    }
+    CHECK( testFrame( ch, testFrame.getWidth( ch ) - 1, plane.height() - 1 ) == plane.height() - 1 );
+  }
+
+  CalypFrame copyFrame( testFrame );
+  const CalypFrame& constFrame = copyFrame;
+  CHECK( constFrame.getPlane( 2 )[3][testFrame.getWidth( 2 ) - 1] == 3 );
+}
+
+TEST_CASE( "8 bits frames are stored in bytes", "CalypFrame" )
+{
+  CalypFrame testFrame( 100, 50, ClpPixelFormats::YUV420p, 8 );
+  CHECK( testFrame.getSampleBytes() == 1 );
+  CHECK( CalypFrame( 100, 50, ClpPixelFormats::YUV420p, 10 ).getSampleBytes() == 2 );
+  CHECK_THROWS( CalypFrame( 100, 50, ClpPixelFormats::YUV420p, 10 ).getBytePlane( 0 ) );
+
+  for( unsigned ch = 0; ch < testFrame.getNumberChannels(); ch++ )
+  {
+    auto plane = testFrame.getBytePlane( ch );
+    CHECK( plane.stride() * sizeof( ClpByte ) % CalypFrame::getDataAlignment() == 0 );
+    for( unsigned y = 0; y < plane.height(); y++ )
+      for( unsigned x = 0; x < plane.width(); x++ )
+        plane[y][x] = ClpByte( x + y + ch );
+  }
+
+  // Read only accessors widen the samples without changing the storage
+  const CalypFrame& constFrame = testFrame;
+  CHECK( constFrame.getPlane( 1 )[7][9] == 1 + 7 + 9 );
+  CHECK( constFrame.getPelBufferYUV()[2][3][4] == 2 + 3 + 4 );
+  CHECK( testFrame.getSampleBytes() == 1 );
+  testFrame.setPixel( 0, 0, CalypPixel( CLP_COLOR_YUV, 200, 201, 202 ) );
+  CHECK( constFrame.getPelBufferYUV()[0][0][0] == 200 );
+
+  // Writable ClpPel accessors move the frame to ClpPel storage
+  testFrame.getPelBufferYUV()[0][1][1] = 255;
+  CHECK( testFrame.getSampleBytes() == 2 );
+  CHECK( testFrame( 0, 1, 1 ) == 255 );
+  CHECK( testFrame( 1, 9, 7 ) == 1 + 7 + 9 );
+
+  // Copies share the samples, overwriting them goes back to byte storage
+  CalypFrame copyFrame( testFrame );
+  CHECK( copyFrame.getSampleBytes() == 2 );
+  CHECK( copyFrame( 0, 1, 1 ) == 255 );
+  CHECK( copyFrame.getMSE( &testFrame, 0 ) == 0 );
+  copyFrame.reset();
+  CHECK( copyFrame.getSampleBytes() == 1 );
+  CHECK( testFrame( 0, 1, 1 ) == 255 );
+}
+
+TEST_CASE( "views reference a region of a frame", "CalypFrame" )
+{
+  for( unsigned bits : { 8u, 10u } )
+  {
+    CAPTURE( bits );
+    auto frame = std::make_shared<CalypFrame>( 64, 32, ClpPixelFormats::YUV420p, bits );
+    for( unsigned ch = 0; ch < frame->getNumberChannels(); ch++ )
+      for( unsigned y = 0; y < frame->getHeight( ch ); y++ )
+        for( unsigned x = 0; x < frame->getWidth( ch ); x++ )
+          frame->setPixel( x << ( ch > 0 ), y << ( ch > 0 ),
+                           CalypPixel( CLP_COLOR_YUV, ClpPel( x + y ), ClpPel( x ), ClpPel( y ) ) );
+
+    // Odd positions are aligned to the chroma grid as in the crop constructor
+    CalypFrame crop( *frame, 5, 3, 20, 10 );
+    auto view = CalypFrame::createView( frame, 5, 3, 20, 10 );
+    REQUIRE( view->isView() );
+    CHECK_FALSE( frame->isView() );
+    CHECK( view->getWidth() == crop.getWidth() );
+    CHECK( view->getHeight() == crop.getHeight() );
+    CHECK( view->getSampleBytes() == frame->getSampleBytes() );
+    for( unsigned ch = 0; ch < frame->getNumberChannels(); ch++ )
+      CHECK( view->getMSE( &crop, ch ) == 0 );
+
+    view->calcHistogram();
+    crop.calcHistogram();
+    const unsigned luma = CalypFrame::HIST_LUMA;
+    for( unsigned bin = 0; bin < 64; bin++ )
+      CHECK( view->getHistogramValue( luma, bin ) == crop.getHistogramValue( luma, bin ) );
+    CHECK( view->getMean( luma, 0, 255 ) == crop.getMean( luma, 0, 255 ) );
+
+    // Samples are shared with the parent, copies are regular frames
+    view->setPixel( 0, 0, CalypPixel( CLP_COLOR_YUV, 200, 201, 202 ) );
+    CHECK( ( *frame )( 0, 4, 2 ) == 200 );
+    CalypFrame copy( *view );
+    CHECK_FALSE( copy.isView() );
+    CHECK( copy( 0, 0, 0 ) == 200 );
+
+    // Regions are limited to the parent frame
+    CHECK( CalypFrame::createView( *frame, 60, 30, 100, 100 ).getWidth() == 4 );
+    CHECK_THROWS( CalypFrame::createView( *frame, 64, 0, 1, 1 ) );
+  }
+}
+
+TEST_CASE( "copies share the samples until they are written", "CalypFrame" )
+{
+  for( unsigned bits : { 8u, 10u } )
+  {
+    CAPTURE( bits );
+    CalypFrame frame( 64, 32, ClpPixelFormats::YUV420p, bits );
+    frame.reset();
+    frame.setPixel( 1, 1, CalypPixel( CLP_COLOR_YUV, 10, 11, 12 ) );
+
+    CalypFrame copy( frame );
+    CalypFrame assigned( 16, 16, ClpPixelFormats::Gray, 8 );
+    assigned = frame;
+    const CalypFrame& constCopy = copy;
+    const CalypFrame& constFrame = frame;
+    // 8 bits frames share the ClpByte planes, each frame widens its own ClpPel copy
+    const auto samples = []( const CalypFrame& f ) -> const void* {
+      if( f.getSampleBytes() == 1 )
+        return f.getBytePlane( 0 ).data();
+      return f.getPelBufferYUV()[0][0];
+    };
+    CHECK( samples( constCopy ) == samples( constFrame ) );
+    CHECK( assigned.getWidth() == 64 );
+    CHECK( assigned( 0, 1, 1 ) == 10 );
+
+    // Writing a copy leaves the other frames unchanged
+    copy.setPixel( 1, 1, CalypPixel( CLP_COLOR_YUV, 20, 21, 22 ) );
+    CHECK( copy( 0, 1, 1 ) == 20 );
+    CHECK( frame( 0, 1, 1 ) == 10 );
+    CHECK( assigned( 0, 1, 1 ) == 10 );
+    CHECK( samples( constCopy ) != samples( constFrame ) );
+
+    assigned.getPelBufferYUV()[1][0][0] = 30;
+    CHECK( assigned( 1, 0, 0 ) == 30 );
+    CHECK( frame( 1, 0, 0 ) == 11 );
+
+    // Overwriting the whole frame does not change the copies
+    std::vector<ClpByte> buffer( frame.getBytesPerFrame(), 0 );
+    CalypFrame snapshot( frame );
+    frame.frameFromBuffer( buffer, CLP_LITTLE_ENDIAN );
+    CHECK( frame( 0, 1, 1 ) == 0 );
+    CHECK( snapshot( 0, 1, 1 ) == 10 );
+    CHECK( snapshot.getMSE( &frame, 0 ) > 0 );
+
+    // Views keep the samples they reference when the parent gets new ones
+    auto view = CalypFrame::createView( snapshot, 0, 0, 8, 8 );
+    CalypFrame other( snapshot );
+    snapshot.setPixel( 1, 1, CalypPixel( CLP_COLOR_YUV, 40, 41, 42 ) );
+    CHECK( view( 0, 1, 1 ) == 10 );
+    CHECK( other( 0, 1, 1 ) == 10 );
+  }
+}
+
+TEST_CASE( "views write into their parent until a copy shares it", "CalypFrame" )
+{
+  for( unsigned bits : { 8u, 10u } )
+  {
+    CAPTURE( bits );
+    CalypFrame frame( 64, 32, ClpPixelFormats::YUV420p, bits );
+    std::vector<ClpByte> buffer( frame.getBytesPerFrame(), 0 );
+    frame.frameFromBuffer( buffer, CLP_LITTLE_ENDIAN );
+    const CalypFrame& constFrame = frame;
+    const unsigned luma = CalypFrame::HIST_LUMA;
+
+    // Writing the view refreshes what the parent derived from its samples
+    auto view = CalypFrame::createView( frame, 8, 4, 16, 8 );
+    frame.calcHistogram();
+    CHECK( frame.getHistogramValue( luma, 0 ) == 64 * 32 );
+    CHECK( constFrame.getPelBufferYUV()[0][4][8] == 0 );
+    view.setPixel( 0, 0, CalypPixel( CLP_COLOR_YUV, 50, 51, 52 ) );
+    REQUIRE( view.isView() );
+    CHECK( frame( 0, 8, 4 ) == 50 );
+    CHECK( constFrame.getPelBufferYUV()[0][4][8] == 50 );
+    frame.calcHistogram();
+    CHECK( frame.getHistogramValue( luma, 50 ) == 1 );
+
+    // Writing the parent refreshes the view
+    view.calcHistogram();
+    frame.setPixel( 9, 4, CalypPixel( CLP_COLOR_YUV, 30, 31, 32 ) );
+    view.calcHistogram();
+    CHECK( view.getHistogramValue( luma, 30 ) == 1 );
+    frame.setPixel( 9, 4, CalypPixel( CLP_COLOR_YUV, 0, 0, 0 ) );
+
+    // Once a copy shares the samples, the view writes its own copy of the region
+    CalypFrame sibling( frame );
+    view.setPixel( 1, 0, CalypPixel( CLP_COLOR_YUV, 60, 61, 62 ) );
+    CHECK_FALSE( view.isView() );
+    CHECK( view( 0, 0, 0 ) == 50 );
+    CHECK( view( 0, 1, 0 ) == 60 );
+    CHECK( sibling( 0, 9, 4 ) == 0 );
+    CHECK( frame( 0, 9, 4 ) == 0 );
+    CHECK( constFrame.getPelBufferYUV()[0][4][9] == 0 );
+
+    // Also after the parent moved to new samples, leaving the old ones to the copy
+    auto other = CalypFrame::createView( frame, 0, 0, 8, 8 );
+    frame.setPixel( 0, 0, CalypPixel( CLP_COLOR_YUV, 70, 71, 72 ) );
+    other.getPelBufferYUV()[0][1][1] = 80;
+    CHECK_FALSE( other.isView() );
+    CHECK( other( 0, 1, 1 ) == 80 );
+    CHECK( sibling( 0, 1, 1 ) == 0 );
+    CHECK( frame( 0, 1, 1 ) == 0 );
+  }
+}
+
+TEST_CASE( "frames are filled from the planes of a decoded picture", "CalypFrame" )
+{
+  constexpr unsigned int kWidth{ 37 };
+  constexpr unsigned int kHeight{ 21 };
+  constexpr std::ptrdiff_t kRowPadding{ 13 };
+
+  auto sampleValue = []( unsigned ch, unsigned x, unsigned y, unsigned bits ) {
+    return unsigned( ( ch * 977 + x * 31 + y * 57 ) % ( 1u << bits ) );
+  };
+  auto storeSample = []( ClpByte* dst, unsigned value, unsigned bytes ) {
+    dst[0] = ClpByte( value );
+    if( bytes > 1 )
+      dst[1] = ClpByte( value >> 8 );
+  };
+
+  SECTION( "Planar" )
+  {
+    for( unsigned bits : { 8u, 10u, 16u } )
+    {
+      CAPTURE( bits );
+      CalypFrame frame( kWidth, kHeight, ClpPixelFormats::YUV420p, bits );
+      const unsigned bytes = bits > 8 ? 2 : 1;
+      std::vector<std::vector<ClpByte>> planes( 3 );
+      std::vector<CalypPlaneSource> sources( 3 );
+      for( unsigned ch = 0; ch < 3; ch++ )
+      {
+        const std::ptrdiff_t stride = frame.getWidth( ch ) * bytes + kRowPadding;
+        planes[ch].assign( stride * frame.getHeight( ch ), 0xFF );
+        for( unsigned y = 0; y < frame.getHeight( ch ); y++ )
+          for( unsigned x = 0; x < frame.getWidth( ch ); x++ )
+            storeSample( &planes[ch][y * stride + x * bytes], sampleValue( ch, x, y, bits ), bytes );
+        sources[ch] = CalypPlaneSource{ planes[ch].data(), stride, 1 };
+      }
+
+      frame.frameFromPlanes( sources, CLP_LITTLE_ENDIAN );
+      for( unsigned ch = 0; ch < 3; ch++ )
+        for( unsigned y = 0; y < frame.getHeight( ch ); y++ )
+          for( unsigned x = 0; x < frame.getWidth( ch ); x++ )
+            REQUIRE( frame( ch, x, y ) == sampleValue( ch, x, y, bits ) );
+    }
+  }
+
+  SECTION( "Interleaved chroma in the most significant bits (P010)" )
+  {
+    constexpr unsigned kBits{ 10 };
+    constexpr unsigned kShift{ 6 };
+    CalypFrame frame( kWidth, kHeight, ClpPixelFormats::YUV420p, kBits );
+    const std::ptrdiff_t lumaStride = kWidth * 2 + kRowPadding;
+    const std::ptrdiff_t chromaStride = frame.getWidth( 1 ) * 4 + kRowPadding;
+    std::vector<ClpByte> luma( lumaStride * kHeight );
+    std::vector<ClpByte> chroma( chromaStride * frame.getHeight( 1 ) );
+    for( unsigned y = 0; y < kHeight; y++ )
+      for( unsigned x = 0; x < kWidth; x++ )
+        storeSample( &luma[y * lumaStride + x * 2], sampleValue( 0, x, y, kBits ) << kShift, 2 );
+    for( unsigned y = 0; y < frame.getHeight( 1 ); y++ )
+      for( unsigned x = 0; x < frame.getWidth( 1 ); x++ )
+        for( unsigned ch = 1; ch < 3; ch++ )
+          storeSample( &chroma[y * chromaStride + x * 4 + ( ch - 1 ) * 2], sampleValue( ch, x, y, kBits ) << kShift, 2 );
+
+    const std::vector<CalypPlaneSource> sources{
+        { luma.data(), lumaStride, 1 },
+        { chroma.data(), chromaStride, 2 },
+        { chroma.data() + 2, chromaStride, 2 },
+    };
+    frame.frameFromPlanes( sources, CLP_LITTLE_ENDIAN, kShift );
+    for( unsigned ch = 0; ch < 3; ch++ )
+      for( unsigned y = 0; y < frame.getHeight( ch ); y++ )
+        for( unsigned x = 0; x < frame.getWidth( ch ); x++ )
+          REQUIRE( frame( ch, x, y ) == sampleValue( ch, x, y, kBits ) );
+  }
+}
+
+TEST_CASE( "YUV frames are converted to RGB with the selected matrix", "CalypFrame" )
+{
+  const auto argb = []( unsigned bits, CalypColorMatrix matrix, CalypColorRange range, ClpPel y, ClpPel u, ClpPel v ) {
+    CalypFrame frame( 8, 2, ClpPixelFormats::YUV444p, bits );
+    frame.setColorMatrix( matrix, range );
+    for( unsigned x = 0; x < 8; x++ )
+      for( unsigned row = 0; row < 2; row++ )
+        frame.setPixel( x, row, CalypPixel( CLP_COLOR_YUV, y, u, v ) );
+    frame.fillRGBBuffer();
+    std::uint32_t pel;
+    std::memcpy( &pel, frame.getRGBBuffer()->data(), sizeof( pel ) );
+    return pel;
+  };
+
+  CHECK( CalypFrame( 8, 2, ClpPixelFormats::YUV444p, 8 ).getColorMatrix() == CLP_MATRIX_BT601 );
+  CHECK( CalypFrame( 8, 2, ClpPixelFormats::YUV444p, 8 ).getColorRange() == CLP_RANGE_FULL );
+
+  for( auto matrix : { CLP_MATRIX_BT601, CLP_MATRIX_BT709, CLP_MATRIX_BT2020 } )
+  {
+    CAPTURE( static_cast<int>( matrix ) );
+    CHECK( argb( 8, matrix, CLP_RANGE_FULL, 255, 128, 128 ) == 0xFFFFFFFF );
+    CHECK( argb( 8, matrix, CLP_RANGE_LIMITED, 235, 128, 128 ) == 0xFFFFFFFF );
+    CHECK( argb( 8, matrix, CLP_RANGE_LIMITED, 16, 128, 128 ) == 0xFF000000 );
+    CHECK( argb( 10, matrix, CLP_RANGE_LIMITED, 940, 512, 512 ) == 0xFFFFFFFF );
+    CHECK( argb( 16, matrix, CLP_RANGE_FULL, 65535, 32768, 32768 ) == 0xFFFFFFFF );
+  }
+
+  // BT.709 limited range red (R = 255, G = B = 0 up to rounding)
+  const std::uint32_t red = argb( 8, CLP_MATRIX_BT709, CLP_RANGE_LIMITED, 63, 102, 240 );
+  CHECK( ( red >> 16 & 0xFF ) >= 253 );
+  CHECK( ( red >> 8 & 0xFF ) <= 2 );
+  CHECK( ( red & 0xFF ) <= 2 );
+
+  // High bit depth samples are not truncated before the conversion
+  CHECK( argb( 10, CLP_MATRIX_BT601, CLP_RANGE_FULL, 3, 512, 512 ) == 0xFF010101 );
+  CHECK( argb( 10, CLP_MATRIX_BT601, CLP_RANGE_FULL, 1, 512, 512 ) == 0xFF000000 );
+}
+
+TEST_CASE( "histograms of views are counted from the tile index", "CalypFrame" )
+{
+  struct Format
+  {
+    ClpPixelFormats pelFormat;
+    unsigned bits;
+    int channel;
+  };
+  for( auto [pelFormat, bits, channel] : { Format{ ClpPixelFormats::YUV420p, 8, CalypFrame::HIST_CHROMA_U },
+                                           Format{ ClpPixelFormats::YUV420p, 10, CalypFrame::HIST_LUMA },
+                                           Format{ ClpPixelFormats::RGB24, 8, CalypFrame::HIST_LUMA } } )
+  {
+    CAPTURE( bits );
+    CalypFrame frame( 301, 203, pelFormat, bits );
+    std::vector<ClpByte> buffer( frame.getBytesPerFrame() );
+    for( std::size_t i = 0; i < buffer.size(); i++ )
+      buffer[i] = static_cast<ClpByte>( ( i * 7919 + i / 301 ) % 251 ) & ( bits > 8 && i % 2 ? 3 : 0xFF );
+    frame.frameFromBuffer( buffer, CLP_LITTLE_ENDIAN );
+    CalypFrame plain( 301, 203, pelFormat, bits );
+    plain.frameFromBuffer( buffer, CLP_LITTLE_ENDIAN );
+    frame.calcHistogramIndex();
+
+    const auto checkRegion = [&]( unsigned x, unsigned y, unsigned width, unsigned height ) {
+      CAPTURE( x, y, width, height );
+      auto view = CalypFrame::createView( frame, x, y, width, height );
+      auto crop = CalypFrame::createView( plain, x, y, width, height );
+      view.calcHistogram();
+      crop.calcHistogram();
+      const unsigned max = view.getNumHistogramSegment() - 1;
+      std::vector<double> viewBins, cropBins;
+      for( unsigned bin = 0; bin <= max; bin++ )
+      {
+        viewBins.push_back( view.getHistogramValue( channel, bin ) );
+        cropBins.push_back( crop.getHistogramValue( channel, bin ) );
+      }
+      CHECK( viewBins == cropBins );
+      CHECK( view.getNumPixelsRange( channel, 0, max ) == crop.getPixels( channel == CalypFrame::HIST_CHROMA_U ) );
+      CHECK( view.getMean( channel, 10, max / 2 ) == crop.getMean( channel, 10, max / 2 ) );
+      CHECK( view.getMedian( channel, 0, max ) == crop.getMedian( channel, 0, max ) );
+      if( view.getNumPixelsRange( channel, 0, max ) > 1 )
+        CHECK( view.getStdDev( channel, 0, max ) == crop.getStdDev( channel, 0, max ) );
+    };
+    checkRegion( 0, 0, 301, 203 );
+    checkRegion( 5, 7, 200, 150 );
+    checkRegion( 64, 32, 100, 100 );
+    checkRegion( 101, 65, 200, 138 );
+    checkRegion( 31, 33, 2, 2 );
+
+    // Writing the frame drops the index
+    frame.setPixel( 40, 40, CalypPixel( frame.getColorSpace(), 1, 2, 3 ) );
+    plain.setPixel( 40, 40, CalypPixel( frame.getColorSpace(), 1, 2, 3 ) );
+    checkRegion( 5, 7, 200, 150 );
+  }
+}
+
+TEST_CASE( "histogram statistics match a scan of the bins", "CalypFrame" )
+{
+  CalypFrame frame( 64, 64, ClpPixelFormats::Gray, 8 );
+  std::vector<ClpByte> buffer( frame.getBytesPerFrame() );
+  for( std::size_t i = 0; i < buffer.size(); i++ )
+    buffer[i] = static_cast<ClpByte>( ( i * i ) % 200 + 20 );
+  frame.frameFromBuffer( buffer, CLP_LITTLE_ENDIAN );
+  frame.calcHistogram();
+
+  const int channel = CalypFrame::HIST_LUMA;
+  for( auto [start, end] : { std::pair{ 0u, 255u }, std::pair{ 30u, 100u }, std::pair{ 0u, 10u } } )
+  {
+    CAPTURE( start, end );
+    double count = 0;
+    double sum = 0;
+    double squares = 0;
+    for( unsigned bin = start; bin <= end; bin++ )
+    {
+      count += frame.getHistogramValue( channel, bin );
+      sum += bin * frame.getHistogramValue( channel, bin );
+      squares += double( bin ) * bin * frame.getHistogramValue( channel, bin );
+    }
+    int median = 0;
+    double cumulative = 0;
+    for( unsigned bin = start; bin <= end; bin++ )
+    {
+      cumulative += frame.getHistogramValue( channel, bin );
+      if( cumulative * 2 > count )
+      {
+        median = static_cast<int>( bin );
+        break;
+      }
+    }
+    const double mean = count > 0 ? sum / count : 0.0;
+    CHECK( frame.getNumPixelsRange( channel, start, end ) == count );
+    CHECK( frame.getMean( channel, start, end ) == mean );
+    CHECK( frame.getMedian( channel, start, end ) == median );
+    if( count > 1 )
+    {
+      const double stdDev = std::sqrt( ( squares - count * mean * mean ) / ( count - 1 ) );
+      CHECK( std::abs( frame.getStdDev( channel, start, end ) - stdDev ) < 1e-9 );
+    }
+  }
+}
+
+TEST_CASE( "SSIM matches a direct computation of the windows", "CalypFrame" )
+{
+  // Mean SSIM of windows placed every step samples, weighted by window( i, j )
+  const auto reference = []( CalypFrame& a, CalypFrame& b, unsigned size, unsigned step, auto window ) {
+    const double peak = ( 1 << a.getBitsPel() ) - 1;
+    const double c1 = ( 0.01 * peak ) * ( 0.01 * peak );
+    const double c2 = ( 0.03 * peak ) * ( 0.03 * peak );
+    double ssim = 0.0;
+    unsigned count = 0;
+    for( unsigned y = 0; y + size <= a.getHeight(); y += step )
+      for( unsigned x = 0; x + size <= a.getWidth(); x += step )
+      {
+        double meanA = 0, meanB = 0, meanAA = 0, meanBB = 0, meanAB = 0;
+        for( unsigned j = 0; j < size; j++ )
+          for( unsigned i = 0; i < size; i++ )
+          {
+            const double w = window( i, j );
+            const double sampleA = a( 0, x + i, y + j );
+            const double sampleB = b( 0, x + i, y + j );
+            meanA += w * sampleA;
+            meanB += w * sampleB;
+            meanAA += w * sampleA * sampleA;
+            meanBB += w * sampleB * sampleB;
+            meanAB += w * sampleA * sampleB;
+          }
+        const double varA = meanAA - meanA * meanA;
+        const double varB = meanBB - meanB * meanB;
+        const double covAB = meanAB - meanA * meanB;
+        ssim += ( ( 2 * meanA * meanB + c1 ) * ( 2 * covAB + c2 ) ) /
+                ( ( meanA * meanA + meanB * meanB + c1 ) * ( varA + varB + c2 ) );
+        count++;
+      }
+    return ssim / count;
+  };
+  const auto gaussian = []( unsigned i, unsigned j ) {
+    double sum = 0;
+    for( int k = -5; k <= 5; k++ )
+      sum += std::exp( -k * k / 4.5 );
+    const double wi = std::exp( -( int( i ) - 5 ) * ( int( i ) - 5 ) / 4.5 ) / sum;
+    const double wj = std::exp( -( int( j ) - 5 ) * ( int( j ) - 5 ) / 4.5 ) / sum;
+    return wi * wj;
+  };
+
+  for( unsigned bits : { 8u, 10u } )
+  {
+    CAPTURE( bits );
+    CalypFrame a( 67, 45, ClpPixelFormats::Gray, bits );
+    CalypFrame b( 67, 45, ClpPixelFormats::Gray, bits );
+    for( unsigned y = 0; y < a.getHeight(); y++ )
+      for( unsigned x = 0; x < a.getWidth(); x++ )
+      {
+        const unsigned value = ( x * 37 + y * y * 11 ) % ( 1 << bits );
+        a.setPixel( x, y, CalypPixel( CLP_COLOR_GRAY, value ) );
+        b.setPixel( x, y, CalypPixel( CLP_COLOR_GRAY, ( value + ( x * y ) % 23 ) % ( 1 << bits ) ) );
+      }
+
+    const auto box = []( unsigned, unsigned ) { return 1.0 / 64; };
+    CHECK( std::abs( a.getSSIM( &b, 0 ) - reference( a, b, 8, 8, box ) ) < 1e-9 );
+    CHECK( std::abs( a.getSSIM( &b, 0, true ) - reference( a, b, 11, 1, gaussian ) ) < 1e-4 );
+    CHECK( a.getSSIM( &a, 0 ) == 1.0 );
+    CHECK( a.getSSIM( &a, 0, true ) == 1.0 );
+  }
+}
+
+TEST_CASE( "MSE, PSNR and WS-PSNR are computed from the SSD of each row", "CalypFrame" )
+{
+  for( unsigned bits : { 8u, 10u, 16u } )
+  {
+    CAPTURE( bits );
+    CalypFrame a( 53, 41, ClpPixelFormats::YUV420p, bits );
+    CalypFrame b( 53, 41, ClpPixelFormats::YUV420p, bits );
+    CalypFrame weights( 53, 41, ClpPixelFormats::Gray, bits );
+    const unsigned maxValue = ( 1 << bits ) - 1;
+    for( unsigned y = 0; y < a.getHeight(); y++ )
+      for( unsigned x = 0; x < a.getWidth(); x++ )
+      {
+        a.setPixel( x, y, CalypPixel( CLP_COLOR_YUV, ( x * 131 + y * 7 ) % maxValue, y % maxValue, x % maxValue ) );
+        b.setPixel( x, y, CalypPixel( CLP_COLOR_YUV, ( x * y * 29 ) % maxValue, x % 5, y % 3 ) );
+        weights.setPixel( x, y, CalypPixel( CLP_COLOR_GRAY, ( x + y ) % 4 ) );
+      }
+
+    for( unsigned ch = 0; ch < a.getNumberChannels(); ch++ )
+    {
+      CAPTURE( ch );
+      const unsigned width = a.getWidth( ch );
+      const unsigned height = a.getHeight( ch );
+      double ssd = 0;
+      double weightedSsd = 0;
+      double wsSsd = 0;
+      double wsWeights = 0;
+      for( unsigned y = 0; y < height; y++ )
+        for( unsigned x = 0; x < width; x++ )
+        {
+          const double diff = double( a( ch, x, y ) ) - double( b( ch, x, y ) );
+          const double weight = std::cos( ( y + 0.5 - height / 2.0 ) * 3.14159265358979323846 / height );
+          ssd += diff * diff;
+          weightedSsd += diff * diff * weights( 0, x, y );
+          wsSsd += diff * diff * weight;
+          wsWeights += weight;
+        }
+      const double mse = ssd / ( width * height );
+      CHECK( a.getMSE( &b, ch ) == mse );
+      CHECK( std::abs( a.getPSNR( &b, ch ) - 10 * std::log10( double( maxValue ) * maxValue / mse ) ) < 1e-9 );
+      CHECK( std::abs( a.getWSPNR( &b, ch ) - 10 * std::log10( double( maxValue ) * maxValue * wsWeights / wsSsd ) ) <
+             1e-9 );
+      if( ch == 0 )
+      {
+        double rowSum = 0;
+        for( auto rowSsd : a.getRowSSD( &b, ch, &weights ) )
+          rowSum += double( rowSsd );
+        CHECK( rowSum == weightedSsd );
+      }
+    }
+    CHECK( a.getWSPNR( &a, 0 ) == 100.0 );
+  }
+}
+
+TEST_CASE( "all quality metrics are computed in a single pass", "CalypFrame" )
+{
+  for( unsigned bits : { 8u, 10u } )
+  {
+    CAPTURE( bits );
+    CalypFrame a( 645, 363, ClpPixelFormats::YUV420p, bits );
+    CalypFrame b( 645, 363, ClpPixelFormats::YUV420p, bits );
+    const unsigned maxValue = ( 1 << bits ) - 1;
+    for( unsigned y = 0; y < a.getHeight(); y++ )
+      for( unsigned x = 0; x < a.getWidth(); x++ )
+      {
+        a.setPixel( x, y, CalypPixel( CLP_COLOR_YUV, ( x * 131 + y * 7 ) % maxValue, y % maxValue, x % maxValue ) );
+        b.setPixel( x, y, CalypPixel( CLP_COLOR_YUV, ( x * 131 + y * 9 ) % maxValue, ( x + y ) % 7, y % maxValue ) );
+      }
+
+    const auto results = a.computeQuality( &b,
+                                           { CalypFrame::PSNR_METRIC, CalypFrame::MSE_METRIC, CalypFrame::SSIM_METRIC,
+                                             CalypFrame::WSPSNR_METRIC, CalypFrame::NUMBER_METRICS },
+                                           { 0, 1, 2, 3 } );
+    for( int metric = 0; metric < CalypFrame::NUMBER_METRICS; metric++ )
+      CHECK( results.hasMetric[metric] );
+    CHECK( !results.hasComponent[3] );
+    for( unsigned ch = 0; ch < a.getNumberChannels(); ch++ )
+    {
+      CAPTURE( ch );
+      CHECK( results.hasComponent[ch] );
+      for( int metric = 0; metric < CalypFrame::NUMBER_METRICS; metric++ )
+      {
+        CAPTURE( metric );
+        CHECK( results( metric, ch ) == a.computeQuality( &b, { metric }, { ch } )( metric, ch ) );
+      }
+      CHECK( results( CalypFrame::MSE_METRIC, ch ) == a.getMSE( &b, ch ) );
+      CHECK( results( CalypFrame::SSIM_METRIC, ch ) == a.getSSIM( &b, ch ) );
+    }
+    CHECK( a.computeQuality( &a, { CalypFrame::PSNR_METRIC }, { 0 } )( CalypFrame::PSNR_METRIC, 0 ) == 100.0 );
+  }
+}
+
+TEST_CASE( "quality maps hold the metrics of each block", "CalypFrame" )
+{
+  for( unsigned bits : { 8u, 10u } )
+  {
+    CAPTURE( bits );
+    auto a = std::make_shared<CalypFrame>( 45, 37, ClpPixelFormats::YUV420p, bits );
+    auto b = std::make_shared<CalypFrame>( 45, 37, ClpPixelFormats::YUV420p, bits );
+    const unsigned maxValue = ( 1 << bits ) - 1;
+    for( unsigned y = 0; y < a->getHeight(); y++ )
+      for( unsigned x = 0; x < a->getWidth(); x++ )
+      {
+        a->setPixel( x, y, CalypPixel( CLP_COLOR_YUV, ( x * 131 + y * 7 ) % maxValue, y % maxValue, x % maxValue ) );
+        b->setPixel( x, y, CalypPixel( CLP_COLOR_YUV, ( x * 131 + y * 9 ) % maxValue, ( x + y ) % 7, y % maxValue ) );
+      }
+
+    const unsigned blockSize = 16;
+    for( unsigned ch = 0; ch < a->getNumberChannels(); ch++ )
+    {
+      CAPTURE( ch );
+      const unsigned width = a->getWidth( ch );
+      const unsigned height = a->getHeight( ch );
+      const auto mse = a->getQualityMap( CalypFrame::MSE_MAP, b.get(), ch, blockSize );
+      const auto absDiff = a->getQualityMap( CalypFrame::ABS_DIFF_MAP, b.get(), ch, blockSize );
+      const auto ssim = a->getQualityMap( CalypFrame::SSIM_MAP, b.get(), ch, blockSize );
+      const unsigned blocksX = ( width + blockSize - 1 ) / blockSize;
+      const unsigned blocksY = ( height + blockSize - 1 ) / blockSize;
+      for( unsigned by = 0; by < blocksY; by++ )
+        for( unsigned bx = 0; bx < blocksX; bx++ )
+        {
+          CAPTURE( bx, by );
+          const unsigned blockWidth = std::min( blockSize, width - bx * blockSize );
+          const unsigned blockHeight = std::min( blockSize, height - by * blockSize );
+          double ssd = 0;
+          double sad = 0;
+          for( unsigned y = by * blockSize; y < by * blockSize + blockHeight; y++ )
+            for( unsigned x = bx * blockSize; x < bx * blockSize + blockWidth; x++ )
+            {
+              const double diff = double( ( *a )( ch, x, y ) ) - double( ( *b )( ch, x, y ) );
+              ssd += diff * diff;
+              sad += std::abs( diff );
+            }
+          CHECK( mse[by][bx] == static_cast<float>( ssd / ( blockWidth * blockHeight ) ) );
+          CHECK( absDiff[by][bx] == static_cast<float>( sad / ( blockWidth * blockHeight ) ) );
+          if( ch == 0 )
+          {
+            // the SSIM of a block is the SSIM of a frame with its samples
+            auto viewA = CalypFrame::createView( a, bx * blockSize, by * blockSize, blockWidth, blockHeight );
+            auto viewB = CalypFrame::createView( b, bx * blockSize, by * blockSize, blockWidth, blockHeight );
+            CHECK( std::abs( ssim[by][bx] - viewA->getSSIM( viewB.get(), 0 ) ) < 1e-6 );
+          }
+        }
+    }
+    CHECK( a->getQualityMap( CalypFrame::SSIM_MAP, a.get(), 0, 8 )[0][0] == 1.0f );
+    CHECK_THROWS( a->getQualityMap( CalypFrame::NUMBER_MAPS, b.get(), 0, 8 ) );
+    CHECK_THROWS( a->getQualityMap( CalypFrame::MSE_MAP, b.get(), 0, 0 ) );
+  }
+}
@@ -22,13 +22,25 @@
  * \brief    CalypStream general tests
  */
 
+#include <algorithm>
 #include <catch2/catch_all.hpp>
+#include <chrono>
+#include <cmath>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <thread>
 #include <variant>
 
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <sys/stat.h>
+#endif
+
+#include "CalypDefs.h"
 #include "CalypFrame.h"
+#include "CalypFrameCache.h"
 #include "CalypStream.h"
+#include "config.h"
 
 constexpr int kFrameRate{ 30 };
 constexpr auto kStreamType = CalypStream::Type::Input;
@@ -277,4 +289,647 @@ TEST_CASE( "Can open .batatas file as RAW video", "CalypStream" )
     CHECK( frame->getPixel( 2, 0 ) == CalypPixel{ CLP_COLOR_YUV, 201, 129, 125 } );
     CHECK( frame->getPixel( 336, 278 ) == CalypPixel{ CLP_COLOR_YUV, 99, 111, 142 } );
   }
-}
\ No newline at end of file
+}
+
+namespace
+{
+constexpr unsigned int kNumberedWidth{ 64 };
+constexpr unsigned int kNumberedHeight{ 48 };
+constexpr auto kNumberedFormat{ ClpPixelFormats::YUV420p };
+constexpr unsigned int kNumberedBitsPel{ 10 };
+
+/**
+ * Frame where every sample is i + 1
+ */
+auto numberedFrame( unsigned int i ) -> CalypFrame
+{
+  CalypFrame frame( kNumberedWidth, kNumberedHeight, kNumberedFormat, kNumberedBitsPel );
+  std::vector<ClpByte> buffer( frame.getBytesPerFrame() );
+  for( std::size_t b = 0; b < buffer.size(); b += 2 )
+    buffer[b] = ClpByte( i + 1 );
+  frame.frameFromBuffer( buffer, CLP_LITTLE_ENDIAN );
+  return frame;
+}
+
+/**
+ * File of numFrames frames where frame i is numberedFrame( i ), raw unless the extension says otherwise
+ */
+void writeNumberedStream( const std::string& filename, unsigned int numFrames )
+{
+  CalypStream output;
+  REQUIRE( output.open( filename, kNumberedWidth, kNumberedHeight, kNumberedFormat, kNumberedBitsPel,
+                        CLP_LITTLE_ENDIAN, kFrameRate, CalypStream::Type::Output ) );
+  for( unsigned int i = 0; i < numFrames; i++ )
+    output.writeFrame( numberedFrame( i ) );
+}
+
+void openNumberedStream( CalypStream& input, const std::string& filename )
+{
+  REQUIRE( input.open( filename, kNumberedWidth, kNumberedHeight, kNumberedFormat, kNumberedBitsPel,
+                       CLP_LITTLE_ENDIAN, kFrameRate, kStreamType ) );
+}
+
+void expectNumberedFrame( const CalypFrame* frame, unsigned int i )
+{
+  REQUIRE( frame != nullptr );
+  const CalypPixel expected{ CLP_COLOR_YUV, ClpPel( i + 1 ), ClpPel( i + 1 ), ClpPel( i + 1 ) };
+  CHECK( frame->getPixel( 0, 0 ) == expected );
+  CHECK( frame->getPixel( kNumberedWidth - 1, kNumberedHeight - 1 ) == expected );
+}
+
+}  // namespace
+
+TEST_CASE( "Raw streams read the written frames after seeking", "CalypStream" )
+{
+  constexpr unsigned int kNumFrames{ 7 };
+  const auto kFilename = ( std::filesystem::temp_directory_path() / "CalypStreamTests_seek.yuv" ).string();
+  writeNumberedStream( kFilename, kNumFrames );
+
+  {
+    CalypStream input;
+    openNumberedStream( input, kFilename );
+    CHECK( input.getFrameNum() == kNumFrames );
+
+    for( unsigned int i = 0; i < 3; i++ )
+    {
+      expectNumberedFrame( input.getCurrFrame(), i );
+      input.setNextFrame();
+      input.readNextFrame();
+    }
+
+    // Backwards, as the reverse playback
+    for( unsigned int i = 5; i > 0; i-- )
+    {
+      REQUIRE( input.seekInput( i - 1 ) );
+      expectNumberedFrame( input.getCurrFrame(), i - 1 );
+    }
+
+    REQUIRE( input.seekInput( kNumFrames - 1 ) );
+    expectNumberedFrame( input.getCurrFrame(), kNumFrames - 1 );
+    CHECK( input.setNextFrame() );
+  }
+
+  std::filesystem::remove( kFilename );
+}
+
+TEST_CASE( "Raw streams seek beyond 4 GiB", "CalypStream" )
+{
+  const auto kFilename = ( std::filesystem::temp_directory_path() / "CalypStreamTests_sparse.yuv" ).string();
+  const std::uint64_t frameBytes = numberedFrame( 0 ).getBytesPerFrame();
+  const std::uint64_t numFrames = ( std::uint64_t( 1 ) << 32 ) / frameBytes + 3;
+  // Frame across the 4 GiB boundary and the last one, the others are never written
+  const std::uint64_t kAcross = ( std::uint64_t( 1 ) << 32 ) / frameBytes;
+  const std::uint64_t kLast = numFrames - 1;
+
+  // Sparse file, only the written frames take disk space
+  {
+    std::ofstream file( kFilename, std::ios::binary );
+  }
+  std::filesystem::resize_file( kFilename, numFrames * frameBytes );
+  {
+    std::fstream file( kFilename, std::ios::in | std::ios::out | std::ios::binary );
+    std::vector<ClpByte> buffer( frameBytes );
+    for( auto [index, id] : { std::pair{ kAcross, 1u }, std::pair{ kLast, 2u } } )
+    {
+      numberedFrame( id ).frameToBuffer( buffer, CLP_LITTLE_ENDIAN );
+      file.seekp( std::streamoff( index * frameBytes ) );
+      file.write( reinterpret_cast<const char*>( buffer.data() ), std::streamsize( buffer.size() ) );
+    }
+    REQUIRE( file.good() );
+  }
+
+  const CalypPixel kEmpty{ CLP_COLOR_YUV, 0, 0, 0 };
+  {
+    CalypStream input;
+    openNumberedStream( input, kFilename );
+    CHECK( input.getFrameNum() == numFrames );
+
+    REQUIRE( input.seekInput( kLast ) );
+    expectNumberedFrame( input.getCurrFrame(), 2 );
+    REQUIRE( input.seekInput( kAcross ) );
+    expectNumberedFrame( input.getCurrFrame(), 1 );
+    REQUIRE( input.seekInput( 0 ) );
+    CHECK( input.getCurrFrame()->getPixel( 0, 0 ) == kEmpty );
+    REQUIRE( input.seekInput( kAcross ) );
+    expectNumberedFrame( input.getCurrFrame(), 1 );
+    input.setNextFrame();
+    CHECK( input.getCurrFrame()->getPixel( 0, 0 ) == kEmpty );
+  }
+
+  std::filesystem::remove( kFilename );
+}
+
+TEST_CASE( "Streams read ahead in their own thread", "CalypStream" )
+{
+  constexpr unsigned int kNumFrames{ 24 };
+  const auto kFilename = ( std::filesystem::temp_directory_path() / "CalypStreamTests_readahead.yuv" ).string();
+  writeNumberedStream( kFilename, kNumFrames );
+
+  SECTION( "Enabled before opening" )
+  {
+    CalypStream input;
+    input.setReadAhead( 3 );
+    openNumberedStream( input, kFilename );
+    CHECK( input.getReadAhead() == 3 );
+    for( unsigned int i = 0; i < kNumFrames; i++ )
+    {
+      expectNumberedFrame( input.getCurrFrame(), i );
+      CHECK( input.setNextFrame() == ( i + 1 == kNumFrames ) );
+      input.readNextFrame();
+    }
+  }
+
+  SECTION( "Seeking drops the frames read ahead" )
+  {
+    CalypStream input;
+    openNumberedStream( input, kFilename );
+    input.setReadAhead( 8, true );
+    for( unsigned int i = 0; i < 5; i++ )
+      input.setNextFrame();
+    expectNumberedFrame( input.getCurrFrame(), 5 );
+
+    REQUIRE( input.seekInput( 17 ) );
+    expectNumberedFrame( input.getCurrFrame(), 17 );
+    input.setNextFrame();
+    expectNumberedFrame( input.getCurrFrame(), 18 );
+
+    REQUIRE( input.seekInput( 2 ) );
+    for( unsigned int i = 2; i < 10; i++ )
+    {
+      expectNumberedFrame( input.getCurrFrame(), i );
+      CHECK( input.getCurrFrame()->getRGBBuffer().has_value() );
+      input.setNextFrame();
+    }
+  }
+
+  SECTION( "Disabled while reading" )
+  {
+    CalypStream input;
+    openNumberedStream( input, kFilename );
+    input.setReadAhead( 4 );
+    input.setNextFrame();
+    input.setReadAhead( 0 );
+    for( unsigned int i = 1; i < kNumFrames; i++ )
+    {
+      expectNumberedFrame( input.getCurrFrame(), i );
+      input.setNextFrame();
+      input.readNextFrame();
+    }
+  }
+
+  std::filesystem::remove( kFilename );
+}
+
+TEST_CASE( "Streams write behind in their own thread", "CalypStream" )
+{
+  constexpr unsigned int kNumFrames{ 16 };
+  const auto kFilename = ( std::filesystem::temp_directory_path() / "CalypStreamTests_writebehind.yuv" ).string();
+
+  SECTION( "Frames changed after being queued" )
+  {
+    {
+      CalypStream output;
+      output.setWriteBehind( 3 );
+      REQUIRE( output.open( kFilename, kNumberedWidth, kNumberedHeight, kNumberedFormat, kNumberedBitsPel,
+                            CLP_LITTLE_ENDIAN, kFrameRate, CalypStream::Type::Output ) );
+      CHECK( output.getWriteBehind() == 3 );
+      // As the modules, that process every frame into the same one
+      CalypFrame frame( kNumberedWidth, kNumberedHeight, kNumberedFormat, kNumberedBitsPel );
+      for( unsigned int i = 0; i < kNumFrames; i++ )
+      {
+        frame.copyFrom( numberedFrame( i ) );
+        output.writeFrame( frame );
+      }
+      output.flush();
+    }
+
+    CalypStream input;
+    openNumberedStream( input, kFilename );
+    CHECK( input.getFrameNum() == kNumFrames );
+    for( unsigned int i = 0; i < kNumFrames; i++ )
+    {
+      expectNumberedFrame( input.getCurrFrame(), i );
+      input.setNextFrame();
+      input.readNextFrame();
+    }
+  }
+
+  SECTION( "Closing writes the queued frames" )
+  {
+    {
+      CalypStream output;
+      REQUIRE( output.open( kFilename, kNumberedWidth, kNumberedHeight, kNumberedFormat, kNumberedBitsPel,
+                            CLP_LITTLE_ENDIAN, kFrameRate, CalypStream::Type::Output ) );
+      output.setWriteBehind( kNumFrames );
+      for( unsigned int i = 0; i < kNumFrames; i++ )
+        output.writeFrame( numberedFrame( i ) );
+    }
+
+    CalypStream input;
+    openNumberedStream( input, kFilename );
+    CHECK( input.getFrameNum() == kNumFrames );
+    REQUIRE( input.seekInput( kNumFrames - 1 ) );
+    expectNumberedFrame( input.getCurrFrame(), kNumFrames - 1 );
+  }
+
+#if defined( __linux__ )
+  SECTION( "Failures are thrown by flush" )
+  {
+    // Writing to /dev/full fails with no space left
+    std::filesystem::remove( kFilename );
+    std::filesystem::create_symlink( "/dev/full", kFilename );
+    {
+      CalypStream output;
+      output.setWriteBehind( 2 );
+      REQUIRE( output.open( kFilename, kNumberedWidth, kNumberedHeight, kNumberedFormat, kNumberedBitsPel,
+                            CLP_LITTLE_ENDIAN, kFrameRate, CalypStream::Type::Output ) );
+      output.writeFrame( numberedFrame( 0 ) );
+      CHECK_THROWS_AS( output.flush(), CalypFailure );
+      CHECK_THROWS_AS( output.writeFrame( numberedFrame( 1 ) ), CalypFailure );
+    }
+  }
+
+  SECTION( "Failures are thrown by close" )
+  {
+    std::filesystem::remove( kFilename );
+    std::filesystem::create_symlink( "/dev/full", kFilename );
+    CalypStream output;
+    output.setWriteBehind( 2 );
+    REQUIRE( output.open( kFilename, kNumberedWidth, kNumberedHeight, kNumberedFormat, kNumberedBitsPel,
+                          CLP_LITTLE_ENDIAN, kFrameRate, CalypStream::Type::Output ) );
+    output.writeFrame( numberedFrame( 0 ) );
+    CHECK_THROWS_AS( output.close(), CalypFailure );
+    // Closed anyway
+    CHECK_NOTHROW( output.close() );
+  }
+#endif
+
+  std::filesystem::remove( kFilename );
+}
+
+TEST_CASE( "Streams keep the frames read in the frame cache", "CalypStream" )
+{
+  constexpr unsigned int kNumFrames{ 24 };
+  constexpr unsigned int kRegionFrames{ 10 };
+  const auto kFilename = ( std::filesystem::temp_directory_path() / "CalypStreamTests_cache.yuv" ).string();
+  writeNumberedStream( kFilename, kNumFrames );
+  const std::size_t frameBytes =
+      CalypFrame::getBytesPerFrame( kNumberedWidth, kNumberedHeight, kNumberedFormat, kNumberedBitsPel );
+  CalypStream::setFrameCacheBudget( ( kRegionFrames + 2 ) * frameBytes );
+
+  SECTION( "Seeking back and forth does not read the file again" )
+  {
+    // The stream gets copies sharing the samples of the cached frames
+    const auto samples = []( const CalypFrame* frame ) { return frame->getPlane( 0 ).data(); };
+    CalypStream input;
+    openNumberedStream( input, kFilename );
+    std::vector<const ClpPel*> firstPass;
+    for( unsigned int i = 0; i < kRegionFrames; i++ )
+    {
+      firstPass.push_back( samples( input.getCurrFrame() ) );
+      input.setNextFrame();
+      input.readNextFrame();
+    }
+
+    for( int pass = 0; pass < 3; pass++ )
+    {
+      for( unsigned int i = kRegionFrames; i > 0; i-- )
+      {
+        input.seekInput( i - 1 );
+        CHECK( samples( input.getCurrFrame() ) == firstPass[i - 1] );
+        expectNumberedFrame( input.getCurrFrame(), i - 1 );
+      }
+      for( unsigned int i = 1; i < kRegionFrames; i++ )
+      {
+        input.seekInputRelative( true );
+        CHECK( samples( input.getCurrFrame() ) == firstPass[i] );
+      }
+    }
+    CHECK( CalypStream::getFrameCacheUsage() <= CalypStream::getFrameCacheBudget() );
+  }
+
+  SECTION( "Writing a frame read does not change the cached one" )
+  {
+    CalypStream input;
+    openNumberedStream( input, kFilename );
+    input.getCurrFrame()->reset();
+    input.seekInput( 1 );
+    input.seekInput( 0 );
+    expectNumberedFrame( input.getCurrFrame(), 0 );
+  }
+
+  SECTION( "Frames read ahead are cached" )
+  {
+    CalypStream input;
+    input.setReadAhead( 4, true );
+    openNumberedStream( input, kFilename );
+    for( unsigned int i = 0; i < kNumFrames; i++ )
+    {
+      expectNumberedFrame( input.getCurrFrame(), i );
+      input.setNextFrame();
+    }
+    // Only the last frames fit in the budget
+    for( unsigned int i = kNumFrames; i > kNumFrames - kRegionFrames; i-- )
+    {
+      input.seekInput( i - 1 );
+      expectNumberedFrame( input.getCurrFrame(), i - 1 );
+      CHECK( input.getCurrFrame()->getRGBBuffer().has_value() );
+    }
+    CHECK( CalypStream::getFrameCacheUsage() <= CalypStream::getFrameCacheBudget() );
+  }
+
+  SECTION( "Closing a stream evicts its frames" )
+  {
+    {
+      CalypStream input;
+      openNumberedStream( input, kFilename );
+      CHECK( CalypStream::getFrameCacheUsage() > 0 );
+    }
+    CHECK( CalypStream::getFrameCacheUsage() == 0 );
+  }
+
+  CalypStream::setFrameCacheBudget( 0 );
+  CHECK( CalypStream::getFrameCacheUsage() == 0 );
+  std::filesystem::remove( kFilename );
+}
+
+TEST_CASE( "Frame cache evicts the frames far from the playhead first", "CalypStream" )
+{
+  constexpr std::size_t kFrameBytes{ 100 };
+  constexpr std::uint64_t kPlayhead{ 100 };
+  CalypFrameCache cache( 4 * kFrameBytes );
+  const auto stream = cache.newStream();
+  auto frame = std::make_shared<CalypFrame>( 8, 8, ClpPixelFormats::Gray, 8 );
+
+  cache.setPlayhead( stream, kPlayhead );
+  cache.insert( stream, kPlayhead - 1, frame, kFrameBytes );
+  cache.insert( stream, kPlayhead, frame, kFrameBytes );
+  cache.insert( stream, 0, frame, kFrameBytes );
+  cache.insert( stream, 1, frame, kFrameBytes );
+  CHECK( cache.usage() == 4 * kFrameBytes );
+
+  // The least recently used are the ones around the playhead
+  cache.insert( stream, 2, frame, kFrameBytes );
+  CHECK( cache.find( stream, kPlayhead - 1 ) != nullptr );
+  CHECK( cache.find( stream, kPlayhead ) != nullptr );
+  CHECK( cache.find( stream, 0 ) == nullptr );
+  CHECK( cache.find( stream, 1 ) != nullptr );
+  CHECK( cache.find( stream, 2 ) != nullptr );
+
+  cache.setPlayhead( stream, 2 );
+  cache.insert( stream, 3, frame, kFrameBytes );
+  CHECK( cache.find( stream, kPlayhead - 1 ) == nullptr );
+  CHECK( cache.usage() == 4 * kFrameBytes );
+
+  cache.setBudget( kFrameBytes );
+  CHECK( cache.usage() == kFrameBytes );
+  cache.dropStream( stream );
+  CHECK( cache.usage() == 0 );
+}
+
+TEST_CASE( "YUV4MPEG2 streams are described by their header", "CalypStream" )
+{
+  constexpr unsigned int kNumFrames{ 6 };
+  const auto kFilename = ( std::filesystem::temp_directory_path() / "CalypStreamTests_header.y4m" ).string();
+  writeNumberedStream( kFilename, kNumFrames );
+
+  SECTION( "Read at any position" )
+  {
+    // The size and format of the file win over the ones given
+    CalypStream input;
+    REQUIRE( input.open( kFilename, 16, 16, ClpPixelFormats::Gray, 8, CLP_BIG_ENDIAN, 1, kStreamType ) );
+    CHECK( input.getFormatName() == "Y4M" );
+    CHECK( input.getWidth() == kNumberedWidth );
+    CHECK( input.getHeight() == kNumberedHeight );
+    CHECK( input.getBitsPerPixel() == kNumberedBitsPel );
+    CHECK( input.getFrameRate() == double( kFrameRate ) );
+    CHECK( input.getCurrFrame()->getPelFormat() == kNumberedFormat );
+    CHECK( input.getFrameNum() == kNumFrames );
+    CHECK( !input.isStreaming() );
+
+    REQUIRE( input.seekInput( 4 ) );
+    expectNumberedFrame( input.getCurrFrame(), 4 );
+    REQUIRE( input.seekInput( 1 ) );
+    expectNumberedFrame( input.getCurrFrame(), 1 );
+    input.setNextFrame();
+    expectNumberedFrame( input.getCurrFrame(), 2 );
+  }
+
+  SECTION( "Found without the extension" )
+  {
+    const auto kRenamed = ( std::filesystem::temp_directory_path() / "CalypStreamTests_header.yuv" ).string();
+    std::filesystem::copy_file( kFilename, kRenamed, std::filesystem::copy_options::overwrite_existing );
+    {
+      CalypStream input;
+      openNumberedStream( input, kRenamed );
+      CHECK( input.getFormatName() == "Y4M" );
+      CHECK( input.getFrameNum() == kNumFrames );
+      expectNumberedFrame( input.getCurrFrame(), 0 );
+    }
+    std::filesystem::remove( kRenamed );
+  }
+
+  SECTION( "Color range from the extension tag" )
+  {
+    {
+      CalypStream input;
+      openNumberedStream( input, kFilename );
+      CHECK( input.getCurrFrame()->getColorRange() == CLP_RANGE_FULL );
+    }
+    const auto kLimited = ( std::filesystem::temp_directory_path() / "CalypStreamTests_limited.y4m" ).string();
+    {
+      std::ofstream file( kLimited, std::ios::binary );
+      file << "YUV4MPEG2 W8 H4 F25:1 Ip A0:0 C420jpeg XCOLORRANGE=LIMITED\nFRAME\n";
+      file << std::string( 8 * 4 * 3 / 2, char( 16 ) );
+    }
+    {
+      CalypStream input;
+      REQUIRE( input.open( kLimited, 0, 0, ClpPixelFormats::Invalid, 8, CLP_BIG_ENDIAN, 1, kStreamType ) );
+      CHECK( input.getCurrFrame()->getColorRange() == CLP_RANGE_LIMITED );
+      CHECK( input.getCurrFrame()->getColorMatrix() == CLP_MATRIX_BT601 );
+    }
+    std::filesystem::remove( kLimited );
+  }
+
+  SECTION( "Fractional frame rates" )
+  {
+    constexpr double kNtscFrameRate{ 30000.0 / 1001.0 };
+    const auto kNtsc = ( std::filesystem::temp_directory_path() / "CalypStreamTests_ntsc.y4m" ).string();
+    {
+      CalypStream output;
+      REQUIRE( output.open( kNtsc, kNumberedWidth, kNumberedHeight, kNumberedFormat, kNumberedBitsPel,
+                            CLP_LITTLE_ENDIAN, kNtscFrameRate, CalypStream::Type::Output ) );
+      output.writeFrame( numberedFrame( 0 ) );
+    }
+    {
+      CalypStream input;
+      openNumberedStream( input, kNtsc );
+      CHECK( std::abs( input.getFrameRate() - kNtscFrameRate ) < 1e-9 );
+    }
+    std::filesystem::remove( kNtsc );
+  }
+
+  std::filesystem::remove( kFilename );
+}
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+TEST_CASE( "YUV4MPEG2 pipes are read as streams", "CalypStream" )
+{
+  constexpr unsigned int kNumFrames{ 20 };
+  const std::size_t readAhead = GENERATE( 0, 4 );
+  const auto kFilename = ( std::filesystem::temp_directory_path() / "CalypStreamTests_pipe.y4m" ).string();
+  std::filesystem::remove( kFilename );
+  REQUIRE( mkfifo( kFilename.c_str(), 0600 ) == 0 );
+
+  // Opening the pipe waits for the other end
+  bool written{ false };
+  std::thread writer( [&] {
+    try
+    {
+      CalypStream output;
+      output.open( kFilename, kNumberedWidth, kNumberedHeight, kNumberedFormat, kNumberedBitsPel, CLP_LITTLE_ENDIAN,
+                   kFrameRate, CalypStream::Type::Output );
+      for( unsigned int i = 0; i < kNumFrames; i++ )
+        output.writeFrame( numberedFrame( i ) );
+      written = true;
+    }
+    catch( ... )
+    {
+    }
+  } );
+
+  unsigned int frames{ 0 };
+  {
+    CalypStream input;
+    input.setReadAhead( readAhead );
+    openNumberedStream( input, kFilename );
+    CHECK( input.isStreaming() );
+    while( true )
+    {
+      expectNumberedFrame( input.getCurrFrame(), frames );
+      frames++;
+      CHECK( input.getFrameNum() >= frames );
+      if( input.setNextFrame() )
+        break;
+      input.readNextFrame();
+    }
+    CHECK( input.getFrameNum() == kNumFrames );
+  }
+  writer.join();
+  std::filesystem::remove( kFilename );
+
+  CHECK( written );
+  CHECK( frames == kNumFrames );
+}
+#endif
+
+TEST_CASE( "Truncated YUV4MPEG2 pipes give the frames read before the failure", "CalypStream" )
+{
+  constexpr unsigned int kNumFrames{ 3 };
+  const std::size_t readAhead = GENERATE( 0, 1 );
+  const auto kWrittenFilename = ( std::filesystem::temp_directory_path() / "CalypStreamTests_truncated.y4m" ).string();
+  const auto kFilename = ( std::filesystem::temp_directory_path() / "CalypStreamTests_truncated_pipe.y4m" ).string();
+  // Half of one more frame after the complete ones
+  writeNumberedStream( kWrittenFilename, kNumFrames + 1 );
+  std::vector<char> bytes;
+  {
+    std::ifstream file( kWrittenFilename, std::ios::binary );
+    bytes.assign( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+  }
+  const std::size_t frameBytes =
+      CalypFrame::getBytesPerFrame( kNumberedWidth, kNumberedHeight, kNumberedFormat, kNumberedBitsPel );
+  bytes.resize( bytes.size() - frameBytes / 2 );
+  std::filesystem::remove( kWrittenFilename );
+  std::filesystem::remove( kFilename );
+  REQUIRE( mkfifo( kFilename.c_str(), 0600 ) == 0 );
+
+  std::thread writer( [&] {
+    std::ofstream pipe( kFilename, std::ios::binary );
+    pipe.write( bytes.data(), static_cast<std::streamsize>( bytes.size() ) );
+  } );
+
+  {
+    CalypStream input;
+    input.setReadAhead( readAhead );
+    openNumberedStream( input, kFilename );
+    for( unsigned int i = 0; i < kNumFrames; i++ )
+    {
+      expectNumberedFrame( input.getCurrFrame(), i );
+      if( i + 1 < kNumFrames )
+        CHECK_NOTHROW( input.setNextFrame() );
+      if( i + 2 < kNumFrames )
+        CHECK_NOTHROW( input.readNextFrame() );
+    }
+    // The following frame is the truncated one
+    if( readAhead > 0 )
+      CHECK_THROWS_AS( input.setNextFrame(), CalypFailure );
+    else
+      CHECK_THROWS_AS( input.readNextFrame(), CalypFailure );
+  }
+  writer.join();
+  std::filesystem::remove( kFilename );
+}
+
+#ifdef USE_FFMPEG
+namespace
+{
+auto sameSamples( const CalypFrame& a, const CalypFrame& b ) -> bool
+{
+  if( a.getNumberChannels() != b.getNumberChannels() )
+    return false;
+  for( unsigned int ch = 0; ch < a.getNumberChannels(); ch++ )
+  {
+    const auto planeA = a.getPlane( ch );
+    const auto planeB = b.getPlane( ch );
+    if( planeA.width() != planeB.width() || planeA.height() != planeB.height() )
+      return false;
+    for( std::size_t y = 0; y < planeA.height(); y++ )
+    {
+      if( !std::ranges::equal( planeA[y], planeB[y] ) )
+        return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+TEST_CASE( "Lossless compressed streams read the written frames", "CalypStream" )
+{
+  constexpr unsigned int kNumFrames{ 30 };
+  const auto extension = GENERATE( as<std::string>{}, "mkv", "nut" );
+  const auto kFilename =
+      ( std::filesystem::temp_directory_path() / ( "CalypStreamTests_lossless." + extension ) ).string();
+  writeNumberedStream( kFilename, kNumFrames );
+
+  {
+    CalypStream input;
+    openNumberedStream( input, kFilename );
+
+    // The frames are counted in the background
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds( 10 );
+    while( input.getFrameNum() != kNumFrames && std::chrono::steady_clock::now() < deadline )
+      std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    REQUIRE( input.getFrameNum() == kNumFrames );
+
+    std::vector<CalypFrame> sequential;
+    for( unsigned int i = 0; i < kNumFrames; i++ )
+    {
+      sequential.push_back( *input.getCurrFrame() );
+      CHECK( sameSamples( sequential.back(), numberedFrame( i ) ) );
+      if( i + 1 < kNumFrames )
+      {
+        input.setNextFrame();
+        input.readNextFrame();
+      }
+    }
+
+    // Seeking back and forth gets the frames decoded in sequence
+    for( unsigned int frameNum : { 0u, kNumFrames - 1, kNumFrames / 2, 3u, kNumFrames - 2, 1u, kNumFrames / 2 + 1 } )
+    {
+      REQUIRE( input.seekInput( frameNum ) );
+      CHECK( sameSamples( *input.getCurrFrame(), sequential[frameNum] ) );
+    }
+  }
+  std::filesystem::remove( kFilename );
+}
+#endif
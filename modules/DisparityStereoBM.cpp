@@ -84,8 +84,8 @@ bool DisparityStereoBM::create( std::vector<CalypFrame*> apcFrameList )
 }
 CalypFrame* DisparityStereoBM::process( std::vector<CalypFrame*> apcFrameList )
 {
-  CalypFrame* InputLeft = apcFrameList[0];
-  CalypFrame* InputRight = apcFrameList[1];
+  const CalypFrame* InputLeft = apcFrameList[0];
+  const CalypFrame* InputRight = apcFrameList[1];
 
   cv::Mat leftImage, rightImage;
   if( !InputLeft->toMat( leftImage, true ) || !InputRight->toMat( rightImage, true ) )
@@ -91,8 +91,8 @@ bool DisparityStereoSGBM::create( std::vector<CalypFrame*> apcFrameList )
 
 CalypFrame* DisparityStereoSGBM::process( std::vector<CalypFrame*> apcFrameList )
 {
-  CalypFrame* InputLeft = apcFrameList[0];
-  CalypFrame* InputRight = apcFrameList[1];
+  const CalypFrame* InputLeft = apcFrameList[0];
+  const CalypFrame* InputRight = apcFrameList[1];
   cv::Mat leftImage, rightImage;
   if( !InputLeft->toMat( leftImage, true ) || !InputRight->toMat( rightImage, true ) )
   {
@@ -57,17 +57,23 @@ bool EightBitsSampling::create( std::vector<CalypFrame*> apcFrameList )
 
 CalypFrame* EightBitsSampling::process( std::vector<CalypFrame*> apcFrameList )
 {
-  CalypFrame* pcFrame = apcFrameList[0];
-  ClpPel* pPelInput = pcFrame->getPelBufferYUV()[0][0];
-  ClpPel* pPelResampled = m_pcResampledFrame->getPelBufferYUV()[0][0];
+  const CalypFrame* pcFrame = apcFrameList[0];
   int bitShifting = m_iBitSifting > 0 ? m_iBitSifting : -m_iBitSifting;
 
-  if( m_iBitSifting > 0 )
-    for( unsigned i = 0; i < pcFrame->getTotalNumberOfPixels(); i++ )
-      *pPelResampled++ = *pPelInput++ >> bitShifting;
-  else
-    for( unsigned i = 0; i < pcFrame->getTotalNumberOfPixels(); i++ )
-      *pPelResampled++ = *pPelInput++ << bitShifting;
+  for( unsigned ch = 0; ch < pcFrame->getNumberChannels(); ch++ )
+  {
+    for( unsigned y = 0; y < pcFrame->getHeight( ch ); y++ )
+    {
+      const ClpPel* pPelInput = pcFrame->getPelBufferYUV()[ch][y];
+      ClpPel* pPelResampled = m_pcResampledFrame->getPelBufferYUV()[ch][y];
+      if( m_iBitSifting > 0 )
+        for( unsigned x = 0; x < pcFrame->getWidth( ch ); x++ )
+          *pPelResampled++ = *pPelInput++ >> bitShifting;
+      else
+        for( unsigned x = 0; x < pcFrame->getWidth( ch ); x++ )
+          *pPelResampled++ = *pPelInput++ << bitShifting;
+    }
+  }
   return m_pcResampledFrame;
 }
 
@@ -42,12 +42,15 @@ bool FilterComponentModule::createFilter( unsigned int uiWidth, unsigned int uiH
   return m_pcFilteredFrame != nullptr;
 }
 
-CalypFrame* FilterComponentModule::filterComponent( CalypFrame* InputFrame, int Component )
+CalypFrame* FilterComponentModule::filterComponent( const CalypFrame* InputFrame, int Component )
 {
   ClpPel*** pppOutputPelYUV = m_pcFilteredFrame->getPelBufferYUV();
   ClpPel*** pppInputPelYUV = InputFrame->getPelBufferYUV();
-  memcpy( pppOutputPelYUV[CLP_LUMA][0], pppInputPelYUV[Component][0],
-          m_pcFilteredFrame->getWidth() * m_pcFilteredFrame->getHeight() * sizeof( ClpPel ) );
+  for( unsigned int y = 0; y < m_pcFilteredFrame->getHeight(); y++ )
+  {
+    memcpy( pppOutputPelYUV[CLP_LUMA][y], pppInputPelYUV[Component][y],
+            m_pcFilteredFrame->getWidth() * sizeof( ClpPel ) );
+  }
   return m_pcFilteredFrame.get();
 }
 
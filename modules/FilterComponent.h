@@ -41,7 +41,7 @@ public:
   CalypFrame* process( std::vector<CalypFrame*> apcFrameList ) = 0;
 
   bool createFilter( unsigned int uiWidth, unsigned int uiHeight, unsigned int bitsPixel );
-  CalypFrame* filterComponent( CalypFrame* InputFrame, int Component );
+  CalypFrame* filterComponent( const CalypFrame* InputFrame, int Component );
 };
 
 class FilterComponentLuma : public FilterComponentModule, public CalypModuleInstance<FilterComponentLuma>
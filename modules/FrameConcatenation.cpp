@@ -64,22 +64,24 @@ bool FrameConcatenation::create( std::vector<CalypFrame*> apcFrameList )
 
 CalypFrame* FrameConcatenation::process( std::vector<CalypFrame*> apcFrameList )
 {
-  ClpPel* pelLeft;
-  ClpPel* pelRight;
+  const CalypFrame* pcLeftFrame = apcFrameList[0];
+  const CalypFrame* pcRightFrame = apcFrameList[1];
+  const ClpPel* pelLeft;
+  const ClpPel* pelRight;
   ClpPel* pelout;
 
   m_pcProcessedFrame->reset();
 
   for( unsigned int ch = 0; ch < m_pcProcessedFrame->getNumberChannels(); ch++ )
   {
-    unsigned int uiHeight = apcFrameList[0]->getHeight( ch );
-    unsigned int uiWidth = apcFrameList[0]->getWidth( ch );
+    unsigned int uiHeight = pcLeftFrame->getHeight( ch );
+    unsigned int uiWidth = pcLeftFrame->getWidth( ch );
     unsigned int shift = ch == 0 ? m_iShiftHor : m_iShiftHor >> m_pcProcessedFrame->getChromaWidthRatio();
 
     for( unsigned int y = 0; y < uiHeight; y++ )
     {
-      pelLeft = apcFrameList[0]->getPelBufferYUV()[ch][y];
-      pelRight = apcFrameList[1]->getPelBufferYUV()[ch][y];
+      pelLeft = pcLeftFrame->getPelBufferYUV()[ch][y];
+      pelRight = pcRightFrame->getPelBufferYUV()[ch][y];
       pelout = m_pcProcessedFrame->getPelBufferYUV()[ch][y];
 
       for( unsigned int x = 0; x < uiWidth; x++ )
@@ -86,12 +86,13 @@ CalypFrame* FrameDifference::process( std::vector<CalypFrame*> apcFrameList )
 {
   const CalypFrame& frame1 = *apcFrameList[0];
   const CalypFrame& frame2 = *apcFrameList[1];
-  ClpPel* pOutputPelYUV = m_pcFrameDifference->getPelBufferYUV()[0][0];
   short aux_pel_1, aux_pel_2;
   short diff = 0;
 
   for( unsigned int ch = 0; ch < m_pcFrameDifference->getNumberChannels(); ch++ )
     for( unsigned int y = 0; y < m_pcFrameDifference->getHeight( ch ); y++ )
+    {
+      ClpPel* pOutputPelYUV = m_pcFrameDifference->getPelBufferYUV()[ch][y];
       for( unsigned int x = 0; x < m_pcFrameDifference->getWidth( ch ); x++ )
       {
         aux_pel_1 = frame1( ch, x, y, false );
@@ -106,6 +107,7 @@ CalypFrame* FrameDifference::process( std::vector<CalypFrame*> apcFrameList )
         }
         *pOutputPelYUV++ = diff;
       }
+    }
   return m_pcFrameDifference;
 }
 
@@ -89,8 +89,8 @@ bool FrameMask::create( std::vector<CalypFrame*> apcFrameList )
 
 CalypFrame* FrameMask::process( std::vector<CalypFrame*> apcFrameList )
 {
-  CalypFrame* InputFrame = apcFrameList[0];
-  CalypFrame* MaskFrame = apcFrameList[1];
+  const CalypFrame* InputFrame = apcFrameList[0];
+  const CalypFrame* MaskFrame = apcFrameList[1];
   CalypPixel pixelImg;
   CalypPixel pixelMask;
   CalypPixel pixelOut;
@@ -74,7 +74,7 @@ bool FrameRotate::create( std::vector<CalypFrame*> apcFrameList )
 
 CalypFrame* FrameRotate::process( std::vector<CalypFrame*> apcFrameList )
 {
-  CalypFrame* InputFrame = apcFrameList[0];
+  const CalypFrame* InputFrame = apcFrameList[0];
   unsigned int inWidht = InputFrame->getWidth();
   unsigned int inHeight = InputFrame->getHeight();
   CalypPixel pixel;
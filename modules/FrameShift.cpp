@@ -60,7 +60,8 @@ bool FrameShift::create( std::vector<CalypFrame*> apcFrameList )
 
 CalypFrame* FrameShift::process( std::vector<CalypFrame*> apcFrameList )
 {
-  ClpPel* pPelInput;
+  const CalypFrame* pcInputFrame = apcFrameList[0];
+  const ClpPel* pPelInput;
   ClpPel* pPelOut;
 
   m_pcProcessedFrame->reset();
@@ -84,7 +85,7 @@ CalypFrame* FrameShift::process( std::vector<CalypFrame*> apcFrameList )
 
     for( unsigned int y = yStartOut, yIn = yStartIn; y < yEndOut; y++, yIn++ )
     {
-      pPelInput = &( apcFrameList[0]->getPelBufferYUV()[ch][yIn][xStartIn] );
+      pPelInput = &( pcInputFrame->getPelBufferYUV()[ch][yIn][xStartIn] );
       pPelOut = &( m_pcProcessedFrame->getPelBufferYUV()[ch][y][xStartOut] );
       for( unsigned int x = xStartOut; x < xEndOut; x++ )
       {
@@ -104,7 +104,8 @@ CalypFrame* HEVCIntraPrediction::process( std::vector<CalypFrame*> apcFrameList
   int y, x;
   int *main_coordinate, *sub_cordinate;
   ClpPel** predBlock = m_pcPredBlock->getPelBufferYUV()[0];
-  ClpPel** refFrame = apcFrameList[0]->getPelBufferYUV()[0];
+  const CalypFrame* pcRefFrame = apcFrameList[0];
+  ClpPel** refFrame = pcRefFrame->getPelBufferYUV()[0];
 
   // Reset block
   for( y = 0; y < m_iBlockSize * 2 + 1; y++ )
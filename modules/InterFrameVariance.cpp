@@ -64,16 +64,16 @@ CalypFrame* InterFrameVariance::process( std::vector<CalypFrame*> apcFrameList )
 {
   int numFrames = apcFrameList.size();
 
-  ClpPel** pInput = new ClpPel*[numFrames];
-  ClpPel* pOutputPelYUV = m_pcFrameVariance->getPelBufferYUV()[0][0];
-
-  for( int i = 0; i < numFrames; i++ )
-  {
-    pInput[i] = apcFrameList[i]->getPelBufferYUV()[0][0];
-  }
+  const ClpPel** pInput = new const ClpPel*[numFrames];
 
   double maxVariance = 0;
   for( unsigned int y = 0; y < m_pcFrameVariance->getHeight(); y++ )
+  {
+    for( int i = 0; i < numFrames; i++ )
+    {
+      const CalypFrame* pcInputFrame = apcFrameList[i];
+      pInput[i] = pcInputFrame->getPelBufferYUV()[0][y];
+    }
     for( unsigned int x = 0; x < m_pcFrameVariance->getWidth(); x++ )
     {
       int sum = 0;
@@ -92,12 +92,16 @@ CalypFrame* InterFrameVariance::process( std::vector<CalypFrame*> apcFrameList )
       if( m_pVariance[y][x] > maxVariance )
         maxVariance = m_pVariance[y][x];
     }
+  }
 
   for( unsigned int y = 0; y < m_pcFrameVariance->getHeight(); y++ )
+  {
+    ClpPel* pOutputPelYUV = m_pcFrameVariance->getPelBufferYUV()[0][y];
     for( unsigned int x = 0; x < m_pcFrameVariance->getWidth(); x++ )
     {
       *pOutputPelYUV++ = m_pVariance[y][x] * 255 / maxVariance;
     }
+  }
   delete[] pInput;
   return m_pcFrameVariance;
 }
@@ -47,14 +47,17 @@ void LumaAverage::create( CalypFrame* frame ) {}
 
 double LumaAverage::measure( CalypFrame* frame )
 {
+  const CalypFrame* pcInputFrame = frame;
   double average = 0;
-  ClpPel* pPel = frame->getPelBufferYUV()[0][0];
-  for( unsigned int y = 0; y < frame->getHeight(); y++ )
-    for( unsigned int x = 0; x < frame->getWidth(); x++ )
+  for( unsigned int y = 0; y < pcInputFrame->getHeight(); y++ )
+  {
+    const ClpPel* pPel = pcInputFrame->getPelBufferYUV()[0][y];
+    for( unsigned int x = 0; x < pcInputFrame->getWidth(); x++ )
     {
       average += *pPel;
       pPel++;
     }
+  }
   return average / double( frame->getHeight() * frame->getWidth() );
 }
 
@@ -38,8 +38,8 @@ private:
   int m_iStep;
   cv::Ptr<cv::DenseOpticalFlow> m_cTvl1;
   cv::Mat_<cv::Point2f> m_cvFlow;
-  CalypFrame* m_pcFramePrev;
-  CalypFrame* m_pcFrameAfter;
+  const CalypFrame* m_pcFramePrev;
+  const CalypFrame* m_pcFrameAfter;
   CalypFrame* m_pcOutputFrame;
 
   void drawFlow();
@@ -112,10 +112,10 @@ void OpticalFlowModule::compensateFlow()
   for( unsigned int c = 0; c < m_pcOutputFrame->getNumberChannels(); c++ )
   {
     ClpPel** pPelPrev = m_pcFramePrev->getPelBufferYUV()[c];
-    ClpPel* pPelOut = m_pcOutputFrame->getPelBufferYUV()[c][0];
 
     for( unsigned int y = 0; y < m_pcOutputFrame->getHeight( c ); y++ )
     {
+      ClpPel* pPelOut = m_pcOutputFrame->getPelBufferYUV()[c][y];
       for( unsigned int x = 0; x < m_pcOutputFrame->getWidth( c ); x++ )
       {
         Point2f u = m_cvFlow( y, x );
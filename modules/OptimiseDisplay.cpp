@@ -65,9 +65,9 @@ CalypFrame* OptimiseDisplay::process( std::vector<CalypFrame*> apcFrameList )
 {
   unsigned numValues = 1u << apcFrameList[0]->getBitsPel();
   std::vector<ClpPel> lookUpTable( numValues, 0 );
-  const ClpPel* pInput1PelYUV = apcFrameList[0]->getPelBufferYUV()[0][0];
-  ClpPel* pOutputPelYUV = m_pcOptimisedFrame->getPelBufferYUV()[0][0];
 
+  // Read only access, the writable buffer would drop the histogram of the input
+  const CalypFrame* pcInputFrame = apcFrameList[0];
   apcFrameList[0]->calcHistogram();
   m_pcOptimisedFrame->reset();
 
@@ -76,17 +76,19 @@ CalypFrame* OptimiseDisplay::process( std::vector<CalypFrame*> apcFrameList )
     ClpPel usedValues = 0;
     for( unsigned b = 0; b < numValues; b++ )
     {
-      if( apcFrameList[0]->getHistogramValue( ch, b ) != 0 )
+      if( pcInputFrame->getHistogramValue( ch, b ) != 0 )
       {
         lookUpTable[b] = usedValues;
         usedValues++;
       }
     }
 
-    ClpPel scale = numValues / usedValues;
+    ClpPel scale = usedValues ? numValues / usedValues : 1;
 
     for( unsigned y = 0; y < m_pcOptimisedFrame->getHeight( ch ); y++ )
     {
+      const ClpPel* pInput1PelYUV = pcInputFrame->getPelBufferYUV()[ch][y];
+      ClpPel* pOutputPelYUV = m_pcOptimisedFrame->getPelBufferYUV()[ch][y];
       for( unsigned x = 0; x < m_pcOptimisedFrame->getWidth( ch ); x++ )
       {
         *pOutputPelYUV++ = lookUpTable[*pInput1PelYUV++] * scale;
@@ -0,0 +1,102 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2021  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     QualityMap.cpp
+ * \brief    Per-block quality map module
+ */
+
+#include "QualityMap.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "lib/CalypFrame.h"
+
+QualityMap::QualityMap()
+{
+  /* Module Definition */
+  m_iModuleAPI = CLP_MODULE_API_2;
+  m_iModuleType = ClpModuleType::FrameProcessing;
+  m_pchModuleCategory = "Quality";
+  m_pchModuleName = "QualityMap";
+  m_pchModuleLongName = "Quality Map";
+  m_pchModuleTooltip = "Map of the MSE, SSIM or mean absolute difference of each block between two images "
+                       "(clipped to the sample range, SSIM is scaled to it)";
+  m_uiModuleRequirements = ClpModuleFeature::NewWindow | ClpModuleFeature::Options;
+  m_uiNumberOfFrames = 2;
+
+  m_cModuleOptions.addOptions()                                                                   /**/
+      ( "Metric", m_uiMap, "Metric of each block (0: MSE, 1: SSIM, 2: absolute difference) [0]" ) /**/
+      ( "BlockSize", m_uiBlockSize, "Size of the blocks, e.g., 8 or the CTU size [8]" )           /**/
+      ( "Component", m_uiComponent, "Select the component to measure [0]" )                       /**/
+      ( "FullResolution", m_uiFullResolution, "Repeat each block value over its samples [1]" );
+
+  m_uiMap = CalypFrame::MSE_MAP;
+  m_uiBlockSize = 8;
+  m_uiComponent = 0;
+  m_uiFullResolution = 1;
+}
+
+bool QualityMap::create( std::vector<CalypFrame*> apcFrameList )
+{
+  _BASIC_MODULE_API_2_CHECK_
+
+  if( !apcFrameList[1]->haveSameFmt( apcFrameList[0], CalypFrame::MATCH_COLOR_SPACE | CalypFrame::MATCH_RESOLUTION |
+                                                          CalypFrame::MATCH_BITS ) )
+    return false;
+  if( m_uiMap >= CalypFrame::NUMBER_MAPS || !m_uiBlockSize ||
+      m_uiComponent >= apcFrameList[0]->getNumberChannels() )
+    return false;
+
+  unsigned int width = apcFrameList[0]->getWidth( m_uiComponent );
+  unsigned int height = apcFrameList[0]->getHeight( m_uiComponent );
+  if( !m_uiFullResolution )
+  {
+    width = ( width + m_uiBlockSize - 1 ) / m_uiBlockSize;
+    height = ( height + m_uiBlockSize - 1 ) / m_uiBlockSize;
+  }
+  m_pcQualityMap = std::make_unique<CalypFrame>( width, height, ClpPixelFormats::Gray, apcFrameList[0]->getBitsPel() );
+  return true;
+}
+
+CalypFrame* QualityMap::process( std::vector<CalypFrame*> apcFrameList )
+{
+  const CalypPlane<float> map =
+      apcFrameList[1]->getQualityMap( m_uiMap, apcFrameList[0], m_uiComponent, m_uiBlockSize );
+  const double maxValue = ( 1 << m_pcQualityMap->getBitsPel() ) - 1;
+  const double scale = m_uiMap == CalypFrame::SSIM_MAP ? maxValue : 1.0;
+  const unsigned int blockSize = m_uiFullResolution ? m_uiBlockSize : 1;
+
+  for( unsigned int y = 0; y < m_pcQualityMap->getHeight(); y++ )
+  {
+    const auto& row = map[y / blockSize];
+    for( unsigned int x = 0; x < m_pcQualityMap->getWidth(); x++ )
+    {
+      const double value = std::clamp( std::round( row[x / blockSize] * scale ), 0.0, maxValue );
+      m_pcQualityMap->setPixel( x, y, CalypPixel( CLP_COLOR_GRAY, ClpPel( value ) ) );
+    }
+  }
+  return m_pcQualityMap.get();
+}
+
+void QualityMap::destroy()
+{
+  m_pcQualityMap = nullptr;
+}
@@ -63,13 +63,16 @@ bool SaliencyBasedFiltering::create( std::vector<CalypFrame*> apcFrameList )
   return true;
 }
 
-static cv::Mat* getCvFrame( ClpPel* pInputPel, unsigned uiWidth, unsigned uiHeight )
+static cv::Mat* getCvFrame( ClpPel** ppInputPel, unsigned uiWidth, unsigned uiHeight )
 {
   cv::Mat* cvInput = new cv::Mat( uiHeight, uiWidth, CV_MAKETYPE( CV_8U, 1 ) );
   unsigned char* pCvPel = cvInput->data;
-  for( unsigned i = 0; i < uiWidth * uiHeight; i++ )
+  for( unsigned y = 0; y < uiHeight; y++ )
   {
-    *pCvPel++ = *pInputPel++;
+    for( unsigned x = 0; x < uiWidth; x++ )
+    {
+      *pCvPel++ = ppInputPel[y][x];
+    }
   }
   return cvInput;
 }
@@ -91,21 +94,23 @@ static cv::Mat* filterframe( cv::Mat* cvFrame, unsigned kernelSize )
   return cvFiltered;
 }
 
-static void filterComponent( CalypFrame* pInput, CalypFrame* pOutput, CalypFrame* Map, unsigned uiComp )
+static void filterComponent( const CalypFrame* pInput, CalypFrame* pOutput, const CalypFrame* Map, unsigned uiComp )
 {
-  ClpPel* pMapPel = Map->getPelBufferYUV()[0][0];
+  ClpPel** ppMapPel = Map->getPelBufferYUV()[0];
   int iMapStep = 1;
-  ClpPel* pInputPel = pInput->getPelBufferYUV()[uiComp][0];
-  ClpPel* pOutputPel = pOutput->getPelBufferYUV()[uiComp][0];
+  ClpPel** ppInputPel = pInput->getPelBufferYUV()[uiComp];
+  ClpPel** ppOutputPel = pOutput->getPelBufferYUV()[uiComp];
   std::int64_t iHeight = pInput->getHeight( uiComp );
   std::int64_t iWidth = pInput->getWidth( uiComp );
+  std::int64_t iMapHeight = Map->getHeight();
+  std::int64_t iMapWidth = Map->getWidth();
 
   if( uiComp > 0 )
   {
     iMapStep = 2;
   }
 
-  cv::Mat* cvInput = getCvFrame( pInputPel, iWidth, iHeight );
+  cv::Mat* cvInput = getCvFrame( ppInputPel, iWidth, iHeight );
 
   unsigned numberFilters = 1;
   unsigned char* pCvPel[3];
@@ -120,6 +125,8 @@ static void filterComponent( CalypFrame* pInput, CalypFrame* pOutput, CalypFrame
   unsigned uiRelevance = 0;
   for( int y = 0; y < iHeight; y++ )
   {
+    ClpPel* pInputPel = ppInputPel[y];
+    ClpPel* pOutputPel = ppOutputPel[y];
     for( int x = 0; x < iWidth; x++ )
     {
       uiRelevance = 0;
@@ -128,7 +135,9 @@ static void filterComponent( CalypFrame* pInput, CalypFrame* pOutput, CalypFrame
       {
         for( std::int64_t i = CLAMP_RANGE( x - iCheckNeighbour, 0, iWidth ); i < CLAMP_RANGE( x + iCheckNeighbour + 1, 0, iWidth ); i++ )
         {
-          uiRelevance += *( pMapPel + ( ( j - y ) * iWidth ) + ( i - x ) );
+          std::int64_t mapY = CLAMP_RANGE( y * iMapStep + j - y, 0, iMapHeight - 1 );
+          std::int64_t mapX = CLAMP_RANGE( x * iMapStep + i - x, 0, iMapWidth - 1 );
+          uiRelevance += ppMapPel[mapY][mapX];
         }
       }
 
@@ -146,15 +155,13 @@ static void filterComponent( CalypFrame* pInput, CalypFrame* pOutput, CalypFrame
         pCvPel[i]++;
       pInputPel++;
       pOutputPel++;
-      pMapPel += iMapStep;
     }
-    pMapPel += ( iMapStep - 1 ) * iWidth;
   }
 }
 
 CalypFrame* SaliencyBasedFiltering::process( std::vector<CalypFrame*> apcFrameList )
 {
-  CalypFrame* pcInputFrame = apcFrameList[0];
+  const CalypFrame* pcInputFrame = apcFrameList[0];
 
   for( unsigned c = 0; c < pcInputFrame->getNumberChannels(); c++ )
     filterComponent( pcInputFrame, m_pcProcessedFrame.get(), apcFrameList[1], c );
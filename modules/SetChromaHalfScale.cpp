@@ -47,17 +47,27 @@ void SetChromaHalfScale::create( CalypFrame* frame )
 
 CalypFrame* SetChromaHalfScale::process( CalypFrame* frame )
 {
-  ClpPel* pPelInput = frame->getPelBufferYUV()[CLP_LUMA][0];
-  ClpPel* pPelOut = m_pcProcessedFrame->getPelBufferYUV()[0][0];
-  ClpPel halfScaleValue = 1 << ( frame->getBitsPel() - 1 );
-  for( unsigned int i = 0; i < frame->getHeight() * frame->getWidth(); i++ )
+  const CalypFrame* pcInputFrame = frame;
+  ClpPel halfScaleValue = 1 << ( pcInputFrame->getBitsPel() - 1 );
+  for( unsigned int y = 0; y < pcInputFrame->getHeight(); y++ )
   {
-    *pPelOut++ = *pPelInput++;
+    const ClpPel* pPelInput = pcInputFrame->getPelBufferYUV()[CLP_LUMA][y];
+    ClpPel* pPelOut = m_pcProcessedFrame->getPelBufferYUV()[CLP_LUMA][y];
+    for( unsigned int x = 0; x < pcInputFrame->getWidth(); x++ )
+    {
+      *pPelOut++ = *pPelInput++;
+    }
   }
-  pPelInput = frame->getPelBufferYUV()[CLP_CHROMA_U][0];
-  for( unsigned int i = 0; i < m_pcProcessedFrame->getChromaLength() * 2; i++ )
+  for( unsigned int ch = CLP_CHROMA_U; ch < m_pcProcessedFrame->getNumberChannels(); ch++ )
   {
-    *pPelOut++ = halfScaleValue;
+    for( unsigned int y = 0; y < m_pcProcessedFrame->getHeight( ch ); y++ )
+    {
+      ClpPel* pPelOut = m_pcProcessedFrame->getPelBufferYUV()[ch][y];
+      for( unsigned int x = 0; x < m_pcProcessedFrame->getWidth( ch ); x++ )
+      {
+        *pPelOut++ = halfScaleValue;
+      }
+    }
   }
   return m_pcProcessedFrame;
 }
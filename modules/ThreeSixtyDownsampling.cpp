@@ -160,7 +160,7 @@ bool ThreeSixtyDownsampling::create( std::vector<CalypFrame*> apcFrameList )
 #define WIDTH_TRIM_START_POINT 0.0
 #define WIDTH_FINAL 1.0
 
-bool ThreeSixtyDownsampling::createDownsamplingMask( CalypFrame* pcInputFrame )
+bool ThreeSixtyDownsampling::createDownsamplingMask( const CalypFrame* pcInputFrame )
 {
   if( m_iRearrange == 3 )
   {
@@ -603,7 +603,7 @@ bool ThreeSixtyDownsampling::createDownsamplingMask( CalypFrame* pcInputFrame )
   return true;
 }
 
-void ThreeSixtyDownsampling::downsamplingOperation( CalypFrame* pcInputFrame )
+void ThreeSixtyDownsampling::downsamplingOperation( const CalypFrame* pcInputFrame )
 {
   unsigned numBytes = m_pcDownsampled->getBitsPel() > 8 ? 2 : 1;
   m_pcDownsampled->reset();
@@ -638,11 +638,11 @@ void ThreeSixtyDownsampling::downsamplingOperation( CalypFrame* pcInputFrame )
     }
     Mat_<Point> reshapePoints = *( m_cvReshapePoints[ch] );
     ClpPel** downSampPelBuff = m_pcDownsampled->getPelBufferYUV()[ch];
-    ClpPel* pelOutputPtr = m_pcResultedFrame->getPelBufferYUV()[ch][0];
 
     Mat outputMask( m_pcResultedFrame->getHeight( ch ), m_pcResultedFrame->getWidth( ch ), CV_8UC1, Scalar( 1 ) );
     for( unsigned y = 0; y < m_pcResultedFrame->getHeight( ch ); y++ )
     {
+      ClpPel* pelOutputPtr = m_pcResultedFrame->getPelBufferYUV()[ch][y];
       for( unsigned x = 0; x < m_pcResultedFrame->getWidth( ch ); x++ )
       {
         Point pt = reshapePoints.at<Point>( y, x );
@@ -664,7 +664,7 @@ void ThreeSixtyDownsampling::downsamplingOperation( CalypFrame* pcInputFrame )
   }
 }
 
-void ThreeSixtyDownsampling::upsamplingOperation( CalypFrame* pcInputFrame )
+void ThreeSixtyDownsampling::upsamplingOperation( const CalypFrame* pcInputFrame )
 {
   unsigned numBytes = m_pcDownsampled->getBitsPel() > 8 ? 2 : 1;
   m_pcDownsampled->reset();
@@ -673,9 +673,9 @@ void ThreeSixtyDownsampling::upsamplingOperation( CalypFrame* pcInputFrame )
   {
     Mat_<Point> reshapePoints = *( m_cvReshapePoints[ch] );
     ClpPel** downSampPelBuff = m_pcDownsampled->getPelBufferYUV()[ch];
-    ClpPel* pelInputPtr = pcInputFrame->getPelBufferYUV()[ch][0];
     for( unsigned y = 0; y < pcInputFrame->getHeight( ch ); y++ )
     {
+      const ClpPel* pelInputPtr = pcInputFrame->getPelBufferYUV()[ch][y];
       for( unsigned x = 0; x < pcInputFrame->getWidth( ch ); x++ )
       {
         Point pt = reshapePoints.at<Point>( y, x );
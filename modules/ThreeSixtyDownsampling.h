@@ -57,10 +57,10 @@ private:
   // Values one per channel
   std::vector<Mat*> m_cvDownsamplingMask;
   std::vector<Mat_<Point>*> m_cvReshapePoints;
-  bool createDownsamplingMask( CalypFrame* pcFrame );
+  bool createDownsamplingMask( const CalypFrame* pcFrame );
 
-  void downsamplingOperation( CalypFrame* pcInputFrame );
-  void upsamplingOperation( CalypFrame* pcInputFrame );
+  void downsamplingOperation( const CalypFrame* pcInputFrame );
+  void upsamplingOperation( const CalypFrame* pcInputFrame );
 
 public:
   ThreeSixtyDownsampling();
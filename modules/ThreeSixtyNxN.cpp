@@ -119,8 +119,8 @@ void ThreeSixtyNxN::downsamplingOperation( const CalypFrame* pcInputFrame )
   {
     int max_value = ( 1 << m_pcOutputFrame->getBitsPel() ) - 1;
     int N = pcInputFrame->getHeight( ch );
-    ClpPel* in = &pcInputFrame->getPelBufferYUV()[ch][0][0];
-    ClpPel* out = &m_pcOutputFrame->getPelBufferYUV()[ch][0][0];
+    ClpPel** in = pcInputFrame->getPelBufferYUV()[ch];
+    ClpPel** out = m_pcOutputFrame->getPelBufferYUV()[ch];
 
     int n_2 = N / 2;
     int n1 = N - 1;
@@ -145,8 +145,9 @@ void ThreeSixtyNxN::downsamplingOperation( const CalypFrame* pcInputFrame )
         novo_x = ( valida ? x : ( x < n_2 ? -dist_y + x * 2 : n1 + dist_y - ( n1 - x ) * 2 ) ) - n_2 + 1;
 
         tx_x = ( N / ( N - fabs( novo_y - n1 ) ) ) * novo_x + n1;
-        tx_y = (int)novo_y * N + in;
-        rx = x + y * N + out;
+        // novo_y is given in half rows of the 2N x N input
+        tx_y = in[(int)novo_y / 2];
+        rx = out[y] + x;
 
         *( rx ) = interpol_lanczos3( tx_y, tx_x, N * 2, max_value );
       }
@@ -160,8 +161,8 @@ void ThreeSixtyNxN::upsamplingOperation( const CalypFrame* pcInputFrame )
   {
     int max_value = ( 1 << m_pcOutputFrame->getBitsPel() ) - 1;
     int N = pcInputFrame->getHeight( ch );
-    ClpPel* in = &pcInputFrame->getPelBufferYUV()[ch][0][0];
-    ClpPel* out = &m_pcOutputFrame->getPelBufferYUV()[ch][0][0];
+    ClpPel** in = pcInputFrame->getPelBufferYUV()[ch];
+    ClpPel** out = m_pcOutputFrame->getPelBufferYUV()[ch];
 
     int x;
     int y;
@@ -191,13 +192,13 @@ void ThreeSixtyNxN::upsamplingOperation( const CalypFrame* pcInputFrame )
         novo_x = ( dist_x > dist_y ? dist_y : ( dist_x + 1 < -dist_y ? -dist_y - 1 : dist_x ) ) + N / 2;
         novo_y = abs( dist_x ) > dist_y ? ( y < N / 2 ? dist_Lj : N - dist_Lj - 1 ) : y;
 
-        linhaY[x] = *( in + (int)novo_x + (int)novo_y * N );
+        linhaY[x] = in[(int)novo_y][(int)novo_x];
       }
 
       for( x = 0; x < n2; x++ )
       {
         tx = ( x + 1 ) / Dj - 1;
-        rx = x + y * n2 + out;
+        rx = out[y] + x;
 
         *( rx ) = interpol_lanczos3( linhaY.data(), tx, Lj, max_value );
       }
@@ -25,6 +25,7 @@
 #include "WeightedPSNR.h"
 
 #include <cmath>
+#include <cstdint>
 
 WeightedPSNR::WeightedPSNR()
 {
@@ -67,33 +68,37 @@ bool WeightedPSNR::create( std::vector<CalypFrame*> apcFrameList )
 
 double measureWMSE( int component, CalypFrame* Org, CalypFrame* Rec, CalypFrame* Mask )
 {
-  ClpPel* pMaskPelYUV = Mask->getPelBufferYUV()[0][0];
-  ClpPel* pRecPelYUV = Rec->getPelBufferYUV()[component][0];
-  ClpPel* pOrgPelYUV = Org->getPelBufferYUV()[component][0];
-
-  double aux_pel_1, aux_pel_2, aux_pel_mask;
-  int diff = 0;
+  const CalypFrame& mask = *Mask;
+  const CalypFrame& rec = *Rec;
+  const CalypFrame& org = *Org;
+  const unsigned int width = rec.getWidth( component );
+  const unsigned int height = rec.getHeight( component );
   double ssd = 0;
-  unsigned int count = 0;
+  std::uint64_t count = 0;
 
-  unsigned int numberOfPixels = 0;
-  if( component == CLP_LUMA )
+  if( mask.getWidth() == width && mask.getHeight() == height )
   {
-    numberOfPixels = Org->getHeight() * Org->getWidth();
+    for( std::uint64_t rowSsd : Rec->getRowSSD( Org, component, Mask ) )
+      ssd += double( rowSsd );
+    for( unsigned int y = 0; y < height; y++ )
+      for( unsigned int x = 0; x < width; x++ )
+        count += mask( CLP_LUMA, x, y );
   }
   else
   {
-    numberOfPixels = Rec->getChromaLength();
-  }
-
-  for( unsigned int i = 0; i < numberOfPixels; i++ )
-  {
-    aux_pel_mask = *pMaskPelYUV++;
-    aux_pel_1 = *pRecPelYUV++;
-    aux_pel_2 = *pOrgPelYUV++;
-    diff = aux_pel_1 - aux_pel_2;
-    ssd += ( aux_pel_mask * diff * diff );
-    count += aux_pel_mask;
+    // The mask is read in raster order, as if it had the size of the component
+    const unsigned int maskWidth = mask.getWidth();
+    std::uint64_t maskIdx = 0;
+    for( unsigned int y = 0; y < height; y++ )
+    {
+      for( unsigned int x = 0; x < width; x++, maskIdx++ )
+      {
+        double aux_pel_mask = mask( CLP_LUMA, maskIdx % maskWidth, maskIdx / maskWidth );
+        int diff = int( rec( component, x, y ) ) - int( org( component, x, y ) );
+        ssd += ( aux_pel_mask * diff * diff );
+        count += aux_pel_mask;
+      }
+    }
   }
   if( ssd == 0.0 )
   {
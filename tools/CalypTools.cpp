@@ -24,9 +24,20 @@
 
 #include "CalypTools.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <climits>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 #include "config.h"
 #include "lib/CalypFrame.h"
@@ -39,8 +50,7 @@ CalypTools::CalypTools()
   m_bVerbose = true;
   m_uiOperation = INVALID_OPERATION;
   m_uiNumberOfFrames = -1;
-
-  m_uiQualityMetric = -1;
+  m_iQualityMap = -1;
 
   m_pcCurrModuleIf = NULL;
 }
@@ -52,7 +62,7 @@ CalypTools::~CalypTools() = default;
 void CalypTools::reportStreamInfo( const CalypStream* stream, std::string strPrefix )
 {
   log( CLP_LOG_INFO, "%sStream name: %s \n", strPrefix.c_str(), stream->getFileName().c_str() );
-  log( CLP_LOG_INFO, "%sResolution: %dx%d@%d \n", strPrefix.c_str(), stream->getWidth(), stream->getHeight(),
+  log( CLP_LOG_INFO, "%sResolution: %dx%d@%g \n", strPrefix.c_str(), stream->getWidth(), stream->getHeight(),
        stream->getFrameRate() );
   log( CLP_LOG_INFO, "%sBits/pel: %d (%s)\n", strPrefix.c_str(), stream->getBitsPerPixel(),
        stream->getEndianess() == CLP_BIG_ENDIAN ? "BE" : "LE" );
@@ -104,6 +114,7 @@ int CalypTools::openInputs()
         hasNegativeValues = std::stoi( GET_PARAM( m_strHasNegativeValues, i ).c_str() ) == 0 ? false : true;
       }
       pcStream = new CalypStream;
+      pcStream->setDecoderThreads( m_uiDecoderThreads );
       try
       {
         if( !pcStream->open( inputFileNames[i], resolutionString, fmtString, uiBitsPerPixel, uiEndianness,
@@ -112,6 +123,7 @@ int CalypTools::openInputs()
           log( CLP_LOG_ERROR, "Cannot open input stream %s! ", inputFileNames[i].c_str() );
           return -1;
         }
+        pcStream->setReadAhead( m_uiReadAhead );
         m_apcInputStreams.push_back( pcStream );
         log( CLP_LOG_INFO, "Found input %d \n", m_apcInputStreams.size() );
         reportStreamInfo( pcStream );
@@ -134,7 +146,9 @@ int CalypTools::openInputs()
   m_uiNumberOfComponents = -1;
   for( unsigned int i = 0; i < m_apcInputStreams.size(); i++ )
   {
-    m_uiNumberOfFrames = std::min( m_uiNumberOfFrames, m_apcInputStreams[i]->getFrameNum() );
+    // Streamed inputs are read until they end
+    if( !m_apcInputStreams[i]->isStreaming() )
+      m_uiNumberOfFrames = std::min( m_uiNumberOfFrames, m_apcInputStreams[i]->getFrameNum() );
     m_uiNumberOfComponents =
         std::min( m_uiNumberOfComponents, m_apcInputStreams[i]->getCurrFrame()->getNumberChannels() );
   }
@@ -146,8 +160,6 @@ int CalypTools::Open( int argc, char* argv[] )
 {
   int iRet = 0;
 
-  log( CLP_LOG_ERROR, "calypTools - The command line interface for Calyp modules! \n" );
-
   // check requirements
   if( CalypPixel::getMaxNumberOfComponents() > MAX_NUMBER_CHANNELS )
   {
@@ -242,10 +254,14 @@ int CalypTools::Open( int argc, char* argv[] )
 
     const CalypFrame* pcInputFrame = m_apcInputStreams[0]->getCurrFrame();
     CalypStream* pcOutputStream = new CalypStream;
+    pcOutputStream->setEncoder( m_strEncoder, m_uiEncoderThreads );
+    pcOutputStream->setWriteBehind( m_uiWriteBehind );
     try
     {
+      // One of every m_iRateReductionFactor frames is kept
+      const double frameRate = m_apcInputStreams[0]->getFrameRate() / m_iRateReductionFactor;
       pcOutputStream->open( m_pcOutputFileNames[0], pcInputFrame->getWidth(), pcInputFrame->getHeight(),
-                            pcInputFrame->getPelFormat(), pcInputFrame->getBitsPel(), m_uiOutEndianness, 1,
+                            pcInputFrame->getPelFormat(), pcInputFrame->getBitsPel(), m_uiOutEndianness, frameRate,
                             CalypStream::Type::Output );
       log( CLP_LOG_INFO, "Output stream from rate-reduction!\n" );
       reportStreamInfo( pcOutputStream, "Output " );
@@ -277,20 +293,37 @@ int CalypTools::Open( int argc, char* argv[] )
    */
   if( Opts().hasOpt( "quality" ) )
   {
-    std::string qualityMetric = m_strQualityMetric;
     if( m_apcInputStreams.size() < 2 )
     {
       log( CLP_LOG_ERROR, "Invalid number of inputs! " );
       return -1;
     }
-    for( unsigned int i = 0; i < CalypFrame::supportedQualityMetricsList().size(); i++ )
+    // metric names are matched ignoring case and dashes (wspsnr selects WS-PSNR)
+    const auto metricKey = []( std::string name ) {
+      name.erase( std::remove( name.begin(), name.end(), '-' ), name.end() );
+      return clpLowercase( name );
+    };
+    std::stringstream qualityMetrics( m_strQualityMetric );
+    std::string qualityMetric;
+    while( std::getline( qualityMetrics, qualityMetric, ',' ) )
     {
-      if( clpLowercase( CalypFrame::supportedQualityMetricsList()[i] ) == clpLowercase( qualityMetric ) )
+      int metric = -1;
+      for( unsigned int i = 0; i < CalypFrame::supportedQualityMetricsList().size(); i++ )
+      {
+        if( metricKey( CalypFrame::supportedQualityMetricsList()[i] ) == metricKey( qualityMetric ) )
+        {
+          metric = i;
+        }
+      }
+      if( metric == -1 )
       {
-        m_uiQualityMetric = i;
+        log( CLP_LOG_ERROR, "Invalid quality metric! " );
+        return -1;
       }
+      if( std::find( m_aiQualityMetrics.begin(), m_aiQualityMetrics.end(), metric ) == m_aiQualityMetrics.end() )
+        m_aiQualityMetrics.push_back( metric );
     }
-    if( m_uiQualityMetric == -1 )
+    if( m_aiQualityMetrics.empty() )
     {
       log( CLP_LOG_ERROR, "Invalid quality metric! " );
       return -1;
@@ -300,6 +333,44 @@ int CalypTools::Open( int argc, char* argv[] )
     log( CLP_LOG_INFO, "Calyp Quality\n" );
   }
 
+  /**
+   * Check Quality map operation
+   */
+  if( Opts().hasOpt( "quality-map" ) )
+  {
+    if( m_apcInputStreams.size() < 2 )
+    {
+      log( CLP_LOG_ERROR, "Invalid number of inputs! " );
+      return -1;
+    }
+    for( unsigned int i = 0; i < CalypFrame::supportedQualityMapsList().size(); i++ )
+    {
+      if( clpLowercase( CalypFrame::supportedQualityMapsList()[i] ) == clpLowercase( m_strQualityMap ) )
+      {
+        m_iQualityMap = i;
+      }
+    }
+    if( m_iQualityMap == -1 )
+    {
+      log( CLP_LOG_ERROR, "Invalid quality map! " );
+      return -1;
+    }
+    if( m_uiBlockSize == 0 )
+    {
+      log( CLP_LOG_ERROR, "Invalid block size! " );
+      return -1;
+    }
+    if( !Opts().hasOpt( "output" ) )
+    {
+      log( CLP_LOG_ERROR, "One output is required! " );
+      return -1;
+    }
+    m_pcOutputFileNames.push_back( m_strOutput );
+    m_uiOperation = QUALITY_MAP_OPERATION;
+    m_fpProcess = &CalypTools::QualityMapOperation;
+    log( CLP_LOG_INFO, "Calyp Quality Map\n" );
+  }
+
   /**
    * Check Module operation
    */
@@ -375,11 +446,13 @@ int CalypTools::Open( int argc, char* argv[] )
           pcModFrame = m_pcCurrModuleIf->process( m_apcInputStreams[0]->getCurrFrame() );
         }
         CalypStream* pcModStream = new CalypStream;
+        pcModStream->setEncoder( m_strEncoder, m_uiEncoderThreads );
+        pcModStream->setWriteBehind( m_uiWriteBehind );
         try
         {
           pcModStream->open( outputFileNames[0], pcModFrame->getWidth(), pcModFrame->getHeight(),
-                             pcModFrame->getPelFormat(), pcModFrame->getBitsPel(), m_uiOutEndianness, 1,
-                             CalypStream::Type::Output );
+                             pcModFrame->getPelFormat(), pcModFrame->getBitsPel(), m_uiOutEndianness,
+                             m_apcInputStreams[0]->getFrameRate(), CalypStream::Type::Output );
           log( CLP_LOG_INFO, "Output stream from module!\n" );
           reportStreamInfo( pcModStream, "Module Output " );
         }
@@ -435,8 +508,23 @@ int CalypTools::Process()
 
 int CalypTools::Close()
 {
-  // Finish
-  return 0;
+  // Finish the outputs, the frames written behind and the encoders fail here
+  int iRet = 0;
+  for( auto pcStream : m_apcOutputStreams )
+  {
+    try
+    {
+      pcStream->close();
+    }
+    catch( const std::exception& e )
+    {
+      log( CLP_LOG_ERROR, "Cannot write the output stream %s: %s\n", pcStream->getFileName().c_str(), e.what() );
+      iRet = -1;
+    }
+    delete pcStream;
+  }
+  m_apcOutputStreams.clear();
+  return iRet;
 }
 
 int CalypTools::SaveOperation()
@@ -468,101 +556,377 @@ int CalypTools::RateReductionOperation()
       m_apcOutputStreams[0]->writeFrame( *m_apcInputStreams[0]->getCurrFrame() );
     }
     abEOF = m_apcInputStreams[0]->setNextFrame();
-    if( !abEOF )
+    if( abEOF )
     {
-      m_apcInputStreams[0]->readNextFrame();
+      break;
     }
+    m_apcInputStreams[0]->readNextFrame();
   }
   return 0;
 }
 
+namespace
+{
+/**
+ * Queue of items handed from one thread to another, push() waits while
+ * the queue is full and pop() while it is empty, until close() is called
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+  explicit BoundedQueue( std::size_t capacity )
+      : m_capacity{ std::max<std::size_t>( capacity, 1 ) }
+  {
+  }
+
+  bool push( T item )
+  {
+    std::unique_lock<std::mutex> lock( m_mutex );
+    m_notFull.wait( lock, [this] { return m_bClosed || m_items.size() < m_capacity; } );
+    if( m_bClosed )
+      return false;
+    m_items.push_back( std::move( item ) );
+    m_notEmpty.notify_one();
+    return true;
+  }
+
+  bool pop( T& item )
+  {
+    std::unique_lock<std::mutex> lock( m_mutex );
+    m_notEmpty.wait( lock, [this] { return m_bClosed || !m_items.empty(); } );
+    if( m_items.empty() )
+      return false;
+    item = std::move( m_items.front() );
+    m_items.pop_front();
+    m_notFull.notify_one();
+    return true;
+  }
+
+  void close()
+  {
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_bClosed = true;
+    m_notFull.notify_all();
+    m_notEmpty.notify_all();
+  }
+
+private:
+  const std::size_t m_capacity;
+  std::mutex m_mutex;
+  std::condition_variable m_notFull;
+  std::condition_variable m_notEmpty;
+  std::deque<T> m_items;
+  bool m_bClosed{ false };
+};
+
+}  // namespace
+
 int CalypTools::QualityOperation()
 {
-  const char* pchQualityMetricName = CalypFrame::supportedQualityMetricsList()[m_uiQualityMetric].c_str();
-  CalypFrame* apcCurrFrame[MAX_NUMBER_INPUTS];
-  bool abEOF[MAX_NUMBER_INPUTS];
-  double adAverageQuality[MAX_NUMBER_INPUTS - 1][MAX_NUMBER_CHANNELS];
-  double dQuality;
-
-  std::string metric_fmt = " ";
-  switch( m_uiQualityMetric )
-  {
-  case CalypFrame::PSNR_METRIC:
-    //"PSNR_0_0"
-    metric_fmt += " %6.3f ";
-    break;
-  case CalypFrame::SSIM_METRIC:
-    //"SSIM_0_0"
-    metric_fmt += " %6.4f ";
-    break;
-  case CalypFrame::MSE_METRIC:
-    //"MSE_0_0"
-    metric_fmt += "%7.2f";
-    break;
-  default:
-    metric_fmt += " %6.3f ";
-  }
-  metric_fmt += " ";
-
-  log( CLP_LOG_INFO, "  Measuring Quality using %s ... \n", pchQualityMetricName );
-  log( CLP_LOG_INFO, "# Frame   ", pchQualityMetricName );
+  double adAverageQuality[CalypFrame::NUMBER_METRICS][MAX_NUMBER_INPUTS - 1][MAX_NUMBER_CHANNELS];
+
+  std::string metric_fmt[CalypFrame::NUMBER_METRICS];
+  for( int metric : m_aiQualityMetrics )
+  {
+    const char* fmt;
+    switch( metric )
+    {
+    case CalypFrame::PSNR_METRIC:
+      //"PSNR_0_0"
+      fmt = " %6.3f ";
+      break;
+    case CalypFrame::SSIM_METRIC:
+      //"SSIM_0_0"
+      fmt = " %6.4f ";
+      break;
+    case CalypFrame::MSE_METRIC:
+      //"MSE_0_0"
+      fmt = "%7.2f";
+      break;
+    default:
+      fmt = " %6.3f ";
+    }
+    metric_fmt[metric] = std::string( " " ) + fmt + " ";
+  }
+
+  std::string qualityMetricNames;
+  for( int metric : m_aiQualityMetrics )
+  {
+    if( !qualityMetricNames.empty() )
+      qualityMetricNames += ", ";
+    qualityMetricNames += CalypFrame::supportedQualityMetricsList()[metric];
+  }
+  log( CLP_LOG_INFO, "  Measuring Quality using %s ... \n", qualityMetricNames.c_str() );
+  log( CLP_LOG_INFO, "# Frame   " );
 
   for( unsigned int s = 1; s < m_apcInputStreams.size(); s++ )
   {
-    for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+    for( int metric : m_aiQualityMetrics )
     {
-      log( CLP_LOG_INFO, "%s_%d_%d  ", pchQualityMetricName, s, c );
+      for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+      {
+        log( CLP_LOG_INFO, "%s_%d_%d  ", CalypFrame::supportedQualityMetricsList()[metric].c_str(), s, c );
+      }
     }
     log( CLP_LOG_INFO, "   " );
   }
 
   log( CLP_LOG_INFO, "\n" );
 
-  for( unsigned int s = 0; s < m_apcInputStreams.size(); s++ )
+  std::vector<unsigned int> components;
+  for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+    components.push_back( c );
+  for( int metric : m_aiQualityMetrics )
+    for( unsigned int s = 0; s < m_apcInputStreams.size() - 1; s++ )
+      for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+        adAverageQuality[metric][s][c] = 0;
+
+  /*
+   * Pipeline: a reader thread for each input prefetches frames into a bounded queue,
+   * the workers take the next frame of every input and measure it, and this thread
+   * collects the results in frame order to print them and update the averages
+   */
+  const unsigned int numWorkers = std::max( 1u, m_uiThreads ? m_uiThreads : std::thread::hardware_concurrency() );
+  const std::size_t numStreams = m_apcInputStreams.size();
+  const std::uint64_t numFrames = m_uiNumberOfFrames;
+
+  std::mutex errorMutex;
+  std::exception_ptr error;
+  std::atomic<bool> aborted{ false };
+  std::vector<std::unique_ptr<BoundedQueue<std::unique_ptr<CalypFrame>>>> frameQueues;
+  for( std::size_t s = 0; s < numStreams; s++ )
+    frameQueues.push_back( std::make_unique<BoundedQueue<std::unique_ptr<CalypFrame>>>( 2 * numWorkers ) );
+
+  std::mutex resultsMutex;
+  std::condition_variable resultsReady;
+  struct FrameResults
   {
-    abEOF[s] = false;
-    for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+    std::vector<CalypFrame::QualityResults> quality;
+    double timeMs;
+  };
+  std::map<std::uint64_t, FrameResults> results;
+  // Frames read from all the inputs, less than numFrames if a stream ends first
+  std::uint64_t framesRead = numFrames;
+
+  const auto fail = [&]( std::exception_ptr exception ) {
     {
-      adAverageQuality[s][c] = 0;
+      std::lock_guard<std::mutex> lock( errorMutex );
+      if( !error )
+        error = exception;
     }
+    aborted = true;
+    for( auto& queue : frameQueues )
+      queue->close();
+    std::lock_guard<std::mutex> lock( resultsMutex );
+    resultsReady.notify_all();
+  };
+
+  std::vector<std::thread> threads;
+  for( std::size_t s = 0; s < numStreams; s++ )
+  {
+    threads.emplace_back( [&, s] {
+      try
+      {
+        CalypStream* stream = m_apcInputStreams[s];
+        std::uint64_t frame = 0;
+        while( frame < numFrames )
+        {
+          // Copies share the samples with the stream frame until it is read again
+          if( !frameQueues[s]->push( stream->getCurrFrame( nullptr ) ) )
+            return;
+          frame++;
+          if( stream->setNextFrame() )
+            break;
+          stream->readNextFrame();
+        }
+        frameQueues[s]->close();
+        std::lock_guard<std::mutex> lock( resultsMutex );
+        framesRead = std::min( framesRead, frame );
+        resultsReady.notify_all();
+      }
+      catch( ... )
+      {
+        fail( std::current_exception() );
+      }
+    } );
   }
-  for( unsigned int frame = 0; frame < m_uiNumberOfFrames; frame++ )
+
+  std::mutex dispatchMutex;
+  std::uint64_t nextFrame = 0;
+  for( unsigned int w = 0; w < numWorkers; w++ )
   {
-    log( CLP_LOG_INFO, "  %3d  ", frame );
-    for( unsigned int s = 0; s < m_apcInputStreams.size(); s++ )
-      apcCurrFrame[s] = m_apcInputStreams[s]->getCurrFrame();
+    threads.emplace_back( [&] {
+      try
+      {
+        std::vector<std::unique_ptr<CalypFrame>> frames( numStreams );
+        while( true )
+        {
+          std::uint64_t frame;
+          {
+            // Frames are taken from all the queues at once to keep them matched
+            std::lock_guard<std::mutex> lock( dispatchMutex );
+            if( nextFrame >= numFrames )
+              return;
+            frame = nextFrame++;
+            for( std::size_t s = 0; s < numStreams; s++ )
+              if( !frameQueues[s]->pop( frames[s] ) )
+                return;
+          }
+          const auto start = std::chrono::steady_clock::now();
+          FrameResults frameResults;
+          for( std::size_t s = 1; s < numStreams; s++ )
+            frameResults.quality.push_back(
+                frames[s]->computeQuality( frames[0].get(), m_aiQualityMetrics, components ) );
+          frameResults.timeMs =
+              std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+
+          std::lock_guard<std::mutex> lock( resultsMutex );
+          results[frame] = std::move( frameResults );
+          resultsReady.notify_all();
+        }
+      }
+      catch( ... )
+      {
+        fail( std::current_exception() );
+      }
+    } );
+  }
 
-    for( unsigned int s = 1; s < m_apcInputStreams.size(); s++ )
+  for( std::uint64_t frame = 0; frame < numFrames; frame++ )
+  {
+    FrameResults frameResults;
+    {
+      std::unique_lock<std::mutex> lock( resultsMutex );
+      resultsReady.wait( lock, [&] { return aborted || results.count( frame ) || frame >= framesRead; } );
+      if( !results.count( frame ) )
+        break;
+      frameResults = std::move( results[frame] );
+      results.erase( frame );
+    }
+
+    log( CLP_LOG_INFO, "  %3d  ", frame );
+    for( unsigned int s = 1; s < numStreams; s++ )
     {
       log( CLP_LOG_RESULT, "  " );
-      for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+      const auto& quality = frameResults.quality[s - 1];
+      for( int metric : m_aiQualityMetrics )
       {
-        dQuality = apcCurrFrame[s]->getQuality( m_uiQualityMetric, apcCurrFrame[0], c );
-        adAverageQuality[s - 1][c] = ( adAverageQuality[s - 1][c] * double( frame ) + dQuality ) / double( frame + 1 );
-        log( CLP_LOG_RESULT, metric_fmt.c_str(), dQuality );
+        for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+        {
+          const double dQuality = quality( metric, c );
+          double& dAverage = adAverageQuality[metric][s - 1][c];
+          dAverage = ( dAverage * double( frame ) + dQuality ) / double( frame + 1 );
+          log( CLP_LOG_RESULT, metric_fmt[metric].c_str(), dQuality );
+          m_cResults.write( { .frame = frame,
+                              .stream = s,
+                              .component = c,
+                              .metric = CalypFrame::supportedQualityMetricsList()[metric],
+                              .value = dQuality,
+                              .timeMs = frameResults.timeMs } );
+        }
       }
       log( CLP_LOG_RESULT, " " );
     }
     log( CLP_LOG_RESULT, "\n" );
-    for( unsigned int s = 0; s < m_apcInputStreams.size(); s++ )
+    m_cResults.flush();
+  }
+
+  for( auto& queue : frameQueues )
+    queue->close();
+  for( auto& thread : threads )
+    thread.join();
+  if( error )
+  {
+    try
     {
-      abEOF[s] = m_apcInputStreams[s]->setNextFrame();
-      if( !abEOF[s] )
-      {
-        m_apcInputStreams[s]->readNextFrame();
-      }
+      std::rethrow_exception( error );
+    }
+    catch( const std::exception& e )
+    {
+      log( CLP_LOG_ERROR, "Cannot measure the quality: %s\n", e.what() );
+    }
+    catch( ... )
+    {
+      log( CLP_LOG_ERROR, "Cannot measure the quality!\n" );
     }
+    return -1;
   }
+
   log( CLP_LOG_INFO, "\n  Mean Values: \n         " );
-  for( unsigned int s = 0; s < m_apcInputStreams.size() - 1; s++ )
+  for( unsigned int s = 0; s < numStreams - 1; s++ )
   {
-    for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+    for( int metric : m_aiQualityMetrics )
     {
-      log( CLP_LOG_INFO, metric_fmt.c_str(), adAverageQuality[s][c] );
+      for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+      {
+        log( CLP_LOG_INFO, metric_fmt[metric].c_str(), adAverageQuality[metric][s][c] );
+        m_cResults.write( { .type = "summary",
+                            .stream = s + 1,
+                            .component = c,
+                            .metric = CalypFrame::supportedQualityMetricsList()[metric],
+                            .value = adAverageQuality[metric][s][c] } );
+      }
     }
     log( CLP_LOG_RESULT, "   " );
   }
   log( CLP_LOG_INFO, "\n" );
+  m_cResults.flush();
+  return 0;
+}
+
+int CalypTools::QualityMapOperation()
+{
+  std::ofstream mapFile( m_pcOutputFileNames[0] );
+  if( !mapFile )
+  {
+    log( CLP_LOG_ERROR, "Cannot open the output file %s! ", m_pcOutputFileNames[0].c_str() );
+    return -1;
+  }
+  const std::string mapName = CalypFrame::supportedQualityMapsList()[m_iQualityMap];
+  log( CLP_LOG_INFO, "  Measuring %s map of %dx%d blocks ... \n", mapName.c_str(), m_uiBlockSize, m_uiBlockSize );
+
+  // One block of text for each frame, stream and component, with a row of values for each row of blocks
+  for( unsigned int frame = 0; frame < m_uiNumberOfFrames; frame++ )
+  {
+    log( CLP_LOG_INFO, "  %3d\n", frame );
+    CalypFrame* pcRefFrame = m_apcInputStreams[0]->getCurrFrame();
+    for( unsigned int s = 1; s < m_apcInputStreams.size(); s++ )
+    {
+      CalypFrame* pcFrame = m_apcInputStreams[s]->getCurrFrame();
+      for( unsigned int c = 0; c < m_uiNumberOfComponents; c++ )
+      {
+        const unsigned int blocksX = ( pcFrame->getWidth( c ) + m_uiBlockSize - 1 ) / m_uiBlockSize;
+        const unsigned int blocksY = ( pcFrame->getHeight( c ) + m_uiBlockSize - 1 ) / m_uiBlockSize;
+        const CalypPlane<float> map = pcFrame->getQualityMap( m_iQualityMap, pcRefFrame, c, m_uiBlockSize );
+        mapFile << "# " << mapName << " frame " << frame << " stream " << s << " component " << c << " " << blocksX
+                << "x" << blocksY << "\n";
+        for( unsigned int y = 0; y < blocksY; y++ )
+        {
+          for( unsigned int x = 0; x < blocksX; x++ )
+            mapFile << ( x ? " " : "" ) << map[y][x];
+          mapFile << "\n";
+        }
+      }
+    }
+    bool bEOF = false;
+    for( unsigned int s = 0; s < m_apcInputStreams.size(); s++ )
+    {
+      if( m_apcInputStreams[s]->setNextFrame() )
+      {
+        bEOF = true;
+        continue;
+      }
+      m_apcInputStreams[s]->readNextFrame();
+    }
+    if( bEOF )
+      break;
+  }
+  if( !mapFile )
+  {
+    log( CLP_LOG_ERROR, "Cannot write the output file %s! ", m_pcOutputFileNames[0].c_str() );
+    return -1;
+  }
   return 0;
 }
 
@@ -616,6 +980,7 @@ int CalypTools::ModuleOperation()
   for( unsigned int frame = 0; frame < m_uiNumberOfFrames; )
   {
     log( CLP_LOG_INFO, "  Processing frame %3d\n", frame );
+    const auto start = std::chrono::steady_clock::now();
     bool bReadFrame = true;
     if( m_pcCurrModuleIf->m_iModuleType == ClpModuleType::FrameProcessing )
     {
@@ -637,6 +1002,12 @@ int CalypTools::ModuleOperation()
         dMeasurementResult = m_pcCurrModuleIf->measure( m_apcInputStreams[0]->getCurrFrame() );
       log( CLP_LOG_INFO, "   %3d", frame );
       log( CLP_LOG_RESULT, "  %8.3f \n", dMeasurementResult );
+      m_cResults.write(
+          { .frame = frame,
+            .metric = m_pcCurrModuleIf->m_pchModuleName,
+            .value = dMeasurementResult,
+            .timeMs = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count() } );
+      m_cResults.flush();
       dAveragedMeasurementResult =
           ( dAveragedMeasurementResult * double( frame ) + dMeasurementResult ) / double( frame + 1 );
     }
@@ -649,6 +1020,9 @@ int CalypTools::ModuleOperation()
     {
       apcFrameList = readInput();
       frame++;
+      // The inputs ended
+      if( apcFrameList.empty() )
+        break;
     }
   }
 
@@ -669,6 +1043,9 @@ int CalypTools::ModuleOperation()
   if( m_pcCurrModuleIf->m_iModuleType == ClpModuleType::FrameMeasurement )
   {
     log( CLP_LOG_INFO, "\n  Mean Value: \n        %8.3f\n", dAveragedMeasurementResult );
+    m_cResults.write(
+        { .type = "summary", .metric = m_pcCurrModuleIf->m_pchModuleName, .value = dAveragedMeasurementResult } );
+    m_cResults.flush();
   }
 
   return 0;
@@ -691,6 +1068,7 @@ int CalypTools::ListStatistics()
     for( unsigned int frame = 0; frame < m_apcInputStreams[input]->getFrameNum(); frame++ )
     {
       log( CLP_LOG_RESULT, "\x1B[34m  Frame: %d\x1B[0m\n", frame );
+      const auto start = std::chrono::steady_clock::now();
 
       auto currFrame = m_apcInputStreams[input]->getCurrFrame();
       abEOF = m_apcInputStreams[input]->setNextFrame();
@@ -748,8 +1126,39 @@ int CalypTools::ListStatistics()
       for( unsigned channel = 0; channel < currFrame->getNumberChannels(); channel++ )
         log( CLP_LOG_RESULT, "| %13.2f ", currFrame->getEntropy( channel, min[channel], max[channel] ) );
       log( CLP_LOG_RESULT, "|\n" );
+
+      if( m_cResults.enabled() )
+      {
+        const double timeMs =
+            std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+        for( unsigned channel = 0; channel < currFrame->getNumberChannels(); channel++ )
+        {
+          const std::pair<const char*, double> statistics[] = {
+              { "min", min[channel] },
+              { "max", max[channel] },
+              { "non_empty_bins", currFrame->getNEBins( channel ) },
+              { "mean", currFrame->getMean( channel, min[channel], max[channel] ) },
+              { "stddev", currFrame->getStdDev( channel, min[channel], max[channel] ) },
+              { "median", currFrame->getMedian( channel, min[channel], max[channel] ) },
+              { "entropy", currFrame->getEntropy( channel, min[channel], max[channel] ) },
+          };
+          for( const auto& [name, value] : statistics )
+            m_cResults.write( { .frame = frame,
+                                .stream = input,
+                                .component = channel,
+                                .metric = name,
+                                .value = value,
+                                .timeMs = timeMs } );
+        }
+        m_cResults.flush();
+      }
     }
+    m_cResults.write( { .type = "summary",
+                        .stream = input,
+                        .metric = "frames",
+                        .value = double( m_apcInputStreams[input]->getFrameNum() ) } );
   }
+  m_cResults.flush();
 
   return 0;
 }
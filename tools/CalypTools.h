@@ -75,6 +75,7 @@ private:
     SAVE_OPERATION,
     RATE_REDUCTION_OPERATION,
     QUALITY_OPERATION,
+    QUALITY_MAP_OPERATION,
     MODULE_OPERATION,
     STATISTICS_OPERATION,
   };
@@ -97,9 +98,12 @@ private:
 
   int RateReductionOperation();
 
-  int m_uiQualityMetric;
+  std::vector<int> m_aiQualityMetrics;
   int QualityOperation();
 
+  int m_iQualityMap;
+  int QualityMapOperation();
+
   CalypModulePtr m_pcCurrModuleIf;
   int ModuleOperation();
   int ListStatistics();
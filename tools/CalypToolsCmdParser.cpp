@@ -29,6 +29,7 @@
 #include <cstring>
 #include <iostream>
 
+#include "lib/CalypCpuFeatures.h"
 #include "lib/CalypFrame.h"
 #include "lib/CalypModuleIf.h"
 #include "lib/CalypStream.h"
@@ -39,6 +40,13 @@ CalypToolsCmdParser::CalypToolsCmdParser()
   m_uiLogLevel = 0;
   m_bQuiet = false;
   m_iFrames = -1;
+  m_uiBlockSize = 8;
+  m_uiThreads = 1;
+  m_uiReadAhead = 0;
+  m_uiDecoderThreads = 0;
+  m_uiWriteBehind = 4;
+  m_strEncoder = "ffv1";
+  m_uiEncoderThreads = 0;
 
   m_cOptions.addOptions()                                     /**/
       ( "help", "produce help message" )                      /**/
@@ -56,9 +64,10 @@ void CalypToolsCmdParser::log( unsigned int level, const char* fmt, ... )
 {
   if( level >= m_uiLogLevel )
   {
+    // stdout only carries the records of the machine readable formats
     std::va_list args;
     va_start( args, fmt );
-    vfprintf( stdout, fmt, args );
+    vfprintf( m_cResults.enabled() ? stderr : stdout, fmt, args );
     va_end( args );
   }
 }
@@ -69,7 +78,7 @@ void CalypToolsCmdParser::log( unsigned int level, std::string log_msg )
   {
     return;
   }
-  std::cout << log_msg;
+  ( m_cResults.enabled() ? std::cerr : std::cout ) << log_msg;
 }
 
 int CalypToolsCmdParser::parseToolsArgs( int argc, char* argv[] )
@@ -86,10 +95,21 @@ int CalypToolsCmdParser::parseToolsArgs( int argc, char* argv[] )
       ( "endianness", m_strEndianness, "File endianness (big, little)" )               /**/
       ( "has_negative", m_strHasNegativeValues, "Flag for files with negatie values" ) /**/
       ( "frames,f", m_iFrames, "number of frames to parse" )                           /**/
-      ( "quality", m_strQualityMetric, "select a quality metric" )                     /**/
+      ( "quality", m_strQualityMetric, "select quality metrics (comma separated)" )    /**/
+      ( "quality-map", m_strQualityMap, "dump per block maps (mse, ssim, absdiff)" )   /**/
+      ( "block-size", m_uiBlockSize, "block size of the quality maps [8]" )            /**/
+      ( "threads", m_uiThreads, "frames measured in parallel (0: one per core) [1]" )  /**/
+      ( "read-ahead", m_uiReadAhead, "frames read ahead in a thread per input [0]" )   /**/
+      ( "decoder-threads", m_uiDecoderThreads, "decoding threads (0: auto) [0]" )      /**/
+      ( "encoder", m_strEncoder, "lossless encoder of mkv/nut outputs [ffv1]" )        /**/
+      ( "encoder-threads", m_uiEncoderThreads, "encoding threads (0: auto) [0]" )      /**/
+      ( "write-behind", m_uiWriteBehind, "frames written in a thread per output [4]" ) /**/
+      ( "output-format", m_strOutputFormat, "results format (text, csv, jsonl)" )        /**/
       ( "module", m_strModule, "select a module (use internal name)" )                 /**/
       ( "save", "save a specific frame" )                                              /**/
-      ( "rate-reduction", m_iRateReductionFactor, "reduce the frame rate" );           /**/
+      ( "statistics", "list the statistics of each frame" )                            /**/
+      ( "rate-reduction", m_iRateReductionFactor, "reduce the frame rate" )            /**/
+      ( "cpu", m_strCpuLevel, "limit the SIMD kernels (generic, sse2, sse4.1, avx2, avx512)" );
 
   iRet = m_cOptions.parse( argc, argv );
   if( iRet < 0 || iRet > 0 )
@@ -102,6 +122,34 @@ int CalypToolsCmdParser::parseToolsArgs( int argc, char* argv[] )
     m_uiLogLevel = CLP_LOG_RESULT;
   }
 
+  if( m_cOptions.hasOpt( "output-format" ) )
+  {
+    auto format = CalypToolsResults::findFormat( m_strOutputFormat );
+    if( !format )
+    {
+      log( CLP_LOG_ERROR, "Invalid output format %s!\n", m_strOutputFormat.c_str() );
+      return -1;
+    }
+    m_cResults.setFormat( *format );
+    // The text tables are replaced by the records
+    if( m_cResults.enabled() )
+      m_uiLogLevel = CLP_LOG_ERROR;
+  }
+
+  log( CLP_LOG_ERROR, "calypTools - The command line interface for Calyp modules! \n" );
+
+  if( m_cOptions.hasOpt( "cpu" ) )
+  {
+    auto cpuLevel = calypFindCpuLevel( m_strCpuLevel );
+    if( !cpuLevel )
+    {
+      log( CLP_LOG_ERROR, "Invalid cpu level %s!\n", m_strCpuLevel.c_str() );
+      return -1;
+    }
+    auto usedLevel = calypSetCpuLevel( *cpuLevel );
+    log( CLP_LOG_INFO, "Using %s kernels\n", std::string( calypCpuLevelName( usedLevel ) ).c_str() );
+  }
+
   if( m_cOptions.hasOpt( "module_list" ) || m_cOptions.hasOpt( "module_list_full" ) )
   {
     listModules();
@@ -117,7 +165,10 @@ int CalypToolsCmdParser::parseToolsArgs( int argc, char* argv[] )
   {
     printf( "Usage: %s module/quality/save [options] --input=input_file [--output=output_file]\n", argv[0] );
     printf( "       %s --module=module_name [options] --input=input_file [--output=output_file]\n", argv[0] );
-    printf( "       %s --quality=quality_metric [options] --input=input_file1 --input=input_file2\n", argv[0] );
+    printf( "       %s --quality=metric[,metric...] [options] --input=input_file1 --input=input_file2\n", argv[0] );
+    printf( "       %s --quality-map=map [--block-size=size] [options] --input=input_file1 --input=input_file2 "
+            "--output=output_file\n",
+            argv[0] );
     m_cOptions.doHelp( std::cout );
     iRet = 1;
   }
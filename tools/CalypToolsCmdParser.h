@@ -27,6 +27,7 @@
 
 #include <vector>
 
+#include "CalypToolsResults.h"
 #include "config.h"
 #include "lib/CalypDefs.h"
 #include "lib/CalypOptions.h"
@@ -60,6 +61,7 @@ public:
 protected:
   CalypOptions m_cOptions;
   unsigned int m_uiLogLevel;
+  CalypToolsResults m_cResults;
 
   /**
    * Command line opts for CalypTools
@@ -80,7 +82,17 @@ protected:
 
   int m_iRateReductionFactor;
   std::string m_strQualityMetric;
+  std::string m_strQualityMap;
+  unsigned int m_uiBlockSize;
+  unsigned int m_uiThreads;
+  unsigned int m_uiReadAhead;
+  unsigned int m_uiDecoderThreads;
+  std::string m_strEncoder;
+  unsigned int m_uiEncoderThreads;
+  unsigned int m_uiWriteBehind;
+  std::string m_strOutputFormat;
   std::string m_strModule;
+  std::string m_strCpuLevel;
 
   bool m_bListPelFmts;
   bool m_bListQuality;
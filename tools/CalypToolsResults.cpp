@@ -0,0 +1,132 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2021  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     CalypToolsResults.cpp
+ * \brief    Machine readable results of calypTools (CSV or JSON lines)
+ */
+
+#include "CalypToolsResults.h"
+
+#include <cmath>
+
+#include "lib/CalypDefs.h"
+
+namespace
+{
+auto formatNumber( double value ) -> std::string
+{
+  char buffer[32];
+  std::snprintf( buffer, sizeof( buffer ), "%.10g", value );
+  return buffer;
+}
+
+// Quote a CSV field when it has separators, quotes or line breaks
+auto csvField( const std::string& field ) -> std::string
+{
+  if( field.find_first_of( ",\"\n" ) == std::string::npos )
+    return field;
+  std::string quoted = "\"";
+  for( char c : field )
+  {
+    if( c == '"' )
+      quoted += '"';
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+auto jsonString( const std::string& str ) -> std::string
+{
+  std::string quoted = "\"";
+  for( char c : str )
+  {
+    if( c == '"' || c == '\\' )
+      quoted += '\\';
+    if( static_cast<unsigned char>( c ) < 0x20 )
+    {
+      char escaped[8];
+      std::snprintf( escaped, sizeof( escaped ), "\\u%04x", c );
+      quoted += escaped;
+      continue;
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+}  // namespace
+
+auto CalypToolsResults::findFormat( const std::string& name ) -> std::optional<Format>
+{
+  const std::string format = clpLowercase( name );
+  if( format == "text" )
+    return Format::Text;
+  if( format == "csv" )
+    return Format::Csv;
+  if( format == "jsonl" )
+    return Format::Jsonl;
+  return std::nullopt;
+}
+
+void CalypToolsResults::write( const CalypToolsRecord& record )
+{
+  if( !enabled() )
+    return;
+
+  std::string line;
+  if( m_format == Format::Csv )
+  {
+    const auto optional = []( const auto& field ) { return field ? std::to_string( *field ) : std::string(); };
+    line = std::string( record.type ) + "," + optional( record.frame ) + "," + optional( record.stream ) + "," +
+           optional( record.component ) + "," + csvField( record.metric ) + "," + formatNumber( record.value ) + "," +
+           ( record.timeMs ? formatNumber( *record.timeMs ) : std::string() );
+  }
+  else
+  {
+    line = "{\"type\":" + jsonString( record.type );
+    if( record.frame )
+      line += ",\"frame\":" + std::to_string( *record.frame );
+    if( record.stream )
+      line += ",\"stream\":" + std::to_string( *record.stream );
+    if( record.component )
+      line += ",\"component\":" + std::to_string( *record.component );
+    // JSON has no representation for NaN or infinity
+    line += ",\"metric\":" + jsonString( record.metric ) +
+            ",\"value\":" + ( std::isfinite( record.value ) ? formatNumber( record.value ) : "null" );
+    if( record.timeMs )
+      line += ",\"time_ms\":" + formatNumber( *record.timeMs );
+    line += "}";
+  }
+
+  std::lock_guard<std::mutex> lock( m_mutex );
+  if( m_format == Format::Csv && !m_bWroteHeader )
+  {
+    std::fputs( "type,frame,stream,component,metric,value,time_ms\n", m_pFile );
+    m_bWroteHeader = true;
+  }
+  std::fputs( line.c_str(), m_pFile );
+  std::fputc( '\n', m_pFile );
+}
+
+void CalypToolsResults::flush()
+{
+  std::lock_guard<std::mutex> lock( m_mutex );
+  std::fflush( m_pFile );
+}
@@ -0,0 +1,84 @@
+/*    This file is a part of Calyp project
+ *    Copyright (C) 2014-2021  by Joao Carreira   (jfmcarreira@gmail.com)
+ *                                Luis Lucas      (luisfrlucas@gmail.com)
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file     CalypToolsResults.h
+ * \brief    Machine readable results of calypTools (CSV or JSON lines)
+ */
+
+#ifndef __CALYPTOOLSRESULTS_H__
+#define __CALYPTOOLSRESULTS_H__
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <optional>
+#include <string>
+
+/**
+ * One result: a value of a frame (or a summary of all frames)
+ * of a stream and component, missing fields are left empty
+ */
+struct CalypToolsRecord
+{
+  const char* type{ "frame" };  //!< "frame" or "summary"
+  std::optional<std::uint64_t> frame;
+  std::optional<unsigned int> stream;
+  std::optional<unsigned int> component;
+  std::string metric;
+  double value{ 0 };
+  std::optional<double> timeMs;  //!< wall time spent on the frame
+};
+
+/**
+ * Writes records as soon as they are computed, either as CSV
+ * (with a header before the first record) or one JSON object per line
+ */
+class CalypToolsResults
+{
+public:
+  enum class Format
+  {
+    Text,
+    Csv,
+    Jsonl,
+  };
+
+  static auto findFormat( const std::string& name ) -> std::optional<Format>;
+
+  explicit CalypToolsResults( std::FILE* file = stdout )
+      : m_pFile{ file }
+  {
+  }
+
+  void setFormat( Format format ) { m_format = format; }
+  auto format() const -> Format { return m_format; }
+  auto enabled() const -> bool { return m_format != Format::Text; }
+
+  void write( const CalypToolsRecord& record );
+  void flush();
+
+private:
+  std::FILE* m_pFile;
+  Format m_format{ Format::Text };
+  bool m_bWroteHeader{ false };
+  std::mutex m_mutex;
+};
+
+#endif  // __CALYPTOOLSRESULTS_H__